@@ -35,11 +35,13 @@ namespace campvis {
     {
         _ignorePropertyUpdates = 0;
         _transferFunction->s_changed.connect(this, &AbstractTransferFunctionEditor::onTFChanged);
+        _tfProperty->s_intensityHistogramChanged.connect(this, &AbstractTransferFunctionEditor::onTFChanged);
     }
 
     AbstractTransferFunctionEditor::~AbstractTransferFunctionEditor() {
         if (_transferFunction != nullptr)
             _transferFunction->s_changed.disconnect(this);
+        _tfProperty->s_intensityHistogramChanged.disconnect(this);
     }
     
     void AbstractTransferFunctionEditor::onTFChanged() {
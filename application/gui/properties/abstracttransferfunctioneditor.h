@@ -77,7 +77,7 @@ namespace campvis {
         tbb::atomic<int> _ignorePropertyUpdates;
 
     private:
-        /// Slot getting called when the transfer function has changed, so that the widget can be updated.
+        /// Slot getting called when the transfer function or the intensity histogram has changed, so that the widget can be updated.
         virtual void onTFChanged();
     };
 }
@@ -20,6 +20,7 @@
 #include "core/pipeline/pipelinefactory.h"
 #include "core/pipeline/processorfactory.h"
 #include "core/pipeline/visualizationprocessor.h"
+#include "core/tools/processorprofiler.h"
 #include "core/classification/tfgeometry1d.h"
 #include "core/classification/tfgeometry2d.h"
 #include "core/classification/geometry1dtransferfunction.h"
@@ -643,6 +644,20 @@ namespace campvis {
         std::vector<std::string> getRegisteredRaycastingProcessors() const;
         AbstractProcessor* createProcessor(const std::string& id, IVec2Property* viewPortSizeProp = nullptr) const;
     };
+
+    /* ProcessorProfiler */
+
+    class ProcessorProfiler {
+    public:
+        static ProcessorProfiler& getRef();
+
+        void startCapture(size_t capacity = 65536);
+        void stopCapture();
+        static bool isCapturing();
+
+        std::string getChromeTrace() const;
+        bool exportChromeTrace(const std::string& filename) const;
+    };
 }
 
 %luacode {
@@ -32,12 +32,18 @@
 
 #include "core/classification/tfgeometry1d.h"
 
+#include <tbb/tbb.h>
+
+#include <cmath>
+
 namespace campvis {
 
     const std::string Geometry1DTransferFunction::loggerCat_ = "CAMPVis.core.classification.Geometry1DTransferFunction";
 
     Geometry1DTransferFunction::Geometry1DTransferFunction(size_t size, const cgt::vec2& intensityDomain /*= cgt::vec2(0.f, 1.f)*/) 
         : GenericGeometryTransferFunction<TFGeometry1D>(cgt::svec3(size, 1, 1), intensityDomain)
+        , _preIntegrationTexture(0)
+        , _dirtyPreIntegrationTexture(false)
     {
     }
 
@@ -56,4 +62,128 @@ namespace campvis {
         return 1;
     }
 
+    void Geometry1DTransferFunction::deinit() {
+        {
+            tbb::mutex::scoped_lock lock(_preIntegrationMutex);
+            delete _preIntegrationTexture;
+            _preIntegrationTexture = 0;
+        }
+        GenericGeometryTransferFunction<TFGeometry1D>::deinit();
+    }
+
+    void Geometry1DTransferFunction::rasterize(std::vector<cgt::vec4>& lut) const {
+        lut.assign(_size.x, cgt::vec4(0.f));
+
+        // later geometries overwrite earlier ones, just like in createTexture()
+        tbb::mutex::scoped_lock lock(_localMutex);
+        for (std::vector<TFGeometry1D*>::const_iterator it = _geometries.begin(); it != _geometries.end(); ++it) {
+            (*it)->rasterize(lut);
+        }
+    }
+
+    bool Geometry1DTransferFunction::updatePreIntegrationTable() {
+        std::vector<cgt::vec4> lut;
+        rasterize(lut);
+        const size_t n = lut.size();
+
+        tbb::mutex::scoped_lock lock(_preIntegrationMutex);
+        size_t firstTexel = 0;
+        size_t lastTexel = n;
+        if (_lookupTable.size() == n && _preIntegrationTable.size() == n * n) {
+            // narrow the update down to the texels that actually changed
+            while (firstTexel < n && lut[firstTexel] == _lookupTable[firstTexel])
+                ++firstTexel;
+            if (firstTexel == n)
+                return false;
+            while (lastTexel > firstTexel && lut[lastTexel - 1] == _lookupTable[lastTexel - 1])
+                --lastTexel;
+        }
+        else {
+            _preIntegrationTable.assign(n * n, cgt::vec4(0.f));
+        }
+
+        _lookupTable.swap(lut);
+        computePreIntegrationTable(firstTexel, lastTexel);
+        _dirtyPreIntegrationTexture = true;
+        return true;
+    }
+
+    const std::vector<cgt::vec4>& Geometry1DTransferFunction::getPreIntegrationTable() const {
+        return _preIntegrationTable;
+    }
+
+    void Geometry1DTransferFunction::computePreIntegrationTable(size_t firstTexel, size_t lastTexel) {
+        const size_t n = _lookupTable.size();
+        if (n == 0 || firstTexel >= lastTexel)
+            return;
+
+        // Convert opacities (given for the base sampling interval) into extinction coefficients and
+        // integrate extinction and extinction-weighted color over the texels using the trapezoidal
+        // rule. The integrals of any segment are then just differences of these prefix sums.
+        std::vector<cgt::dvec4> extinction(n);
+        for (size_t i = 0; i < n; ++i) {
+            double tau = -std::log(1.0 - std::min(static_cast<double>(_lookupTable[i].a), 1.0 - 1e-6));
+            extinction[i] = cgt::dvec4(cgt::dvec3(_lookupTable[i].xyz()) * tau, tau);
+        }
+        std::vector<cgt::dvec4> integral(n, cgt::dvec4(0.0));
+        for (size_t i = 1; i < n; ++i) {
+            integral[i] = integral[i - 1] + (extinction[i - 1] + extinction[i]) * 0.5;
+        }
+
+        // The table is symmetric, so each row only computes entries (f, b) with b >= f and mirrors
+        // them. Entry (f, b) depends on the texels [f, b], so only segments overlapping the changed
+        // texels have to be recomputed. Rows from lastTexel on are covered entirely by mirroring.
+        tbb::parallel_for(tbb::blocked_range<size_t>(0, lastTexel), [&] (const tbb::blocked_range<size_t>& range) {
+            for (size_t f = range.begin(); f != range.end(); ++f) {
+                _preIntegrationTable[f * n + f] = _lookupTable[f];
+
+                for (size_t b = std::max(f + 1, firstTexel); b < n; ++b) {
+                    cgt::dvec4 segment = integral[b] - integral[f];
+                    double length = static_cast<double>(b - f);
+
+                    cgt::vec4 value;
+                    if (segment.w > 1e-9)
+                        value = cgt::vec4(cgt::vec3(segment.xyz() / segment.w), static_cast<float>(1.0 - std::exp(-segment.w / length)));
+                    else
+                        value = cgt::vec4((_lookupTable[f].xyz() + _lookupTable[b].xyz()) * .5f, 0.f);
+
+                    _preIntegrationTable[f * n + b] = value;
+                    _preIntegrationTable[b * n + f] = value;
+                }
+            }
+        });
+    }
+
+    void Geometry1DTransferFunction::bindPreIntegrationTable(cgt::Shader* shader, const cgt::TextureUnit& texUnit, const std::string& tableUniform /*= "_preIntegrationTable"*/, const std::string& transFuncParamsUniform /*= "_transferFunctionParams"*/) {
+        cgtAssert(shader != 0, "Shader must not be 0.");
+        updatePreIntegrationTable();
+
+        texUnit.activate();
+        {
+            tbb::mutex::scoped_lock lock(_preIntegrationMutex);
+            const cgt::ivec3 tableSize(static_cast<int>(_lookupTable.size()), static_cast<int>(_lookupTable.size()), 1);
+            if (_preIntegrationTexture != 0 && _preIntegrationTexture->getDimensions() != tableSize) {
+                delete _preIntegrationTexture;
+                _preIntegrationTexture = 0;
+            }
+            if (_preIntegrationTexture == 0) {
+                _preIntegrationTexture = new cgt::Texture(GL_TEXTURE_2D, tableSize, GL_RGBA32F, cgt::Texture::LINEAR);
+                _preIntegrationTexture->setWrapping(cgt::Texture::CLAMP_TO_EDGE);
+                _dirtyPreIntegrationTexture = true;
+            }
+            if (_dirtyPreIntegrationTexture) {
+                _preIntegrationTexture->uploadTexture(reinterpret_cast<const GLubyte*>(&_preIntegrationTable.front()), GL_RGBA, GL_FLOAT);
+                _dirtyPreIntegrationTexture = false;
+            }
+            _preIntegrationTexture->bind();
+        }
+        LGL_ERROR;
+
+        bool tmp = shader->getIgnoreUniformLocationError();
+        shader->setIgnoreUniformLocationError(true);
+        shader->setUniform(tableUniform, texUnit.getUnitNumber());
+        shader->setUniform(transFuncParamsUniform + "._intensityDomain", cgt::vec2(_intensityDomain));
+        shader->setIgnoreUniformLocationError(tmp);
+    }
+
 }
\ No newline at end of file
@@ -29,12 +29,26 @@
 
 #include <vector>
 
+namespace cgt {
+    class Shader;
+    class Texture;
+    class TextureUnit;
+}
+
 namespace campvis {
 
     class TFGeometry1D;
 
     /**
      * A 1D transfer function built from multiple geometries.
+     * 
+     * Besides the regular lookup texture, Geometry1DTransferFunction provides a pre-integrated
+     * lookup table (see bindPreIntegrationTable()). Its entry (f, b) stores the color and opacity
+     * of a ray segment of the base sampling interval whose intensity varies linearly from f (front
+     * sample) to b (back sample), so that raycasters can sample much coarser without slab artifacts.
+     * The table is computed on the CPU from a CPU rasterization of the TF geometries. It is built
+     * in parallel and on geometry edits only the entries whose segment overlaps the changed part
+     * of the lookup table are recomputed.
      */
     class CAMPVIS_CORE_API Geometry1DTransferFunction : public GenericGeometryTransferFunction<TFGeometry1D> {
     public:
@@ -62,7 +76,58 @@ namespace campvis {
          */
         virtual size_t getDimensionality() const;
 
+        /**
+         * Deletes the OpenGL textures and shader, hence, this methods has to be called from a thread with a valid OpenGL context!
+         */
+        virtual void deinit();
+
+        /**
+         * Rasterizes all TF geometries on the CPU into a lookup table, mirroring what the
+         * OpenGL path renders into the TF texture.
+         * \param   lut     Lookup table to fill, will be resized to the TF size.
+         */
+        void rasterize(std::vector<cgt::vec4>& lut) const;
+
+        /**
+         * Brings the pre-integration table up to date with the current TF geometries.
+         * Only the entries affected by changes since the last update are recomputed.
+         * \note    Does not need an OpenGL context.
+         * \return  True if the pre-integration table has changed.
+         */
+        bool updatePreIntegrationTable();
+
+        /**
+         * Returns the pre-integration table as computed by the last call to updatePreIntegrationTable().
+         * Entry (f, b) is stored at index f * size + b, colors are not premultiplied by alpha.
+         * \return  _preIntegrationTable
+         */
+        const std::vector<cgt::vec4>& getPreIntegrationTable() const;
+
+        /**
+         * Binds the pre-integration table as 2D OpenGL texture to the given texture unit and sets up uniforms.
+         * Use lookupPreIntegratedTF() from transferfunction.frag to sample it.
+         * \note    Calling thread must have a valid OpenGL context.
+         * \param   shader                  Shader used for rendering
+         * \param   texUnit                 Texture unit to bind texture to
+         * \param   tableUniform            Uniform name to store the pre-integration table sampler
+         * \param   transFuncParamsUniform  Uniform name to store the TF parameters struct
+         */
+        void bindPreIntegrationTable(cgt::Shader* shader, const cgt::TextureUnit& texUnit, const std::string& tableUniform = "_preIntegrationTable", const std::string& transFuncParamsUniform = "_transferFunctionParams");
+
     protected:
+        /**
+         * Computes all pre-integration table entries whose segment overlaps the lookup table texels
+         * [firstTexel, lastTexel). Expects _lookupTable to be up to date.
+         * \param   firstTexel  First changed texel of the lookup table
+         * \param   lastTexel   One past the last changed texel of the lookup table
+         */
+        void computePreIntegrationTable(size_t firstTexel, size_t lastTexel);
+
+        std::vector<cgt::vec4> _lookupTable;            ///< CPU lookup table the pre-integration table was computed from
+        std::vector<cgt::vec4> _preIntegrationTable;    ///< Pre-integration table, size x size entries
+        cgt::Texture* _preIntegrationTexture;           ///< OpenGL texture storing the pre-integration table
+        bool _dirtyPreIntegrationTexture;               ///< Flag whether _preIntegrationTexture has to be updated
+        mutable tbb::mutex _preIntegrationMutex;        ///< mutex protecting the pre-integration members
 
         static const std::string loggerCat_;
 
@@ -100,6 +100,28 @@ namespace campvis {
         fg.render(GL_TRIANGLE_STRIP);
     }
 
+    void TFGeometry1D::rasterize(std::vector<cgt::vec4>& lut) const {
+        if (_keyPoints.size() < 2 || lut.empty())
+            return;
+
+        const float n = static_cast<float>(lut.size());
+        std::vector<KeyPoint>::const_iterator b = _keyPoints.begin() + 1;
+        for (size_t i = 0; i < lut.size(); ++i) {
+            // sample at texel centers, same as the OpenGL rasterization
+            float x = (static_cast<float>(i) + .5f) / n;
+            if (x < _keyPoints.front()._position || x > _keyPoints.back()._position)
+                continue;
+
+            while (b + 1 != _keyPoints.end() && b->_position < x)
+                ++b;
+            std::vector<KeyPoint>::const_iterator a = b - 1;
+
+            float width = b->_position - a->_position;
+            float t = (width > 0.f) ? cgt::clamp((x - a->_position) / width, 0.f, 1.f) : 1.f;
+            lut[i] = cgt::mix(cgt::vec4(a->_color), cgt::vec4(b->_color), t) / 255.f;
+        }
+    }
+
     TFGeometry1D* TFGeometry1D::createQuad(const cgt::vec2& interval, const cgt::col4& leftColor, const cgt::col4& rightColor) {
         cgtAssert(interval.x >= 0.f && interval.y <= 1.f, "Interval out of bounds");
 
@@ -93,6 +93,15 @@ namespace campvis {
          */
         void render() const;
 
+        /**
+         * Rasterizes this transfer function geometry on the CPU into the lookup table \a lut.
+         * Mirrors render(): every texel whose center lies within the geometry's intensity domain
+         * is overwritten with the linearly interpolated KeyPoint color, all other texels are
+         * left untouched.
+         * \param   lut     Lookup table to rasterize into, RGBA in [0, 1], spanning the TF domain [0, 1].
+         */
+        void rasterize(std::vector<cgt::vec4>& lut) const;
+
         /// Signal to be emitted when this TF geometry has changed.
         sigslot::signal0 s_changed;
         
@@ -27,14 +27,18 @@
 #include "cgt/assert.h"
 #include "cgt/logmanager.h"
 #include "core/datastructures/abstractdata.h"
+#include "core/datastructures/imagedata.h"
+
+#include <algorithm>
 
 namespace campvis {
     const std::string DataContainer::loggerCat_ = "CAMPVis.core.datastructures.DataContainer";
 
     DataContainer::DataContainer(const std::string& name)
         : _name(name)
+        , _accessCounter(0)
     {
-
+        _memoryBudget = 0;
     }
 
     DataContainer::~DataContainer() {
@@ -65,9 +69,13 @@ namespace campvis {
         cgtAssert(!name.empty(), "The data's name must not be empty.");
         _handles.erase(name);
         _handles.insert(std::make_pair(name, dh));
+        touch(name);
  
         s_dataAdded.emitSignal(name, dh);
         s_changed.emitSignal();
+
+        if (_memoryBudget != 0)
+            enforceMemoryBudget();
     }
 
     bool DataContainer::hasData(const std::string& name) const {
@@ -78,6 +86,7 @@ namespace campvis {
     DataHandle DataContainer::getData(const std::string& name) const {
         tbb::concurrent_hash_map<std::string, DataHandle>::const_accessor a;
         if (_handles.find(a, name)) {
+            touch(name);
             return a->second;
         }
         else {
@@ -87,6 +96,9 @@ namespace campvis {
 
     void DataContainer::removeData(const std::string& name) {
         _handles.erase(name);
+
+        tbb::spin_mutex::scoped_lock lock(_localMutex);
+        _lastAccess.erase(name);
     }
 
     std::vector< std::pair< std::string, DataHandle> > DataContainer::getDataHandlesCopy() const {
@@ -103,6 +115,9 @@ namespace campvis {
 
     void DataContainer::clear() {
         _handles.clear();
+
+        tbb::spin_mutex::scoped_lock lock(_localMutex);
+        _lastAccess.clear();
     }
 
     const std::string& DataContainer::getName() const {
@@ -113,4 +128,112 @@ namespace campvis {
         _name = name;
     }
 
+    size_t DataContainer::getMemoryBudget() const {
+        return _memoryBudget;
+    }
+
+    void DataContainer::setMemoryBudget(size_t budget) {
+        _memoryBudget = budget;
+        if (budget != 0)
+            enforceMemoryBudget();
+    }
+
+    const std::string& DataContainer::getScratchDirectory() const {
+        return _scratchDirectory;
+    }
+
+    void DataContainer::setScratchDirectory(const std::string& directory) {
+        _scratchDirectory = directory;
+    }
+
+    size_t DataContainer::getMemoryFootprint() const {
+        size_t toReturn = 0;
+
+        tbb::spin_mutex::scoped_lock lock(_localMutex);
+        for (tbb::concurrent_hash_map<std::string, DataHandle>::const_iterator it = _handles.begin(); it != _handles.end(); ++it) {
+            toReturn += it->second.getData()->getLocalMemoryFootprint() + it->second.getData()->getVideoMemoryFootprint();
+        }
+
+        return toReturn;
+    }
+
+    size_t DataContainer::enforceMemoryBudget() {
+        size_t budget = _memoryBudget;
+        if (budget == 0)
+            return 0;
+
+        // gather current footprint and all images in least recently used order
+        size_t footprint = 0;
+        std::vector< std::pair<size_t, std::string> > candidates;
+        {
+            tbb::spin_mutex::scoped_lock lock(_localMutex);
+            for (tbb::concurrent_hash_map<std::string, DataHandle>::const_iterator it = _handles.begin(); it != _handles.end(); ++it) {
+                const AbstractData* data = it->second.getData();
+                footprint += data->getLocalMemoryFootprint() + data->getVideoMemoryFootprint();
+                if (dynamic_cast<const ImageData*>(data) != 0)
+                    candidates.push_back(std::make_pair(_lastAccess[it->first], it->first));
+            }
+        }
+
+        if (footprint <= budget)
+            return 0;
+        std::sort(candidates.begin(), candidates.end());
+
+        // first pass releases secondary representations
+        size_t freed = 0;
+        for (size_t i = 0; i < candidates.size() && footprint > budget + freed; ++i) {
+            // pin the image and release the accessor before deleting representations: deleting
+            // OpenGL textures waits for the OpenGL thread, which may be blocked in getData() on this key
+            DataHandle pinned(0);
+            {
+                tbb::concurrent_hash_map<std::string, DataHandle>::accessor a;
+                if (! _handles.find(a, candidates[i].second) || ! a->second.isUnique())
+                    continue;
+                pinned = a->second;
+            }
+
+            freed += static_cast<const ImageData*>(pinned.getData())->releaseSecondaryRepresentations();
+        }
+
+        // second pass spills image data to disk
+        for (size_t i = 0; i < candidates.size() && footprint > budget + freed; ++i) {
+            // pin the image and write its scratch file without holding the accessor, so that
+            // getData() and addData() on this key are not blocked by the disk I/O
+            DataHandle pinned(0);
+            {
+                tbb::concurrent_hash_map<std::string, DataHandle>::accessor a;
+                if (! _handles.find(a, candidates[i].second) || ! a->second.isUnique())
+                    continue;
+                pinned = a->second;
+            }
+
+            const ImageData* id = static_cast<const ImageData*>(pinned.getData());
+            if (id->createScratchRepresentation(_scratchDirectory) == 0)
+                continue;
+
+            // only swap the representations if nobody else got hold of the image in the meantime,
+            // again without holding the accessor as this may delete OpenGL textures
+            {
+                tbb::concurrent_hash_map<std::string, DataHandle>::accessor a;
+                bool found = _handles.find(a, candidates[i].second);
+                pinned = DataHandle(0);
+                if (! found || a->second.getData() != id || ! a->second.isUnique())
+                    continue;
+                pinned = a->second;
+            }
+
+            freed += id->spillToDisk(_scratchDirectory);
+        }
+
+        if (footprint > budget + freed)
+            LDEBUG("Could not enforce memory budget of DataContainer " << _name << ", " << (footprint - freed) << " bytes still in use.");
+
+        return freed;
+    }
+
+    void DataContainer::touch(const std::string& name) const {
+        tbb::spin_mutex::scoped_lock lock(_localMutex);
+        _lastAccess[name] = ++_accessCounter;
+    }
+
 }
\ No newline at end of file
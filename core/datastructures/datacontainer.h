@@ -26,6 +26,7 @@
 #define DATACONTAINER_H__
 
 #include "sigslot/sigslot.h"
+#include <tbb/atomic.h>
 #include <tbb/concurrent_hash_map.h>
 #include <tbb/spin_mutex.h>
 
@@ -134,6 +135,54 @@ namespace campvis {
          */
         void setName(const std::string& name);
 
+        /**
+         * Returns the memory budget of this DataContainer.
+         * \return  _memoryBudget
+         */
+        size_t getMemoryBudget() const;
+
+        /**
+         * Sets the memory budget of this DataContainer in bytes, 0 for no budget (default).
+         * If the sum of the local and video memory footprints of all data exceeds the budget, 
+         * enforceMemoryBudget() frees memory of the least recently used images.
+         * \param   budget      The new memory budget in bytes.
+         */
+        void setMemoryBudget(size_t budget);
+
+        /**
+         * Returns the directory for scratch files of spilled images.
+         * \return  _scratchDirectory
+         */
+        const std::string& getScratchDirectory() const;
+
+        /**
+         * Sets the directory for scratch files of spilled images, the system's temporary 
+         * directory is used if empty (default).
+         * \param   directory   The new scratch directory.
+         */
+        void setScratchDirectory(const std::string& directory);
+
+        /**
+         * Returns the sum of the local and video memory footprints of all data in this DataContainer.
+         * \return  Number of bytes occupied by the data in this DataContainer.
+         */
+        size_t getMemoryFootprint() const;
+
+        /**
+         * Frees memory until the memory footprint of this DataContainer is within its memory budget.
+         * Images are processed in least recently used order (with respect to addData() and getData()).
+         * First, their secondary representations are released, afterwards their data is spilled to 
+         * scratch files on disk (see ImageData::releaseSecondaryRepresentations() and 
+         * ImageData::spillToDisk()). Both are transparently recreated on the next getRepresentation().
+         * Only images that are not referenced by any other DataHandle are considered, since freeing 
+         * them invalidates pointers to their representations. Representations are freed and scratch
+         * files are written without locking the corresponding key, so that concurrent getData() 
+         * calls (e.g. from the OpenGL thread, which has to delete OpenGL textures) are not blocked.
+         * \note    Gets called automatically by addData() if a memory budget is set.
+         * \return  Number of bytes freed.
+         */
+        size_t enforceMemoryBudget();
+
         /**
          * Returns a copy of the current map of DataHandles.
          * \note    Use with caution, this method is to be considered as slow, as it includes several 
@@ -160,6 +209,17 @@ namespace campvis {
 
         std::string _name;
 
+        tbb::atomic<size_t> _memoryBudget;              ///< Memory budget in bytes, 0 for no budget
+        std::string _scratchDirectory;                  ///< Directory for scratch files of spilled images
+        mutable std::map<std::string, size_t> _lastAccess;  ///< Access counter value of the last access to each DataHandle, protected by _localMutex
+        mutable size_t _accessCounter;                      ///< Counter incremented on each access, protected by _localMutex
+
+        /**
+         * Marks the DataHandle with the given name as most recently used.
+         * \param   name    Key of the accessed DataHandle.
+         */
+        void touch(const std::string& name) const;
+
         static const std::string loggerCat_;
     };
 
@@ -71,4 +71,8 @@ namespace campvis {
         return _timestamp;
     }
 
+    bool DataHandle::isUnique() const {
+        return _ptr.use_count() == 1;
+    }
+
 }
\ No newline at end of file
@@ -90,6 +90,13 @@ namespace campvis {
          */
         clock_t getTimestamp() const;
 
+        /**
+         * Returns whether this is the only DataHandle referencing the managed AbstractData instance.
+         * \note    The result may be outdated immediately if other threads copy DataHandles to the same data.
+         * \return  _ptr.use_count() == 1
+         */
+        bool isUnique() const;
+
 
     private:
         std::shared_ptr<AbstractData> _ptr;     ///< managed data
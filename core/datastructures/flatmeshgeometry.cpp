@@ -0,0 +1,547 @@
+// ================================================================================================
+// 
+// This file is part of the CAMPVis Software Framework.
+// 
+// If not explicitly stated otherwise: Copyright (C) 2012-2015, all rights reserved,
+//      Christian Schulte zu Berge <christian.szb@in.tum.de>
+//      Chair for Computer Aided Medical Procedures
+//      Technische Universitaet Muenchen
+//      Boltzmannstr. 3, 85748 Garching b. Muenchen, Germany
+// 
+// For a full list of authors and contributors, please refer to the file "AUTHORS.txt".
+// 
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file 
+// except in compliance with the License. You may obtain a copy of the License at
+// 
+// http://www.apache.org/licenses/LICENSE-2.0
+// 
+// Unless required by applicable law or agreed to in writing, software distributed under the 
+// License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, 
+// either express or implied. See the License for the specific language governing permissions 
+// and limitations under the License.
+// 
+// ================================================================================================
+
+#include "flatmeshgeometry.h"
+
+#include "cgt/assert.h"
+#include "cgt/logmanager.h"
+#include "cgt/buffer.h"
+#include "cgt/vertexarrayobject.h"
+
+#include <tbb/tbb.h>
+
+#include "core/datastructures/facegeometry.h"
+#include "core/datastructures/meshgeometry.h"
+
+#include <algorithm>
+#include <list>
+#include <utility>
+
+namespace campvis {
+
+    const std::string FlatMeshGeometry::loggerCat_ = "CAMPVis.core.datastructures.FlatMeshGeometry";
+
+    namespace {
+        /// Minimum number of vertices processed by one TBB task, small meshes are processed serially.
+        const size_t VERTEX_GRAIN_SIZE = 4096;
+        /// Minimum number of faces processed by one TBB task.
+        const size_t FACE_GRAIN_SIZE = 256;
+
+        float distanceToPlane(const cgt::vec3& vertex, float p, const cgt::vec3& pNormal, float epsilon) {
+            float distance = cgt::dot(pNormal, vertex) - p;
+            if (std::abs(distance) <= epsilon)
+                return 0;
+            else
+                return distance;
+        }
+
+        /**
+         * Appends \a source to \a target if \a target holds one element for each of the 
+         * \a numVertices vertices preceding the new ones. Otherwise, the attribute is not 
+         * present for all vertices and \a target is cleared.
+         */
+        template<typename T>
+        void appendAttribute(std::vector<T>& target, const std::vector<T>& source, size_t numVertices, bool firstFace) {
+            if (! source.empty() && (firstFace || target.size() == numVertices))
+                target.insert(target.end(), source.begin(), source.end());
+            else
+                target.clear();
+        }
+
+        /**
+         * Uploads \a data into a newly created buffer object, if \a data is not empty.
+         */
+        template<typename T>
+        void createBuffer(cgt::BufferObject*& buffer, const std::vector<T>& data, cgt::BufferObject::BaseType baseType, size_t elementSize) {
+            if (! data.empty()) {
+                buffer = new cgt::BufferObject(cgt::BufferObject::ARRAY_BUFFER, cgt::BufferObject::USAGE_STATIC_DRAW);
+                buffer->data(&data.front(), data.size() * sizeof(T), baseType, elementSize);
+            }
+        }
+    }
+
+    FlatMeshGeometry::FlatMeshGeometry()
+        : GeometryData()
+        , _faceOffsets(1, 0)
+    {
+    }
+
+    FlatMeshGeometry::FlatMeshGeometry(const MeshGeometry& mesh)
+        : GeometryData()
+        , _faceOffsets(1, 0)
+    {
+        const std::vector<FaceGeometry>& faces = mesh.getFaces();
+        size_t numVertices = 0;
+        for (size_t i = 0; i < faces.size(); ++i)
+            numVertices += faces[i].size();
+
+        reserve(faces.size(), numVertices);
+        for (size_t i = 0; i < faces.size(); ++i)
+            addFace(faces[i]);
+    }
+
+    FlatMeshGeometry::FlatMeshGeometry(const std::vector<size_t>& faceOffsets, const std::vector<cgt::vec3>& vertices, const std::vector<cgt::vec3>& textureCoordinates /*= std::vector<cgt::vec3>()*/, const std::vector<cgt::vec4>& colors /*= std::vector<cgt::vec4>()*/, const std::vector<cgt::vec3>& normals /*= std::vector<cgt::vec3>()*/)
+        : GeometryData()
+        , _faceOffsets(faceOffsets)
+        , _vertices(vertices)
+        , _textureCoordinates(textureCoordinates)
+        , _colors(colors)
+        , _normals(normals)
+    {
+        cgtAssert(!faceOffsets.empty() && faceOffsets.front() == 0 && faceOffsets.back() == vertices.size(), "Face offsets must start with 0 and end with the number of vertices.");
+        cgtAssert(textureCoordinates.empty() || textureCoordinates.size() == vertices.size(), "Texture coordinates vector must be either empty or of the same size as the vertex vector.");
+        cgtAssert(colors.empty() || colors.size() == vertices.size(), "Colors vector must be either empty or of the same size as the vertex vector.");
+        cgtAssert(normals.empty() || normals.size() == vertices.size(), "Normals vector must be either empty or of the same size as the vertex vector.");
+    }
+
+    FlatMeshGeometry::~FlatMeshGeometry() {
+
+    }
+
+    FlatMeshGeometry* FlatMeshGeometry::clone() const {
+        return new FlatMeshGeometry(*this);
+    }
+
+    size_t FlatMeshGeometry::getLocalMemoryFootprint() const {
+        size_t sum = 0;
+        for (size_t i = 0; i < NUM_BUFFERS; ++i) {
+            if (_buffers[i] != nullptr)
+                sum += sizeof(cgt::BufferObject);
+        }
+
+        return sizeof(*this) + sum 
+            + (sizeof(size_t) * _faceOffsets.capacity())
+            + (sizeof(cgt::vec3) * (_vertices.capacity() + _textureCoordinates.capacity() + _normals.capacity())) 
+            + (sizeof(cgt::vec4) * _colors.capacity())
+            + (sizeof(cgt::col4) * _pickingInformation.capacity());
+    }
+
+    std::string FlatMeshGeometry::getTypeAsString() const {
+        return "Flat Mesh Geometry Data";
+    }
+
+    std::unique_ptr<MeshGeometry> FlatMeshGeometry::toMeshGeometry() const {
+        std::vector<FaceGeometry> faces;
+        faces.reserve(size());
+
+        for (size_t i = 0; i < size(); ++i) {
+            const size_t b = _faceOffsets[i];
+            const size_t e = _faceOffsets[i+1];
+
+            std::vector<cgt::vec3> verts(_vertices.begin() + b, _vertices.begin() + e);
+            std::vector<cgt::vec3> texCoords, norms;
+            std::vector<cgt::vec4> cols;
+            if (! _textureCoordinates.empty())
+                texCoords.assign(_textureCoordinates.begin() + b, _textureCoordinates.begin() + e);
+            if (! _colors.empty())
+                cols.assign(_colors.begin() + b, _colors.begin() + e);
+            if (! _normals.empty())
+                norms.assign(_normals.begin() + b, _normals.begin() + e);
+
+            faces.push_back(FaceGeometry(verts, texCoords, cols, norms));
+            if (! _pickingInformation.empty())
+                faces.back().setPickingInformation(std::vector<cgt::col4>(_pickingInformation.begin() + b, _pickingInformation.begin() + e));
+        }
+
+        return std::unique_ptr<MeshGeometry>(new MeshGeometry(faces));
+    }
+
+    void FlatMeshGeometry::clear() {
+        _faceOffsets.resize(1);
+        _vertices.clear();
+        _textureCoordinates.clear();
+        _colors.clear();
+        _normals.clear();
+        _pickingInformation.clear();
+        _buffersDirty = true;
+    }
+
+    void FlatMeshGeometry::reserve(size_t numFaces, size_t numVertices) {
+        _faceOffsets.reserve(numFaces + 1);
+        _vertices.reserve(numVertices);
+        _textureCoordinates.reserve(numVertices);
+        _colors.reserve(numVertices);
+        _normals.reserve(numVertices);
+        _pickingInformation.reserve(numVertices);
+    }
+
+    void FlatMeshGeometry::addFace(const std::vector<cgt::vec3>& vertices, const std::vector<cgt::vec3>& textureCoordinates /*= std::vector<cgt::vec3>()*/, const std::vector<cgt::vec4>& colors /*= std::vector<cgt::vec4>()*/, const std::vector<cgt::vec3>& normals /*= std::vector<cgt::vec3>()*/) {
+        cgtAssert(textureCoordinates.empty() || textureCoordinates.size() == vertices.size(), "Texture coordinates vector must be either empty or of the same size as the vertex vector.");
+        cgtAssert(colors.empty() || colors.size() == vertices.size(), "Colors vector must be either empty or of the same size as the vertex vector.");
+        cgtAssert(normals.empty() || normals.size() == vertices.size(), "Normals vector must be either empty or of the same size as the vertex vector.");
+
+        const bool firstFace = (size() == 0);
+        const size_t numVertices = _vertices.size();
+
+        appendAttribute(_textureCoordinates, textureCoordinates, numVertices, firstFace);
+        appendAttribute(_colors, colors, numVertices, firstFace);
+        appendAttribute(_normals, normals, numVertices, firstFace);
+        // picking information can only be set for the whole mesh
+        _pickingInformation.clear();
+
+        _vertices.insert(_vertices.end(), vertices.begin(), vertices.end());
+        _faceOffsets.push_back(_vertices.size());
+        _buffersDirty = true;
+    }
+
+    void FlatMeshGeometry::addFace(const FaceGeometry& face) {
+        const bool firstFace = (size() == 0);
+        const size_t numVertices = _vertices.size();
+
+        // keep the picking information of the previous faces, which addFace() resets
+        std::vector<cgt::col4> pickingInformation;
+        pickingInformation.swap(_pickingInformation);
+        addFace(face.getVertices(), face.getTextureCoordinates(), face.getColors(), face.getNormals());
+        pickingInformation.swap(_pickingInformation);
+        appendAttribute(_pickingInformation, face.getPickingInformation(), numVertices, firstFace);
+    }
+
+    size_t FlatMeshGeometry::size() const {
+        return _faceOffsets.size() - 1;
+    }
+
+    size_t FlatMeshGeometry::getNumVertices() const {
+        return _vertices.size();
+    }
+
+    const std::vector<size_t>& FlatMeshGeometry::getFaceOffsets() const {
+        return _faceOffsets;
+    }
+
+    const std::vector<cgt::vec3>& FlatMeshGeometry::getVertices() const {
+        return _vertices;
+    }
+
+    const std::vector<cgt::vec3>& FlatMeshGeometry::getTextureCoordinates() const {
+        return _textureCoordinates;
+    }
+
+    const std::vector<cgt::vec4>& FlatMeshGeometry::getColors() const {
+        return _colors;
+    }
+
+    const std::vector<cgt::vec3>& FlatMeshGeometry::getNormals() const {
+        return _normals;
+    }
+
+    const std::vector<cgt::col4>& FlatMeshGeometry::getPickingInformation() const {
+        return _pickingInformation;
+    }
+
+    void FlatMeshGeometry::setPickingInformation(const std::vector<cgt::col4>& pickingInformation) {
+        cgtAssert(pickingInformation.size() == 0 || pickingInformation.size() == _vertices.size(), "Number of picking informations does not match number of vertices!");
+        _pickingInformation = pickingInformation;
+        _buffersDirty = true;
+    }
+
+    void FlatMeshGeometry::clipAgainstPlane(float p, const cgt::vec3& normal, FlatMeshGeometry& output, bool close /*= true*/, float epsilon /*= 1e-4f*/) const {
+        cgtAssert(&output != this, "Cannot clip a FlatMeshGeometry in place.");
+        cgtAssert(epsilon >= 0, "Epsilon must be positive.");
+
+        const size_t numFaces = size();
+        const bool hasTexCoords = ! _textureCoordinates.empty();
+        const bool hasColors = ! _colors.empty();
+        const bool hasNormals = ! _normals.empty();
+        const bool hasPicking = ! _pickingInformation.empty();
+
+        // pass 1: signed distance of each vertex to the clip plane
+        std::vector<float> distances(_vertices.size());
+        tbb::parallel_for(tbb::blocked_range<size_t>(0, _vertices.size(), VERTEX_GRAIN_SIZE), [&] (const tbb::blocked_range<size_t>& range) {
+            for (size_t i = range.begin(); i != range.end(); ++i)
+                distances[i] = distanceToPlane(_vertices[i], p, normal, epsilon);
+        });
+
+        // pass 2: number of output vertices of each clipped face
+        std::vector<size_t> outputCounts(numFaces + 1, 0);
+        tbb::parallel_for(tbb::blocked_range<size_t>(0, numFaces, FACE_GRAIN_SIZE), [&] (const tbb::blocked_range<size_t>& range) {
+            for (size_t f = range.begin(); f != range.end(); ++f) {
+                const size_t b = _faceOffsets[f];
+                const size_t e = _faceOffsets[f+1];
+                if (b == e)
+                    continue;
+
+                size_t count = 0;
+                float lastDistance = distances[e - 1];
+                for (size_t i = b; i < e; ++i) {
+                    if ((lastDistance > 0) != (distances[i] > 0))
+                        ++count;
+                    if (distances[i] <= 0)
+                        ++count;
+                    lastDistance = distances[i];
+                }
+                outputCounts[f] = count;
+            }
+        });
+
+        // compute the output face offsets, faces which are clipped away entirely are dropped
+        output.clear();
+        std::vector<size_t> sourceFaces;
+        sourceFaces.reserve(numFaces);
+        size_t numOutputVertices = 0;
+        for (size_t f = 0; f < numFaces; ++f) {
+            if (outputCounts[f] > 0) {
+                sourceFaces.push_back(f);
+                numOutputVertices += outputCounts[f];
+                output._faceOffsets.push_back(numOutputVertices);
+            }
+        }
+
+        output._vertices.resize(numOutputVertices);
+        if (hasTexCoords)
+            output._textureCoordinates.resize(numOutputVertices);
+        if (hasColors)
+            output._colors.resize(numOutputVertices);
+        if (hasNormals)
+            output._normals.resize(numOutputVertices);
+        if (hasPicking)
+            output._pickingInformation.resize(numOutputVertices);
+
+        // pass 3: Sutherland-Hodgman polygon clipping of each face into its output range
+        tbb::parallel_for(tbb::blocked_range<size_t>(0, sourceFaces.size(), FACE_GRAIN_SIZE), [&] (const tbb::blocked_range<size_t>& range) {
+            for (size_t k = range.begin(); k != range.end(); ++k) {
+                const size_t b = _faceOffsets[sourceFaces[k]];
+                const size_t e = _faceOffsets[sourceFaces[k] + 1];
+                size_t o = output._faceOffsets[k];
+                size_t lastIndex = e - 1;
+                float lastDistance = distances[lastIndex];
+
+                for (size_t i = b; i < e; ++i) {
+                    const float currentDistance = distances[i];
+
+                    // case 1: last vertex outside, this vertex inside clip region => clip
+                    // case 2: last vertex inside, this vertex outside clip region => clip
+                    if ((lastDistance > 0) != (currentDistance > 0)) {
+                        float t = lastDistance / (lastDistance - currentDistance);
+
+                        output._vertices[o] = cgt::mix(_vertices[lastIndex], _vertices[i], t);
+                        if (hasTexCoords)
+                            output._textureCoordinates[o] = cgt::mix(_textureCoordinates[lastIndex], _textureCoordinates[i], t);
+                        if (hasColors)
+                            output._colors[o] = cgt::mix(_colors[lastIndex], _colors[i], t);
+                        if (hasNormals)
+                            output._normals[o] = cgt::mix(_normals[lastIndex], _normals[i], t);
+                        if (hasPicking)
+                            output._pickingInformation[o] = _pickingInformation[(lastDistance > 0) ? i : lastIndex];
+                        ++o;
+                    }
+
+                    // case 1.2 + case 3: current vertix in front of plane => keep
+                    if (currentDistance <= 0) {
+                        output._vertices[o] = _vertices[i];
+                        if (hasTexCoords)
+                            output._textureCoordinates[o] = _textureCoordinates[i];
+                        if (hasColors)
+                            output._colors[o] = _colors[i];
+                        if (hasNormals)
+                            output._normals[o] = _normals[i];
+                        if (hasPicking)
+                            output._pickingInformation[o] = _pickingInformation[i];
+                        ++o;
+                    }
+
+                    lastIndex = i;
+                    lastDistance = currentDistance;
+                }
+            }
+        });
+
+        if (close)
+            closeClippedMesh(p, normal, output, epsilon);
+    }
+
+    FlatMeshGeometry FlatMeshGeometry::clipAgainstPlane(float p, const cgt::vec3& normal, bool close /*= true*/, float epsilon /*= 1e-4f*/) const {
+        FlatMeshGeometry toReturn;
+        clipAgainstPlane(p, normal, toReturn, close, epsilon);
+        return toReturn;
+    }
+
+    void FlatMeshGeometry::closeClippedMesh(float p, const cgt::vec3& normal, FlatMeshGeometry& output, float epsilon) {
+        typedef std::pair<size_t, size_t> Edge;
+        std::list<Edge> unsortedEdges;
+        std::list<size_t> sortedVertices;
+        const std::vector<cgt::vec3>& verts = output._vertices;
+
+        // find all edges lying on clip plane
+        for (size_t f = 0; f < output.size(); ++f) {
+            const size_t b = output._faceOffsets[f];
+            const size_t n = output._faceOffsets[f+1] - b;
+            for (size_t j = 0; j < n; ++j) {
+                if (    distanceToPlane(verts[b + j], p, normal, epsilon) == 0
+                     && distanceToPlane(verts[b + (j+1) % n], p, normal, epsilon) == 0)
+                {
+                    unsortedEdges.push_back(std::make_pair(b + j, b + (j+1) % n));
+                    ++j;
+                }
+            }
+        }
+
+        if (unsortedEdges.empty())
+            return;
+
+        // sort edges into sortedVertices list
+        auto equals = [&] (size_t left, size_t right) -> bool {
+            return cgt::distance(verts[left], verts[right]) < epsilon;
+        };
+
+        sortedVertices.push_back(unsortedEdges.front().second);
+        unsortedEdges.pop_front();
+        while (! unsortedEdges.empty()) {
+            bool didWork = false;
+
+            // look for the edge that has one vertex in common with the last added sorted vertex
+            for (std::list<Edge>::iterator it = unsortedEdges.begin(); it != unsortedEdges.end(); ++it) {
+                if (equals(sortedVertices.back(), it->first)) {
+                    sortedVertices.push_back(it->second);
+                    unsortedEdges.erase(it);
+                    didWork = true;
+                    break;
+                }
+                if (equals(sortedVertices.back(), it->second)) {
+                    sortedVertices.push_back(it->first);
+                    unsortedEdges.erase(it);
+                    didWork = true;
+                    break;
+                }
+            }
+
+            // emergency break...
+            if (! didWork)
+                break;
+        }
+
+        if (sortedVertices.size() > 2) {
+            // make face ccw
+            cgt::vec3 closingFaceNormal = cgt::normalize(cgt::cross(verts[sortedVertices.front()], verts[*(++sortedVertices.begin())]));
+
+            if (cgt::dot(normal, closingFaceNormal) < 0)
+                std::reverse(sortedVertices.begin(), sortedVertices.end());
+        }
+
+        // build face by appending the referenced vertices, the attribute arrays already are of the correct size
+        for (std::list<size_t>::iterator it = sortedVertices.begin(); it != sortedVertices.end(); ++it) {
+            output._vertices.push_back(output._vertices[*it]);
+            if (! output._textureCoordinates.empty())
+                output._textureCoordinates.push_back(output._textureCoordinates[*it]);
+            if (! output._colors.empty())
+                output._colors.push_back(output._colors[*it]);
+            if (! output._normals.empty())
+                output._normals.push_back(output._normals[*it]);
+            if (! output._pickingInformation.empty())
+                output._pickingInformation.push_back(output._pickingInformation[*it]);
+        }
+        output._faceOffsets.push_back(output._vertices.size());
+    }
+
+    void FlatMeshGeometry::render(GLenum mode) const {
+        if (_vertices.empty())
+            return;
+
+        createGLBuffers();
+        if (_buffersDirty) {
+            LERROR("Cannot render without initialized OpenGL buffers.");
+            return;
+        }
+
+        cgt::VertexArrayObject vao;
+        if (_verticesBuffer)
+            vao.setVertexAttributePointer(0, _verticesBuffer);
+        if (_texCoordsBuffer)
+            vao.setVertexAttributePointer(1, _texCoordsBuffer);
+        if (_colorsBuffer)
+            vao.setVertexAttributePointer(2, _colorsBuffer);
+        if (_normalsBuffer)
+            vao.setVertexAttributePointer(3, _normalsBuffer);
+        if (_pickingBuffer)
+            vao.setVertexAttributePointer(4, _pickingBuffer);
+        LGL_ERROR;
+
+        for (size_t i = 0; i < size(); ++i) {
+            GLint startIndex = static_cast<GLint>(_faceOffsets[i]);
+            GLsizei numVertices = static_cast<GLsizei>(_faceOffsets[i+1] - _faceOffsets[i]);
+            if (numVertices > 2)
+                glDrawArrays(mode, startIndex, numVertices);
+            else
+                glDrawArrays(GL_LINES, startIndex, numVertices);
+        }
+        LGL_ERROR;
+    }
+
+    void FlatMeshGeometry::createGLBuffers() const {
+        if (_buffersDirty) {
+            deleteBuffers();
+
+            try {
+                createBuffer(_verticesBuffer, _vertices, cgt::BufferObject::FLOAT, 3);
+                createBuffer(_texCoordsBuffer, _textureCoordinates, cgt::BufferObject::FLOAT, 3);
+                createBuffer(_colorsBuffer, _colors, cgt::BufferObject::FLOAT, 4);
+                createBuffer(_normalsBuffer, _normals, cgt::BufferObject::FLOAT, 3);
+                createBuffer(_pickingBuffer, _pickingInformation, cgt::BufferObject::UNSIGNED_BYTE, 4);
+            }
+            catch (cgt::Exception& e) {
+                LERROR("Error creating OpenGL Buffer objects: " << e.what());
+                _buffersDirty = true;
+                return;
+            }
+
+            LGL_ERROR;
+            _buffersDirty = false;
+        }
+    }
+
+    cgt::Bounds FlatMeshGeometry::getWorldBounds() const {
+        return tbb::parallel_reduce(
+            tbb::blocked_range<size_t>(0, _vertices.size(), VERTEX_GRAIN_SIZE), 
+            cgt::Bounds(),
+            [&] (const tbb::blocked_range<size_t>& range, cgt::Bounds bounds) -> cgt::Bounds {
+                for (size_t i = range.begin(); i != range.end(); ++i)
+                    bounds.addPoint(_vertices[i]);
+                return bounds;
+            },
+            [] (cgt::Bounds lhs, const cgt::Bounds& rhs) -> cgt::Bounds {
+                if (rhs.isDefined() || rhs.onlyPoint())
+                    lhs.addVolume(rhs);
+                return lhs;
+            });
+    }
+
+    bool FlatMeshGeometry::hasTextureCoordinates() const {
+        return ! _textureCoordinates.empty();
+    }
+
+    bool FlatMeshGeometry::hasPickingInformation() const {
+        return ! _pickingInformation.empty();
+    }
+
+    void FlatMeshGeometry::applyTransformationToVertices(const cgt::mat4& t) {
+        tbb::parallel_for(tbb::blocked_range<size_t>(0, _vertices.size(), VERTEX_GRAIN_SIZE), [&] (const tbb::blocked_range<size_t>& range) {
+            for (size_t i = range.begin(); i != range.end(); ++i) {
+                cgt::vec4 tmp = t * cgt::vec4(_vertices[i], 1.f);
+                _vertices[i] = tmp.xyz() / tmp.w;
+            }
+        });
+
+        _buffersDirty = true;
+    }
+
+}
@@ -0,0 +1,237 @@
+// ================================================================================================
+// 
+// This file is part of the CAMPVis Software Framework.
+// 
+// If not explicitly stated otherwise: Copyright (C) 2012-2015, all rights reserved,
+//      Christian Schulte zu Berge <christian.szb@in.tum.de>
+//      Chair for Computer Aided Medical Procedures
+//      Technische Universitaet Muenchen
+//      Boltzmannstr. 3, 85748 Garching b. Muenchen, Germany
+// 
+// For a full list of authors and contributors, please refer to the file "AUTHORS.txt".
+// 
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file 
+// except in compliance with the License. You may obtain a copy of the License at
+// 
+// http://www.apache.org/licenses/LICENSE-2.0
+// 
+// Unless required by applicable law or agreed to in writing, software distributed under the 
+// License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, 
+// either express or implied. See the License for the specific language governing permissions 
+// and limitations under the License.
+// 
+// ================================================================================================
+
+
+#ifndef FLATMESHGEOMETRY_H__
+#define FLATMESHGEOMETRY_H__
+
+#include "cgt/bounds.h"
+#include "cgt/vector.h"
+#include "core/datastructures/geometrydata.h"
+
+#include <memory>
+#include <vector>
+
+namespace campvis {
+    class FaceGeometry;
+    class MeshGeometry;
+
+    /**
+     * Class for mesh geometry stored in flat, contiguous arrays.
+     * 
+     * In contrast to MeshGeometry, which stores a list of FaceGeometry objects each owning its 
+     * own vertex attribute arrays, FlatMeshGeometry stores the vertex attributes of all faces in 
+     * one array per attribute. The vertices of face i are [_faceOffsets[i], _faceOffsets[i+1]).
+     * Each vertex attribute is either present for all vertices or empty.
+     * 
+     * This allows clipping, transforming and computing the bounds of the mesh as parallel 
+     * operations over the plain arrays, and uploading each attribute to OpenGL in a single call.
+     * 
+     * The internal OpenGL buffers are lazy-instantiated.
+     */
+    class CAMPVIS_CORE_API FlatMeshGeometry : public GeometryData {
+    public:
+        /**
+         * Creates a new empty FlatMeshGeometry.
+         */
+        FlatMeshGeometry();
+
+        /**
+         * Creates a new FlatMeshGeometry from the faces of the given MeshGeometry.
+         * Vertex attributes that are not present in all faces are dropped.
+         * \param   mesh    MeshGeometry to convert
+         */
+        explicit FlatMeshGeometry(const MeshGeometry& mesh);
+
+        /**
+         * Creates a new FlatMeshGeometry from the given flat vertex attribute arrays.
+         * \param   faceOffsets         Offsets of the faces into the vertex arrays, starting with 0 and ending with vertices.size().
+         * \param   vertices            The list of the vertex positions of all faces.
+         * \param   textureCoordinates  The list of vertex texture coordinates, may be empty.
+         * \param   colors              The list of vertex colors, may be empty.
+         * \param   normals             The list of vertex normals, may be empty.
+         */
+        FlatMeshGeometry(
+            const std::vector<size_t>& faceOffsets,
+            const std::vector<cgt::vec3>& vertices,
+            const std::vector<cgt::vec3>& textureCoordinates = std::vector<cgt::vec3>(),
+            const std::vector<cgt::vec4>& colors = std::vector<cgt::vec4>(),
+            const std::vector<cgt::vec3>& normals = std::vector<cgt::vec3>());
+
+        /**
+         * Destructor, deletes VBOs/VAO if necessary. Hence, needs a valid OpenGL context
+         */
+        virtual ~FlatMeshGeometry();
+
+        /// \see AbstractData::clone()
+        virtual FlatMeshGeometry* clone() const;
+        /// \see AbstractData::getLocalMemoryFootprint()
+        virtual size_t getLocalMemoryFootprint() const;
+        /// \see AbstractData::getTypeAsString()
+        virtual std::string getTypeAsString() const;
+
+        /**
+         * Converts this mesh into a MeshGeometry.
+         * \return  A MeshGeometry with one FaceGeometry per face of this mesh.
+         */
+        std::unique_ptr<MeshGeometry> toMeshGeometry() const;
+
+        /**
+         * Removes all faces, keeps the allocated memory.
+         */
+        void clear();
+
+        /**
+         * Reserves memory for the given number of faces and vertices.
+         * \param   numFaces    Number of faces to reserve memory for
+         * \param   numVertices Total number of vertices to reserve memory for
+         */
+        void reserve(size_t numFaces, size_t numVertices);
+
+        /**
+         * Appends a face to this mesh.
+         * The optional attributes must be given consistently for all faces of the mesh.
+         * \param   vertices            The list of the vertex positions of the face.
+         * \param   textureCoordinates  The list of vertex texture coordinates, may be empty.
+         * \param   colors              The list of vertex colors, may be empty.
+         * \param   normals             The list of vertex normals, may be empty.
+         */
+        void addFace(
+            const std::vector<cgt::vec3>& vertices,
+            const std::vector<cgt::vec3>& textureCoordinates = std::vector<cgt::vec3>(),
+            const std::vector<cgt::vec4>& colors = std::vector<cgt::vec4>(),
+            const std::vector<cgt::vec3>& normals = std::vector<cgt::vec3>());
+
+        /**
+         * Appends a face to this mesh.
+         * \param   face    The face to append.
+         */
+        void addFace(const FaceGeometry& face);
+
+        /**
+         * Returns the number of faces of this mesh.
+         * \return _faceOffsets.size() - 1
+         */
+        size_t size() const;
+
+        /**
+         * Returns the total number of vertices of this mesh.
+         * \return _vertices.size()
+         */
+        size_t getNumVertices() const;
+
+        /**
+         * Returns the offsets of the faces into the vertex arrays, has size() + 1 elements.
+         * \return  _faceOffsets
+         */
+        const std::vector<size_t>& getFaceOffsets() const;
+
+        /// Returns the vertex positions of all faces.
+        const std::vector<cgt::vec3>& getVertices() const;
+        /// Returns the vertex texture coordinates of all faces, may be empty.
+        const std::vector<cgt::vec3>& getTextureCoordinates() const;
+        /// Returns the vertex colors of all faces, may be empty.
+        const std::vector<cgt::vec4>& getColors() const;
+        /// Returns the vertex normals of all faces, may be empty.
+        const std::vector<cgt::vec3>& getNormals() const;
+        /// Returns the vertex picking information of all faces, may be empty.
+        const std::vector<cgt::col4>& getPickingInformation() const;
+
+        /**
+         * Sets the picking information of all vertices.
+         * \param   pickingInformation  Picking information, must be empty or have one entry per vertex.
+         */
+        void setPickingInformation(const std::vector<cgt::col4>& pickingInformation);
+
+        /**
+         * Clips this FlatMeshGeometry against an aribtrary clip plane and writes the result into 
+         * \a output, reusing its memory.
+         * The faces are clipped in parallel using Sutherland-Hodgman polygon clipping.
+         * \note    When clipping against one of the faces of this mesh, the mesh closing 
+         *          algorithm might fail and return an invalid mesh!
+         * \param   p       Point on clip plane
+         * \param   normal  Clip plane normal
+         * \param   output  FlatMeshGeometry receiving the clipped mesh, must not be this.
+         * \param   close   Flag, whether the returned mesh shall be closed. 
+         *                  If true, the closing face will be the last one in the returned mesh.
+         * \param   epsilon Clipping precision
+         */
+        void clipAgainstPlane(float p, const cgt::vec3& normal, FlatMeshGeometry& output, bool close = true, float epsilon = 1e-4f) const;
+
+        /**
+         * Clips this FlatMeshGeometry against an aribtrary clip plane.
+         * \see     clipAgainstPlane(float, const cgt::vec3&, FlatMeshGeometry&, bool, float)
+         * \param   p       Point on clip plane
+         * \param   normal  Clip plane normal
+         * \param   close   Flag, whether the returned mesh shall be closed. 
+         * \param   epsilon Clipping precision
+         * \return  The clipped FlatMeshGeometry
+         */
+        FlatMeshGeometry clipAgainstPlane(float p, const cgt::vec3& normal, bool close = true, float epsilon = 1e-4f) const;
+
+        /**
+         * Renders this FlatMeshGeometry.
+         * Must be called from a valid OpenGL context.
+         * \param   mode    OpenGL rendering mode for this mesh
+         */
+        virtual void render(GLenum mode) const;
+
+        /// \see GeometryData::getWorldBounds
+        virtual cgt::Bounds getWorldBounds() const;
+        /// \see GeometryData::hasTextureCoordinates
+        virtual bool hasTextureCoordinates() const;
+        /// \see GeometryData::hasPickingInformation
+        virtual bool hasPickingInformation() const;
+        /// \see GeometryData::applyTransformationToVertices
+        virtual void applyTransformationToVertices(const cgt::mat4& t);
+
+    protected:
+        /**
+         * Creates the OpenGL VBOs and the VAO for this mesh's geometry.
+         * Must be called from a valid OpenGL context.
+         */
+        void createGLBuffers() const;
+
+        /**
+         * Appends the face closing the clipped mesh \a output to \a output.
+         * \param   p       Point on clip plane
+         * \param   normal  Clip plane normal
+         * \param   output  Clipped mesh
+         * \param   epsilon Clipping precision
+         */
+        static void closeClippedMesh(float p, const cgt::vec3& normal, FlatMeshGeometry& output, float epsilon);
+
+        std::vector<size_t> _faceOffsets;               ///< Offsets of the faces into the vertex arrays, size() + 1 elements
+        std::vector<cgt::vec3> _vertices;               ///< Vertex positions of all faces
+        std::vector<cgt::vec3> _textureCoordinates;     ///< Vertex texture coordinates of all faces, may be empty
+        std::vector<cgt::vec4> _colors;                 ///< Vertex colors of all faces, may be empty
+        std::vector<cgt::vec3> _normals;                ///< Vertex normals of all faces, may be empty
+        std::vector<cgt::col4> _pickingInformation;     ///< Vertex picking information of all faces, may be empty
+
+        static const std::string loggerCat_;
+    };
+
+}
+
+#endif // FLATMESHGEOMETRY_H__
@@ -28,7 +28,10 @@
 #include "core/datastructures/imagerepresentationlocal.h"
 #include "core/tools/typetraits.h"
 
+#include <tbb/mutex.h>
+
 #include <cstring>  // needed for memcpy
+#include <memory>
 
 namespace campvis {
 
@@ -162,6 +165,24 @@ namespace campvis {
          */
         static GenericImageRepresentationLocal<BASETYPE, NUMCHANNELS>* create(const ImageData* parent, ElementType* data);
 
+        /**
+         * Creates a new GenericImageRepresentationLocal wrapping memory owned by someone else and 
+         * automatically adds it to \a parent which will take ownerwhip.
+         * 
+         * The representation does \b not take ownership of \a data, instead it keeps \a dataOwner
+         * alive for its own lifetime. Use this to wrap memory-mapped files or buffers of other 
+         * libraries without copying them. As long as somebody else shares \a dataOwner, the data 
+         * is treated as read-only and copied before the first write access.
+         *
+         * \note    You do \b not own the returned pointer.
+         *
+         * \param   parent      Image this representation represents, must not be 0, will take ownership of the returned pointer.
+         * \param   data        Pointer to the image data, must not be 0, must stay valid as long as \a dataOwner is alive.
+         * \param   dataOwner   Object owning the memory pointed to by \a data, must not be 0.
+         * \return  A pointer to the newly created GenericImageRepresentationLocal, you do \b not own this pointer!
+         */
+        static GenericImageRepresentationLocal<BASETYPE, NUMCHANNELS>* create(const ImageData* parent, ElementType* data, std::shared_ptr<void> dataOwner);
+
         /**
          * Destructor
          */
@@ -244,6 +265,8 @@ namespace campvis {
 
         /**
          * Returns a pointer to the image data.
+         * \note    If the image data may be shared with someone else (see getDataOwner()), call 
+         *          ensureUnique() before writing to it.
          * \return  _data
          */
         ElementType* getImageData();
@@ -254,6 +277,28 @@ namespace campvis {
          */
         const ElementType* getImageData() const;
 
+        /**
+         * Returns shared ownership of the memory pointed to by getImageData().
+         * Use this to hand the image data to other libraries without copying it: As long as the 
+         * returned pointer is alive, the memory stays valid, even beyond the lifetime of this
+         * representation. Writers of this representation have to call ensureUnique() first, so
+         * that the other side is never affected.
+         * \note    The other side must not write to the shared memory.
+         * \return  _dataOwner
+         */
+        std::shared_ptr<void> getDataOwner() const;
+
+        /**
+         * Makes sure that nobody else shares the memory of the image data by copying it if 
+         * necessary (copy-on-write). Call this once before writing to a representation whose data
+         * may have been shared via getDataOwner(), e.g. before a parallel loop calling setElement().
+         * The element accessors never reallocate the image data themselves.
+         * \note    Thread-safe, concurrent callers wait until the data has been copied. However,
+         *          the data is replaced, hence pointers obtained by getImageData() before are 
+         *          no longer valid for writing.
+         */
+        void ensureUnique();
+
 
         /**
          * Returns the image element at the given coordinates \a position using bi-/trilinear filtering.
@@ -267,11 +312,14 @@ namespace campvis {
          * Creates a new strongly typed ImageData object storing the image in the local memory.
          * 
          * \param   parent  Image this representation represents, must not be 0.
-         * \param   data    Pointer to the image data, must not be 0, GenericImageRepresentationLocal takes ownership of this pointer!
+         * \param   data        Pointer to the image data, GenericImageRepresentationLocal takes ownership of this pointer unless \a dataOwner is given!
+         * \param   dataOwner   Optional object owning the memory of \a data, if 0 this representation takes ownership of \a data.
          */
-        GenericImageRepresentationLocal(ImageData* parent, ElementType* data);
+        GenericImageRepresentationLocal(ImageData* parent, ElementType* data, std::shared_ptr<void> dataOwner = nullptr);
 
-        ElementType* _data;
+        ElementType* _data;                     ///< Pointer to the image data
+        std::shared_ptr<void> _dataOwner;       ///< Owner of the memory of _data, either this representation or someone else
+        mutable tbb::mutex _ownerMutex;         ///< Mutex protecting _dataOwner and the replacement of _data
 
         static const std::string loggerCat_;
 
@@ -290,9 +338,18 @@ namespace campvis {
     }
 
     template<typename BASETYPE, size_t NUMCHANNELS>
-    campvis::GenericImageRepresentationLocal<BASETYPE, NUMCHANNELS>::GenericImageRepresentationLocal(ImageData* parent, ElementType* data)
+    campvis::GenericImageRepresentationLocal<BASETYPE, NUMCHANNELS>* campvis::GenericImageRepresentationLocal<BASETYPE, NUMCHANNELS>::create(const ImageData* parent, ElementType* data, std::shared_ptr<void> dataOwner) {
+        cgtAssert(data != 0 && dataOwner != nullptr, "Wrapping foreign memory requires both the data and its owner.");
+        ThisType* toReturn = new ThisType(const_cast<ImageData*>(parent), data, dataOwner);
+        toReturn->addToParent();
+        return toReturn;
+    }
+
+    template<typename BASETYPE, size_t NUMCHANNELS>
+    campvis::GenericImageRepresentationLocal<BASETYPE, NUMCHANNELS>::GenericImageRepresentationLocal(ImageData* parent, ElementType* data, std::shared_ptr<void> dataOwner)
         : ImageRepresentationLocal(parent, TypeTraits<BASETYPE, NUMCHANNELS>::weaklyTypedPointerBaseType)
         , _data(data)
+        , _dataOwner(dataOwner)
     {
         cgtAssert(_parent->getNumChannels() == NUMCHANNELS, "Number of channels must match parent image's number of channels!");
         if (_data == 0) {
@@ -300,11 +357,15 @@ namespace campvis {
             _data = new ElementType[numElements];
             memset(_data, 0, numElements * TypeTraits<BASETYPE, NUMCHANNELS>::elementSize);
         }
+
+        // manage our own memory through a shared pointer as well, so that it can be shared with others
+        if (_dataOwner == nullptr)
+            _dataOwner = std::shared_ptr<ElementType>(_data, std::default_delete<ElementType[]>());
     }
 
     template<typename BASETYPE, size_t NUMCHANNELS>
     campvis::GenericImageRepresentationLocal<BASETYPE, NUMCHANNELS>::~GenericImageRepresentationLocal() {
-        delete [] _data;
+        // _dataOwner releases the memory once nobody else shares it anymore
     }
 
     template<typename BASETYPE, size_t NUMCHANNELS>
@@ -397,6 +458,25 @@ namespace campvis {
         return _data;
     }
 
+    template<typename BASETYPE, size_t NUMCHANNELS>
+    std::shared_ptr<void> campvis::GenericImageRepresentationLocal<BASETYPE, NUMCHANNELS>::getDataOwner() const {
+        tbb::mutex::scoped_lock lock(_ownerMutex);
+        return _dataOwner;
+    }
+
+    template<typename BASETYPE, size_t NUMCHANNELS>
+    void campvis::GenericImageRepresentationLocal<BASETYPE, NUMCHANNELS>::ensureUnique() {
+        tbb::mutex::scoped_lock lock(_ownerMutex);
+        if (_dataOwner.use_count() > 1) {
+            size_t numElements = getNumElements();
+            ElementType* newData = new ElementType[numElements];
+            memcpy(newData, _data, numElements * sizeof(ElementType));
+
+            _data = newData;
+            _dataOwner = std::shared_ptr<ElementType>(_data, std::default_delete<ElementType[]>());
+        }
+    }
+
     template<typename BASETYPE, size_t NUMCHANNELS>
     typename campvis::GenericImageRepresentationLocal<BASETYPE, NUMCHANNELS>::ElementType campvis::GenericImageRepresentationLocal<BASETYPE, NUMCHANNELS>::getElementLinear(const cgt::vec3 position) const {
         ElementType toReturn;
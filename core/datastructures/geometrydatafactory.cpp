@@ -77,8 +77,8 @@ namespace campvis {
         // For each horizontal stripe, construct the indeces for triangle strips
         int verticesPerStrip = (xSegments + 1) * 2;
         for (int y = 0; y < ySegments; ++y) {
-            std::vector<uint16_t> indices(verticesPerStrip);
-            for (uint16_t x = 0; x <= xSegments; ++x) {
+            std::vector<uint32_t> indices(verticesPerStrip);
+            for (int x = 0; x <= xSegments; ++x) {
                 indices[x*2 + 0] = (y + 0) * (xSegments + 1) + x;
                 indices[x*2 + 1] = (y + 1) * (xSegments + 1) + x;
             }
@@ -181,6 +181,41 @@ namespace campvis {
         return std::unique_ptr<MeshGeometry>(new MeshGeometry(faces));
     }
 
+    std::unique_ptr<FlatMeshGeometry> GeometryDataFactory::createFlatCube(const cgt::Bounds& bounds, const cgt::Bounds& texBounds) {
+        // cube corners are indexed by bit 0: x, bit 1: y, bit 2: z, with 0 denoting llf and 1 denoting urb
+        static const int faceCorners[6][4] = {
+            { 2, 3, 1, 0 },     // front
+            { 3, 7, 5, 1 },     // right
+            { 6, 7, 3, 2 },     // top
+            { 6, 2, 0, 4 },     // left
+            { 0, 1, 5, 4 },     // bottom
+            { 7, 6, 4, 5 }      // back
+        };
+        static const cgt::vec3 faceNormals[6] = {
+            cgt::vec3(0.f, 0.f, -1.f), cgt::vec3(1.f, 0.f, 0.f), cgt::vec3(0.f, 1.f, 0.f), 
+            cgt::vec3(-1.f, 0.f, 0.f), cgt::vec3(0.f, -1.f, 0.f), cgt::vec3(0.f, 0.f, 1.f)
+        };
+
+        const cgt::vec3 llf = bounds.getLLF();
+        const cgt::vec3 urb = bounds.getURB();
+        const cgt::vec3 tLlf = texBounds.getLLF();
+        const cgt::vec3 tUrb = texBounds.getURB();
+
+        std::vector<size_t> faceOffsets(7);
+        std::vector<cgt::vec3> vertices(24), texCoords(24), normals(24);
+        for (size_t f = 0; f < 6; ++f) {
+            faceOffsets[f + 1] = 4 * (f + 1);
+            for (size_t i = 0; i < 4; ++i) {
+                const int c = faceCorners[f][i];
+                vertices[4*f + i]  = cgt::vec3((c & 1) ? urb.x : llf.x, (c & 2) ? urb.y : llf.y, (c & 4) ? urb.z : llf.z);
+                texCoords[4*f + i] = cgt::vec3((c & 1) ? tUrb.x : tLlf.x, (c & 2) ? tUrb.y : tLlf.y, (c & 4) ? tUrb.z : tLlf.z);
+                normals[4*f + i]   = faceNormals[f];
+            }
+        }
+
+        return std::unique_ptr<FlatMeshGeometry>(new FlatMeshGeometry(faceOffsets, vertices, texCoords, std::vector<cgt::vec4>(), normals));
+    }
+
     std::unique_ptr<MultiIndexedGeometry> GeometryDataFactory::createTeapot() {
         std::vector<cgt::vec3> vertices, normals;
         vertices.reserve(Teapot::num_teapot_vertices);
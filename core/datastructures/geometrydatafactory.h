@@ -30,6 +30,7 @@
 
 #include "core/datastructures/geometrydata.h"
 #include "core/datastructures/facegeometry.h"
+#include "core/datastructures/flatmeshgeometry.h"
 #include "core/datastructures/meshgeometry.h"
 #include "core/datastructures/multiindexedgeometry.h"
 
@@ -73,6 +74,15 @@ namespace campvis {
          */
         static std::unique_ptr<MeshGeometry> createCube(const cgt::Bounds& bounds, const cgt::Bounds& texBounds);
 
+        /**
+         * Creates a FlatMeshGeometry building a cube with the given bounds and texture coordinates.
+         * Produces the same faces as createCube(), but allocates only one array per vertex attribute.
+         * \param   bounds      coordinates of the cube bounds
+         * \param   texBounds   texture coordinates at the cube bounds
+         * \return  A FlatMeshGeometry building a cube with the given bounds and texture coordinates.
+         */
+        static std::unique_ptr<FlatMeshGeometry> createFlatCube(const cgt::Bounds& bounds, const cgt::Bounds& texBounds);
+
         /**
          * Creates an MultiIndexedGeometry storing the famous Utah teapot.
          * \return  MultiIndexedGeometry storing the famous Utah teapot.
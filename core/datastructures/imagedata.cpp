@@ -24,6 +24,12 @@
 
 #include "imagedata.h"
 
+#include "cgt/opengljobprocessor.h"
+
+#include "core/datastructures/imagerepresentationdisk.h"
+#include "core/datastructures/imagerepresentationlocal.h"
+#include "core/tools/concurrenthistogram.h"
+
 namespace campvis {
     const std::string ImageData::loggerCat_ = "CAMPVis.core.datastructures.ImageData";
 
@@ -48,6 +54,10 @@ namespace campvis {
         for (auto it = this->_representations.begin(); it != this->_representations.end(); ++it) {
             (*it)->clone(toReturn);
         }
+
+        // the histogram depends only on the image data, hence the clone can share it
+        tbb::spin_mutex::scoped_lock lock(_histogramMutex);
+        toReturn->_nativeHistogram = _nativeHistogram;
         return toReturn;
     }
 
@@ -56,6 +66,10 @@ namespace campvis {
         for (tbb::concurrent_vector<const AbstractImageRepresentation*>::const_iterator it = _representations.begin(); it != _representations.end(); ++it)
             toReturn += (*it)->getLocalMemoryFootprint();
 
+        tbb::spin_mutex::scoped_lock lock(_histogramMutex);
+        if (_nativeHistogram != nullptr)
+            toReturn += sizeof(*_nativeHistogram) + (_nativeHistogram->getNumBuckets(0) + 1) * sizeof(size_t);
+
         return toReturn;
     }
 
@@ -115,11 +129,82 @@ namespace campvis {
     }
 
     void ImageData::clearRepresentations() {
-        for (tbb::concurrent_vector<const AbstractImageRepresentation*>::iterator it = _representations.begin(); it != _representations.end(); ++it)
+        // delete in reverse order, so that converted representations go before the ones they were created from
+        for (tbb::concurrent_vector<const AbstractImageRepresentation*>::reverse_iterator it = _representations.rbegin(); it != _representations.rend(); ++it)
             delete *it;
         _representations.clear();
     }
 
+    size_t ImageData::releaseSecondaryRepresentations() const {
+        tbb::mutex::scoped_lock lock(_conversionMutex);
+        if (_representations.size() <= 1)
+            return 0;
+
+        const AbstractImageRepresentation* primary = _representations.front();
+        for (auto it = _representations.begin(); it != _representations.end(); ++it) {
+            if (dynamic_cast<const ImageRepresentationDisk*>(*it) != 0) {
+                primary = *it;
+                break;
+            }
+        }
+
+        return removeRepresentationsExcept(primary);
+    }
+
+    const ImageRepresentationDisk* ImageData::createScratchRepresentation(const std::string& directory /*= ""*/) const {
+        const ImageRepresentationDisk* disk = getRepresentation<ImageRepresentationDisk>(false);
+        if (disk != 0)
+            return disk;
+
+        // getRepresentation() only locks _conversionMutex for the conversion itself, the scratch 
+        // file is written without holding it
+        const ImageRepresentationLocal* local = getRepresentation<ImageRepresentationLocal>();
+        if (local == 0)
+            return 0;
+
+        return ImageRepresentationDisk::createScratchCopy(local, directory);
+    }
+
+    size_t ImageData::spillToDisk(const std::string& directory /*= ""*/) const {
+        const ImageRepresentationDisk* disk = createScratchRepresentation(directory);
+        if (disk == 0)
+            return 0;
+
+        tbb::mutex::scoped_lock lock(_conversionMutex);
+        LDEBUG("Spilled image data to scratch file.");
+        return removeRepresentationsExcept(disk);
+    }
+
+    size_t ImageData::removeRepresentationsExcept(const AbstractImageRepresentation* representation) const {
+        size_t toReturn = 0;
+        bool hasVideoMemory = false;
+        std::vector<const AbstractImageRepresentation*> toDelete;
+
+        for (auto it = _representations.begin(); it != _representations.end(); ++it) {
+            if (*it != representation) {
+                toReturn += (*it)->getLocalMemoryFootprint() + (*it)->getVideoMemoryFootprint();
+                hasVideoMemory |= ((*it)->getVideoMemoryFootprint() > 0);
+                toDelete.push_back(*it);
+            }
+        }
+
+        _representations.clear();
+        _representations.push_back(representation);
+
+        // OpenGL representations need a valid context for deletion
+        if (hasVideoMemory) {
+            cgt::OpenGLJobProcessor::ScopedSynchronousGlJobExecution jobGuard;
+            for (auto it = toDelete.rbegin(); it != toDelete.rend(); ++it)
+                delete *it;
+        }
+        else {
+            for (auto it = toDelete.rbegin(); it != toDelete.rend(); ++it)
+                delete *it;
+        }
+
+        return toReturn;
+    }
+
     void ImageData::addRepresentation(const AbstractImageRepresentation* representation) {
         cgtAssert(representation != 0, "Representation must not be 0.");
         _representations.push_back(representation);
@@ -130,6 +215,39 @@ namespace campvis {
         addRepresentation(representation);
     }
 
+    std::shared_ptr<const ImageData::IntensityHistogramType> ImageData::getNativeIntensityHistogram(bool performComputation /*= true*/) const {
+        {
+            tbb::spin_mutex::scoped_lock lock(_histogramMutex);
+            if (_nativeHistogram != nullptr || ! performComputation)
+                return _nativeHistogram;
+        }
+
+        // only one thread computes the histogram, all others wait for it and use its result
+        tbb::mutex::scoped_lock computationLock(_histogramComputationMutex);
+        {
+            tbb::spin_mutex::scoped_lock lock(_histogramMutex);
+            if (_nativeHistogram != nullptr)
+                return _nativeHistogram;
+        }
+
+        const ImageRepresentationLocal* localRep = getRepresentation<ImageRepresentationLocal>();
+        if (localRep == 0)
+            return nullptr;
+
+        const Interval<float>& range = localRep->getNormalizedIntensityRange();
+        float mins = range.getLeft();
+        float maxs = (range.getRight() > range.getLeft()) ? range.getRight() : range.getLeft() + 1.f;
+        size_t numBytes = WeaklyTypedPointer::numBytes(localRep->getBaseType());
+        size_t numBuckets = (numBytes <= 2) ? (static_cast<size_t>(1) << (8 * numBytes)) : NATIVE_HISTOGRAM_MAX_BUCKETS;
+
+        std::shared_ptr<IntensityHistogramType> histogram(new IntensityHistogramType(&mins, &maxs, &numBuckets));
+        localRep->computeNormalizedIntensityHistogram(*histogram);
+
+        tbb::spin_mutex::scoped_lock lock(_histogramMutex);
+        _nativeHistogram = histogram;
+        return _nativeHistogram;
+    }
+
     std::string ImageData::getTypeAsString() const {
         return "Image Data";
     }
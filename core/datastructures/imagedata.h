@@ -26,6 +26,7 @@
 #define IMAGEDATA_H__
 
 #include <tbb/concurrent_vector.h>
+#include <tbb/mutex.h>
 #include <tbb/spin_mutex.h>
 
 #include "cgt/logmanager.h"
@@ -38,9 +39,13 @@
 #include "core/datastructures/imagemappinginformation.h"
 #include "core/datastructures/imagerepresentationconverter.h"
 
+#include <memory>
 #include <vector>
 
 namespace campvis {
+    template<typename T, size_t ND>
+    class ConcurrentGenericHistogramND;
+    class ImageRepresentationDisk;
 
     /**
      * Stores basic information about one (semantic) image of arbitrary dimension.
@@ -52,6 +57,9 @@ namespace campvis {
     friend class AbstractImageRepresentation;
 
     public:
+        /// Type of the histogram of normalized intensities, see getNativeIntensityHistogram()
+        typedef ConcurrentGenericHistogramND<float, 1> IntensityHistogramType;
+
         /**
          * Creates a new ImageData instance with the given parameters.
          * \param dimensionality    Dimensionality of this image
@@ -176,6 +184,58 @@ namespace campvis {
          */
         size_t getNumRepresentations() const;
 
+        /**
+         * Deletes all representations except for the primary one to free memory.
+         * The primary representation is an ImageRepresentationDisk if there is one, otherwise the
+         * first representation of this image. All other representations can be recreated from it
+         * by the next call to getRepresentation().
+         * \note    This invalidates all pointers to the deleted representations. Hence, make sure that
+         *          nobody else is using this image, e.g. by holding the only DataHandle to it.
+         * \return  Number of bytes of local and video memory freed.
+         */
+        size_t releaseSecondaryRepresentations() const;
+
+        /**
+         * Makes sure that this image has an ImageRepresentationDisk by writing its data into a 
+         * scratch file if necessary. All other representations stay valid, hence this method can 
+         * be called while others are using this image. The disk I/O is performed without holding 
+         * the conversion lock, so that other threads are not blocked from converting this image.
+         * \param   directory   Directory for the scratch file, the system's temporary directory if empty.
+         * \return  The disk representation of this image, 0 if the scratch file could not be written.
+         */
+        const ImageRepresentationDisk* createScratchRepresentation(const std::string& directory = "") const;
+
+        /**
+         * Moves the image data into a scratch file on disk and deletes all other representations.
+         * Subsequent calls to getRepresentation() transparently reload the data from the scratch file.
+         * If this image already has an ImageRepresentationDisk, no scratch file is written, 
+         * otherwise createScratchRepresentation() is used to write it.
+         * \note    This invalidates all pointers to the deleted representations. Hence, make sure that
+         *          nobody else is using this image, e.g. by holding the only DataHandle to it.
+         * \param   directory   Directory for the scratch file, the system's temporary directory if empty.
+         * \return  Number of bytes of local and video memory freed.
+         */
+        size_t spillToDisk(const std::string& directory = "") const;
+
+        /**
+         * Returns the histogram of the normalized intensities of this image's first channel at its 
+         * native resolution. It spans the image's intensity range with one bucket per representable 
+         * value for 8 and 16 bit images and NATIVE_HISTOGRAM_MAX_BUCKETS buckets otherwise.
+         * Hence, histograms for arbitrary intensity domains can be obtained by rebinning it instead 
+         * of touching the image data again.
+         * The histogram is computed once from the local representation and then cached for the 
+         * lifetime of this image, hence the image data must not change afterwards.
+         * \note    Computing the histogram may convert the image to an ImageRepresentationLocal,
+         *          so you may want to call this method from a background thread.
+         * \param   performComputation  Flag whether to compute the histogram if it is not cached yet.
+         * \return  The cached histogram, 0 if it is not yet computed and \a performComputation is 
+         *          false, or if no ImageRepresentationLocal could be created.
+         */
+        std::shared_ptr<const IntensityHistogramType> getNativeIntensityHistogram(bool performComputation = true) const;
+
+        /// Maximum number of buckets of the native intensity histogram
+        static const size_t NATIVE_HISTOGRAM_MAX_BUCKETS = 65536;
+
     protected:
         template<typename T>
         const T* tryPerformConversion() const;
@@ -201,6 +261,15 @@ namespace campvis {
          */
         void clearRepresentations();
 
+        /**
+         * Deletes all representations except for \a representation.
+         * \note    Make sure to call this method only when nobody else holds pointers to the
+         *          representations as they will be invalidated. This method is \b not thread-safe!
+         * \param   representation  Representation to keep, must be one of _representations.
+         * \return  Number of bytes of local and video memory freed.
+         */
+        size_t removeRepresentationsExcept(const AbstractImageRepresentation* representation) const;
+
         /// List of all representations of this image. Mutable to allow lazy instantiation of new representations.
         mutable tbb::concurrent_vector<const AbstractImageRepresentation*> _representations;
 
@@ -211,7 +280,13 @@ namespace campvis {
         ImageMappingInformation _mappingInformation;    ///< Mapping information of this image
 
         /// Mutex protecting the representation conversions to ensure that there is only one conversion happening at a time.
-        mutable tbb::spin_mutex _conversionMutex;
+        /// Conversions may download from the GPU, hence a blocking mutex is used instead of a spin mutex.
+        mutable tbb::mutex _conversionMutex;
+
+        mutable std::shared_ptr<const IntensityHistogramType> _nativeHistogram;  ///< Cached native intensity histogram, may be 0
+        mutable tbb::spin_mutex _histogramMutex;                                ///< Mutex protecting _nativeHistogram
+        /// Mutex ensuring that the native intensity histogram is computed only once at a time.
+        mutable tbb::mutex _histogramComputationMutex;
 
         static const std::string loggerCat_;
     };
@@ -230,7 +305,7 @@ namespace campvis {
 
         // no representation found, create a new one
         if (performConversion) {
-            tbb::spin_mutex::scoped_lock lock(_conversionMutex);
+            tbb::mutex::scoped_lock lock(_conversionMutex);
 
             // in the meantime, there something might have changed, so check again whether there is a new rep.
             for (auto it = _representations.begin(); it != _representations.end(); ++it) {
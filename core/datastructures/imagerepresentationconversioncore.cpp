@@ -34,6 +34,14 @@ namespace campvis {
 
         // test source image type via dynamic cast
         if (const ImageRepresentationDisk* tester = dynamic_cast<const ImageRepresentationDisk*>(source)) {
+            // if possible, upload directly from the memory-mapped file
+            std::shared_ptr<MappedFile> mapping;
+            WeaklyTypedPointer mappedWtp = tester->getMappedWeaklyTypedPointer(mapping);
+            if (mappedWtp._pointer != nullptr) {
+                cgt::OpenGLJobProcessor::ScopedSynchronousGlJobExecution jobGuard;
+                return ImageRepresentationGL::create(const_cast<ImageData*>(tester->getParent()), mappedWtp);
+            }
+
             WeaklyTypedPointer wtp = tester->getWeaklyTypedPointer();
 
             if (wtp._pointer == nullptr) {
@@ -89,7 +97,17 @@ namespace campvis {
 
         // test source image type via dynamic cast
         if (const ImageRepresentationDisk* tester = dynamic_cast<const ImageRepresentationDisk*>(source)) {
-            return ImageRepresentationLocal::create(tester->getParent(), tester->getWeaklyTypedPointer());
+            // try to directly wrap the memory-mapped file first, this saves us from copying any data
+            std::shared_ptr<MappedFile> mapping;
+            WeaklyTypedPointer wtp = tester->getMappedWeaklyTypedPointer(mapping);
+            if (wtp._pointer != nullptr)
+                return ImageRepresentationLocal::create(tester->getParent(), wtp, mapping);
+
+            wtp = tester->getWeaklyTypedPointer();
+            if (wtp._pointer != nullptr)
+                return ImageRepresentationLocal::create(tester->getParent(), wtp);
+
+            return nullptr;
         }
         else if (const ImageRepresentationGL* tester = dynamic_cast<const ImageRepresentationGL*>(source)) {
             cgt::OpenGLJobProcessor::ScopedSynchronousGlJobExecution jobGuard;
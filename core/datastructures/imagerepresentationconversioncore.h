@@ -34,6 +34,7 @@
 #include "core/datastructures/imagerepresentationlocal.h"
 #include "core/datastructures/imagerepresentationgl.h"
 #include "core/datastructures/genericimagerepresentationlocal.h"
+#include "core/tools/mappedfile.h"
 
 namespace campvis {
 
@@ -86,8 +87,15 @@ namespace campvis {
             if (const ImageRepresentationDisk* tester = dynamic_cast<const ImageRepresentationDisk*>(source)) {
                 // converting from disk representation
                 if (tester->getBaseType() == TypeTraits<BASETYPE, NUMCHANNELS>::weaklyTypedPointerBaseType && tester->getParent()->getNumChannels() == NUMCHANNELS) {
-                    WeaklyTypedPointer wtp = tester->getWeaklyTypedPointer();
-                    return GenericImageRepresentationLocal<BASETYPE, NUMCHANNELS>::create(tester->getParent(), static_cast<ElementType*>(wtp._pointer));
+                    // try to directly wrap the memory-mapped file first, this saves us from copying any data
+                    std::shared_ptr<MappedFile> mapping;
+                    WeaklyTypedPointer wtp = tester->getMappedWeaklyTypedPointer(mapping);
+                    if (wtp._pointer != nullptr)
+                        return GenericImageRepresentationLocal<BASETYPE, NUMCHANNELS>::create(tester->getParent(), static_cast<ElementType*>(wtp._pointer), mapping);
+
+                    wtp = tester->getWeaklyTypedPointer();
+                    if (wtp._pointer != nullptr)
+                        return GenericImageRepresentationLocal<BASETYPE, NUMCHANNELS>::create(tester->getParent(), static_cast<ElementType*>(wtp._pointer));
                 }
                 else {
                     LWARNINGC("CAMPVis.core.datastructures.GenericLocalConversion", "Could not convert since base type or number of channels mismatch.");
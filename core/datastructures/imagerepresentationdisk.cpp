@@ -26,8 +26,106 @@
 
 #include "cgt/filesystem.h"
 
+#include "core/datastructures/imagerepresentationlocal.h"
+#include "core/tools/mappedfile.h"
+
+#include <tbb/atomic.h>
+
+#include <tbb/blocked_range2d.h>
+#include <tbb/parallel_for.h>
+#include <tbb/task_group.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <sstream>
+#include <vector>
+
 
 namespace campvis {
+
+    namespace {
+        /// Number of bytes to read from disk in one go when loading image data.
+        const size_t CHUNK_SIZE = 32 * 1024 * 1024;
+
+        /**
+         * Copies \a numElements elements of \a numBytesPerElement bytes each from \a source to 
+         * \a destination and swaps their endianess if \a swapWidth is not 0.
+         * \param   source              Pointer to first source element
+         * \param   destination         Pointer to first destination element
+         * \param   numElements         Number of elements to copy
+         * \param   numBytesPerElement  Number of bytes per element
+         * \param   sourcePitch         Distance between adjacent source elements in bytes
+         * \param   destinationPitch    Distance between adjacent destination elements in bytes
+         * \param   swapWidth           Number of bytes per value to endian-swap, 0 for no swapping
+         */
+        void gatherRow(const char* source, char* destination, size_t numElements, size_t numBytesPerElement, size_t sourcePitch, size_t destinationPitch, size_t swapWidth) {
+            if (sourcePitch == numBytesPerElement && destinationPitch == numBytesPerElement) {
+                memcpy(destination, source, numElements * numBytesPerElement);
+            }
+            else {
+                for (size_t x = 0; x < numElements; ++x)
+                    memcpy(destination + x * destinationPitch, source + x * sourcePitch, numBytesPerElement);
+            }
+
+            // This is not the most beautiful design, but unfortunately swapEndian needs to know the number of bytes at compiletime...
+            size_t numValuesPerElement = (swapWidth == 0) ? 0 : numBytesPerElement / swapWidth;
+            switch (swapWidth) {
+                case 0: // fallthrough
+                case 1:
+                    // nothing to do here.
+                    break;
+
+                case 2:
+                    for (size_t x = 0; x < numElements; ++x)
+                        for (size_t i = 0; i < numValuesPerElement; ++i)
+                            EndianHelper::swapEndian<2>(destination + x * destinationPitch + 2*i);
+                    break;
+
+                case 4:
+                    for (size_t x = 0; x < numElements; ++x)
+                        for (size_t i = 0; i < numValuesPerElement; ++i)
+                            EndianHelper::swapEndian<4>(destination + x * destinationPitch + 4*i);
+                    break;
+
+                default:
+                    cgtAssert(false, "Tried to swap endianess with unsupported number of bytes per value.");
+                    break;
+            }
+        }
+
+        /// Counter to generate unique scratch file names.
+        tbb::atomic<size_t> scratchFileCounter;
+
+        /**
+         * Generates a new unique file name for a scratch file.
+         * \param   directory   Directory for the scratch file, the system's temporary directory if empty.
+         * \return  Path to the new scratch file.
+         */
+        std::string generateScratchFileName(const std::string& directory) {
+            std::string dir = directory;
+            if (dir.empty()) {
+                const char* envVariables[] = { "TMPDIR", "TEMP", "TMP" };
+                for (size_t i = 0; i < 3 && dir.empty(); ++i) {
+                    if (const char* value = std::getenv(envVariables[i]))
+                        dir = value;
+                }
+                if (dir.empty()) {
+#ifdef WIN32
+                    dir = cgt::FileSystem::currentDirectory();
+#else
+                    dir = "/tmp";
+#endif
+                }
+            }
+
+            std::ostringstream ss;
+            ss << dir << "/campvis_scratch_" << std::chrono::steady_clock::now().time_since_epoch().count() << "_" << scratchFileCounter.fetch_and_increment() << ".raw";
+            return ss.str();
+        }
+    }
+
     const std::string ImageRepresentationDisk::loggerCat_ = "CAMPVis.core.datastructures.ImageRepresentationDisk";
 
     ImageRepresentationDisk* ImageRepresentationDisk::create(ImageData* parent, const std::string& url, WeaklyTypedPointer::BaseType type, size_t offset /*= 0*/, EndianHelper::Endianness endianness /*= EndianHelper::LITTLE_ENDIAN*/, const cgt::svec3& stride /*= cgt::svec3::zero */, bool multichannelSideBySide /*= false*/) {
@@ -44,150 +142,216 @@ namespace campvis {
         , _endianess(endianness)
         , _stride(stride)
         , _multichannelSideBySide(multichannelSideBySide)
+        , _isScratchFile(false)
     {
     }
 
     ImageRepresentationDisk::~ImageRepresentationDisk() {
+        if (_isScratchFile && ! cgt::FileSystem::deleteFile(_url))
+            LWARNING("Could not delete scratch file " << _url << ".");
+    }
+
+    ImageRepresentationDisk* ImageRepresentationDisk::createScratchCopy(const ImageRepresentationLocal* source, const std::string& directory /*= ""*/) {
+        cgtAssert(source != 0, "Source representation must not be 0!");
+
+        WeaklyTypedPointer wtp = source->getWeaklyTypedPointer();
+        std::string url = generateScratchFileName(directory);
+
+        std::ofstream file(url.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+        if (! file.is_open()) {
+            LERROR("Could not open scratch file " << url << " for writing.");
+            return 0;
+        }
+
+        file.write(static_cast<const char*>(wtp._pointer), source->getNumElements() * wtp.getNumBytesPerElement());
+        file.close();
+        if (file.fail()) {
+            LERROR("Could not write scratch file " << url << ".");
+            cgt::FileSystem::deleteFile(url);
+            return 0;
+        }
+
+        ImageRepresentationDisk* toReturn = new ImageRepresentationDisk(const_cast<ImageData*>(source->getParent()), url, wtp._baseType, 0, EndianHelper::getLocalEndianness());
+        toReturn->_isScratchFile = true;
+        toReturn->addToParent();
+        return toReturn;
     }
 
     campvis::WeaklyTypedPointer ImageRepresentationDisk::getWeaklyTypedPointer() const {
-        const cgt::svec3& size = getSize();
-        size_t numElements = cgt::hmul(size);
-        size_t numBytesPerElement = WeaklyTypedPointer::numBytes(_type, _parent->getNumChannels());
-        size_t numBytes = numElements * numBytesPerElement;
+        size_t numChannels = _parent->getNumChannels();
+        size_t numBytesPerChannel = WeaklyTypedPointer::numBytes(_type);
+        size_t numBytesPerElement = numBytesPerChannel * numChannels;
+        size_t numBytesOnDisk = getNumBytesOnDisk();
 
         // open file and prepare for read
         std::ifstream file(_url.c_str(), std::ios::in | std::ios::binary | std::ios::ate);
-        if (file.is_open()) {
-            size_t fileSize = static_cast<size_t>(file.tellg());
-            if (fileSize < numBytes + _offset) {
-                LERROR("File is smaller than expected, " << (numBytes + _offset) - fileSize << " Bytes missing.");
-                return WeaklyTypedPointer(_type, _parent->getNumChannels(), 0);
-            }
+        if (! file.is_open()) {
+            LERROR("Could not open file " << _url << " for reading.");
+            return WeaklyTypedPointer(_type, numChannels, 0);
+        }
 
-            file.seekg(_offset, std::ios::beg);
+        size_t fileSize = static_cast<size_t>(file.tellg());
+        if (fileSize < numBytesOnDisk + _offset) {
+            LERROR("File is smaller than expected, " << (numBytesOnDisk + _offset) - fileSize << " Bytes missing.");
+            return WeaklyTypedPointer(_type, numChannels, 0);
+        }
 
-            // Reserve memory - because we have no type information we simply read into a char array.
-            char* data = new char[numBytes];
+        // Reserve memory - because we have no type information we simply read into a char array.
+        char* data = new char[getNumElements() * numBytesPerElement];
+        size_t swapWidth = (_endianess != EndianHelper::getLocalEndianness()) ? numBytesPerChannel : 0;
+        bool success = true;
 
-            // handle stride:
-            cgt::svec3 canonicStride = getCanonicStride(size);
-            if (_stride == cgt::svec3::zero || _stride == canonicStride) {
-                // no stride is easy - we have just one chunk of data:
-                file.read(data, numBytes);
-            }
-            else {
-                // TODO:    Check for correctness when being adequately awake! ;)
-                size_t index = 0;
-
-                // we have a stride at at least one direction
-                if (_stride.z == 0 || canonicStride.z) {
-                    if (_stride.y == 0 || canonicStride.y) {
-                        // we have a stride only in the last dimension so we can read the elements from the first two dimension in a row
-                        size_t sz = size.x*size.y;
-                        for (size_t z = 0; z < size.z; ++z) {
-                            size_t posZ = static_cast<size_t>(file.tellg());
-                            file.read(data + index, sz * numBytesPerElement);
-                            file.seekg(posZ + (_stride.z * numBytesPerElement), std::ios::beg);
-                            index += sz;
-                        }
-                    }
-                    else {
-                        // we have a stride only in the last 2 dimensions so we can read the elements from the first dimension in a row
-                        for (size_t z = 0; z < size.z; ++z) {
-                            size_t posZ = static_cast<size_t>(file.tellg());
-                            for (size_t y = 0; y < size.y; ++y) {
-                                file.read(data + index, size.x * numBytesPerElement);
-                                file.seekg((_stride.y - size.x) * numBytesPerElement, std::ios::cur);
-                                index += size.x;
-                            }
-                            file.seekg(posZ + (_stride.z * numBytesPerElement), std::ios::beg);
-                        }
-                    }
-                }
-                else {
-                    // read each element separately
-                    for (size_t z = 0; z < size.z; ++z) {
-                        size_t posZ = static_cast<size_t>(file.tellg());
-                        for (size_t y = 0; y < size.y; ++y) {
-                            size_t posY = static_cast<size_t>(file.tellg());
-                            for (size_t x = 0; x < size.x; ++x) {    
-                                file.read(data + index, numBytesPerElement);
-                                file.seekg((_stride.x - 1) * numBytesPerElement, std::ios::cur);
-                                ++index;
-                            }
-                            file.seekg(posY + (_stride.y * numBytesPerElement), std::ios::beg);
-                        }
-                        file.seekg(posZ + (_stride.z * numBytesPerElement), std::ios::beg);
-                    }
-                }
-            }
+        if (_multichannelSideBySide && numChannels > 1) {
+            // each channel is stored as separate plane, we read one plane after the other and
+            // gather it directly into the interleaved layout
+            size_t numBytesPerPlane = numBytesOnDisk / numChannels;
+            for (size_t channel = 0; channel < numChannels && success; ++channel)
+                success = readChunked(file, _offset + channel * numBytesPerPlane, data + channel * numBytesPerChannel, numBytesPerChannel, numBytesPerElement, swapWidth);
+        }
+        else {
+            success = readChunked(file, _offset, data, numBytesPerElement, numBytesPerElement, swapWidth);
+        }
 
-            file.close();
-
-            // handle endianess
-            EndianHelper::Endianness localEndianess = EndianHelper::getLocalEndianness();
-            if (_endianess != localEndianess) {
-                // This is not the most beautiful design, but unfortunately swapEndian needs to know the number of bytes at compiletime...
-                switch (_type) {
-                    case WeaklyTypedPointer::UINT8: // fallthrough
-                    case WeaklyTypedPointer::INT8:
-                        // nothing to do here.
-                        break;
-
-                    case WeaklyTypedPointer::UINT16: // fallthrough
-                    case WeaklyTypedPointer::INT16: {
-                        for (size_t i = 0; i < numElements; ++i)
-                            EndianHelper::swapEndian<2>(data + (2*i));
-                        break;
-                        }
+        if (! success) {
+            LERROR("Error while reading from file " << _url << ".");
+            delete [] data;
+            return WeaklyTypedPointer(_type, numChannels, 0);
+        }
 
-                    case WeaklyTypedPointer::UINT32: // fallthrough
-                    case WeaklyTypedPointer::INT32: // fallthrough
-                    case WeaklyTypedPointer::FLOAT: {
-                        for (size_t i = 0; i < numElements; ++i)
-                            EndianHelper::swapEndian<4>(data + (4*i));
-                        break;
-                        }
+        return WeaklyTypedPointer(_type, numChannels, static_cast<void*>(data));
+    }
 
-                    default:
-                        cgtAssert(false, "Should not reach this!");
-                        LERROR("Tried to swap endianess with unsupported number of bytes per element (" << numBytesPerElement << ")");
-                        break;
-                }
-            }
+    bool ImageRepresentationDisk::isDirectlyMappable() const {
+        const cgt::svec3& size = getSize();
+        cgt::svec3 packedStride(1, size.x, size.x * size.y);
 
-            if (_multichannelSideBySide && _parent->getNumChannels() > 1) {
-                // there is no simple in-place solution, so we copy everything around...
-                char* reordered = new char[numBytes];
-                size_t numBytesPerChannel = numBytesPerElement / _parent->getNumChannels();
-                for (size_t i = 0; i < numElements; ++i) {
-                    for (size_t j = 0; j < _parent->getNumChannels(); ++j) {
-                        size_t fromOffset = (i + j*numElements) * numBytesPerChannel;
-                        size_t toOffset = (j + i*_parent->getNumChannels()) * numBytesPerChannel;
-                        memcpy(reordered + toOffset, data + fromOffset, numBytesPerChannel);
-                    }
-                }
+        return _endianess == EndianHelper::getLocalEndianness()
+            && getEffectiveStride(size) == packedStride
+            && (! _multichannelSideBySide || _parent->getNumChannels() == 1)
+            && (_offset % WeaklyTypedPointer::numBytes(_type)) == 0;
+    }
 
-                std::swap(data, reordered);
-                delete [] reordered;
-            }
+    WeaklyTypedPointer ImageRepresentationDisk::getMappedWeaklyTypedPointer(std::shared_ptr<MappedFile>& mapping) const {
+        mapping.reset();
+        if (! isDirectlyMappable())
+            return WeaklyTypedPointer(_type, _parent->getNumChannels(), 0);
 
-            return WeaklyTypedPointer(_type, _parent->getNumChannels(), static_cast<void*>(data));
-        }
-        else {
-            LERROR("Could not open file " << _url << " for reading.");
+        std::shared_ptr<MappedFile> mf(new MappedFile(_url));
+        if (! mf->isOpen())
+            return WeaklyTypedPointer(_type, _parent->getNumChannels(), 0);
+
+        if (mf->getSize() < getNumBytesOnDisk() + _offset) {
+            LERROR("File is smaller than expected, " << (getNumBytesOnDisk() + _offset) - mf->getSize() << " Bytes missing.");
             return WeaklyTypedPointer(_type, _parent->getNumChannels(), 0);
         }
 
+        mapping = mf;
+        return WeaklyTypedPointer(_type, _parent->getNumChannels(), static_cast<void*>(mf->getData() + _offset));
+    }
+
+    bool ImageRepresentationDisk::readChunked(std::ifstream& file, size_t fileOffset, char* destination, size_t numBytesPerElement, size_t destinationPitch, size_t swapWidth) const {
+        const cgt::svec3& size = getSize();
+        if (cgt::hmul(size) == 0)
+            return true;
+
+        cgt::svec3 stride = getEffectiveStride(size);
+        const size_t sourcePitch = stride.x * numBytesPerElement;
+        const size_t rowDistance = stride.y * numBytesPerElement;
+        const size_t sliceDistance = stride.z * numBytesPerElement;
+        const size_t sliceSpan = ((size.y - 1) * stride.y + (size.x - 1) * stride.x + 1) * numBytesPerElement;
+
+        // we read as many whole slices per chunk as fit into CHUNK_SIZE, but at least one
+        const size_t slicesPerChunk = std::max(size_t(1), CHUNK_SIZE / std::max(sliceDistance, sliceSpan));
+        const size_t maxChunkSize = (std::min(slicesPerChunk, size.z) - 1) * sliceDistance + sliceSpan;
+
+        // Use two staging buffers, so that we can read the next chunk from disk while the 
+        // previous one is gathered into the destination buffer.
+        std::vector<char> staging[2];
+        staging[0].resize(maxChunkSize);
+        if (slicesPerChunk < size.z)
+            staging[1].resize(maxChunkSize);
+
+        tbb::task_group gatherTasks;
+        size_t currentBuffer = 0;
+        bool success = true;
+
+        for (size_t firstSlice = 0; firstSlice < size.z; firstSlice += slicesPerChunk) {
+            const size_t numSlices = std::min(slicesPerChunk, size.z - firstSlice);
+            const size_t chunkSize = (numSlices - 1) * sliceDistance + sliceSpan;
+            char* chunk = &staging[currentBuffer].front();
+
+            file.seekg(fileOffset + firstSlice * sliceDistance, std::ios::beg);
+            file.read(chunk, chunkSize);
+
+            // wait for the gathering of the previous chunk before launching the next one
+            gatherTasks.wait();
+            if (! file.good()) {
+                success = false;
+                break;
+            }
+
+            gatherTasks.run([=, &size] () {
+                tbb::parallel_for(tbb::blocked_range2d<size_t>(0, numSlices, 0, size.y), [&] (const tbb::blocked_range2d<size_t>& range) {
+                    for (size_t z = range.rows().begin(); z != range.rows().end(); ++z) {
+                        for (size_t y = range.cols().begin(); y != range.cols().end(); ++y) {
+                            const char* src = chunk + z * sliceDistance + y * rowDistance;
+                            char* dst = destination + ((firstSlice + z) * size.y + y) * size.x * destinationPitch;
+                            gatherRow(src, dst, size.x, numBytesPerElement, sourcePitch, destinationPitch, swapWidth);
+                        }
+                    }
+                });
+            });
+
+            currentBuffer = 1 - currentBuffer;
+        }
+
+        gatherTasks.wait();
+        return success;
     }
 
     cgt::svec3 ImageRepresentationDisk::getCanonicStride(const cgt::svec3& size) const {
         return cgt::svec3(0, size.x, size.x * size.y);
     }
 
+    cgt::svec3 ImageRepresentationDisk::getEffectiveStride(const cgt::svec3& size) const {
+        cgt::svec3 toReturn;
+        toReturn.x = (_stride.x == 0) ? 1 : _stride.x;
+        toReturn.y = (_stride.y == 0) ? size.x * toReturn.x : _stride.y;
+        toReturn.z = (_stride.z == 0) ? size.y * toReturn.y : _stride.z;
+        return toReturn;
+    }
+
+    size_t ImageRepresentationDisk::getNumBytesOnDisk() const {
+        const cgt::svec3& size = getSize();
+        if (cgt::hmul(size) == 0)
+            return 0;
+
+        cgt::svec3 stride = getEffectiveStride(size);
+        size_t numElementsSpanned = (size.z - 1) * stride.z + (size.y - 1) * stride.y + (size.x - 1) * stride.x + 1;
+
+        // for side-by-side channels the stride refers to single channel values within each plane,
+        // which results in the same byte count as interleaved channels.
+        return numElementsSpanned * WeaklyTypedPointer::numBytes(_type, _parent->getNumChannels());
+    }
+
     ImageRepresentationDisk* ImageRepresentationDisk::clone(ImageData* newParent) const {
-        return ImageRepresentationDisk::create(newParent, _url, _type, _offset, _endianess, _stride);
+        if (! _isScratchFile)
+            return ImageRepresentationDisk::create(newParent, _url, _type, _offset, _endianess, _stride, _multichannelSideBySide);
+
+        // scratch files are deleted together with their owner, so the clone needs its own copy
+        std::string url = generateScratchFileName(cgt::FileSystem::dirName(_url));
+        try {
+            cgt::FileSystem::copyFile(_url, url);
+        }
+        catch (cgt::Exception& e) {
+            LERROR("Could not copy scratch file " << _url << ": " << e.what());
+            return 0;
+        }
+
+        ImageRepresentationDisk* toReturn = new ImageRepresentationDisk(newParent, url, _type, _offset, _endianess, _stride, _multichannelSideBySide);
+        toReturn->_isScratchFile = true;
+        toReturn->addToParent();
+        return toReturn;
     }
 
     size_t ImageRepresentationDisk::getLocalMemoryFootprint() const {
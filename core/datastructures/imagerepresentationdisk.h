@@ -29,7 +29,12 @@
 #include "core/tools/endianhelper.h"
 #include "core/tools/weaklytypedpointer.h"
 
+#include <fstream>
+#include <memory>
+
 namespace campvis {
+    class ImageRepresentationLocal;
+    class MappedFile;
 
     /**
      * Subclass of ImageData offering access to image data stored in binary form on the local harddisk.
@@ -61,9 +66,22 @@ namespace campvis {
             bool multichannelSideBySide = false
             );
 
+        /**
+         * Writes the image data of \a source into a new scratch file in \a directory, creates an
+         * ImageRepresentationDisk for it and adds it to the parent of \a source.
+         * The scratch file is owned by the returned representation and deleted together with it.
+         *
+         * \note    You do \b not own the returned pointer.
+         *
+         * \param   source      Local representation whose data shall be written, must not be 0.
+         * \param   directory   Directory for the scratch file, the system's temporary directory if empty.
+         * \return  A pointer to the newly created ImageRepresentationDisk, 0 if writing the file failed.
+         */
+        static ImageRepresentationDisk* createScratchCopy(const ImageRepresentationLocal* source, const std::string& directory = "");
+
 
         /**
-         * Destructor
+         * Destructor, deletes the file if it is a scratch file created by createScratchCopy().
          */
         virtual ~ImageRepresentationDisk();
 
@@ -88,11 +106,34 @@ namespace campvis {
 
         /**
          * Downloads the whole image data to local memory.
+         * The file is read in a single streaming pass, strides, endianess and side-by-side 
+         * multichannel layouts are resolved on the fly.
          * \note    The caller has to take ownership of the returned pointer.
          * \return  Pointer to the image data in the local memory, to be owned by caller.
          */
         WeaklyTypedPointer getWeaklyTypedPointer() const;
 
+        /**
+         * Returns whether the on-disk layout of the image data matches the in-memory layout of an
+         * ImageRepresentationLocal, so that the memory-mapped file can be used directly.
+         * This is the case for tightly packed data of local endianess with interleaved channels
+         * starting at a suitably aligned offset.
+         * \return  True if getMappedWeaklyTypedPointer() can provide a zero-copy pointer.
+         */
+        bool isDirectlyMappable() const;
+
+        /**
+         * Memory-maps the file and returns a WeaklyTypedPointer directly pointing into the mapped
+         * pages, hence without copying any data.
+         * The mapping is private (copy-on-write), so writing to the returned memory does not 
+         * modify the file.
+         * \param   mapping     Output parameter for the MappedFile owning the returned memory, 
+         *                      the pointer stays valid as long as \a mapping is alive.
+         * \return  A WeaklyTypedPointer into the mapped file, its _pointer is 0 if the file could 
+         *          not be mapped or isDirectlyMappable() is false.
+         */
+        WeaklyTypedPointer getMappedWeaklyTypedPointer(std::shared_ptr<MappedFile>& mapping) const;
+
 
         /**
          * Returns the base type of the data
@@ -131,6 +172,36 @@ namespace campvis {
          */
         cgt::svec3 getCanonicStride(const cgt::svec3& size) const;
 
+        /**
+         * Calculates the effective stride of the data on disk, i.e. the distance in elements 
+         * between the starts of adjacent elements, rows and slices.
+         * \param   size    Image size (number of elements per dimension).
+         * \return  _stride where zero components are replaced by the tightly packed distance.
+         */
+        cgt::svec3 getEffectiveStride(const cgt::svec3& size) const;
+
+        /**
+         * Returns the number of bytes spanned by the image data in the file starting at _offset.
+         * \return  Number of bytes between _offset and the end of the last image element.
+         */
+        size_t getNumBytesOnDisk() const;
+
+        /**
+         * Reads image data from \a file into the tightly packed layout in \a destination.
+         * The file is read sequentially in large chunks of whole slices into a staging buffer, 
+         * from which the elements are gathered and endian-swapped in parallel, while the next 
+         * chunk is being read.
+         * 
+         * \param   file                File to read from, must be open in binary mode.
+         * \param   fileOffset          Offset of the first element to read in the file (in bytes).
+         * \param   destination         Pointer to the first destination element.
+         * \param   numBytesPerElement  Number of bytes per element to read.
+         * \param   destinationPitch    Distance between adjacent destination elements in bytes.
+         * \param   swapWidth           Number of bytes per value to endian-swap, 0 for no swapping.
+         * \return  True on success, false if reading from \a file failed.
+         */
+        bool readChunked(std::ifstream& file, size_t fileOffset, char* destination, size_t numBytesPerElement, size_t destinationPitch, size_t swapWidth) const;
+
         std::string _url;                       ///< path to file with raw data
         size_t _offset;                         ///< offset of first data element in file (in bytes)
         WeaklyTypedPointer::BaseType _type;     ///< base type of data
@@ -144,6 +215,7 @@ namespace campvis {
         cgt::svec3 _stride;
 
         bool _multichannelSideBySide;           ///< Flag whether multichannel images are stored side by side
+        bool _isScratchFile;                    ///< Flag whether _url is a scratch file owned by this representation
 
         static const std::string loggerCat_;
     };
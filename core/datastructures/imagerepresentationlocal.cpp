@@ -28,10 +28,106 @@
 #include <tbb/spin_mutex.h>
 
 #include "core/datastructures/genericimagerepresentationlocal.h"
+#include "core/tools/voxelview.h"
 
 #include <limits>
+#include <random>
 
 namespace campvis {
+
+    namespace {
+        /// Accessor for the first channel of a single-channel image using a VoxelView.
+        template<typename BASETYPE>
+        struct VoxelViewAccessor {
+            explicit VoxelViewAccessor(const VoxelView<BASETYPE, 1>& view) : _view(view) {}
+            size_t getNumElements() const { return _view.getNumElements(); }
+            float operator() (size_t index) const { return _view.getNormalized(index, 0); }
+            VoxelView<BASETYPE, 1> _view;
+        };
+
+        /// Accessor for the first channel of an arbitrary image using the virtual ImageRepresentationLocal interface.
+        struct VirtualAccessor {
+            explicit VirtualAccessor(const ImageRepresentationLocal* rep) : _rep(rep) {}
+            size_t getNumElements() const { return _rep->getNumElements(); }
+            float operator() (size_t index) const { return _rep->getElementNormalized(index, 0); }
+            const ImageRepresentationLocal* _rep;
+        };
+
+        /**
+         * Reduction body for tbb::parallel_reduce computing the range of normalized intensities 
+         * and optionally filling a histogram with the same values using batched thread-local insertion.
+         */
+        template<typename ACCESSOR>
+        struct IntensityRangeReducer {
+            IntensityRangeReducer(const ACCESSOR& accessor, ConcurrentGenericHistogramND<float, 1>* histogram)
+                : _accessor(accessor)
+                , _histogram(histogram)
+                , _min(std::numeric_limits<float>::max())
+                , _max(-std::numeric_limits<float>::max())
+            {}
+
+            IntensityRangeReducer(IntensityRangeReducer& rhs, tbb::split)
+                : _accessor(rhs._accessor)
+                , _histogram(rhs._histogram)
+                , _min(std::numeric_limits<float>::max())
+                , _max(-std::numeric_limits<float>::max())
+            {}
+
+            void operator() (const tbb::blocked_range<size_t>& range) {
+                static const size_t BATCH_SIZE = 256;
+                float batch[BATCH_SIZE];
+                float localMin = _min;
+                float localMax = _max;
+
+                for (size_t start = range.begin(); start < range.end(); start += BATCH_SIZE) {
+                    const size_t count = std::min(BATCH_SIZE, range.end() - start);
+                    for (size_t i = 0; i < count; ++i) {
+                        float value = _accessor(start + i);
+                        localMin = std::min(localMin, value);
+                        localMax = std::max(localMax, value);
+                        batch[i] = value;
+                    }
+
+                    if (_histogram != 0)
+                        _histogram->addSamples(batch, count);
+                }
+
+                _min = localMin;
+                _max = localMax;
+            }
+
+            void join(const IntensityRangeReducer& rhs) {
+                _min = std::min(_min, rhs._min);
+                _max = std::max(_max, rhs._max);
+            }
+
+            ACCESSOR _accessor;
+            ConcurrentGenericHistogramND<float, 1>* _histogram;
+            float _min;
+            float _max;
+        };
+
+        /// Dispatches IntensityRangeReducer on the base type of single-channel images.
+        struct IntensityRangeDispatcher {
+            explicit IntensityRangeDispatcher(ConcurrentGenericHistogramND<float, 1>* histogram)
+                : _histogram(histogram)
+                , _min(std::numeric_limits<float>::max())
+                , _max(-std::numeric_limits<float>::max())
+            {}
+
+            template<typename BASETYPE>
+            void operator() (const VoxelView<BASETYPE, 1>& view) {
+                IntensityRangeReducer< VoxelViewAccessor<BASETYPE> > reducer(VoxelViewAccessor<BASETYPE>(view), _histogram);
+                tbb::parallel_reduce(tbb::blocked_range<size_t>(0, view.getNumElements()), reducer);
+                _min = reducer._min;
+                _max = reducer._max;
+            }
+
+            ConcurrentGenericHistogramND<float, 1>* _histogram;
+            float _min;
+            float _max;
+        };
+    }
     
     const std::string ImageRepresentationLocal::loggerCat_ = "CAMPVis.core.datastructures.ImageRepresentationLocal";
 
@@ -46,6 +142,10 @@ namespace campvis {
 
     }
 
+    WeaklyTypedPointer::BaseType ImageRepresentationLocal::getBaseType() const {
+        return _baseType;
+    }
+
     const Interval<float>& ImageRepresentationLocal::getNormalizedIntensityRange() const {
         if (_intensityRangeDirty)
             computeNormalizedIntensityRange();
@@ -53,32 +153,74 @@ namespace campvis {
         return _normalizedIntensityRange;
     }
 
+    Interval<float> ImageRepresentationLocal::computeNormalizedIntensityHistogram(ConcurrentGenericHistogramND<float, 1>& histogram) const {
+        computeNormalizedIntensityRangeAndHistogram(&histogram);
+        return _normalizedIntensityRange;
+    }
+
+    void ImageRepresentationLocal::sampleNormalizedIntensityHistogram(ConcurrentGenericHistogramND<float, 1>& histogram, size_t numSamples) const {
+        const size_t numElements = getNumElements();
+        if (numElements <= numSamples) {
+            computeNormalizedIntensityHistogram(histogram);
+            return;
+        }
+
+        static const size_t GRAIN_SIZE = 4096;
+        tbb::parallel_for(tbb::blocked_range<size_t>(0, numSamples, GRAIN_SIZE), [&] (const tbb::blocked_range<size_t>& range) {
+            // the simple_partitioner yields the same ranges in each run, hence seeding with the range 
+            // start makes the samples independent of the scheduling
+            std::minstd_rand generator(static_cast<unsigned int>(range.begin() + 1));
+            std::uniform_int_distribution<size_t> distribution(0, numElements - 1);
+
+            std::vector<float> batch(range.size());
+            for (size_t i = 0; i < batch.size(); ++i)
+                batch[i] = getElementNormalized(distribution(generator), 0);
+            histogram.addSamples(batch.data(), batch.size());
+        }, tbb::simple_partitioner());
+
+        histogram.mergeLocalBuckets();
+    }
+
     void ImageRepresentationLocal::computeNormalizedIntensityRange() const {
-        _normalizedIntensityRange = Interval<float>(); // reset interval to empty one
-        tbb::spin_mutex _mutex; // mutex to protect for concurrent access
+        computeNormalizedIntensityRangeAndHistogram(0);
+    }
 
-        tbb::parallel_for(tbb::blocked_range<size_t>(0, getNumElements()), [&] (const tbb::blocked_range<size_t>& range) {
-            float localMin = std::numeric_limits<float>::max();
-            float localMax = -std::numeric_limits<float>::max();
+    void ImageRepresentationLocal::computeNormalizedIntensityRangeAndHistogram(ConcurrentGenericHistogramND<float, 1>* histogram) const {
+        IntensityRangeReducer<VirtualAccessor> virtualReducer(VirtualAccessor(this), histogram);
+        IntensityRangeDispatcher dispatcher(histogram);
 
-            for (size_t i = range.begin(); i != range.end(); ++i) {
-                float value = this->getElementNormalized(i, 0);
-                localMax = std::max(localMax, value);
-                localMin = std::min(localMin, value);
-            }
+        float min, max;
 
-            {
-                tbb::spin_mutex::scoped_lock(mutex);
-                _normalizedIntensityRange.nibble(localMin);
-                _normalizedIntensityRange.nibble(localMax);
-            }
-        });
+        // use the typed fast path for single-channel images, which are by far the most common ones
+        if (dispatchVoxelView<1>(this, dispatcher)) {
+            min = dispatcher._min;
+            max = dispatcher._max;
+        }
+        else {
+            tbb::parallel_reduce(tbb::blocked_range<size_t>(0, getNumElements()), virtualReducer);
+            min = virtualReducer._min;
+            max = virtualReducer._max;
+        }
+
+        _normalizedIntensityRange = Interval<float>(); // reset interval to empty one
+        if (min <= max) {
+            _normalizedIntensityRange.nibble(min);
+            _normalizedIntensityRange.nibble(max);
+        }
+
+        if (histogram != 0)
+            histogram->mergeLocalBuckets();
 
         _intensityRangeDirty = false;
     }
 
-    ImageRepresentationLocal* ImageRepresentationLocal::create(const ImageData* parent, WeaklyTypedPointer wtp) {
+    ImageRepresentationLocal* ImageRepresentationLocal::create(const ImageData* parent, WeaklyTypedPointer wtp, std::shared_ptr<void> dataOwner /*= nullptr*/) {
 #define CONVERT_DISK_TO_GENERIC_LOCAL(baseType,numChannels) \
+        if (dataOwner != nullptr) \
+            return GenericImageRepresentationLocal<baseType, numChannels>::create( \
+                const_cast<ImageData*>(parent), \
+                reinterpret_cast< TypeTraits<baseType, numChannels>::ElementType*>(wtp._pointer), \
+                dataOwner); \
         return GenericImageRepresentationLocal<baseType, numChannels>::create( \
             const_cast<ImageData*>(parent), \
             reinterpret_cast< TypeTraits<baseType, numChannels>::ElementType*>(wtp._pointer));
@@ -27,6 +27,8 @@
 
 #include "cgt/vector.h"
 
+#include <memory>
+
 #include "core/datastructures/genericabstractimagerepresentation.h"
 #include "core/tools/concurrenthistogram.h"
 #include "core/tools/endianhelper.h"
@@ -45,7 +47,15 @@ namespace campvis {
          */
         virtual ~ImageRepresentationLocal();
 
-        static ImageRepresentationLocal* create(const ImageData* parent, WeaklyTypedPointer wtp);
+        /**
+         * Creates a new GenericImageRepresentationLocal matching the type of \a wtp and adds it to \a parent.
+         * \note    You do \b not own the returned pointer.
+         * \param   parent      Image this representation represents, must not be 0, will take ownership of the returned pointer.
+         * \param   wtp         Image data, the representation takes ownership of wtp._pointer unless \a dataOwner is given.
+         * \param   dataOwner   Optional object owning the memory of \a wtp, which is then kept alive instead of taking ownership.
+         * \return  A pointer to the newly created representation, you do \b not own this pointer!
+         */
+        static ImageRepresentationLocal* create(const ImageData* parent, WeaklyTypedPointer wtp, std::shared_ptr<void> dataOwner = nullptr);
 
         /// \see AbstractData::clone()
         virtual ImageRepresentationLocal* clone(ImageData* newParent) const = 0;
@@ -56,6 +66,12 @@ namespace campvis {
          * \return  A WeaklyTypedPointer to the image data.
          */
         virtual const WeaklyTypedPointer getWeaklyTypedPointer() const = 0;
+
+        /**
+         * Returns the base type of the image data.
+         * \return  _baseType
+         */
+        WeaklyTypedPointer::BaseType getBaseType() const;
         
         /**
          * Returns the normalized value of the element at the given index and channel.
@@ -153,6 +169,29 @@ namespace campvis {
          */
         const Interval<float>& getNormalizedIntensityRange() const;
 
+        /**
+         * Computes the histogram of the normalized intensities of the first channel and the range
+         * of normalized intensities in one single pass over the image data.
+         * The samples are inserted using ConcurrentGenericHistogramND::addSamples(), hence 
+         * \a histogram must not be filled concurrently by someone else.
+         * As a side effect, the lazily evaluated normalized intensity range gets updated.
+         * \sa      getNormalizedIntensityRange()
+         * \param   histogram   Histogram to fill with the normalized intensities.
+         * \return  The range of normalized intensities.
+         */
+        Interval<float> computeNormalizedIntensityHistogram(ConcurrentGenericHistogramND<float, 1>& histogram) const;
+
+        /**
+         * Fills \a histogram with the normalized intensities of the first channel of \a numSamples
+         * randomly chosen elements. This gives a quick estimate of the intensity distribution 
+         * without visiting every element. If the image has no more than \a numSamples elements, 
+         * all of them are used.
+         * \note    The random generator is seeded deterministically, hence the result is reproducible.
+         * \param   histogram   Histogram to fill with the sampled normalized intensities.
+         * \param   numSamples  Number of elements to sample.
+         */
+        void sampleNormalizedIntensityHistogram(ConcurrentGenericHistogramND<float, 1>& histogram, size_t numSamples) const;
+
     protected:
         /**
          * Creates a new ImageData representation in local memory.
@@ -168,6 +207,13 @@ namespace campvis {
          */
         void computeNormalizedIntensityRange() const;
 
+        /**
+         * Computes the normalized intensity range and optionally the intensity histogram in a 
+         * single parallel pass and stores the range in _normalizedIntensityRange.
+         * \param   histogram   Histogram to fill with the normalized intensities, may be 0.
+         */
+        void computeNormalizedIntensityRangeAndHistogram(ConcurrentGenericHistogramND<float, 1>* histogram) const;
+
 
         WeaklyTypedPointer::BaseType _baseType;     ///< Base type of the image data
 
@@ -30,6 +30,7 @@
 #include "cgt/vertexarrayobject.h"
 
 #include <algorithm>
+#include <limits>
 #include <list>
 #include <utility>
 
@@ -58,13 +59,39 @@ namespace campvis {
 
     }
 
+    IndexedMeshGeometry::IndexedMeshGeometry(
+        const std::vector<uint32_t>& indices, 
+        const std::vector<cgt::vec3>& vertices, 
+        const std::vector<cgt::vec3>& textureCoordinates /*= std::vector<cgt::vec3>()*/, 
+        const std::vector<cgt::vec4>& colors /*= std::vector<cgt::vec4>()*/, 
+        const std::vector<cgt::vec3>& normals /*= std::vector<cgt::vec3>() */)
+        : GeometryData()
+        , _vertices(vertices)
+        , _textureCoordinates(textureCoordinates)
+        , _colors(colors)
+        , _normals(normals)
+        , _indicesBuffer(0)
+    {
+        cgtAssert(textureCoordinates.empty() || textureCoordinates.size() == vertices.size(), "Texture coordinates vector must be either empty or of the same size as the vertex vector.");
+        cgtAssert(colors.empty() || colors.size() == vertices.size(), "Colors vector must be either empty or of the same size as the vertex vector.");
+        cgtAssert(normals.empty() || normals.size() == vertices.size(), "Normals vector must be either empty or of the same size as the vertex vector.");
+
+        // use 16 bit indices whenever possible
+        if (indices.empty() || *std::max_element(indices.begin(), indices.end()) <= std::numeric_limits<uint16_t>::max())
+            _indices.assign(indices.begin(), indices.end());
+        else
+            _wideIndices = indices;
+    }
+
     IndexedMeshGeometry::IndexedMeshGeometry(const IndexedMeshGeometry& rhs)
         : GeometryData(rhs)
         , _indices(rhs._indices)
+        , _wideIndices(rhs._wideIndices)
         , _vertices(rhs._vertices)
         , _textureCoordinates(rhs._textureCoordinates)
         , _colors(rhs._colors)
         , _normals(rhs._normals)
+        , _pickingInformation(rhs._pickingInformation)
         , _indicesBuffer(0)
     {
 
@@ -80,6 +107,7 @@ namespace campvis {
 
         GeometryData::operator=(rhs);
         _indices = rhs._indices;
+        _wideIndices = rhs._wideIndices;
         _vertices = rhs._vertices;
         _textureCoordinates = rhs._textureCoordinates;
         _colors = rhs._colors;
@@ -102,8 +130,28 @@ namespace campvis {
         _buffersDirty = true;
     }
 
+    size_t IndexedMeshGeometry::getNumIndices() const {
+        return _wideIndices.empty() ? _indices.size() : _wideIndices.size();
+    }
+
+    bool IndexedMeshGeometry::hasWideIndices() const {
+        return ! _wideIndices.empty();
+    }
+
+    uint32_t IndexedMeshGeometry::getIndex(size_t i) const {
+        return _wideIndices.empty() ? _indices[i] : _wideIndices[i];
+    }
+
+    const std::vector<cgt::vec3>& IndexedMeshGeometry::getVertices() const {
+        return _vertices;
+    }
+
+    const std::vector<cgt::vec3>& IndexedMeshGeometry::getNormals() const {
+        return _normals;
+    }
+
     IndexedMeshGeometry* IndexedMeshGeometry::clone() const {
-        IndexedMeshGeometry* toReturn = new IndexedMeshGeometry(_indices, _vertices, _textureCoordinates, _colors, _normals);
+        IndexedMeshGeometry* toReturn = new IndexedMeshGeometry(*this);
         toReturn->setPickingInformation(_pickingInformation);
         return toReturn;
     }
@@ -115,7 +163,7 @@ namespace campvis {
                 sum += sizeof(cgt::BufferObject);
         }
 
-        return sizeof(*this) + sum + (sizeof(size_t) * _indices.size()) + (sizeof(cgt::vec3) * (_vertices.size() + _textureCoordinates.size() + _normals.size())) + (sizeof(cgt::vec4) * _colors.size());
+        return sizeof(*this) + sum + (sizeof(uint16_t) * _indices.size()) + (sizeof(uint32_t) * _wideIndices.size()) + (sizeof(cgt::vec3) * (_vertices.size() + _textureCoordinates.size() + _normals.size())) + (sizeof(cgt::vec4) * _colors.size());
     }
 
     size_t IndexedMeshGeometry::getVideoMemoryFootprint() const {
@@ -124,7 +172,7 @@ namespace campvis {
 
 
     void IndexedMeshGeometry::render(GLenum mode) const {
-        if (_indices.empty())
+        if (getNumIndices() == 0)
             return;
 
         createGLBuffers();
@@ -146,7 +194,7 @@ namespace campvis {
             vao.setVertexAttributePointer(4, _pickingBuffer);
         vao.bindIndexBuffer(_indicesBuffer);
 
-        glDrawElements(mode, static_cast<GLsizei>(_indices.size()), GL_UNSIGNED_SHORT, 0);
+        glDrawElements(mode, static_cast<GLsizei>(getNumIndices()), hasWideIndices() ? GL_UNSIGNED_INT : GL_UNSIGNED_SHORT, 0);
         LGL_ERROR;
     }
 
@@ -157,7 +205,10 @@ namespace campvis {
 
             try {
                 _indicesBuffer = new cgt::BufferObject(cgt::BufferObject::ELEMENT_ARRAY_BUFFER, cgt::BufferObject::USAGE_STATIC_DRAW);
-                _indicesBuffer->data(&_indices.front(), _indices.size() * sizeof(uint16_t), cgt::BufferObject::UNSIGNED_SHORT, 1);
+                if (hasWideIndices())
+                    _indicesBuffer->data(&_wideIndices.front(), _wideIndices.size() * sizeof(uint32_t), cgt::BufferObject::UNSIGNED_INT, 1);
+                else
+                    _indicesBuffer->data(&_indices.front(), _indices.size() * sizeof(uint16_t), cgt::BufferObject::UNSIGNED_SHORT, 1);
 
                 _verticesBuffer = new cgt::BufferObject(cgt::BufferObject::ARRAY_BUFFER, cgt::BufferObject::USAGE_STATIC_DRAW);
                 _verticesBuffer->data(&_vertices.front(), _vertices.size() * sizeof(cgt::vec3), cgt::BufferObject::FLOAT, 3);
@@ -37,6 +37,7 @@ namespace campvis {
     /**
      * Class for mesh geometry.
      * Every IndexedMeshGeometry consists of a stream of vertices and an index list defining the faces.
+     * Indices are stored with 16 bit if all of them fit, and with 32 bit otherwise.
      * 
      * The internal OpenGL buffers are lazy-instantiated.
      * 
@@ -60,6 +61,23 @@ namespace campvis {
             const std::vector<cgt::vec4>& colors = std::vector<cgt::vec4>(),
             const std::vector<cgt::vec3>& normals = std::vector<cgt::vec3>()
             );
+
+        /**
+         * Creates a new IndexedMeshGeometry built from the given faces with 32 bit indices.
+         * If all indices fit into 16 bit, they are stored as such to save memory.
+         * \param   indices             Index list defining the faces.
+         * \param   vertices            The list of the vertex positions of the face.
+         * \param   textureCoordinates  The list of vertex texture coordinates, may be empty.
+         * \param   colors              The list of vertex colors, may be empty.
+         * \param   normals             The list of vertex normals, may be empty.
+         */
+        explicit IndexedMeshGeometry(
+            const std::vector<uint32_t>& indices,
+            const std::vector<cgt::vec3>& vertices,
+            const std::vector<cgt::vec3>& textureCoordinates = std::vector<cgt::vec3>(),
+            const std::vector<cgt::vec4>& colors = std::vector<cgt::vec4>(),
+            const std::vector<cgt::vec3>& normals = std::vector<cgt::vec3>()
+            );
         
         /**
          * Copy constructor
@@ -92,6 +110,37 @@ namespace campvis {
          */
         void setPickingInformation(const std::vector<cgt::col4>& pickingInformation);
 
+        /**
+         * Returns the number of indices of this geometry.
+         * \return  The size of the index list.
+         */
+        size_t getNumIndices() const;
+
+        /**
+         * Returns whether this geometry stores its indices with 32 bit.
+         * \return  !_wideIndices.empty()
+         */
+        bool hasWideIndices() const;
+
+        /**
+         * Returns the \a i-th index of this geometry, regardless of its width.
+         * \param   i   Position in the index list, must be smaller than getNumIndices().
+         * \return  The index as 32 bit integer.
+         */
+        uint32_t getIndex(size_t i) const;
+
+        /**
+         * The list of the vertex positions of the face.
+         * \return _vertices
+         */
+        const std::vector<cgt::vec3>& getVertices() const;
+
+        /**
+         * The list of vertex normals, may be empty.
+         * \return _normals
+         */
+        const std::vector<cgt::vec3>& getNormals() const;
+
 
         /// \see AbstractData::clone()
         virtual IndexedMeshGeometry* clone() const;
@@ -128,7 +177,8 @@ namespace campvis {
         /// Deletes the OpenGL BufferObject for the indices.
         void deleteIndicesBuffer() const;
 
-        std::vector<uint16_t> _indices;                 ///< Index list defining the faces
+        std::vector<uint16_t> _indices;                 ///< Index list defining the faces, empty if _wideIndices is used
+        std::vector<uint32_t> _wideIndices;             ///< 32 bit index list defining the faces, only used if there are indices >= 65536
         std::vector<cgt::vec3> _vertices;               ///< The list of the vertex positions of the face.
         std::vector<cgt::vec3> _textureCoordinates;     ///< The list of vertex texture coordinates, may be empty.
         std::vector<cgt::vec4> _colors;                 ///< The list of vertex colors, may be empty.
@@ -37,6 +37,11 @@ namespace campvis {
 
     const std::string MultiIndexedGeometry::loggerCat_ = "CAMPVis.core.datastructures.MultiIndexedGeometry";
 
+    namespace {
+        const uint16_t RESTART_INDEX_16 = 65535;
+        const uint32_t RESTART_INDEX_32 = 0xFFFFFFFF;
+    }
+
 
     MultiIndexedGeometry::MultiIndexedGeometry(
         const std::vector<cgt::vec3>& vertices, 
@@ -59,6 +64,7 @@ namespace campvis {
     MultiIndexedGeometry::MultiIndexedGeometry(const MultiIndexedGeometry& rhs)
         : GeometryData(rhs)
         , _indices(rhs._indices)
+        , _wideIndices(rhs._wideIndices)
         , _vertices(rhs._vertices)
         , _textureCoordinates(rhs._textureCoordinates)
         , _colors(rhs._colors)
@@ -78,6 +84,7 @@ namespace campvis {
 
         GeometryData::operator=(rhs);
         _indices = rhs._indices;
+        _wideIndices = rhs._wideIndices;
 
         _vertices = rhs._vertices;
         _textureCoordinates = rhs._textureCoordinates;
@@ -93,6 +100,7 @@ namespace campvis {
     MultiIndexedGeometry* MultiIndexedGeometry::clone() const {
         MultiIndexedGeometry* toReturn = new MultiIndexedGeometry(_vertices, _textureCoordinates, _colors, _normals);
         toReturn->_indices = _indices;
+        toReturn->_wideIndices = _wideIndices;
 
         return toReturn;
     }
@@ -107,7 +115,7 @@ namespace campvis {
                 sum += sizeof(cgt::BufferObject);
         }
 
-        return sizeof(*this) + sum + (sizeof(size_t) * _indices.size()) + (sizeof(cgt::vec3) * (_vertices.size() + _textureCoordinates.size() + _normals.size())) + (sizeof(cgt::vec4) * _colors.size());
+        return sizeof(*this) + sum + (sizeof(uint16_t) * _indices.size()) + (sizeof(uint32_t) * _wideIndices.size()) + (sizeof(cgt::vec3) * (_vertices.size() + _textureCoordinates.size() + _normals.size())) + (sizeof(cgt::vec4) * _colors.size());
     }
 
     size_t MultiIndexedGeometry::getVideoMemoryFootprint() const {
@@ -115,13 +123,50 @@ namespace campvis {
     }
 
     void MultiIndexedGeometry::addPrimitive(const std::vector<uint16_t>& indices) {
+        if (hasWideIndices()) {
+            addPrimitive(std::vector<uint32_t>(indices.begin(), indices.end()));
+            return;
+        }
+
         if (! _indices.empty())
-            _indices.push_back(65535);
+            _indices.push_back(RESTART_INDEX_16);
 
         _indices.insert(_indices.end(), indices.begin(), indices.end());
         _buffersDirty = true;
     }
 
+    void MultiIndexedGeometry::addPrimitive(const std::vector<uint32_t>& indices) {
+        // stay with 16 bit indices as long as possible, 65535 is reserved for primitive restart
+        if (! hasWideIndices() && (indices.empty() || *std::max_element(indices.begin(), indices.end()) < RESTART_INDEX_16)) {
+            addPrimitive(std::vector<uint16_t>(indices.begin(), indices.end()));
+            return;
+        }
+
+        widenIndices();
+        if (! _wideIndices.empty())
+            _wideIndices.push_back(RESTART_INDEX_32);
+
+        _wideIndices.insert(_wideIndices.end(), indices.begin(), indices.end());
+        _buffersDirty = true;
+    }
+
+    size_t MultiIndexedGeometry::getNumIndices() const {
+        return hasWideIndices() ? _wideIndices.size() : _indices.size();
+    }
+
+    bool MultiIndexedGeometry::hasWideIndices() const {
+        return ! _wideIndices.empty();
+    }
+
+    void MultiIndexedGeometry::widenIndices() {
+        _wideIndices.reserve(_wideIndices.size() + _indices.size());
+        for (size_t i = 0; i < _indices.size(); ++i)
+            _wideIndices.push_back(_indices[i] == RESTART_INDEX_16 ? RESTART_INDEX_32 : _indices[i]);
+
+        std::vector<uint16_t>().swap(_indices);
+        _buffersDirty = true;
+    }
+
     const std::vector<cgt::col4>& MultiIndexedGeometry::getPickingInformation() const {
         return _pickingInformation;
     }
@@ -133,7 +178,7 @@ namespace campvis {
     }
 
     void MultiIndexedGeometry::render(GLenum mode) const {
-        if (_indices.empty())
+        if (getNumIndices() == 0)
             return;
 
         createGLBuffers();
@@ -156,15 +201,15 @@ namespace campvis {
         vao.bindIndexBuffer(_indicesBuffer);
 
         glEnable(GL_PRIMITIVE_RESTART);
-        glPrimitiveRestartIndex(65535);
-        glDrawElements(mode, static_cast<GLsizei>(_indices.size()), GL_UNSIGNED_SHORT, 0);
+        glPrimitiveRestartIndex(hasWideIndices() ? RESTART_INDEX_32 : RESTART_INDEX_16);
+        glDrawElements(mode, static_cast<GLsizei>(getNumIndices()), hasWideIndices() ? GL_UNSIGNED_INT : GL_UNSIGNED_SHORT, 0);
         glDisable(GL_PRIMITIVE_RESTART);
 
         LGL_ERROR;
     }
 
     void MultiIndexedGeometry::renderInstanced(GLsizei count, GLenum mode /*= GL_TRIANGLE_FAN*/) const {
-        if (_indices.empty())
+        if (getNumIndices() == 0)
             return;
 
         createGLBuffers();
@@ -187,8 +232,8 @@ namespace campvis {
         vao.bindIndexBuffer(_indicesBuffer);
 
         glEnable(GL_PRIMITIVE_RESTART);
-        glPrimitiveRestartIndex(65535);
-        glDrawElementsInstanced(mode, static_cast<GLsizei>(_indices.size()), GL_UNSIGNED_SHORT, 0, count);
+        glPrimitiveRestartIndex(hasWideIndices() ? RESTART_INDEX_32 : RESTART_INDEX_16);
+        glDrawElementsInstanced(mode, static_cast<GLsizei>(getNumIndices()), hasWideIndices() ? GL_UNSIGNED_INT : GL_UNSIGNED_SHORT, 0, count);
         glDisable(GL_PRIMITIVE_RESTART);
 
         LGL_ERROR;
@@ -201,7 +246,10 @@ namespace campvis {
 
             try {
                 _indicesBuffer = new cgt::BufferObject(cgt::BufferObject::ELEMENT_ARRAY_BUFFER, cgt::BufferObject::USAGE_STATIC_DRAW);
-                _indicesBuffer->data(&_indices.front(), _indices.size() * sizeof(uint16_t), cgt::BufferObject::UNSIGNED_SHORT, 1);
+                if (hasWideIndices())
+                    _indicesBuffer->data(&_wideIndices.front(), _wideIndices.size() * sizeof(uint32_t), cgt::BufferObject::UNSIGNED_INT, 1);
+                else
+                    _indicesBuffer->data(&_indices.front(), _indices.size() * sizeof(uint16_t), cgt::BufferObject::UNSIGNED_SHORT, 1);
 
                 _verticesBuffer = new cgt::BufferObject(cgt::BufferObject::ARRAY_BUFFER, cgt::BufferObject::USAGE_STATIC_DRAW);
                 _verticesBuffer->data(&_vertices.front(), _vertices.size() * sizeof(cgt::vec3), cgt::BufferObject::FLOAT, 3);
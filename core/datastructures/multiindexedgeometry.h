@@ -39,6 +39,8 @@ namespace campvis {
      * Internally working with glMultiDrawElements(), every MultiIndexedGeometry consists of a 
      * stream of vertices, an index list defining the faces and a pair of arrays defining start
      * indices and number of indices for each primitive to render.
+     * Indices are stored with 16 bit as long as all of them fit, the storage is widened to 
+     * 32 bit once a primitive with a larger index is added.
      * 
      * The internal OpenGL buffers are lazy-instantiated.
      */
@@ -90,6 +92,24 @@ namespace campvis {
          * \param   indices     Index list defining the faces.
          */
         void addPrimitive(const std::vector<uint16_t>& indices);
+
+        /**
+         * Add a render primitive given by a list of 32 bit indices.
+         * \param   indices     Index list defining the faces.
+         */
+        void addPrimitive(const std::vector<uint32_t>& indices);
+
+        /**
+         * Returns the number of indices of this geometry, including the primitive restart indices.
+         * \return  The size of the index list.
+         */
+        size_t getNumIndices() const;
+
+        /**
+         * Returns whether this geometry stores its indices with 32 bit.
+         * \return  !_wideIndices.empty()
+         */
+        bool hasWideIndices() const;
         
         /**
          * The list of picking information colors, may be empty.
@@ -137,7 +157,11 @@ namespace campvis {
         /// Deletes the OpenGL BufferObject for the indices.
         void deleteIndicesBuffer() const;
 
-        std::vector<uint16_t> _indices;                 ///< Index list defining the faces
+        /// Converts the 16 bit index list into the 32 bit one, including the primitive restart indices.
+        void widenIndices();
+
+        std::vector<uint16_t> _indices;                 ///< Index list defining the faces, empty if _wideIndices is used
+        std::vector<uint32_t> _wideIndices;             ///< 32 bit index list defining the faces, only used if there are indices >= 65535
 
         std::vector<cgt::vec3> _vertices;               ///< The list of the vertex positions of the face.
         std::vector<cgt::vec3> _textureCoordinates;     ///< The list of vertex texture coordinates, may be empty.
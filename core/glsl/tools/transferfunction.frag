@@ -58,6 +58,26 @@ vec4 lookupTF(in sampler1D tf, in TFParameters1D texParams, in float intensity)
     return (intensity >= 0.0 ? texture(tf, intensity) : vec4(0.0, 0.0, 0.0, 0.0));
 }
 
+/**
+ * Performs a pre-integrated 1D transfer function lookup for the ray segment between the given front
+ * and back sample intensities, as computed by Geometry1DTransferFunction::bindPreIntegrationTable().
+ * Before lookup both intensities will be mapped to the TF domain.
+ * \param	table			Pre-integration table sampler
+ * \param   texParams       TF parameters struct
+ * \param	intensityFront	Image intensity of the segment's front sample (normalized to [0, 1])
+ * \param	intensityBack	Image intensity of the segment's back sample (normalized to [0, 1])
+ * \return	The color (not premultiplied) and opacity of the segment for the base sampling interval.
+ */
+vec4 lookupPreIntegratedTF(in sampler2D table, in TFParameters1D texParams, in float intensityFront, in float intensityBack) {
+    vec2 domain = texParams._intensityDomain;
+    vec2 intensities = (vec2(intensityBack, intensityFront) - domain.x) / (domain.y - domain.x);
+
+    // segments entirely outside the TF domain are transparent, partially outside ones are clamped
+    if (all(lessThan(intensities, vec2(0.0))) || all(greaterThan(intensities, vec2(1.0))))
+        return vec4(0.0, 0.0, 0.0, 0.0);
+    return texture(table, clamp(intensities, 0.0, 1.0));
+}
+
 /**
  * Performs a 2D transfer function lookup for the given TF, intensity and y-value.
  * Before lookup \a intensity will be mapped to the TF domain.
@@ -36,6 +36,7 @@
 #include "core/datastructures/imagerepresentationconverter.h"
 #include "core/pipeline/pipelinefactory.h"
 #include "core/pipeline/processorfactory.h"
+#include "core/tools/processorprofiler.h"
 #include "core/tools/quadrenderer.h"
 #include "core/tools/simplejobprocessor.h"
 
@@ -46,6 +47,7 @@ namespace campvis {
         sigslot::signal_manager::init();
         sigslot::signal_manager::getRef().start();
         SimpleJobProcessor::init();
+        ProcessorProfiler::init();
 
         // Init CGT
         cgt::init(cgt::InitFeature::ALL, cgt::Debug);
@@ -85,6 +87,7 @@ namespace campvis {
         cgt::deinitGL();
         cgt::deinit();
 
+        ProcessorProfiler::deinit();
         SimpleJobProcessor::deinit();
         ImageRepresentationConverter::deinit();
         PipelineFactory::deinit();
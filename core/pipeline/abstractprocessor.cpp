@@ -25,6 +25,7 @@
 #include "abstractprocessor.h"
 #include "cgt/assert.h"
 #include "core/properties/abstractproperty.h"
+#include "core/tools/processorprofiler.h"
 
 #include <ext/threading.h>
 
@@ -41,6 +42,7 @@ namespace campvis {
         _ignorePropertyChanges = 0;
         _locked = 0;
         _level = VALID;
+        _invalidationTime = 0;
     }
 
     AbstractProcessor::~AbstractProcessor() {
@@ -114,6 +116,11 @@ namespace campvis {
             do {
                 tmp = _level;
             } while (_level.compare_and_swap(tmp | level, tmp) != tmp);
+
+            // remember when the processor became invalid to measure its queue wait time
+            if (tmp == VALID && ProcessorProfiler::isCapturing())
+                _invalidationTime = ProcessorProfiler::getTimestamp();
+
             s_invalidated.emitSignal(this);
         }
     }
@@ -136,13 +143,29 @@ namespace campvis {
 
 
     void AbstractProcessor::process(DataContainer& data) {
+        bool profile = ProcessorProfiler::isCapturing();
+        long long invalidationTime = _invalidationTime.fetch_and_store(0);
+        long long startTime = 0;
+
         if (hasInvalidShader()) {
+            if (profile)
+                startTime = ProcessorProfiler::getTimestamp();
+
             updateShader();
             validate(INVALID_SHADER);
+
+            if (profile)
+                ProcProfiler.record(data.getName(), getName(), INVALID_SHADER, startTime, ProcessorProfiler::getTimestamp(), invalidationTime);
         }
         if (hasInvalidProperties()) {
+            if (profile)
+                startTime = ProcessorProfiler::getTimestamp();
+
             updateProperties(data);
             validate(INVALID_PROPERTIES);
+
+            if (profile)
+                ProcProfiler.record(data.getName(), getName(), INVALID_PROPERTIES, startTime, ProcessorProfiler::getTimestamp(), invalidationTime);
         }
 
         // use a scoped lock for exception safety
@@ -150,8 +173,14 @@ namespace campvis {
         cgtAssert(_locked == true, "Processor not locked, this should not happen!");
 
         if (hasInvalidResult()) {
+            if (profile)
+                startTime = ProcessorProfiler::getTimestamp();
+
             updateResult(data);
             validate(INVALID_RESULT);
+
+            if (profile)
+                ProcProfiler.record(data.getName(), getName(), INVALID_RESULT, startTime, ProcessorProfiler::getTimestamp(), invalidationTime);
         }
     }
 
@@ -148,6 +148,16 @@ namespace campvis {
          * \return  The current processor state in terms of stability.
          */
         virtual ProcessorState getProcessorState() const = 0;
+
+        /**
+         * Returns whether this processor may be executed on an arbitrary worker thread without an
+         * OpenGL context, concurrently to other processors of the same pipeline.
+         * Such processors must not issue OpenGL calls other than through 
+         * cgt::OpenGLJobProcessor::ScopedSynchronousGlJobExecution.
+         * Defaults to false, override in processors performing only CPU work.
+         * \return  false
+         */
+        virtual bool supportsConcurrentExecution() const { return false; };
         
         /**
          * Registers \a prop as property with the provided invalidation level. Registered properties 
@@ -378,6 +388,7 @@ namespace campvis {
 
     private:
         tbb::atomic<int> _level;            ///< current invalidation level
+        tbb::atomic<long long> _invalidationTime;   ///< timestamp of the last invalidation of a valid processor (only set while profiling)
         tbb::concurrent_queue<int> _queuedInvalidations;
 
         static const std::string loggerCat_;
@@ -27,6 +27,14 @@
 #include "cgt/cgt_gl.h"
 #include "cgt/glcanvas.h"
 
+#include <ext/threading.h>
+#include <tbb/task_group.h>
+
+#include <algorithm>
+#include <deque>
+#include <functional>
+#include <set>
+
 #include "core/pipeline/visualizationprocessor.h"
 #include "core/properties/datanameproperty.h"
 #include "core/properties/metaproperty.h"
@@ -38,6 +46,7 @@ namespace campvis {
         : AbstractPipeline(dataContainer)
         , _pipelineName(pipelineName)
     {
+        _parallelExecution = true;
     }
 
     AutoEvaluationPipeline::~AutoEvaluationPipeline() {
@@ -75,6 +84,19 @@ namespace campvis {
     }
 
     void AutoEvaluationPipeline::executePipeline() {
+        if (_parallelExecution) {
+            std::vector<ProcessorNode> graph = buildDependencyGraph();
+
+            // only pay for the scheduling if there is anything to execute concurrently
+            for (size_t i = 0; i < graph.size(); ++i) {
+                AbstractProcessor* p = graph[i]._processor;
+                if (! graph[i]._onPipelineThread && p->getEnabled() && !p->isLocked() && !p->isValid()) {
+                    executeDependencyGraph(graph);
+                    return;
+                }
+            }
+        }
+
         // execute each processor once
         // (AbstractProcessor::process() takes care of executing only invalid processors)
         for (size_t i = 0; i < _processors.size(); ++i) {
@@ -82,6 +104,181 @@ namespace campvis {
         }
     }
 
+    bool AutoEvaluationPipeline::getParallelExecution() const {
+        return _parallelExecution;
+    }
+
+    void AutoEvaluationPipeline::setParallelExecution(bool value) {
+        _parallelExecution = value;
+    }
+
+    namespace {
+        /// Local helper function to recursively collect the names of all data read and written by
+        /// the DataNameProperties in \a hpc.
+        void collectDataNames(const HasPropertyCollection* hpc, std::set<std::string>& reads, std::set<std::string>& writes) {
+            const PropertyCollection& pc = hpc->getProperties();
+            for (size_t i = 0; i < pc.size(); ++i) {
+                if (const DataNameProperty* dnp = dynamic_cast<const DataNameProperty*>(pc[i])) {
+                    if (dnp->getAccessInfo() == DataNameProperty::READ)
+                        reads.insert(dnp->getValue());
+                    else
+                        writes.insert(dnp->getValue());
+                }
+                else if (const MetaProperty* mp = dynamic_cast<const MetaProperty*>(pc[i])) {
+                    collectDataNames(mp, reads, writes);
+                }
+            }
+        }
+
+        /// Local helper function checking whether the two sorted sets share at least one element.
+        bool intersects(const std::set<std::string>& lhs, const std::set<std::string>& rhs) {
+            std::set<std::string>::const_iterator l = lhs.begin(), r = rhs.begin();
+            while (l != lhs.end() && r != rhs.end()) {
+                if (*l < *r)
+                    ++l;
+                else if (*r < *l)
+                    ++r;
+                else
+                    return true;
+            }
+            return false;
+        }
+    }
+
+    std::vector<AutoEvaluationPipeline::ProcessorNode> AutoEvaluationPipeline::buildDependencyGraph() const {
+        const size_t numProcessors = _processors.size();
+        std::vector<std::set<std::string> > reads(numProcessors), writes(numProcessors);
+        std::vector<ProcessorNode> graph(numProcessors);
+
+        for (size_t i = 0; i < numProcessors; ++i) {
+            AbstractProcessor* p = _processors[i];
+            tbb::concurrent_hash_map<AbstractProcessor*, bool>::const_accessor a;
+            bool isVisProcessor = !_isVisProcessorMap.find(a, p) || a->second;
+
+            graph[i]._processor = p;
+            graph[i]._onPipelineThread = isVisProcessor || !p->supportsConcurrentExecution();
+            graph[i]._numPendingPredecessors = 0;
+            collectDataNames(p, reads[i], writes[i]);
+        }
+
+        for (size_t j = 0; j < numProcessors; ++j) {
+            bool chainedToPipelineThread = false;
+
+            // iterate backwards, so that we only chain to the closest preceding pipeline thread processor
+            for (size_t i = j; i-- > 0; ) {
+                bool dependent = intersects(writes[i], reads[j]) || intersects(reads[i], writes[j]) || intersects(writes[i], writes[j]);
+                bool chained = graph[i]._onPipelineThread && graph[j]._onPipelineThread && !chainedToPipelineThread;
+
+                if (dependent || chained) {
+                    graph[i]._successors.push_back(j);
+                    ++graph[j]._numPendingPredecessors;
+                }
+                if (chained)
+                    chainedToPipelineThread = true;
+            }
+        }
+
+        return graph;
+    }
+
+    void AutoEvaluationPipeline::executeDependencyGraph(std::vector<ProcessorNode>& graph) {
+        std::mutex mutex;
+        std::condition_variable condition;
+        std::deque<size_t> readyOnPipelineThread;   ///< ready nodes that must be executed on this thread
+        std::deque<size_t> readyOnAnyThread;        ///< ready nodes that may be executed on any thread
+        size_t numFinished = 0;
+        tbb::task_group tasks;
+
+        std::function<void()> runReadyNode;
+        std::function<void(size_t)> onFinished = [&] (size_t index) {
+            const std::vector<size_t>& successors = graph[index]._successors;
+            std::lock_guard<std::mutex> lock(mutex);
+            for (size_t i = 0; i < successors.size(); ++i) {
+                size_t s = successors[i];
+                if (--graph[s]._numPendingPredecessors == 0) {
+                    if (graph[s]._onPipelineThread) {
+                        readyOnPipelineThread.push_back(s);
+                    }
+                    else {
+                        readyOnAnyThread.push_back(s);
+                        tasks.run(runReadyNode);
+                    }
+                }
+            }
+
+            ++numFinished;
+            condition.notify_one();
+        };
+
+        // Each spawned task executes one ready node, if the pipeline thread did not take it yet.
+        runReadyNode = [&] () {
+            size_t index;
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                if (readyOnAnyThread.empty())
+                    return;
+                index = readyOnAnyThread.front();
+                readyOnAnyThread.pop_front();
+            }
+
+            executeProcessor(graph[index]._processor);
+            onFinished(index);
+        };
+
+        // The pipeline thread stays in the arena the whole time, so that the workers can pick up
+        // the tasks it spawned.
+        _arena.execute([&] () {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                for (size_t i = 0; i < graph.size(); ++i) {
+                    if (graph[i]._numPendingPredecessors == 0) {
+                        if (graph[i]._onPipelineThread) {
+                            readyOnPipelineThread.push_back(i);
+                        }
+                        else {
+                            readyOnAnyThread.push_back(i);
+                            tasks.run(runReadyNode);
+                        }
+                    }
+                }
+            }
+
+            // Execute processors needing the OpenGL context on this thread. While there are none,
+            // help with the others instead of blocking, so we make progress without worker threads.
+            while (true) {
+                size_t index;
+                bool onPipelineThread;
+                {
+                    std::unique_lock<std::mutex> lock(mutex);
+                    while (readyOnPipelineThread.empty() && readyOnAnyThread.empty() && numFinished != graph.size())
+                        condition.wait(lock);
+
+                    if (! readyOnPipelineThread.empty()) {
+                        index = readyOnPipelineThread.front();
+                        readyOnPipelineThread.pop_front();
+                        onPipelineThread = true;
+                    }
+                    else if (! readyOnAnyThread.empty()) {
+                        index = readyOnAnyThread.front();
+                        readyOnAnyThread.pop_front();
+                        onPipelineThread = false;
+                    }
+                    else {
+                        break;
+                    }
+                }
+
+                if (onPipelineThread)
+                    executeProcessorAndCheckOpenGLState(graph[index]._processor);
+                else
+                    executeProcessor(graph[index]._processor);
+                onFinished(index);
+            }
+
+            tasks.wait();
+        });
+    }
+
     void AutoEvaluationPipeline::onDataNamePropertyChanged(const AbstractProperty* prop) {
         // static_cast is safe since this slot only get called for DataNameProperties
         // const_cast is not beautiful but safe here as well
@@ -29,15 +29,24 @@
 #include <tbb/concurrent_hash_map.h>
 #include <tbb/concurrent_unordered_map.h>
 #include <tbb/spin_rw_mutex.h>
+#include <tbb/task_arena.h>
 
 #include "core/pipeline/abstractpipeline.h"
 
+#include <vector>
+
 
 namespace campvis {
     /**
      * Specializtaion of AbstractPipeline performing automatic execution of invalidated processors.
      * AutoEvaluationPipeline connects to the s_(in)validated signals of all of its processors and
      * executes processors with invalid results using the correct threads.
+     * 
+     * If parallel execution is enabled, the pipeline derives a dependency graph from the 
+     * DataNameProperties of its processors. Processors supporting concurrent execution are then
+     * executed on a TBB task arena as soon as all of their predecessors are finished, while all 
+     * other processors are executed one after another on the pipeline thread owning the OpenGL
+     * context, in the order they were added.
      */
     class CAMPVIS_CORE_API AutoEvaluationPipeline : public AbstractPipeline {
     public:
@@ -69,7 +78,45 @@ namespace campvis {
         /// \see AbstractPipeline::executePipeline()
         virtual void executePipeline() override;
 
+        /**
+         * Returns whether independent processors are executed in parallel.
+         * \return  _parallelExecution
+         */
+        bool getParallelExecution() const;
+
+        /**
+         * Sets whether independent processors supporting concurrent execution shall be executed 
+         * in parallel.
+         * \param   value   New flag whether to execute independent processors in parallel.
+         */
+        void setParallelExecution(bool value);
+
     protected:
+        /**
+         * Node of the processor dependency graph.
+         */
+        struct ProcessorNode {
+            AbstractProcessor* _processor;              ///< The processor to execute
+            bool _onPipelineThread;                     ///< Flag whether the processor needs to be executed on the pipeline thread
+            std::vector<size_t> _successors;            ///< Indices of the nodes depending on this one
+            tbb::atomic<size_t> _numPendingPredecessors;///< Number of predecessors not yet executed
+        };
+
+        /**
+         * Builds the dependency graph of all processors of this pipeline. Processor B depends on
+         * processor A if A was added before B and both access the same data where at least one of
+         * them writes it. Processors to be executed on the pipeline thread are additionally chained
+         * in their original order.
+         * \return  The dependency graph, node i corresponds to _processors[i].
+         */
+        std::vector<ProcessorNode> buildDependencyGraph() const;
+
+        /**
+         * Executes all processors of \a graph respecting the dependencies. Blocks until all 
+         * processors are executed.
+         * \param   graph   Dependency graph as built by buildDependencyGraph().
+         */
+        void executeDependencyGraph(std::vector<ProcessorNode>& graph);
 
         /**
          * Slot getting called when one of the observed processors got invalidated.
@@ -130,6 +177,9 @@ namespace campvis {
         PortMapType _portMap;
         IteratorMapType _iteratorMap;
         tbb::spin_rw_mutex _pmMutex;
+
+        tbb::atomic<bool> _parallelExecution;   ///< Flag whether to execute independent processors in parallel
+        tbb::task_arena _arena;                 ///< Task arena for executing processors concurrently
     };
 
 }
@@ -25,17 +25,26 @@
 #include "transferfunctionproperty.h"
 #include "core/datastructures/imagedata.h"
 #include "core/datastructures/imagerepresentationlocal.h"
+#include "core/tools/simplejobprocessor.h"
 
 #include <tbb/tbb.h>
 
 namespace campvis {
 
+    namespace {
+        /// Maximum number of buckets of the intensity histogram
+        const size_t MAX_NUM_BUCKETS = 512;
+        /// Number of voxels sampled for the preview histogram
+        const size_t NUM_PREVIEW_SAMPLES = 65536;
+    }
+
     const std::string TransferFunctionProperty::loggerCat_ = "CAMPVis.core.datastructures.TransferFunctionProperty";
 
     TransferFunctionProperty::TransferFunctionProperty(const std::string& name, const std::string& title, AbstractTransferFunction* tf)
         : AbstractProperty(name, title)
         , _transferFunction(tf)
         , _imageHandle(0)
+        , _histogramJobState(new HistogramJobState())
         , _autoFitWindowToData(true)
     {
         cgtAssert(tf != 0, "Assigned transfer function must not be 0.");
@@ -45,9 +54,17 @@ namespace campvis {
 
         _intensityHistogram = 0;
         _dirtyHistogram = false;
+        _histogramJobState->_pending = false;
+        _histogramJobState->_property = this;
     }
 
     TransferFunctionProperty::~TransferFunctionProperty() {
+        // detach a pending background histogram job, it only touches this property while holding the mutex
+        {
+            tbb::mutex::scoped_lock lock(_histogramJobState->_mutex);
+            _histogramJobState->_property = 0;
+        }
+
         delete _transferFunction;
         delete _intensityHistogram;
     }
@@ -128,25 +145,74 @@ namespace campvis {
     void TransferFunctionProperty::computeIntensityHistogram() const {
         IntensityHistogramType* newHistogram = 0;
 
+        // reset the flag first, so that a background job finishing in the meantime is not missed
+        _dirtyHistogram = false;
+
         // create new histogram according to the current intensity domain
-        ImageRepresentationLocal::ScopedRepresentation repLocal(_imageHandle);
-        if (repLocal != 0) {
+        if (const ImageData* id = static_cast<const ImageData*>(_imageHandle.getData())) {
             float mins = _transferFunction->getIntensityDomain().x;
             float maxs = _transferFunction->getIntensityDomain().y;
-            size_t numBuckets = std::min(WeaklyTypedPointer::numBytes(repLocal->getWeaklyTypedPointer()._baseType) << 8, static_cast<size_t>(512));
-            newHistogram = new IntensityHistogramType(&mins, &maxs, &numBuckets);
-            tbb::parallel_for(tbb::blocked_range<size_t>(0, repLocal->getNumElements()), [&] (const tbb::blocked_range<size_t>& range) {
-                for (size_t i = range.begin(); i != range.end(); ++i) {
-                    float value = repLocal->getElementNormalized(i, 0);
-                    newHistogram->addSample(&value);
+
+            std::shared_ptr<const ImageData::IntensityHistogramType> nativeHistogram = id->getNativeIntensityHistogram(false);
+            if (nativeHistogram != nullptr) {
+                // rebin the native histogram by assigning each of its buckets to the bucket containing its center
+                size_t numBuckets = std::min(nativeHistogram->getNumBuckets(0), MAX_NUM_BUCKETS);
+                newHistogram = new IntensityHistogramType(&mins, &maxs, &numBuckets);
+
+                const size_t numNativeBuckets = nativeHistogram->getNumBuckets(0);
+                const float nativeMin = nativeHistogram->getMin(0);
+                const float nativeBucketWidth = (nativeHistogram->getMax(0) - nativeMin) / static_cast<float>(numNativeBuckets);
+                std::vector<float> centers(numNativeBuckets);
+                std::vector<size_t> weights(numNativeBuckets);
+                for (size_t i = 0; i < numNativeBuckets; ++i) {
+                    centers[i] = nativeMin + (static_cast<float>(i) + .5f) * nativeBucketWidth;
+                    weights[i] = nativeHistogram->getNumElements(i);
                 }
-            });
+
+                newHistogram->addSamples(centers.data(), weights.data(), numNativeBuckets);
+                newHistogram->mergeLocalBuckets();
+            }
+            else {
+                // give a quick preview from a random subset of the voxels if they are in local memory anyway
+                const ImageRepresentationLocal* repLocal = id->getRepresentation<ImageRepresentationLocal>(false);
+                if (repLocal != 0) {
+                    size_t numBuckets = std::min(WeaklyTypedPointer::numBytes(repLocal->getBaseType()) << 8, MAX_NUM_BUCKETS);
+                    newHistogram = new IntensityHistogramType(&mins, &maxs, &numBuckets);
+                    repLocal->sampleNormalizedIntensityHistogram(*newHistogram, NUM_PREVIEW_SAMPLES);
+                }
+
+                requestNativeIntensityHistogram(_imageHandle);
+            }
         }
 
         // atomically replace old histogram with the new one and delete the old one.
         IntensityHistogramType* oldHistogram = _intensityHistogram.fetch_and_store(newHistogram);
         delete oldHistogram;
-        _dirtyHistogram = false;
+    }
+
+    void TransferFunctionProperty::requestNativeIntensityHistogram(DataHandle imageHandle) const {
+        // without job processor (e.g. in unit tests), compute the histogram right away
+        if (! SimpleJobProcessor::isInited()) {
+            static_cast<const ImageData*>(imageHandle.getData())->getNativeIntensityHistogram();
+            _dirtyHistogram = true;
+            return;
+        }
+
+        if (_histogramJobState->_pending.compare_and_swap(true, false) == false) {
+            // the job holds its own DataHandle and job state, so both stay valid even if the image is 
+            // replaced or the property is destroyed meanwhile
+            std::shared_ptr<HistogramJobState> state = _histogramJobState;
+            SimpleJobProc.enqueueJob([state, imageHandle] () {
+                static_cast<const ImageData*>(imageHandle.getData())->getNativeIntensityHistogram();
+
+                tbb::mutex::scoped_lock lock(state->_mutex);
+                state->_pending = false;
+                if (state->_property != 0) {
+                    state->_property->_dirtyHistogram = true;
+                    state->_property->s_intensityHistogramChanged.emitSignal();
+                }
+            });
+        }
     }
 
     const TransferFunctionProperty::IntensityHistogramType* TransferFunctionProperty::getIntensityHistogram() const {
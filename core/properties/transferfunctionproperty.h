@@ -32,6 +32,9 @@
 #include "core/classification/abstracttransferfunction.h"
 
 #include <tbb/atomic.h>
+#include <tbb/mutex.h>
+
+#include <memory>
 
 namespace campvis {
 
@@ -110,8 +113,12 @@ namespace campvis {
         void setAutoFitWindowToData(bool newValue);
         
         /**
-         * Returns the intensity histogram
-         * \return  _intensityHistogram
+         * Returns the intensity histogram of the image for the TF's current intensity domain.
+         * It is obtained by rebinning the image's cached native intensity histogram. If that is not
+         * available yet, it is computed in the background and this method returns a preview from
+         * a random subset of the voxels until s_intensityHistogramChanged is emitted.
+         * \note    The returned pointer is valid until the next call to this method.
+         * \return  _intensityHistogram, may be 0.
          */
         const IntensityHistogramType* getIntensityHistogram() const;
 
@@ -125,13 +132,34 @@ namespace campvis {
         sigslot::signal0 s_imageHandleChanged;
         /// Signal emitted when the flag whether to automatically fit the TF window to the data in the image handle.
         sigslot::signal0 s_autoFitWindowToDataChanged;
+        /// Signal emitted when the exact intensity histogram has been computed in the background and replaces the preview.
+        /// Mutable, since it is emitted from the lazy evaluation in getIntensityHistogram().
+        mutable sigslot::signal0 s_intensityHistogramChanged;
 
     protected:
+        /**
+         * State shared between the property and its background histogram job.
+         * The job keeps the state alive on its own, so that the property can be destroyed while the
+         * job is still queued or running (or dropped by the job processor) without waiting for it.
+         */
+        struct HistogramJobState {
+            tbb::atomic<bool> _pending;                         ///< Flag whether there is a background job computing a native intensity histogram.
+            tbb::mutex _mutex;                                  ///< Mutex protecting _property.
+            const TransferFunctionProperty* _property;          ///< The owning property, 0 after it has been destroyed.
+        };
+
         /**
          * Computes the intensity histogram, you may override this method if needed.
          */
         virtual void computeIntensityHistogram() const;
 
+        /**
+         * Enqueues the computation of the native intensity histogram of the image in \a imageHandle
+         * as background job, unless there is one pending already.
+         * \param   imageHandle     DataHandle to the image, must not be 0.
+         */
+        void requestNativeIntensityHistogram(DataHandle imageHandle) const;
+
         /// Slot called from TF when its intensity domain has changed
         void onTfIntensityDomainChanged();
 
@@ -139,6 +167,7 @@ namespace campvis {
         DataHandle _imageHandle;                                ///< DataHandle to the image for this transfer function. May be 0.
         mutable tbb::atomic<IntensityHistogramType*> _intensityHistogram;   ///< Intensity histogram of the intensity in _imageHandle for the current _intensityDomain
         mutable tbb::atomic<bool> _dirtyHistogram;              ///< Flag whether the intensity histogram has to be updated.
+        std::shared_ptr<HistogramJobState> _histogramJobState;  ///< State shared with the background histogram job.
         bool _autoFitWindowToData;                              ///< Flag whether to automatically fit the TF window to the data in the image handle.
 
         static const std::string loggerCat_;
@@ -30,6 +30,11 @@
 #include "cgt/logmanager.h"
 #include "cgt/cgt_math.h"
 #include <tbb/atomic.h>
+#include <tbb/blocked_range.h>
+#include <tbb/enumerable_thread_specific.h>
+#include <tbb/parallel_for.h>
+
+#include <vector>
 
 namespace campvis {
 
@@ -37,6 +42,12 @@ namespace campvis {
      * Generic implementation of thread-safe n-D histograms.
      * After successful creation ConcurrentGenericHistogramND ensures:
      *  * Calling addSample() is thread-safe.
+     *  * Calling addSamples() is thread-safe.
+     * 
+     * addSample() updates the shared buckets using atomic operations, which causes heavy contention
+     * when many threads fill the same histogram. For bulk insertion, use addSamples() instead, which
+     * fills per-thread bucket arrays without any synchronization. These are merged into the shared 
+     * buckets by mergeLocalBuckets(), which has to be called once after all samples were added.
      * 
      * \tparam  T   Base data type of the histogram elements
      * \tparam  ND  Dimensionality of the histogram
@@ -64,6 +75,20 @@ namespace campvis {
          */
         size_t getNumBuckets(size_t dimension) const;
 
+        /**
+         * Returns the lower bound of the histogram range for the given dimension.
+         * \param   dimension   Dimension, must be smaller than ND.
+         * \return  _min[dimension]
+         */
+        T getMin(size_t dimension) const { return _min[dimension]; };
+
+        /**
+         * Returns the upper bound of the histogram range for the given dimension.
+         * \param   dimension   Dimension, must be smaller than ND.
+         * \return  _max[dimension]
+         */
+        T getMax(size_t dimension) const { return _max[dimension]; };
+
         /**
          * Adds the given sample to the histogram.
          * \note    This method is thread-safe.
@@ -71,6 +96,33 @@ namespace campvis {
          */
         void addSample(T sample[ND]);
 
+        /**
+         * Adds the given batch of samples to the calling thread's local buckets.
+         * The samples do not show up in the histogram until mergeLocalBuckets() is called.
+         * \note    This method is thread-safe and does not perform any synchronization per sample.
+         * \param   samples     Array of \a numSamples samples, each consisting of ND consecutive values.
+         * \param   numSamples  Number of samples in \a samples.
+         */
+        void addSamples(const T* samples, size_t numSamples);
+
+        /**
+         * Adds the given batch of weighted samples to the calling thread's local buckets, e.g. to 
+         * rebin another histogram. The samples do not show up in the histogram until 
+         * mergeLocalBuckets() is called.
+         * \note    This method is thread-safe and does not perform any synchronization per sample.
+         * \param   samples     Array of \a numSamples samples, each consisting of ND consecutive values.
+         * \param   weights     Array of \a numSamples weights, i.e. how often each sample is added.
+         * \param   numSamples  Number of samples in \a samples.
+         */
+        void addSamples(const T* samples, const size_t* weights, size_t numSamples);
+
+        /**
+         * Merges all thread-local buckets filled by addSamples() into the histogram and 
+         * updates _maxFilling accordingly. Afterwards, the thread-local buckets are empty.
+         * \note    This method must not be called concurrently to addSamples().
+         */
+        void mergeLocalBuckets();
+
         /**
          * Returns a const pointer to the raw data.
          * \return  _buckets
@@ -119,6 +171,16 @@ namespace campvis {
          */
         size_t getArrayIndex(size_t bucketNumbers[ND]) const;
 
+        /**
+         * Computes the array index in _buckets of the given sample.
+         * \param   sample  Array of the values for each dimension (must have at least ND elements).
+         * \return  The array index for \a sample, _arraySize if it is out of bounds.
+         */
+        size_t getSampleIndex(const T* sample) const;
+
+        /// Per-thread bucket arrays of size _arraySize + 1 for addSamples()
+        typedef tbb::enumerable_thread_specific< std::vector<size_t> > LocalBucketsType;
+
         T _min[ND];                         ///< minimum value for each dimension
         T _max[ND];                         ///< maximum value for each dimension
         size_t _numBuckets[ND];             ///< number of buckets for each dimension
@@ -126,6 +188,8 @@ namespace campvis {
         tbb::atomic<size_t>* _buckets;      ///< array of the buckets storing the histogram
         tbb::atomic<size_t> _numSamples;    ///< total number of sampled elements
         tbb::atomic<size_t> _maxFilling;    ///< number of elements in the bucket with the most samples
+
+        LocalBucketsType _localBuckets;     ///< per-thread buckets filled by addSamples(), merged by mergeLocalBuckets()
     };
 
 // ================================================================================================
@@ -134,6 +198,7 @@ namespace campvis {
     campvis::ConcurrentGenericHistogramND<T, ND>::ConcurrentGenericHistogramND(T mins[ND], T maxs[ND], size_t numBuckets[ND]) 
         : _arraySize(1)
         , _buckets(0)
+        , _localBuckets()
     {
         for (size_t i = 0; i < ND; ++i) {
             _min[i] = mins[i];
@@ -163,11 +228,7 @@ namespace campvis {
 
     template<typename T, size_t ND>
     void campvis::ConcurrentGenericHistogramND<T, ND>::addSample(T sample[ND]) {
-        size_t bucketNumbers[ND];
-        for (size_t i = 0; i < ND; ++i)
-            bucketNumbers[i] = getBucketNumber(i, sample[i]);
-
-        size_t index = getArrayIndex(bucketNumbers);
+        size_t index = getSampleIndex(sample);
         ++(_buckets[index]);
         ++_numSamples;
 
@@ -180,6 +241,66 @@ namespace campvis {
         } while (_maxFilling.compare_and_swap(_buckets[index], old) != old);
     }
 
+    template<typename T, size_t ND>
+    void campvis::ConcurrentGenericHistogramND<T, ND>::addSamples(const T* samples, size_t numSamples) {
+        bool exists = false;
+        std::vector<size_t>& local = _localBuckets.local(exists);
+        if (! exists || local.size() != _arraySize + 1)
+            local.assign(_arraySize + 1, 0);
+
+        for (size_t i = 0; i < numSamples; ++i)
+            ++local[getSampleIndex(samples + i*ND)];
+
+        _numSamples += numSamples;
+    }
+
+    template<typename T, size_t ND>
+    void campvis::ConcurrentGenericHistogramND<T, ND>::addSamples(const T* samples, const size_t* weights, size_t numSamples) {
+        bool exists = false;
+        std::vector<size_t>& local = _localBuckets.local(exists);
+        if (! exists || local.size() != _arraySize + 1)
+            local.assign(_arraySize + 1, 0);
+
+        size_t totalWeight = 0;
+        for (size_t i = 0; i < numSamples; ++i) {
+            local[getSampleIndex(samples + i*ND)] += weights[i];
+            totalWeight += weights[i];
+        }
+
+        _numSamples += totalWeight;
+    }
+
+    template<typename T, size_t ND>
+    void campvis::ConcurrentGenericHistogramND<T, ND>::mergeLocalBuckets() {
+        if (_localBuckets.empty())
+            return;
+
+        // sum up the local buckets, distributing the work over the buckets
+        tbb::parallel_for(tbb::blocked_range<size_t>(0, _arraySize + 1), [&] (const tbb::blocked_range<size_t>& range) {
+            for (typename LocalBucketsType::iterator it = _localBuckets.begin(); it != _localBuckets.end(); ++it) {
+                const std::vector<size_t>& local = *it;
+                for (size_t i = range.begin(); i != range.end(); ++i)
+                    _buckets[i] += local[i];
+            }
+        });
+        _localBuckets.clear();
+
+        // compute _maxFilling once instead of after each sample
+        size_t maxFilling = _maxFilling;
+        for (size_t i = 0; i < _arraySize; ++i)
+            maxFilling = std::max(maxFilling, static_cast<size_t>(_buckets[i]));
+        _maxFilling = maxFilling;
+    }
+
+    template<typename T, size_t ND>
+    size_t campvis::ConcurrentGenericHistogramND<T, ND>::getSampleIndex(const T* sample) const {
+        size_t bucketNumbers[ND];
+        for (size_t i = 0; i < ND; ++i)
+            bucketNumbers[i] = getBucketNumber(i, sample[i]);
+
+        return getArrayIndex(bucketNumbers);
+    }
+
     template<typename T, size_t ND>
     size_t campvis::ConcurrentGenericHistogramND<T, ND>::getBucketNumber(size_t dimension, T sample) const {
         cgtAssert(dimension < ND, "Dimension out of bounds.");
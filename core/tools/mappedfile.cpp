@@ -0,0 +1,136 @@
+// ================================================================================================
+// 
+// This file is part of the CAMPVis Software Framework.
+// 
+// If not explicitly stated otherwise: Copyright (C) 2012-2015, all rights reserved,
+//      Christian Schulte zu Berge <christian.szb@in.tum.de>
+//      Chair for Computer Aided Medical Procedures
+//      Technische Universitaet Muenchen
+//      Boltzmannstr. 3, 85748 Garching b. Muenchen, Germany
+// 
+// For a full list of authors and contributors, please refer to the file "AUTHORS.txt".
+// 
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file 
+// except in compliance with the License. You may obtain a copy of the License at
+// 
+// http://www.apache.org/licenses/LICENSE-2.0
+// 
+// Unless required by applicable law or agreed to in writing, software distributed under the 
+// License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, 
+// either express or implied. See the License for the specific language governing permissions 
+// and limitations under the License.
+// 
+// ================================================================================================
+
+#include "mappedfile.h"
+
+#include "cgt/logmanager.h"
+
+#ifdef WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#endif
+
+namespace campvis {
+
+    const std::string MappedFile::loggerCat_ = "CAMPVis.core.tools.MappedFile";
+
+    MappedFile::MappedFile(const std::string& url)
+        : _url(url)
+        , _data(0)
+        , _size(0)
+#ifdef WIN32
+        , _fileHandle(INVALID_HANDLE_VALUE)
+        , _mappingHandle(0)
+#endif
+    {
+#ifdef WIN32
+        _fileHandle = CreateFileA(_url.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+        if (_fileHandle == INVALID_HANDLE_VALUE) {
+            LDEBUG("Could not open file " << _url << " for mapping.");
+            return;
+        }
+
+        LARGE_INTEGER fileSize;
+        if (! GetFileSizeEx(_fileHandle, &fileSize) || fileSize.QuadPart == 0) {
+            CloseHandle(_fileHandle);
+            _fileHandle = INVALID_HANDLE_VALUE;
+            return;
+        }
+
+        _mappingHandle = CreateFileMappingA(_fileHandle, NULL, PAGE_WRITECOPY, 0, 0, NULL);
+        if (_mappingHandle != 0) {
+            _data = static_cast<char*>(MapViewOfFile(_mappingHandle, FILE_MAP_COPY, 0, 0, 0));
+            if (_data != 0)
+                _size = static_cast<size_t>(fileSize.QuadPart);
+        }
+
+        if (_data == 0) {
+            LDEBUG("Could not map file " << _url << ".");
+            if (_mappingHandle != 0)
+                CloseHandle(_mappingHandle);
+            CloseHandle(_fileHandle);
+            _mappingHandle = 0;
+            _fileHandle = INVALID_HANDLE_VALUE;
+        }
+#else
+        int fd = open(_url.c_str(), O_RDONLY);
+        if (fd == -1) {
+            LDEBUG("Could not open file " << _url << " for mapping.");
+            return;
+        }
+
+        struct stat fileStat;
+        if (fstat(fd, &fileStat) == 0 && fileStat.st_size > 0) {
+            // MAP_PRIVATE gives us copy-on-write semantics, the file itself is never modified
+            void* ptr = mmap(0, static_cast<size_t>(fileStat.st_size), PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+            if (ptr != MAP_FAILED) {
+                _data = static_cast<char*>(ptr);
+                _size = static_cast<size_t>(fileStat.st_size);
+            }
+            else {
+                LDEBUG("Could not map file " << _url << ".");
+            }
+        }
+
+        // the mapping stays valid after closing the file descriptor
+        close(fd);
+#endif
+    }
+
+    MappedFile::~MappedFile() {
+#ifdef WIN32
+        if (_data != 0)
+            UnmapViewOfFile(_data);
+        if (_mappingHandle != 0)
+            CloseHandle(_mappingHandle);
+        if (_fileHandle != INVALID_HANDLE_VALUE)
+            CloseHandle(_fileHandle);
+#else
+        if (_data != 0)
+            munmap(_data, _size);
+#endif
+    }
+
+    bool MappedFile::isOpen() const {
+        return _data != 0;
+    }
+
+    char* MappedFile::getData() const {
+        return _data;
+    }
+
+    size_t MappedFile::getSize() const {
+        return _size;
+    }
+
+    const std::string& MappedFile::getUrl() const {
+        return _url;
+    }
+
+}
@@ -0,0 +1,101 @@
+// ================================================================================================
+// 
+// This file is part of the CAMPVis Software Framework.
+// 
+// If not explicitly stated otherwise: Copyright (C) 2012-2015, all rights reserved,
+//      Christian Schulte zu Berge <christian.szb@in.tum.de>
+//      Chair for Computer Aided Medical Procedures
+//      Technische Universitaet Muenchen
+//      Boltzmannstr. 3, 85748 Garching b. Muenchen, Germany
+// 
+// For a full list of authors and contributors, please refer to the file "AUTHORS.txt".
+// 
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file 
+// except in compliance with the License. You may obtain a copy of the License at
+// 
+// http://www.apache.org/licenses/LICENSE-2.0
+// 
+// Unless required by applicable law or agreed to in writing, software distributed under the 
+// License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, 
+// either express or implied. See the License for the specific language governing permissions 
+// and limitations under the License.
+// 
+// ================================================================================================
+
+#ifndef MAPPEDFILE_H__
+#define MAPPEDFILE_H__
+
+#include <string>
+
+#include "core/coreapi.h"
+
+namespace campvis {
+
+    /**
+     * Maps a whole file into the virtual address space of this process.
+     * 
+     * The mapping is private and copy-on-write: The pages are backed by the file as long as they
+     * are only read, writing to them creates a private copy of the affected page, which is never 
+     * written back to disk. Hence, mapped data can safely be handed out as mutable image data.
+     * 
+     * \note    The mapping is released on destruction, all pointers obtained via getData() are
+     *          invalid afterwards.
+     */
+    class CAMPVIS_CORE_API MappedFile {
+    public:
+        /**
+         * Creates a new MappedFile and tries to map the file \a url.
+         * Use isOpen() to check whether the mapping was successful.
+         * \param   url     Path to the file to map.
+         */
+        explicit MappedFile(const std::string& url);
+
+        /**
+         * Destructor, releases the mapping.
+         */
+        ~MappedFile();
+
+        /**
+         * Returns whether the file has been mapped successfully.
+         * \return  _data != 0
+         */
+        bool isOpen() const;
+
+        /**
+         * Returns a pointer to the first byte of the mapped file.
+         * \return  _data, 0 if the mapping was not successful.
+         */
+        char* getData() const;
+
+        /**
+         * Returns the size of the mapped file in bytes.
+         * \return  _size
+         */
+        size_t getSize() const;
+
+        /**
+         * Returns the path of the mapped file.
+         * \return  _url
+         */
+        const std::string& getUrl() const;
+
+    private:
+        // non-copyable
+        MappedFile(const MappedFile& rhs);
+        MappedFile& operator=(const MappedFile& rhs);
+
+        std::string _url;       ///< Path to the mapped file
+        char* _data;            ///< Pointer to the first byte of the mapping, 0 if not mapped
+        size_t _size;           ///< Size of the mapping in bytes
+
+#ifdef WIN32
+        void* _fileHandle;      ///< Windows file handle
+        void* _mappingHandle;   ///< Windows file mapping handle
+#endif
+
+        static const std::string loggerCat_;
+    };
+
+}
+
+#endif // MAPPEDFILE_H__
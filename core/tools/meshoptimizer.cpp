@@ -0,0 +1,317 @@
+// ================================================================================================
+// 
+// This file is part of the CAMPVis Software Framework.
+// 
+// If not explicitly stated otherwise: Copyright (C) 2012-2015, all rights reserved,
+//      Christian Schulte zu Berge <christian.szb@in.tum.de>
+//      Chair for Computer Aided Medical Procedures
+//      Technische Universitaet Muenchen
+//      Boltzmannstr. 3, 85748 Garching b. Muenchen, Germany
+// 
+// For a full list of authors and contributors, please refer to the file "AUTHORS.txt".
+// 
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file 
+// except in compliance with the License. You may obtain a copy of the License at
+// 
+// http://www.apache.org/licenses/LICENSE-2.0
+// 
+// Unless required by applicable law or agreed to in writing, software distributed under the 
+// License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, 
+// either express or implied. See the License for the specific language governing permissions 
+// and limitations under the License.
+// 
+// ================================================================================================
+
+#include "meshoptimizer.h"
+
+#include "cgt/assert.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <unordered_map>
+
+namespace campvis {
+
+    namespace {
+        const uint32_t INVALID_INDEX = std::numeric_limits<uint32_t>::max();
+
+        /**
+         * Hashes and compares vertices by the bytes of all their attributes, so that it can be 
+         * used with an std::unordered_map of vertex indices.
+         */
+        struct VertexAttributeComparer {
+            VertexAttributeComparer(const std::vector<cgt::vec3>& vertices, const std::vector<cgt::vec3>& textureCoordinates, const std::vector<cgt::vec4>& colors, const std::vector<cgt::vec3>& normals)
+                : _vertices(vertices)
+                , _textureCoordinates(textureCoordinates)
+                , _colors(colors)
+                , _normals(normals)
+            {}
+
+            template<typename T>
+            static void hashBytes(size_t& hash, const T& value) {
+                // FNV-1a
+                const unsigned char* bytes = reinterpret_cast<const unsigned char*>(&value);
+                for (size_t i = 0; i < sizeof(T); ++i) {
+                    hash ^= bytes[i];
+                    hash *= 1099511628211ULL;
+                }
+            }
+
+            template<typename T>
+            static bool equalBytes(const std::vector<T>& v, uint32_t left, uint32_t right) {
+                return v.empty() || memcmp(&v[left], &v[right], sizeof(T)) == 0;
+            }
+
+            size_t operator() (uint32_t index) const {
+                size_t hash = 14695981039346656037ULL;
+                hashBytes(hash, _vertices[index]);
+                if (! _textureCoordinates.empty())
+                    hashBytes(hash, _textureCoordinates[index]);
+                if (! _colors.empty())
+                    hashBytes(hash, _colors[index]);
+                if (! _normals.empty())
+                    hashBytes(hash, _normals[index]);
+                return hash;
+            }
+
+            bool operator() (uint32_t left, uint32_t right) const {
+                return equalBytes(_vertices, left, right) && equalBytes(_textureCoordinates, left, right) 
+                    && equalBytes(_colors, left, right) && equalBytes(_normals, left, right);
+            }
+
+            const std::vector<cgt::vec3>& _vertices;
+            const std::vector<cgt::vec3>& _textureCoordinates;
+            const std::vector<cgt::vec4>& _colors;
+            const std::vector<cgt::vec3>& _normals;
+        };
+
+        /**
+         * Copies the elements of \a v in the order given by \a sourceIndices.
+         */
+        template<typename T>
+        void gather(std::vector<T>& v, const std::vector<uint32_t>& sourceIndices) {
+            if (v.empty())
+                return;
+
+            std::vector<T> tmp(sourceIndices.size());
+            for (size_t i = 0; i < sourceIndices.size(); ++i)
+                tmp[i] = v[sourceIndices[i]];
+            v.swap(tmp);
+        }
+
+        // Parameters of Forsyth's vertex scoring function
+        const float CACHE_DECAY_POWER = 1.5f;
+        const float LAST_TRIANGLE_SCORE = 0.75f;
+        const float VALENCE_BOOST_SCALE = 2.f;
+        const float VALENCE_BOOST_POWER = 0.5f;
+        const size_t MAX_PRECOMPUTED_VALENCE = 64;
+
+        /**
+         * Precomputed vertex scores of Forsyth's vertex cache optimisation.
+         */
+        struct VertexScoreTable {
+            explicit VertexScoreTable(size_t cacheSize)
+                : _cacheScores(cacheSize)
+                , _valenceScores(MAX_PRECOMPUTED_VALENCE)
+            {
+                for (size_t i = 0; i < cacheSize; ++i) {
+                    if (i < 3) {
+                        // the vertices of the last triangle get a fixed score to not favor one of them
+                        _cacheScores[i] = LAST_TRIANGLE_SCORE;
+                    }
+                    else {
+                        float scaler = 1.f - static_cast<float>(i - 3) / static_cast<float>(cacheSize - 3);
+                        _cacheScores[i] = std::pow(scaler, CACHE_DECAY_POWER);
+                    }
+                }
+                for (size_t i = 1; i < MAX_PRECOMPUTED_VALENCE; ++i)
+                    _valenceScores[i] = valenceScore(i);
+            }
+
+            static float valenceScore(size_t numActiveTriangles) {
+                return VALENCE_BOOST_SCALE * std::pow(static_cast<float>(numActiveTriangles), -VALENCE_BOOST_POWER);
+            }
+
+            float operator() (int cachePosition, size_t numActiveTriangles) const {
+                // vertices without remaining triangles are not interesting anymore
+                if (numActiveTriangles == 0)
+                    return -1.f;
+
+                float score = (cachePosition >= 0) ? _cacheScores[cachePosition] : 0.f;
+                score += (numActiveTriangles < MAX_PRECOMPUTED_VALENCE) ? _valenceScores[numActiveTriangles] : valenceScore(numActiveTriangles);
+                return score;
+            }
+
+            std::vector<float> _cacheScores;
+            std::vector<float> _valenceScores;
+        };
+    }
+
+    size_t MeshOptimizer::deduplicateVertices(std::vector<uint32_t>& indices, std::vector<cgt::vec3>& vertices, std::vector<cgt::vec3>& textureCoordinates, std::vector<cgt::vec4>& colors, std::vector<cgt::vec3>& normals) {
+        cgtAssert(textureCoordinates.empty() || textureCoordinates.size() == vertices.size(), "Texture coordinates vector must be either empty or of the same size as the vertex vector.");
+        cgtAssert(colors.empty() || colors.size() == vertices.size(), "Colors vector must be either empty or of the same size as the vertex vector.");
+        cgtAssert(normals.empty() || normals.size() == vertices.size(), "Normals vector must be either empty or of the same size as the vertex vector.");
+
+        VertexAttributeComparer comparer(vertices, textureCoordinates, colors, normals);
+        std::unordered_map<uint32_t, uint32_t, VertexAttributeComparer, VertexAttributeComparer> uniqueVertices(vertices.size(), comparer, comparer);
+
+        std::vector<uint32_t> remap(vertices.size(), INVALID_INDEX);
+        std::vector<uint32_t> sourceIndices;
+        sourceIndices.reserve(vertices.size());
+
+        // assign new indices in order of first use, duplicates get the index of their first occurrence
+        for (size_t i = 0; i < indices.size(); ++i) {
+            uint32_t& index = indices[i];
+            cgtAssert(index < vertices.size(), "Index out of bounds.");
+
+            if (remap[index] == INVALID_INDEX) {
+                auto it = uniqueVertices.insert(std::make_pair(index, static_cast<uint32_t>(sourceIndices.size())));
+                if (it.second)
+                    sourceIndices.push_back(index);
+                remap[index] = it.first->second;
+            }
+            index = remap[index];
+        }
+
+        gather(vertices, sourceIndices);
+        gather(textureCoordinates, sourceIndices);
+        gather(colors, sourceIndices);
+        gather(normals, sourceIndices);
+        return vertices.size();
+    }
+
+    std::vector<uint32_t> MeshOptimizer::optimizeVertexCache(const std::vector<uint32_t>& indices, size_t numVertices, size_t cacheSize /*= 32*/) {
+        cgtAssert(indices.size() % 3 == 0, "Index list must be a triangle list.");
+        cgtAssert(cacheSize > 3, "Cache size must be larger than 3.");
+
+        const size_t numTriangles = indices.size() / 3;
+        std::vector<uint32_t> toReturn;
+        toReturn.reserve(indices.size());
+        if (numTriangles == 0)
+            return toReturn;
+
+        VertexScoreTable scoreTable(cacheSize);
+
+        // build vertex-triangle adjacency, the first numActiveTriangles[v] entries of each vertex are not yet emitted
+        std::vector<uint32_t> numActiveTriangles(numVertices, 0);
+        for (size_t i = 0; i < indices.size(); ++i) {
+            cgtAssert(indices[i] < numVertices, "Index out of bounds.");
+            ++numActiveTriangles[indices[i]];
+        }
+
+        std::vector<uint32_t> adjacencyOffsets(numVertices + 1, 0);
+        for (size_t v = 0; v < numVertices; ++v)
+            adjacencyOffsets[v + 1] = adjacencyOffsets[v] + numActiveTriangles[v];
+
+        std::vector<uint32_t> adjacency(indices.size());
+        std::vector<uint32_t> fill(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+        for (size_t i = 0; i < indices.size(); ++i)
+            adjacency[fill[indices[i]]++] = static_cast<uint32_t>(i / 3);
+
+        // initial scores
+        std::vector<int> cachePositions(numVertices, -1);
+        std::vector<float> vertexScores(numVertices);
+        for (size_t v = 0; v < numVertices; ++v)
+            vertexScores[v] = scoreTable(-1, numActiveTriangles[v]);
+
+        std::vector<float> triangleScores(numTriangles);
+        std::vector<bool> emitted(numTriangles, false);
+        uint32_t bestTriangle = 0;
+        for (size_t t = 0; t < numTriangles; ++t) {
+            triangleScores[t] = vertexScores[indices[3*t]] + vertexScores[indices[3*t + 1]] + vertexScores[indices[3*t + 2]];
+            if (triangleScores[t] > triangleScores[bestTriangle])
+                bestTriangle = static_cast<uint32_t>(t);
+        }
+
+        std::vector<uint32_t> cache, newCache;
+        cache.reserve(cacheSize + 3);
+        newCache.reserve(cacheSize + 3);
+        size_t nextUnemitted = 0;
+
+        for (size_t n = 0; n < numTriangles; ++n) {
+            if (bestTriangle == INVALID_INDEX) {
+                // no candidate in the cache, continue with the next triangle in input order
+                while (emitted[nextUnemitted])
+                    ++nextUnemitted;
+                bestTriangle = static_cast<uint32_t>(nextUnemitted);
+            }
+
+            // emit triangle and remove it from the active triangles of its vertices
+            const uint32_t* tri = &indices[3 * bestTriangle];
+            toReturn.insert(toReturn.end(), tri, tri + 3);
+            emitted[bestTriangle] = true;
+
+            for (size_t i = 0; i < 3; ++i) {
+                uint32_t* begin = &adjacency[adjacencyOffsets[tri[i]]];
+                uint32_t* last = begin + (--numActiveTriangles[tri[i]]);
+                std::iter_swap(std::find(begin, last + 1, bestTriangle), last);
+            }
+
+            // move the triangle's vertices to the front of the LRU cache
+            newCache.clear();
+            for (size_t i = 0; i < 3; ++i) {
+                if (std::find(newCache.begin(), newCache.end(), tri[i]) == newCache.end())
+                    newCache.push_back(tri[i]);
+            }
+            const size_t numTriangleVertices = newCache.size();
+            for (size_t i = 0; i < cache.size(); ++i) {
+                if (std::find(newCache.begin(), newCache.begin() + numTriangleVertices, cache[i]) == newCache.begin() + numTriangleVertices)
+                    newCache.push_back(cache[i]);
+            }
+
+            // update the scores of all vertices in the cache, including the evicted ones, and their triangles
+            for (size_t i = 0; i < newCache.size(); ++i) {
+                const uint32_t v = newCache[i];
+                cachePositions[v] = (i < cacheSize) ? static_cast<int>(i) : -1;
+
+                const float newScore = scoreTable(cachePositions[v], numActiveTriangles[v]);
+                const float delta = newScore - vertexScores[v];
+                vertexScores[v] = newScore;
+
+                for (uint32_t j = 0; j < numActiveTriangles[v]; ++j)
+                    triangleScores[adjacency[adjacencyOffsets[v] + j]] += delta;
+            }
+
+            if (newCache.size() > cacheSize)
+                newCache.resize(cacheSize);
+            cache.swap(newCache);
+
+            // find the best triangle among the ones using cached vertices
+            bestTriangle = INVALID_INDEX;
+            float bestScore = -1.f;
+            for (size_t i = 0; i < cache.size(); ++i) {
+                const uint32_t v = cache[i];
+                for (uint32_t j = 0; j < numActiveTriangles[v]; ++j) {
+                    const uint32_t t = adjacency[adjacencyOffsets[v] + j];
+                    if (triangleScores[t] > bestScore) {
+                        bestScore = triangleScores[t];
+                        bestTriangle = t;
+                    }
+                }
+            }
+        }
+
+        return toReturn;
+    }
+
+    float MeshOptimizer::computeAverageCacheMissRatio(const std::vector<uint32_t>& indices, size_t numVertices, size_t cacheSize /*= 16*/) {
+        if (indices.size() < 3)
+            return 0.f;
+
+        // FIFO cache: a vertex is cached if less than cacheSize misses happened since it was loaded
+        std::vector<size_t> loadTime(numVertices, std::numeric_limits<size_t>::max());
+        size_t numMisses = 0;
+        for (size_t i = 0; i < indices.size(); ++i) {
+            size_t& t = loadTime[indices[i]];
+            if (t == std::numeric_limits<size_t>::max() || numMisses - t >= cacheSize) {
+                t = numMisses;
+                ++numMisses;
+            }
+        }
+
+        return static_cast<float>(numMisses) / static_cast<float>(indices.size() / 3);
+    }
+
+}
@@ -0,0 +1,87 @@
+// ================================================================================================
+// 
+// This file is part of the CAMPVis Software Framework.
+// 
+// If not explicitly stated otherwise: Copyright (C) 2012-2015, all rights reserved,
+//      Christian Schulte zu Berge <christian.szb@in.tum.de>
+//      Chair for Computer Aided Medical Procedures
+//      Technische Universitaet Muenchen
+//      Boltzmannstr. 3, 85748 Garching b. Muenchen, Germany
+// 
+// For a full list of authors and contributors, please refer to the file "AUTHORS.txt".
+// 
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file 
+// except in compliance with the License. You may obtain a copy of the License at
+// 
+// http://www.apache.org/licenses/LICENSE-2.0
+// 
+// Unless required by applicable law or agreed to in writing, software distributed under the 
+// License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, 
+// either express or implied. See the License for the specific language governing permissions 
+// and limitations under the License.
+// 
+// ================================================================================================
+
+#ifndef MESHOPTIMIZER_H__
+#define MESHOPTIMIZER_H__
+
+#include "cgt/vector.h"
+#include "core/coreapi.h"
+
+#include <vector>
+
+namespace campvis {
+
+    /**
+     * Collection of preprocessing algorithms for indexed triangle meshes.
+     * 
+     * All methods work on triangle lists with 32 bit indices, the resulting index lists can 
+     * be passed to IndexedMeshGeometry, which stores them as 16 bit indices if possible.
+     */
+    struct CAMPVIS_CORE_API MeshOptimizer {
+    public:
+        /**
+         * Merges vertices whose attributes are bitwise identical and removes vertices not 
+         * referenced by \a indices. The remaining vertices are sorted by their first use in 
+         * \a indices, so that running this after optimizeVertexCache() also optimizes the 
+         * order of vertex fetches. All arrays are modified in place.
+         * \param   indices             Triangle list indexing the vertex arrays, will be remapped.
+         * \param   vertices            The list of vertex positions.
+         * \param   textureCoordinates  The list of vertex texture coordinates, may be empty.
+         * \param   colors              The list of vertex colors, may be empty.
+         * \param   normals             The list of vertex normals, may be empty.
+         * \return  The number of vertices after deduplication.
+         */
+        static size_t deduplicateVertices(
+            std::vector<uint32_t>& indices,
+            std::vector<cgt::vec3>& vertices,
+            std::vector<cgt::vec3>& textureCoordinates,
+            std::vector<cgt::vec4>& colors,
+            std::vector<cgt::vec3>& normals);
+
+        /**
+         * Reorders the triangles of the triangle list \a indices to improve the hit rate of the 
+         * GPU's post-transform vertex cache, using Tom Forsyth's linear-speed vertex cache 
+         * optimisation. Runs in linear time of the number of triangles.
+         * \param   indices     Triangle list to reorder, size must be a multiple of 3.
+         * \param   numVertices Number of vertices referenced by \a indices.
+         * \param   cacheSize   Size of the simulated LRU vertex cache.
+         * \return  The reordered triangle list.
+         */
+        static std::vector<uint32_t> optimizeVertexCache(const std::vector<uint32_t>& indices, size_t numVertices, size_t cacheSize = 32);
+
+        /**
+         * Computes the average cache miss ratio (ACMR) of the triangle list \a indices, i.e. the 
+         * number of vertex cache misses per triangle when simulating a FIFO vertex cache.
+         * Values range from 3 (worst) to about 0.5 (optimal for regular meshes).
+         * \param   indices     Triangle list, size must be a multiple of 3.
+         * \param   numVertices Number of vertices referenced by \a indices.
+         * \param   cacheSize   Size of the simulated FIFO vertex cache.
+         * \return  Average number of cache misses per triangle.
+         */
+        static float computeAverageCacheMissRatio(const std::vector<uint32_t>& indices, size_t numVertices, size_t cacheSize = 16);
+    };
+
+}
+
+#endif // MESHOPTIMIZER_H__
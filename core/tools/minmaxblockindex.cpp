@@ -0,0 +1,138 @@
+// ================================================================================================
+// 
+// This file is part of the CAMPVis Software Framework.
+// 
+// If not explicitly stated otherwise: Copyright (C) 2012-2015, all rights reserved,
+//      Christian Schulte zu Berge <christian.szb@in.tum.de>
+//      Chair for Computer Aided Medical Procedures
+//      Technische Universitaet Muenchen
+//      Boltzmannstr. 3, 85748 Garching b. Muenchen, Germany
+// 
+// For a full list of authors and contributors, please refer to the file "AUTHORS.txt".
+// 
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file 
+// except in compliance with the License. You may obtain a copy of the License at
+// 
+// http://www.apache.org/licenses/LICENSE-2.0
+// 
+// Unless required by applicable law or agreed to in writing, software distributed under the 
+// License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, 
+// either express or implied. See the License for the specific language governing permissions 
+// and limitations under the License.
+// 
+// ================================================================================================
+
+
+#include "minmaxblockindex.h"
+
+#include "cgt/assert.h"
+#include "cgt/logmanager.h"
+
+#include "core/datastructures/imagerepresentationlocal.h"
+#include "core/tools/voxelview.h"
+
+#include <tbb/tbb.h>
+
+#include <algorithm>
+#include <limits>
+
+namespace campvis {
+
+    const std::string MinMaxBlockIndex::loggerCat_ = "CAMPVis.core.tools.MinMaxBlockIndex";
+
+    namespace {
+        /**
+         * Computes the normalized (min, max) intensity of each block, adjacent blocks share their 
+         * boundary voxels.
+         */
+        struct BlockIndexFunctor {
+            BlockIndexFunctor(size_t blockSize, const cgt::svec3& numBlocks, std::vector<cgt::vec2>& blockRanges)
+                : _blockSize(blockSize)
+                , _numBlocks(numBlocks)
+                , _blockRanges(blockRanges)
+            {}
+
+            template<typename BASETYPE>
+            void operator() (const VoxelView<BASETYPE, 1>& input) const {
+                const size_t B = _blockSize;
+                const cgt::svec3& size = input.getSize();
+                const cgt::svec3 numBlocks = _numBlocks;
+                std::vector<cgt::vec2>& blockRanges = _blockRanges;
+
+                tbb::parallel_for(tbb::blocked_range<size_t>(0, numBlocks.z * numBlocks.y), [&] (const tbb::blocked_range<size_t>& range) {
+                    for (size_t i = range.begin(); i != range.end(); ++i) {
+                        for (size_t bx = 0; bx < numBlocks.x; ++bx) {
+                            const cgt::svec3 llf(bx, i % numBlocks.y, i / numBlocks.y);
+                            const cgt::svec3 urb = cgt::min((llf + cgt::svec3(1)) * B, size - cgt::svec3(1));
+                            cgt::vec2 minMax(std::numeric_limits<float>::max(), -std::numeric_limits<float>::max());
+
+                            for (size_t z = llf.z * B; z <= urb.z; ++z) {
+                                for (size_t y = llf.y * B; y <= urb.y; ++y) {
+                                    size_t index = input.positionToIndex(cgt::svec3(llf.x * B, y, z));
+                                    for (size_t x = llf.x * B; x <= urb.x; ++x, ++index) {
+                                        const float value = input.getNormalized(index, 0);
+                                        minMax.x = std::min(minMax.x, value);
+                                        minMax.y = std::max(minMax.y, value);
+                                    }
+                                }
+                            }
+
+                            blockRanges[i * numBlocks.x + bx] = minMax;
+                        }
+                    }
+                });
+            }
+
+            size_t _blockSize;
+            cgt::svec3 _numBlocks;
+            std::vector<cgt::vec2>& _blockRanges;
+        };
+    }
+
+    MinMaxBlockIndex::MinMaxBlockIndex(size_t blockSize)
+        : _blockSize(blockSize)
+        , _indexedImage(0)
+        , _indexedTimestamp(0)
+        , _numBlocks(0, 0, 0)
+    {
+        cgtAssert(blockSize > 0, "Block size must be greater 0.");
+    }
+
+    bool MinMaxBlockIndex::update(const ImageRepresentationLocal* input, const DataHandle& dh) {
+        cgtAssert(input != 0, "Input image must not be 0.");
+        if (_indexedImage.getData() == dh.getData() && _indexedTimestamp == dh.getTimestamp() && ! _blockRanges.empty())
+            return false;
+
+        const cgt::svec3 size = cgt::max(input->getSize(), cgt::svec3(2));
+        _numBlocks = (size - cgt::svec3(1) + cgt::svec3(_blockSize - 1)) / _blockSize;
+        _blockRanges.resize(cgt::hmul(_numBlocks));
+
+        BlockIndexFunctor functor(_blockSize, _numBlocks, _blockRanges);
+        dispatchVoxelView<1>(input, functor);
+
+        _indexedImage = dh;
+        _indexedTimestamp = dh.getTimestamp();
+        LDEBUG("Built min/max block index with " << _blockRanges.size() << " blocks.");
+        return true;
+    }
+
+    void MinMaxBlockIndex::clear() {
+        _indexedImage = DataHandle(0);
+        _indexedTimestamp = 0;
+        _numBlocks = cgt::svec3(0, 0, 0);
+        _blockRanges.clear();
+    }
+
+    size_t MinMaxBlockIndex::getBlockSize() const {
+        return _blockSize;
+    }
+
+    const cgt::svec3& MinMaxBlockIndex::getNumBlocks() const {
+        return _numBlocks;
+    }
+
+    const std::vector<cgt::vec2>& MinMaxBlockIndex::getBlockRanges() const {
+        return _blockRanges;
+    }
+
+}
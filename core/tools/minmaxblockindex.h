@@ -0,0 +1,100 @@
+// ================================================================================================
+// 
+// This file is part of the CAMPVis Software Framework.
+// 
+// If not explicitly stated otherwise: Copyright (C) 2012-2015, all rights reserved,
+//      Christian Schulte zu Berge <christian.szb@in.tum.de>
+//      Chair for Computer Aided Medical Procedures
+//      Technische Universitaet Muenchen
+//      Boltzmannstr. 3, 85748 Garching b. Muenchen, Germany
+// 
+// For a full list of authors and contributors, please refer to the file "AUTHORS.txt".
+// 
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file 
+// except in compliance with the License. You may obtain a copy of the License at
+// 
+// http://www.apache.org/licenses/LICENSE-2.0
+// 
+// Unless required by applicable law or agreed to in writing, software distributed under the 
+// License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, 
+// either express or implied. See the License for the specific language governing permissions 
+// and limitations under the License.
+// 
+// ================================================================================================
+
+
+#ifndef MINMAXBLOCKINDEX_H__
+#define MINMAXBLOCKINDEX_H__
+
+#include "cgt/vector.h"
+
+#include "core/coreapi.h"
+#include "core/datastructures/datahandle.h"
+
+#include <string>
+#include <vector>
+
+namespace campvis {
+    class ImageRepresentationLocal;
+
+    /**
+     * Min/max index over the blocks of a single-channel volume for skipping regions that cannot
+     * contribute to a result, e.g. empty space in ray casting or blocks not containing an isosurface.
+     * 
+     * The volume is partitioned into blocks of getBlockSize()^3 cells, each block stores the 
+     * normalized (min, max) intensity of its voxels. Adjacent blocks share their boundary voxels, 
+     * so that every trilinearly interpolated sample and every cell lies completely within the block 
+     * containing it. The index is cached and only rebuilt by update() if the data has changed.
+     */
+    class CAMPVIS_CORE_API MinMaxBlockIndex {
+    public:
+        /**
+         * Creates a new empty MinMaxBlockIndex.
+         * \param   blockSize   Number of cells per block edge.
+         */
+        explicit MinMaxBlockIndex(size_t blockSize);
+
+        /**
+         * Rebuilds the index for \a input if it was built for different data.
+         * \param   input   Input image representation, must be single-channel.
+         * \param   dh      DataHandle of the input image, used to detect changed data.
+         * \return  True if the index has been rebuilt.
+         */
+        bool update(const ImageRepresentationLocal* input, const DataHandle& dh);
+
+        /**
+         * Clears the index and releases the cached DataHandle.
+         */
+        void clear();
+
+        /// Returns the number of cells per block edge.
+        size_t getBlockSize() const;
+
+        /// Returns the number of blocks in each dimension.
+        const cgt::svec3& getNumBlocks() const;
+
+        /// Returns the normalized (min, max) intensity of each block in x-fastest order.
+        const std::vector<cgt::vec2>& getBlockRanges() const;
+
+        /**
+         * Returns the normalized (min, max) intensity of the given block.
+         * \param   block   Block coordinates, must be smaller than getNumBlocks().
+         * \return  _blockRanges[(block.z * _numBlocks.y + block.y) * _numBlocks.x + block.x]
+         */
+        const cgt::vec2& getBlockRange(const cgt::svec3& block) const {
+            return _blockRanges[(block.z * _numBlocks.y + block.y) * _numBlocks.x + block.x];
+        }
+
+    protected:
+        size_t _blockSize;                      ///< Number of cells per block edge
+        DataHandle _indexedImage;               ///< DataHandle of the image the index was built for
+        clock_t _indexedTimestamp;              ///< Timestamp of _indexedImage when the index was built
+        cgt::svec3 _numBlocks;                  ///< Number of blocks in each dimension
+        std::vector<cgt::vec2> _blockRanges;    ///< Normalized (min, max) intensity of each block
+
+        static const std::string loggerCat_;
+    };
+
+}
+
+#endif // MINMAXBLOCKINDEX_H__
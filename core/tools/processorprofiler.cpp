@@ -0,0 +1,238 @@
+// ================================================================================================
+// 
+// This file is part of the CAMPVis Software Framework.
+// 
+// If not explicitly stated otherwise: Copyright (C) 2012-2015, all rights reserved,
+//      Christian Schulte zu Berge <christian.szb@in.tum.de>
+//      Chair for Computer Aided Medical Procedures
+//      Technische Universitaet Muenchen
+//      Boltzmannstr. 3, 85748 Garching b. Muenchen, Germany
+// 
+// For a full list of authors and contributors, please refer to the file "AUTHORS.txt".
+// 
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file 
+// except in compliance with the License. You may obtain a copy of the License at
+// 
+// http://www.apache.org/licenses/LICENSE-2.0
+// 
+// Unless required by applicable law or agreed to in writing, software distributed under the 
+// License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, 
+// either express or implied. See the License for the specific language governing permissions 
+// and limitations under the License.
+// 
+// ================================================================================================
+
+#include "processorprofiler.h"
+
+#include "cgt/logmanager.h"
+
+#include "core/pipeline/abstractprocessor.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <thread>
+
+namespace campvis {
+
+    const std::string ProcessorProfiler::loggerCat_ = "CAMPVis.core.tools.ProcessorProfiler";
+
+    tbb::atomic<bool> ProcessorProfiler::s_capturing;
+
+    namespace {
+        /// Copies \a source into the fixed-size buffer \a destination, truncating if necessary.
+        void copyName(char* destination, const std::string& source) {
+            size_t length = std::min(source.size(), ProcessorProfiler::MAX_NAME_LENGTH - 1);
+            memcpy(destination, source.c_str(), length);
+            destination[length] = 0;
+        }
+
+        /// Returns the name of the processor method executing the given invalidation level.
+        const char* getLevelName(int invalidationLevel) {
+            switch (invalidationLevel) {
+                case AbstractProcessor::INVALID_SHADER:
+                    return "updateShader";
+                case AbstractProcessor::INVALID_PROPERTIES:
+                    return "updateProperties";
+                case AbstractProcessor::INVALID_RESULT:
+                    return "updateResult";
+                default:
+                    return "unknown";
+            }
+        }
+
+        /// Escapes \a str for use inside a JSON string.
+        std::string escapeJson(const char* str) {
+            std::string toReturn;
+            for (const char* c = str; *c != 0; ++c) {
+                switch (*c) {
+                    case '"':  toReturn += "\\\""; break;
+                    case '\\': toReturn += "\\\\"; break;
+                    case '\n': toReturn += "\\n"; break;
+                    case '\t': toReturn += "\\t"; break;
+                    default:
+                        if (static_cast<unsigned char>(*c) >= 0x20)
+                            toReturn += *c;
+                        break;
+                }
+            }
+            return toReturn;
+        }
+    }
+
+    ProcessorProfiler::ProcessorProfiler()
+        : _mask(0)
+        , _captureStartTime(0)
+    {
+        _writeIndex = 0;
+        _activeWriters = 0;
+        s_capturing = false;
+    }
+
+    ProcessorProfiler::~ProcessorProfiler() {
+        s_capturing = false;
+    }
+
+    void ProcessorProfiler::startCapture(size_t capacity /*= 65536*/) {
+        // stop recording and wait for all writers that already passed the s_capturing check
+        // (fetch_and_store is a full fence, pairing with the one in record())
+        s_capturing.fetch_and_store(false);
+        while (_activeWriters != 0)
+            std::this_thread::yield();
+
+        size_t size = 1;
+        while (size < capacity)
+            size <<= 1;
+
+        // only reallocate the ring buffer if its capacity changes
+        if (_slots.size() != size)
+            std::vector<Slot>(size).swap(_slots);
+        for (size_t i = 0; i < _slots.size(); ++i)
+            _slots[i]._sequence = 0;
+        _mask = size - 1;
+        _writeIndex = 0;
+        _captureStartTime = getTimestamp();
+
+        s_capturing = true;
+        LINFO("Started processor profiling capture.");
+    }
+
+    void ProcessorProfiler::stopCapture() {
+        s_capturing = false;
+        LINFO("Stopped processor profiling capture, " << std::min(static_cast<size_t>(_writeIndex), _slots.size()) << " records captured.");
+    }
+
+    bool ProcessorProfiler::isCapturing() {
+        return s_capturing;
+    }
+
+    long long ProcessorProfiler::getTimestamp() {
+        return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    void ProcessorProfiler::record(const std::string& contextName, const std::string& processorName, int invalidationLevel, long long startTime, long long endTime, long long invalidationTime) {
+        if (! s_capturing)
+            return;
+
+        // register as writer and check the flag again, so that startCapture() can wait for us
+        _activeWriters.fetch_and_increment();
+        if (! s_capturing) {
+            _activeWriters.fetch_and_decrement();
+            return;
+        }
+
+        // claim a slot and mark it as being written, fetch_and_store fences the following writes
+        size_t index = _writeIndex.fetch_and_increment();
+        Slot& slot = _slots[index & _mask];
+        slot._sequence.fetch_and_store(0);
+
+        Record& r = slot._record;
+        copyName(r._contextName, contextName);
+        copyName(r._processorName, processorName);
+        r._invalidationLevel = invalidationLevel;
+        r._threadId = std::hash<std::thread::id>()(std::this_thread::get_id());
+        r._startTime = startTime - _captureStartTime;
+        r._duration = endTime - startTime;
+        r._queueWaitTime = (invalidationTime != 0 && invalidationTime <= startTime) ? startTime - invalidationTime : 0;
+
+        // publish the record (release store)
+        slot._sequence = index + 1;
+        _activeWriters.fetch_and_decrement();
+    }
+
+    std::vector<ProcessorProfiler::Record> ProcessorProfiler::getRecords() const {
+        std::vector<Record> toReturn;
+        if (_slots.empty())
+            return toReturn;
+
+        size_t end = _writeIndex;
+        size_t begin = (end > _slots.size()) ? end - _slots.size() : 0;
+        toReturn.reserve(end - begin);
+
+        for (size_t i = begin; i < end; ++i) {
+            const Slot& slot = _slots[i & _mask];
+            if (slot._sequence != i + 1)
+                continue;
+
+            Record r = slot._record;
+            // skip the record if it was overwritten while copying, the fence keeps the copy
+            // from being reordered after the second sequence load
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (slot._sequence == i + 1)
+                toReturn.push_back(r);
+        }
+
+        return toReturn;
+    }
+
+    std::string ProcessorProfiler::getChromeTrace() const {
+        std::vector<Record> records = getRecords();
+
+        // assign small consecutive ids to contexts and threads for readable lanes
+        std::map<std::string, size_t> contextIds;
+        std::map<size_t, size_t> threadIds;
+        for (size_t i = 0; i < records.size(); ++i) {
+            contextIds.insert(std::make_pair(std::string(records[i]._contextName), contextIds.size() + 1));
+            threadIds.insert(std::make_pair(records[i]._threadId, threadIds.size() + 1));
+        }
+
+        std::ostringstream ss;
+        ss << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+
+        bool first = true;
+        for (std::map<std::string, size_t>::const_iterator it = contextIds.begin(); it != contextIds.end(); ++it) {
+            ss << (first ? "" : ",") << "\n{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":" << it->second 
+               << ",\"args\":{\"name\":\"" << escapeJson(it->first.c_str()) << "\"}}";
+            first = false;
+        }
+
+        for (size_t i = 0; i < records.size(); ++i) {
+            const Record& r = records[i];
+            ss << (first ? "" : ",") << "\n{\"name\":\"" << escapeJson(r._processorName) << "::" << getLevelName(r._invalidationLevel)
+               << "\",\"cat\":\"" << getLevelName(r._invalidationLevel)
+               << "\",\"ph\":\"X\",\"ts\":" << r._startTime << ",\"dur\":" << r._duration
+               << ",\"pid\":" << contextIds[r._contextName] << ",\"tid\":" << threadIds[r._threadId]
+               << ",\"args\":{\"queueWaitTime\":" << r._queueWaitTime << "}}";
+            first = false;
+        }
+
+        ss << "\n]}\n";
+        return ss.str();
+    }
+
+    bool ProcessorProfiler::exportChromeTrace(const std::string& filename) const {
+        std::ofstream file(filename.c_str(), std::ios::out | std::ios::trunc);
+        if (! file.is_open() || file.bad()) {
+            LERROR("Could not open file " << filename << " for writing.");
+            return false;
+        }
+
+        file << getChromeTrace();
+        return ! file.bad();
+    }
+
+}
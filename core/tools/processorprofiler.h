@@ -0,0 +1,162 @@
+// ================================================================================================
+// 
+// This file is part of the CAMPVis Software Framework.
+// 
+// If not explicitly stated otherwise: Copyright (C) 2012-2015, all rights reserved,
+//      Christian Schulte zu Berge <christian.szb@in.tum.de>
+//      Chair for Computer Aided Medical Procedures
+//      Technische Universitaet Muenchen
+//      Boltzmannstr. 3, 85748 Garching b. Muenchen, Germany
+// 
+// For a full list of authors and contributors, please refer to the file "AUTHORS.txt".
+// 
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file 
+// except in compliance with the License. You may obtain a copy of the License at
+// 
+// http://www.apache.org/licenses/LICENSE-2.0
+// 
+// Unless required by applicable law or agreed to in writing, software distributed under the 
+// License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, 
+// either express or implied. See the License for the specific language governing permissions 
+// and limitations under the License.
+// 
+// ================================================================================================
+
+#ifndef PROCESSORPROFILER_H__
+#define PROCESSORPROFILER_H__
+
+#include "cgt/singleton.h"
+
+#include <tbb/atomic.h>
+
+#include "core/coreapi.h"
+
+#include <string>
+#include <vector>
+
+namespace campvis {
+
+    /**
+     * Singleton class for recording the execution times of processors.
+     * 
+     * While a capture is running, AbstractProcessor::process() records one Record per executed
+     * invalidation level (updateShader(), updateProperties(), updateResult()) including the 
+     * executing thread and the time the processor was waiting for execution after it had been 
+     * invalidated. Records are stored in a fixed-size lock-free ring buffer, so that recording 
+     * does not serialize concurrently executing processors. Once the ring buffer is full, the 
+     * oldest records are overwritten.
+     * 
+     * The captured records can be exported in the Chrome trace event format, which can be viewed
+     * using chrome://tracing.
+     */
+    class CAMPVIS_CORE_API ProcessorProfiler : public cgt::Singleton<ProcessorProfiler> {
+        friend class cgt::Singleton<ProcessorProfiler>;
+
+    public:
+        /// Maximum length of the names stored in a Record, including the terminating zero.
+        static const size_t MAX_NAME_LENGTH = 64;
+
+        /**
+         * Profiling record of a single processor execution step.
+         */
+        struct Record {
+            char _contextName[MAX_NAME_LENGTH];     ///< Name of the DataContainer the processor worked on
+            char _processorName[MAX_NAME_LENGTH];   ///< Name of the processor
+            int _invalidationLevel;                 ///< Executed invalidation level (AbstractProcessor::InvalidationLevel)
+            size_t _threadId;                       ///< Hash of the ID of the executing thread
+            long long _startTime;                   ///< Start time in microseconds since start of the capture
+            long long _duration;                    ///< Duration in microseconds
+            long long _queueWaitTime;               ///< Time in microseconds between invalidation and start of the execution
+        };
+
+        /**
+         * Destructor
+         */
+        virtual ~ProcessorProfiler();
+
+        /**
+         * Starts a new capture, discarding all previously captured records.
+         * Waits for record() calls in flight to finish before the ring buffer is reset. Must not
+         * be called concurrently to getRecords().
+         * \param   capacity    Number of records the ring buffer can store, will be rounded up to the next power of two.
+         */
+        void startCapture(size_t capacity = 65536);
+
+        /**
+         * Stops the current capture. The captured records are kept until the next capture is started.
+         */
+        void stopCapture();
+
+        /**
+         * Returns whether a capture is currently running.
+         * \note    This method does not require the singleton to be initialized.
+         * \return  s_capturing
+         */
+        static bool isCapturing();
+
+        /**
+         * Returns a timestamp in microseconds of a monotonic clock.
+         * \return  The current timestamp.
+         */
+        static long long getTimestamp();
+
+        /**
+         * Records a single processor execution step.
+         * \note    This method is thread-safe and lock-free. Does nothing if no capture is running.
+         * \param   contextName         Name of the DataContainer the processor worked on.
+         * \param   processorName       Name of the processor.
+         * \param   invalidationLevel   Executed invalidation level.
+         * \param   startTime           Start time as returned by getTimestamp().
+         * \param   endTime             End time as returned by getTimestamp().
+         * \param   invalidationTime    Time the processor got invalidated as returned by getTimestamp(), 0 if unknown.
+         */
+        void record(const std::string& contextName, const std::string& processorName, int invalidationLevel, long long startTime, long long endTime, long long invalidationTime);
+
+        /**
+         * Returns all records of the last capture, ordered by the time they were recorded.
+         * \note    Records written concurrently to this call are skipped.
+         * \return  The captured records.
+         */
+        std::vector<Record> getRecords() const;
+
+        /**
+         * Returns the records of the last capture in the Chrome trace event format (JSON).
+         * Each DataContainer gets its own process lane, each thread its own thread lane.
+         * \return  The JSON string.
+         */
+        std::string getChromeTrace() const;
+
+        /**
+         * Writes the records of the last capture in the Chrome trace event format to the file \a filename.
+         * \param   filename    Name of the file to write.
+         * \return  True on success.
+         */
+        bool exportChromeTrace(const std::string& filename) const;
+
+    protected:
+        ProcessorProfiler();
+
+        /**
+         * Ring buffer slot, the sequence number tells whether _record is complete.
+         */
+        struct Slot {
+            tbb::atomic<size_t> _sequence;  ///< Index + 1 of the record stored in this slot once written completely, 0 while writing
+            Record _record;                 ///< The record
+        };
+
+        std::vector<Slot> _slots;           ///< The ring buffer
+        size_t _mask;                       ///< _slots.size() - 1 for fast modulo
+        tbb::atomic<size_t> _writeIndex;    ///< Index of the next record to write
+        tbb::atomic<int> _activeWriters;    ///< Number of record() calls currently writing into _slots
+        long long _captureStartTime;        ///< Timestamp of the capture start
+
+        static tbb::atomic<bool> s_capturing;   ///< Flag whether a capture is running
+
+        static const std::string loggerCat_;
+    };
+
+}
+
+#define ProcProfiler cgt::Singleton<campvis::ProcessorProfiler>::getRef()
+
+#endif // PROCESSORPROFILER_H__
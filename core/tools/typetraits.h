@@ -372,7 +372,7 @@ namespace {
             if (value >= 0)
                 return (static_cast<float>(value) / std::numeric_limits<T>::max()) * .5f + .5f;
             else
-                return (static_cast<float>(value) / -std::numeric_limits<T>::min()) * .5f + .5f;
+                return (static_cast<float>(value) / -static_cast<float>(std::numeric_limits<T>::min())) * .5f + .5f;
         }
 
         static T denormalizeFromFloat(float value) {
@@ -380,7 +380,7 @@ namespace {
             if(value >= 0.0f)
                 return static_cast<T>(value * std::numeric_limits<T>::max());
             else
-                return static_cast<T>(value * -std::numeric_limits<T>::min());
+                return static_cast<T>(value * -static_cast<float>(std::numeric_limits<T>::min()));
         };
     };
 }
@@ -0,0 +1,273 @@
+// ================================================================================================
+// 
+// This file is part of the CAMPVis Software Framework.
+// 
+// If not explicitly stated otherwise: Copyright (C) 2012-2015, all rights reserved,
+//      Christian Schulte zu Berge <christian.szb@in.tum.de>
+//      Chair for Computer Aided Medical Procedures
+//      Technische Universitaet Muenchen
+//      Boltzmannstr. 3, 85748 Garching b. Muenchen, Germany
+// 
+// For a full list of authors and contributors, please refer to the file "AUTHORS.txt".
+// 
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file 
+// except in compliance with the License. You may obtain a copy of the License at
+// 
+// http://www.apache.org/licenses/LICENSE-2.0
+// 
+// Unless required by applicable law or agreed to in writing, software distributed under the 
+// License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, 
+// either express or implied. See the License for the specific language governing permissions 
+// and limitations under the License.
+// 
+// ================================================================================================
+
+#ifndef VOXELVIEW_H__
+#define VOXELVIEW_H__
+
+#include "cgt/assert.h"
+#include "cgt/vector.h"
+
+#include "core/datastructures/genericimagerepresentationlocal.h"
+#include "core/tools/typetraits.h"
+
+#include <algorithm>
+
+namespace campvis {
+
+    /**
+     * Lightweight, strongly typed read-only view on the image data of a 
+     * GenericImageRepresentationLocal<BASETYPE, NUMCHANNELS>.
+     * 
+     * In contrast to ImageRepresentationLocal::getElementNormalized() and friends, all accessors 
+     * are non-virtual and inlined and the strides are precomputed, so that per-voxel loops 
+     * compile to plain memory accesses which the compiler can vectorize. Use dispatchVoxelView()
+     * to dispatch once on the base type of an ImageRepresentationLocal.
+     * 
+     * \note    The view does not own any data, the underlying representation must stay alive as
+     *          long as the view is used.
+     * \tparam  BASETYPE    Base type of the image data
+     * \tparam  NUMCHANNELS Number of channels of the image data
+     */
+    template<typename BASETYPE, size_t NUMCHANNELS>
+    class VoxelView {
+    public:
+        /// Type of the viewed image representation
+        typedef GenericImageRepresentationLocal<BASETYPE, NUMCHANNELS> RepresentationType;
+        /// Type of one single image element
+        typedef typename TypeTraits<BASETYPE, NUMCHANNELS>::ElementType ElementType;
+        /// Type of one single image element normalized to float
+        typedef typename TypeTraits<float, NUMCHANNELS>::ElementType NormalizedType;
+
+        /**
+         * Creates a new VoxelView of the given representation.
+         * \param   representation  Image representation to view, must not be 0.
+         */
+        explicit VoxelView(const RepresentationType* representation)
+            : _data(representation->getImageData())
+            , _size(representation->getSize())
+            , _strideY(_size.x)
+            , _strideZ(_size.x * _size.y)
+        {
+            cgtAssert(_data != 0, "Image data must not be 0.");
+        };
+
+        /// Returns the image size.
+        const cgt::svec3& getSize() const { return _size; };
+
+        /// Returns the number of image elements.
+        size_t getNumElements() const { return _strideZ * _size.z; };
+
+        /// Returns a pointer to the image data.
+        const ElementType* getData() const { return _data; };
+
+        /// Converts the voxel position \a position to its array index.
+        size_t positionToIndex(const cgt::svec3& position) const {
+            return position.x + position.y * _strideY + position.z * _strideZ;
+        };
+
+        /// Converts the array index \a index to its voxel position.
+        cgt::svec3 indexToPosition(size_t index) const {
+            return cgt::svec3(index % _strideY, (index % _strideZ) / _strideY, index / _strideZ);
+        };
+
+        /// Returns the image element at array index \a index.
+        const ElementType& getElement(size_t index) const { 
+            return _data[index];
+        };
+
+        /// Returns the image element at voxel position \a position.
+        const ElementType& getElement(const cgt::svec3& position) const {
+            return _data[positionToIndex(position)];
+        };
+
+        /**
+         * Returns channel \a channel of the element at array index \a index normalized to float.
+         * \see     ImageRepresentationLocal::getElementNormalized() for details on the normalization.
+         */
+        float getNormalized(size_t index, size_t channel) const {
+            return TypeNormalizer::normalizeToFloat(TypeTraits<BASETYPE, NUMCHANNELS>::getChannel(_data[index], channel));
+        };
+
+        /// Returns channel \a channel of the element at voxel position \a position normalized to float.
+        float getNormalized(const cgt::svec3& position, size_t channel) const {
+            return getNormalized(positionToIndex(position), channel);
+        };
+
+        /// Returns all channels of the element at array index \a index normalized to float.
+        NormalizedType getNormalized(size_t index) const {
+            NormalizedType toReturn;
+            for (size_t c = 0; c < NUMCHANNELS; ++c)
+                TypeTraits<float, NUMCHANNELS>::setChannel(toReturn, c, getNormalized(index, c));
+            return toReturn;
+        };
+
+        /**
+         * Returns channel \a channel at the voxel coordinates \a position normalized to float 
+         * using trilinear interpolation.
+         * \see     GenericImageRepresentationLocal::getElementNormalizedLinear(), which this method
+         *          matches exactly.
+         */
+        float getNormalizedLinear(const cgt::vec3& position, size_t channel) const {
+            size_t indices[8];
+            float weights[8];
+            computeLinearSupport(position, indices, weights);
+
+            float toReturn = 0.f;
+            for (size_t i = 0; i < 8; ++i)
+                toReturn += getNormalized(indices[i], channel) * weights[i];
+            return toReturn;
+        };
+
+        /**
+         * Returns all channels at the voxel coordinates \a position normalized to float using
+         * trilinear interpolation. Interpolation weights and indices are computed only once for
+         * all channels.
+         */
+        NormalizedType getNormalizedLinear(const cgt::vec3& position) const {
+            size_t indices[8];
+            float weights[8];
+            computeLinearSupport(position, indices, weights);
+
+            NormalizedType toReturn;
+            for (size_t c = 0; c < NUMCHANNELS; ++c) {
+                float value = 0.f;
+                for (size_t i = 0; i < 8; ++i)
+                    value += getNormalized(indices[i], c) * weights[i];
+                TypeTraits<float, NUMCHANNELS>::setChannel(toReturn, c, value);
+            }
+            return toReturn;
+        };
+
+        /**
+         * Computes the gradient of channel \a channel at voxel position \a position using central
+         * differences in voxel coordinates. Voxels outside the image are treated as 0.
+         * \param   position    Voxel position, must be inside the image.
+         * \param   channel     Image channel
+         * \return  ((f(x+1) - f(x-1)) / 2, (f(y+1) - f(y-1)) / 2, (f(z+1) - f(z-1)) / 2)
+         */
+        cgt::vec3 getGradient(const cgt::svec3& position, size_t channel = 0) const {
+            const size_t index = positionToIndex(position);
+            cgt::vec3 forward(0.f), backward(0.f);
+
+            if (position.x != _size.x - 1)
+                forward.x = getNormalized(index + 1, channel);
+            if (position.y != _size.y - 1)
+                forward.y = getNormalized(index + _strideY, channel);
+            if (position.z != _size.z - 1)
+                forward.z = getNormalized(index + _strideZ, channel);
+
+            if (position.x != 0)
+                backward.x = getNormalized(index - 1, channel);
+            if (position.y != 0)
+                backward.y = getNormalized(index - _strideY, channel);
+            if (position.z != 0)
+                backward.z = getNormalized(index - _strideZ, channel);
+
+            return (forward - backward) * .5f;
+        };
+
+    protected:
+        /**
+         * Computes the array indices and weights of the 8 voxels contributing to the trilinear 
+         * interpolation at \a position.
+         */
+        void computeLinearSupport(const cgt::vec3& position, size_t* indices, float* weights) const {
+            cgt::vec3 posAbs = cgt::max(position - 0.5f, cgt::vec3::zero);
+            cgt::vec3 p = posAbs - floor(posAbs); // get decimal part
+            cgt::svec3 llb = cgt::min(cgt::svec3(posAbs), _size - cgt::svec3(1));
+            cgt::svec3 urf = cgt::min(cgt::svec3(ceil(posAbs)), _size - cgt::svec3(1));
+
+            const size_t x[2] = { llb.x, urf.x };
+            const size_t y[2] = { llb.y * _strideY, urf.y * _strideY };
+            const size_t z[2] = { llb.z * _strideZ, urf.z * _strideZ };
+            const float wx[2] = { 1.f - p.x, p.x };
+            const float wy[2] = { 1.f - p.y, p.y };
+            const float wz[2] = { 1.f - p.z, p.z };
+
+            for (size_t i = 0; i < 8; ++i) {
+                indices[i] = x[i & 1] + y[(i >> 1) & 1] + z[i >> 2];
+                weights[i] = wx[i & 1] * wy[(i >> 1) & 1] * wz[i >> 2];
+            }
+        };
+
+        const ElementType* _data;   ///< Pointer to the image data
+        cgt::svec3 _size;           ///< Image size
+        size_t _strideY;            ///< Number of elements between adjacent rows
+        size_t _strideZ;            ///< Number of elements between adjacent slices
+    };
+
+    /**
+     * Dispatches \a functor with a VoxelView<BASETYPE, NUMCHANNELS> of \a representation, where 
+     * BASETYPE is determined at runtime from the base type of \a representation.
+     * Hence, the dispatch happens once per image instead of once per voxel.
+     * 
+     * \a functor has to offer a templated call operator accepting VoxelViews of all base types:
+     * \code
+     * struct Foo {
+     *     template<typename BASETYPE>
+     *     void operator() (const VoxelView<BASETYPE, 1>& view) const { ... }
+     * };
+     * \endcode
+     * 
+     * \param   representation  Image representation to dispatch, may be 0.
+     * \param   functor         Functor to call with the typed VoxelView.
+     * \tparam  NUMCHANNELS     Number of channels of the image data.
+     * \return  True if \a functor was called, false if \a representation is 0 or its number of
+     *          channels does not match NUMCHANNELS.
+     */
+    template<size_t NUMCHANNELS, typename FUNCTOR>
+    bool dispatchVoxelView(const ImageRepresentationLocal* representation, FUNCTOR& functor) {
+        if (representation == 0 || representation->getParent()->getNumChannels() != NUMCHANNELS)
+            return false;
+
+#define DISPATCH_VOXEL_VIEW(BASETYPE) \
+        functor(VoxelView<BASETYPE, NUMCHANNELS>(static_cast<const GenericImageRepresentationLocal<BASETYPE, NUMCHANNELS>*>(representation))); \
+        return true;
+
+        switch (representation->getBaseType()) {
+            case WeaklyTypedPointer::UINT8:
+                DISPATCH_VOXEL_VIEW(uint8_t)
+            case WeaklyTypedPointer::INT8:
+                DISPATCH_VOXEL_VIEW(int8_t)
+            case WeaklyTypedPointer::UINT16:
+                DISPATCH_VOXEL_VIEW(uint16_t)
+            case WeaklyTypedPointer::INT16:
+                DISPATCH_VOXEL_VIEW(int16_t)
+            case WeaklyTypedPointer::UINT32:
+                DISPATCH_VOXEL_VIEW(uint32_t)
+            case WeaklyTypedPointer::INT32:
+                DISPATCH_VOXEL_VIEW(int32_t)
+            case WeaklyTypedPointer::FLOAT:
+                DISPATCH_VOXEL_VIEW(float)
+            default:
+                cgtAssert(false, "Should not reach this - wrong base data type!");
+                return false;
+        }
+
+#undef DISPATCH_VOXEL_VIEW
+    }
+
+}
+
+#endif // VOXELVIEW_H__
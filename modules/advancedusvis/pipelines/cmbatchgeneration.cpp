@@ -33,17 +33,28 @@
 #include "core/classification/tfgeometry1d.h"
 #include "core/datastructures/imagerepresentationgl.h"
 #include "core/datastructures/facegeometry.h"
+#include "core/datastructures/renderdata.h"
+#include "core/tools/stringutils.h"
 
 #ifdef CAMPVIS_HAS_MODULE_DEVIL
 #include <IL/il.h>
 #include <IL/ilu.h>
 #endif
 
+#include <tbb/enumerable_thread_specific.h>
+#include <tbb/pipeline.h>
+#include <tbb/task_scheduler_init.h>
+#include <tbb/tick_count.h>
+
+#include <map>
+#include <memory>
 #include <sstream>
 #include <iomanip>
 
 namespace campvis {
 
+    const std::string CmBatchGeneration::loggerCat_ = "CAMPVis.modules.advancedusvis.CmBatchGeneration";
+
     CmBatchGeneration::CmBatchGeneration(DataContainer& dc)
         : AutoEvaluationPipeline(dc, getId())
         , _usReader()
@@ -185,6 +196,33 @@ namespace campvis {
         AutoEvaluationPipeline::onProcessorInvalidated(processor);
     }
 
+    namespace {
+        /// Thread-local copies of the CPU-only processors, so that several frames can be computed concurrently
+        struct CpuStageProcessors {
+            CpuStageProcessors() : _initialized(false) {};
+
+            ScanlineConverter _scanlineConverter;
+            ConfidenceMapGenerator _confidenceGenerator;
+            bool _initialized;
+        };
+    }
+
+    CmBatchGeneration::BatchFrame::BatchFrame(int index)
+        : _index(index)
+        , _data(new DataContainer("CmBatchGeneration.Frame"))
+    {
+        std::stringstream ss;
+        ss << "export" << std::setfill('0') << std::setw(4) << index << ".bmp";
+        _fileName = ss.str();
+
+        for (size_t i = 0; i < 4; ++i)
+            _stageTimes[i] = 0.0;
+    }
+
+    CmBatchGeneration::BatchFrame::~BatchFrame() {
+        delete _data;
+    }
+
     void CmBatchGeneration::startBatchProcess() {
         if (p_range.getValue().x > p_range.getValue().y)
             return;
@@ -194,29 +232,152 @@ namespace campvis {
         getDataContainer().removeData(_confidenceGenerator.p_targetImageID.getValue());
         getDataContainer().removeData(_confidenceGenerator.p_targetImageID.getValue() + "velocities");
 
-        cgt::GLContextScopedLock lock(_canvas);
-
         cgt::ivec2 originalCanvasSize = _canvasSize.getValue();
         _canvasSize.setValue(_scanlineConverter.p_targetSize.getValue());
-        
-        for (int i = p_range.getValue().x; i < p_range.getValue().y; ++i) {
-            executePass(i);
+
+        // Besides the frames being computed in parallel, allow one frame to be decoded and one to 
+        // be encoded. This bounds the memory footprint of the pipeline.
+        const size_t maxFramesInFlight = static_cast<size_t>(tbb::task_scheduler_init::default_num_threads()) + 2;
+        tbb::enumerable_thread_specific<CpuStageProcessors> cpuProcessors;
+
+        int nextFrame = p_range.getValue().x;
+        const int endFrame = p_range.getValue().y;
+        size_t numFrames = 0;
+        double stageTimes[4] = { 0.0, 0.0, 0.0, 0.0 };
+        tbb::tick_count startTime = tbb::tick_count::now();
+
+        // The frames are owned by inFlightFrames from decoding until they are encoded, the stages
+        // only pass raw pointers. If a stage throws, TBB cancels the pipeline and drops the frames
+        // in flight, which are then deleted together with inFlightFrames during unwinding.
+        std::map< int, std::unique_ptr<BatchFrame> > inFlightFrames;
+        tbb::mutex inFlightMutex;
+
+        tbb::parallel_pipeline(maxFramesInFlight,
+            // Stage 1: decode
+            tbb::make_filter<void, BatchFrame*>(tbb::filter::serial_in_order, [&] (tbb::flow_control& fc) -> BatchFrame* {
+                if (nextFrame >= endFrame) {
+                    fc.stop();
+                    return nullptr;
+                }
+
+                tbb::tick_count t = tbb::tick_count::now();
+                std::unique_ptr<BatchFrame> frame(new BatchFrame(nextFrame++));
+                decodeFrame(*frame);
+                frame->_stageTimes[0] = (tbb::tick_count::now() - t).seconds();
+
+                BatchFrame* toReturn = frame.get();
+                tbb::mutex::scoped_lock lock(inFlightMutex);
+                inFlightFrames[toReturn->_index].swap(frame);
+                return toReturn;
+            }) &
+            // Stage 2: scanline conversion and confidence map computation using thread-local processors
+            tbb::make_filter<BatchFrame*, BatchFrame*>(tbb::filter::parallel, [&] (BatchFrame* frame) -> BatchFrame* {
+                tbb::tick_count t = tbb::tick_count::now();
+                CpuStageProcessors& local = cpuProcessors.local();
+                if (! local._initialized) {
+                    local._scanlineConverter.init();
+                    local._confidenceGenerator.init();
+                    local._initialized = true;
+                }
+
+                // use the current settings of the pipeline's processors
+                local._scanlineConverter.p_sourceImageID.setValue(_scanlineConverter.p_sourceImageID.getValue());
+                local._scanlineConverter.p_targetImageID.setValue(_scanlineConverter.p_targetImageID.getValue());
+                local._scanlineConverter.p_targetSize.setValue(_scanlineConverter.p_targetSize.getValue());
+                local._scanlineConverter.p_origin.setValue(_scanlineConverter.p_origin.getValue());
+                local._scanlineConverter.p_angles.setValue(_scanlineConverter.p_angles.getValue());
+                local._scanlineConverter.p_lengths.setValue(_scanlineConverter.p_lengths.getValue());
+
+                local._confidenceGenerator.p_sourceImageID.setValue(_confidenceGenerator.p_sourceImageID.getValue());
+                local._confidenceGenerator.p_targetImageID.setValue(_confidenceGenerator.p_targetImageID.getValue());
+                local._confidenceGenerator.p_alpha.setValue(_confidenceGenerator.p_alpha.getValue());
+                local._confidenceGenerator.p_beta.setValue(_confidenceGenerator.p_beta.getValue());
+                local._confidenceGenerator.p_gamma.setValue(_confidenceGenerator.p_gamma.getValue());
+                local._confidenceGenerator.p_normalizeValues.setValue(_confidenceGenerator.p_normalizeValues.getValue());
+                local._confidenceGenerator.p_solver.selectById(_confidenceGenerator.p_solver.getOptionId());
+                local._confidenceGenerator.p_numSteps.setValue(_confidenceGenerator.p_numSteps.getValue());
+                // the temporal filter depends on the previous frame and is applied in stage 3
+                local._confidenceGenerator.p_temporalFiltering.setValue(false);
+
+                local._scanlineConverter.forceProcess(*frame->_data, AbstractProcessor::INVALID_RESULT);
+                local._confidenceGenerator.forceProcess(*frame->_data, AbstractProcessor::INVALID_RESULT);
+                frame->_stageTimes[1] = (tbb::tick_count::now() - t).seconds();
+                return frame;
+            }) &
+            // Stage 3: temporal filtering and rendering, OpenGL is serial anyway
+            tbb::make_filter<BatchFrame*, BatchFrame*>(tbb::filter::serial_in_order, [&] (BatchFrame* frame) -> BatchFrame* {
+                tbb::tick_count t = tbb::tick_count::now();
+                renderFrame(*frame);
+                frame->_stageTimes[2] = (tbb::tick_count::now() - t).seconds();
+                return frame;
+            }) &
+            // Stage 4: encode
+            tbb::make_filter<BatchFrame*, void>(tbb::filter::serial_in_order, [&] (BatchFrame* frame) {
+                tbb::tick_count t = tbb::tick_count::now();
+                encodeFrame(*frame);
+                frame->_stageTimes[3] = (tbb::tick_count::now() - t).seconds();
+
+                for (size_t i = 0; i < 4; ++i)
+                    stageTimes[i] += frame->_stageTimes[i];
+                ++numFrames;
+
+                // take the frame out of inFlightFrames and delete it outside the lock
+                std::unique_ptr<BatchFrame> finished;
+                {
+                    tbb::mutex::scoped_lock lock(inFlightMutex);
+                    std::map< int, std::unique_ptr<BatchFrame> >::iterator it = inFlightFrames.find(frame->_index);
+                    finished.swap(it->second);
+                    inFlightFrames.erase(it);
+                }
+            })
+        );
+
+        double totalTime = (tbb::tick_count::now() - startTime).seconds();
+
+        for (auto it = cpuProcessors.begin(); it != cpuProcessors.end(); ++it) {
+            if (it->_initialized) {
+                it->_scanlineConverter.deinit();
+                it->_confidenceGenerator.deinit();
+            }
         }
 
         _canvasSize.setValue(originalCanvasSize);
+
+        // report throughput of each stage
+        static const char* stageNames[4] = { "Decode", "Scanline conversion + confidence map", "Filtering + rendering", "Encode" };
+        LINFO("Processed " << numFrames << " frames in " << totalTime << " s (" << (totalTime > 0.0 ? numFrames / totalTime : 0.0) << " frames/s).");
+        for (size_t i = 0; i < 4; ++i) {
+            double msPerFrame = (numFrames > 0) ? 1000.0 * stageTimes[i] / numFrames : 0.0;
+            double framesPerSecond = (stageTimes[i] > 0.0) ? numFrames / stageTimes[i] : 0.0;
+            LINFO(stageNames[i] << ": " << msPerFrame << " ms/frame, " << framesPerSecond << " frames/s per thread.");
+        }
     }
 
-    void CmBatchGeneration::executePass(int path) {
-        // set up processors:
-        std::stringstream ss;
-        ss << "export" << std::setfill('0') << std::setw(4) << path << ".bmp";
-        std::string fileName = ss.str();
-
-        // read image
-        _usReader.p_url.setValue(p_sourcePath.getValue() + "\\" + fileName);
-        forceExecuteProcessor(&_usReader);
-        forceExecuteProcessor(&_scanlineConverter);
-        forceExecuteProcessor(&_confidenceGenerator);
+    void CmBatchGeneration::decodeFrame(BatchFrame& frame) {
+        tbb::mutex::scoped_lock lock(_devilMutex);
+        _usReader.p_url.setValue(p_sourcePath.getValue() + "\\" + frame._fileName);
+        _usReader.forceProcess(*frame._data, AbstractProcessor::INVALID_RESULT);
+    }
+
+    void CmBatchGeneration::renderFrame(BatchFrame& frame) {
+        DataContainer& dc = getDataContainer();
+        DataHandle cm = frame._data->getData(_confidenceGenerator.p_targetImageID.getValue());
+        if (cm.getData() == nullptr) {
+            LERROR("No confidence map computed for '" << frame._fileName << "', skipping.");
+            return;
+        }
+
+        cgt::GLContextScopedLock lock(_canvas);
+
+        // publish the frame's data to the pipeline, so that the GL processors can work on it
+        dc.addDataHandle(_usReader.p_targetImageID.getValue(), frame._data->getData(_usReader.p_targetImageID.getValue()));
+        dc.addDataHandle(_scanlineConverter.p_targetImageID.getValue(), frame._data->getData(_scanlineConverter.p_targetImageID.getValue()));
+        _confidenceGenerator.applyTemporalFilter(dc, dynamic_cast<const ImageData*>(cm.getData()));
+        cm = DataHandle();
+
+        // the input images may now carry GL representations, hence release them while we hold the context
+        frame._data->clear();
+
         forceExecuteProcessor(&_usBlurFilter);
 
         _usFusion.p_transferFunction.setAutoFitWindowToData(false);
@@ -227,15 +388,13 @@ namespace campvis {
             tf->addGeometry(TFGeometry1D::createQuad(cgt::vec2(0.0f, 1.0f), cgt::col4(0, 0, 0, 255), cgt::col4(0, 0, 0, 0)));
             _usFusion.p_confidenceTF.replaceTF(tf);
             _usFusion.p_view.selectById("us");
-            forceExecuteProcessor(&_usFusion);
-            save(_usFusion.p_targetImageID.getValue(), p_targetPathResampled.getValue() + "\\" + fileName);
+            renderView(frame, p_targetPathResampled.getValue() + "\\" + frame._fileName);
         }
 
         {
             // Confidence Map
             _usFusion.p_view.selectById("cm");
-            forceExecuteProcessor(&_usFusion);
-            save(_usFusion.p_targetImageID.getValue(), p_targetPathCmCpu.getValue() + "\\" + fileName);
+            renderView(frame, p_targetPathCmCpu.getValue() + "\\" + frame._fileName);
         }
 
         {
@@ -245,8 +404,7 @@ namespace campvis {
             _usFusion.p_confidenceTF.replaceTF(tf);
             _usFusion.p_hue.setValue(0.15f);
             _usFusion.p_view.selectById("colorOverlay");
-            forceExecuteProcessor(&_usFusion);
-            save(_usFusion.p_targetImageID.getValue(), p_targetPathColorOverlay.getValue() + "\\" + fileName);
+            renderView(frame, p_targetPathColorOverlay.getValue() + "\\" + frame._fileName);
         }
 
         {
@@ -256,8 +414,7 @@ namespace campvis {
             _usFusion.p_confidenceTF.replaceTF(tf);
             _usFusion.p_hue.setValue(0.23f);
             _usFusion.p_view.selectById("mappingLAB");
-            forceExecuteProcessor(&_usFusion);
-            save(_usFusion.p_targetImageID.getValue(), p_targetPathColor.getValue() + "\\" + fileName);
+            renderView(frame, p_targetPathColor.getValue() + "\\" + frame._fileName);
         }
 
         {
@@ -266,16 +423,43 @@ namespace campvis {
             tf->addGeometry(TFGeometry1D::createQuad(cgt::vec2(0.0f, 1.0f), cgt::col4(0, 0, 0, 255), cgt::col4(0, 0, 0, 0)));
             _usFusion.p_confidenceTF.replaceTF(tf);
             _usFusion.p_view.selectById("mappingSharpness");
-            forceExecuteProcessor(&_usFusion);
-            save(_usFusion.p_targetImageID.getValue(), p_targetPathFuzzy.getValue() + "\\" + fileName);
+            renderView(frame, p_targetPathFuzzy.getValue() + "\\" + frame._fileName);
         }
     }
 
-    void CmBatchGeneration::save(const std::string& dataName, const std::string& fileName) {
-        _imageWriter.p_inputImage.setValue(dataName);
-        _imageWriter.p_url.setValue(fileName);
-        _imageWriter.p_writeDepthImage.setValue(false);
-        forceExecuteProcessor(&_imageWriter);
+    void CmBatchGeneration::renderView(BatchFrame& frame, const std::string& fileName) {
+        forceExecuteProcessor(&_usFusion);
+
+        // download the rendering into a local image, so that it can be written without GL context
+        DataHandle dh = getDataContainer().getData(_usFusion.p_targetImageID.getValue());
+        const RenderData* rd = dynamic_cast<const RenderData*>(dh.getData());
+        if (rd == nullptr || rd->getNumColorTextures() == 0) {
+            LERROR("No rendering found for '" << fileName << "', skipping.");
+            return;
+        }
+
+        const ImageRepresentationLocal* rep = rd->getColorTexture(0)->getRepresentation<ImageRepresentationLocal>(true);
+        if (rep == nullptr) {
+            LERROR("Could not download rendering for '" << fileName << "', skipping.");
+            return;
+        }
+
+        ImageData* image = new ImageData(rep->getDimensionality(), rep->getSize(), rep->getParent()->getNumChannels());
+        rep->clone(image);
+
+        std::string dataName = "output" + StringUtils::toString(frame._outputs.size());
+        frame._data->addData(dataName, image);
+        frame._outputs.push_back(std::make_pair(dataName, fileName));
+    }
+
+    void CmBatchGeneration::encodeFrame(BatchFrame& frame) {
+        tbb::mutex::scoped_lock lock(_devilMutex);
+        for (size_t i = 0; i < frame._outputs.size(); ++i) {
+            _imageWriter.p_inputImage.setValue(frame._outputs[i].first);
+            _imageWriter.p_url.setValue(frame._outputs[i].second);
+            _imageWriter.p_writeDepthImage.setValue(false);
+            _imageWriter.forceProcess(*frame._data, AbstractProcessor::INVALID_RESULT);
+        }
     }
 
 }
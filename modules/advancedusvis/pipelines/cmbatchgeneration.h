@@ -37,12 +37,30 @@
 #include "modules/preprocessing/processors/glgaussianfilter.h"
 #include "modules/randomwalk/processors/confidencemapgenerator.h"
 
+#include <tbb/mutex.h>
+
+#include <string>
+#include <utility>
+#include <vector>
+
 namespace cgt {
     class Shader;
 }
 
 namespace campvis {
     
+    /**
+     * Batch pipeline computing confidence maps and uncertainty visualizations for a range of
+     * ultrasound images on disk.
+     * 
+     * The frames are streamed through a bounded TBB pipeline of four stages:
+     *  1. reading the image (serial, in order)
+     *  2. scanline conversion and confidence map computation (parallel over several frames)
+     *  3. temporal filtering, blurring and fusion rendering (serial, in order, needs OpenGL)
+     *  4. writing the result images (serial, in order)
+     * Hence, frame N+1 is decoded and frame N-1 is encoded while frame N is being computed.
+     * Since DevIL is not thread-safe, stages 1 and 4 share a mutex.
+     */
     class CAMPVIS_MODULES_API CmBatchGeneration : public AutoEvaluationPipeline {
     public:
         /**
@@ -70,9 +88,47 @@ namespace campvis {
         void onPropertyChanged(const AbstractProperty* p) override;
         virtual void onProcessorInvalidated(AbstractProcessor* processor) override;
 
+        /// Per-frame state flowing through the batch pipeline
+        struct BatchFrame {
+            explicit BatchFrame(int index);
+            ~BatchFrame();
+
+            int _index;                         ///< Index of the frame in p_range
+            std::string _fileName;              ///< File name of the frame (without path)
+            DataContainer* _data;               ///< Working set of data for this frame
+            std::vector< std::pair<std::string, std::string> > _outputs; ///< Pairs of (data name, target file) to write
+
+            double _stageTimes[4];              ///< Time spent in each of the stages in seconds
+        };
+
         void startBatchProcess();
-        void executePass(int path);
-        void save(const std::string& dataName, const std::string& fileName);
+
+        /**
+         * Stage 1: Reads the image of the given frame into its DataContainer.
+         * \param  frame   Frame to read
+         */
+        void decodeFrame(BatchFrame& frame);
+
+        /**
+         * Stage 3: Applies the temporal filter to the confidence map, renders all fusion views 
+         * into the pipeline's DataContainer and downloads the results into the frame's DataContainer.
+         * \note   Must be called in frame order and with a valid OpenGL context.
+         * \param  frame   Frame to render
+         */
+        void renderFrame(BatchFrame& frame);
+
+        /**
+         * Renders the current fusion view and schedules its download for writing to \a fileName.
+         * \param  frame       Frame to render
+         * \param  fileName    Target file name for this view
+         */
+        void renderView(BatchFrame& frame, const std::string& fileName);
+
+        /**
+         * Stage 4: Writes all result images of the given frame.
+         * \param  frame   Frame to write
+         */
+        void encodeFrame(BatchFrame& frame);
 
         DevilImageReader _usReader;                     ///< Reads the original image
         ScanlineConverter _scanlineConverter;           ///< Performs a scanline conversion
@@ -96,6 +152,9 @@ namespace campvis {
         ButtonProperty p_execute;                       ///< Button to start the batch process
 
         cgt::Shader* _shader;
+        tbb::mutex _devilMutex;                         ///< DevIL is not thread-safe, so reading and writing must not overlap
+
+        static const std::string loggerCat_;
     };
 }
 
@@ -30,9 +30,48 @@
 #include "core/tools/interval.h"
 #include "core/datastructures/imagedata.h"
 #include "core/datastructures/genericimagerepresentationlocal.h"
+#include "core/tools/voxelview.h"
+
+#include <tbb/tbb.h>
+#include <limits>
 
 namespace campvis {
 
+    namespace {
+        /**
+         * Applies the scanline conversion lookup table to a typed input image.
+         */
+        struct ScanlineConversionFunctor {
+            ScanlineConversionFunctor(const std::vector<ScanlineConverter::LookupEntry>& lookupTable, ImageRepresentationLocal* output)
+                : _lookupTable(lookupTable)
+                , _output(output)
+            {}
+
+            template<typename BASETYPE, size_t NUMCHANNELS>
+            void operator() (const VoxelView<BASETYPE, NUMCHANNELS>& input) const {
+                typedef typename TypeTraits<BASETYPE, NUMCHANNELS>::ElementType ElementType;
+                ElementType* outputData = static_cast<GenericImageRepresentationLocal<BASETYPE, NUMCHANNELS>*>(_output)->getImageData();
+                const ScanlineConverter::LookupEntry* table = _lookupTable.data();
+
+                tbb::parallel_for(tbb::blocked_range<size_t>(0, _lookupTable.size()), [&] (const tbb::blocked_range<size_t>& range) {
+                    for (size_t i = range.begin(); i != range.end(); ++i) {
+                        const ScanlineConverter::LookupEntry& e = table[i];
+                        for (size_t c = 0; c < NUMCHANNELS; ++c) {
+                            float value = input.getNormalized(e._indices[0], c) * e._weights[0]
+                                        + input.getNormalized(e._indices[1], c) * e._weights[1]
+                                        + input.getNormalized(e._indices[2], c) * e._weights[2]
+                                        + input.getNormalized(e._indices[3], c) * e._weights[3];
+                            TypeTraits<BASETYPE, NUMCHANNELS>::setChannel(outputData[i], c, TypeNormalizer::denormalizeFromFloat<BASETYPE>(value));
+                        }
+                    }
+                });
+            }
+
+            const std::vector<ScanlineConverter::LookupEntry>& _lookupTable;
+            ImageRepresentationLocal* _output;
+        };
+    }
+
     const std::string ScanlineConverter::loggerCat_ = "CAMPVis.modules.classification.ScanlineConverter";
 
     ScanlineConverter::ScanlineConverter()
@@ -43,6 +82,8 @@ namespace campvis {
         , p_origin("PolarOrigin", "Polar Origin", cgt::vec2(340.f, 536.f), cgt::vec2(-1000.f), cgt::vec2(1000.f), cgt::vec2(0.1f))
         , p_angles("PolarAngles", "Polar Angles", cgt::vec2(233.f, 308.f), cgt::vec2(0.f), cgt::vec2(360.f), cgt::vec2(0.1f))
         , p_lengths("PolarLengths", "Polar Lengths", cgt::vec2(116.f, 540.f), cgt::vec2(0.f), cgt::vec2(1000.f), cgt::vec2(0.1f))
+        , _tableInputSize(cgt::svec3::zero)
+        , _tableTargetSize(cgt::ivec2::zero)
     {
         addProperty(p_sourceImageID);
         addProperty(p_targetImageID);
@@ -58,27 +99,73 @@ namespace campvis {
 
     std::vector<cgt::vec3> ScanlineConverter::generateLookupVertices(const ImageData* inputImage) const {
         cgtAssert(inputImage != nullptr, "Input image must not be 0!");
-        std::vector<cgt::vec3> vertices;
 
         const cgt::ivec2& outputSize = p_targetSize.getValue();
+        const cgt::vec2& origin = p_origin.getValue();
         const float rarara = cgt::PIf / 180.f;
         Interval<float> fanAngles(p_angles.getValue().x * rarara, p_angles.getValue().y * rarara);
         Interval<float> fanSize(p_lengths.getValue().x, p_lengths.getValue().y);
 
+        // the angle only depends on the column, so compute the directions only once per column
+        std::vector<cgt::vec2> directions(outputSize.x);
+        for (int x = 0; x < outputSize.x; ++x) {
+            float phi = fanAngles.getLeft() + (static_cast<float>(x) / static_cast<float>(outputSize.x) * fanAngles.size());
+            directions[x] = cgt::vec2(cos(phi), sin(phi));
+        }
 
-        for (int y = 0; y < outputSize.y; ++y) {
-            float r = fanSize.getLeft() + static_cast<float>(outputSize.y - 1 - y) / static_cast<float>(outputSize.y) * fanSize.size();
+        std::vector<cgt::vec3> vertices(outputSize.x * outputSize.y);
+        tbb::parallel_for(tbb::blocked_range<int>(0, outputSize.y), [&] (const tbb::blocked_range<int>& range) {
+            for (int y = range.begin(); y != range.end(); ++y) {
+                float r = fanSize.getLeft() + static_cast<float>(outputSize.y - 1 - y) / static_cast<float>(outputSize.y) * fanSize.size();
 
-            for (int x = 0; x < outputSize.x; ++x) {
-                float phi = fanAngles.getLeft() + (static_cast<float>(x) / static_cast<float>(outputSize.x) * fanAngles.size());
-                const cgt::vec3 cc(r * cos(phi) + p_origin.getValue().x, r * sin(phi) + p_origin.getValue().y, 0.f);
-                vertices.push_back(cc);
+                for (int x = 0; x < outputSize.x; ++x) {
+                    vertices[y * outputSize.x + x] = cgt::vec3(r * directions[x].x + origin.x, r * directions[x].y + origin.y, 0.f);
+                }
             }
-        }
+        });
 
         return vertices;
     }
 
+    void ScanlineConverter::updateLookupTable(const ImageData* inputImage) {
+        const cgt::svec3& inputSize = inputImage->getSize();
+        if (! _lookupTable.empty() && inputSize == _tableInputSize && p_targetSize.getValue() == _tableTargetSize
+            && p_origin.getValue() == _tableOrigin && p_angles.getValue() == _tableAngles && p_lengths.getValue() == _tableLengths)
+        {
+            return;
+        }
+
+        cgtAssert(inputImage->getNumElements() <= std::numeric_limits<uint32_t>::max(), "Input image too large for lookup table.");
+        std::vector<cgt::vec3> vertices = generateLookupVertices(inputImage);
+        _lookupTable.resize(vertices.size());
+
+        // same support as ImageRepresentationLocal::getElementNormalizedLinear() for 2D images
+        tbb::parallel_for(tbb::blocked_range<size_t>(0, vertices.size()), [&] (const tbb::blocked_range<size_t>& range) {
+            for (size_t i = range.begin(); i != range.end(); ++i) {
+                cgt::vec2 posAbs = cgt::max(vertices[i].xy() - 0.5f, cgt::vec2::zero);
+                cgt::vec2 p = posAbs - floor(posAbs);
+                cgt::svec2 llb = cgt::min(cgt::svec2(posAbs), inputSize.xy() - cgt::svec2(1));
+                cgt::svec2 urf = cgt::min(cgt::svec2(ceil(posAbs)), inputSize.xy() - cgt::svec2(1));
+
+                LookupEntry& e = _lookupTable[i];
+                e._indices[0] = static_cast<uint32_t>(llb.x + inputSize.x * llb.y);
+                e._indices[1] = static_cast<uint32_t>(urf.x + inputSize.x * llb.y);
+                e._indices[2] = static_cast<uint32_t>(llb.x + inputSize.x * urf.y);
+                e._indices[3] = static_cast<uint32_t>(urf.x + inputSize.x * urf.y);
+                e._weights[0] = (1.f - p.x) * (1.f - p.y);
+                e._weights[1] = (      p.x) * (1.f - p.y);
+                e._weights[2] = (1.f - p.x) * (      p.y);
+                e._weights[3] = (      p.x) * (      p.y);
+            }
+        });
+
+        _tableInputSize = inputSize;
+        _tableTargetSize = p_targetSize.getValue();
+        _tableOrigin = p_origin.getValue();
+        _tableAngles = p_angles.getValue();
+        _tableLengths = p_lengths.getValue();
+    }
+
     void ScanlineConverter::updateResult(DataContainer& dataContainer) {
         ImageRepresentationLocal::ScopedRepresentation input(dataContainer, p_sourceImageID.getValue());
 
@@ -91,11 +178,12 @@ namespace campvis {
             wtp._pointer = nullptr;
             auto outputRep = ImageRepresentationLocal::create(outputImage, wtp);
 
-            auto vertices = generateLookupVertices(input->getParent());
-            for (size_t i = 0; i < vertices.size(); ++i) {
-                for (size_t c = 0; c < numChannels; ++c) {
-                    outputRep->setElementNormalized(i, c, input->getElementNormalizedLinear(vertices[i], c));
-                }
+            updateLookupTable(input->getParent());
+            ScanlineConversionFunctor functor(_lookupTable, outputRep);
+            if (! (dispatchVoxelView<1>(input, functor) || dispatchVoxelView<2>(input, functor) || dispatchVoxelView<3>(input, functor) || dispatchVoxelView<4>(input, functor))) {
+                LERROR("Unsupported number of channels.");
+                delete outputImage;
+                return;
             }
 
             dataContainer.addData(p_targetImageID.getValue(), outputImage);
@@ -33,12 +33,18 @@
 
 #include "modules/modulesapi.h"
 
+#include <vector>
+
 namespace campvis {
     class ImageData;
 
     /**
      * Performs scanline conversion from a curvilinear (US) image in a rectilinear image into
      * a rectilinear image given the fan parameters.
+     * 
+     * The fan geometry is compiled into a lookup table of source indices and bilinear weights,
+     * which is cached as long as the fan parameters and the input image size do not change.
+     * Hence, converting a sequence of frames only costs one parallel gather per frame.
      */
     class CAMPVIS_MODULES_API ScanlineConverter : public AbstractProcessor {
     public:
@@ -68,6 +74,12 @@ namespace campvis {
          */
         std::vector<cgt::vec3> generateLookupVertices(const ImageData* inputImage) const;
 
+        /// Bilinear interpolation support of a single target pixel
+        struct LookupEntry {
+            uint32_t _indices[4];   ///< Array indices of the four contributing input pixels
+            float _weights[4];      ///< Bilinear weights of the four contributing input pixels
+        };
+
         DataNameProperty p_sourceImageID;       ///< ID for input image
         DataNameProperty p_targetImageID;       ///< ID for output confidence map image
 
@@ -80,6 +92,20 @@ namespace campvis {
         /// \see AbstractProcessor::updateResult
         virtual void updateResult(DataContainer& dataContainer);
 
+        /**
+         * Updates the cached lookup table if the fan parameters or the input image size changed.
+         * \param   inputImage  Pointer to the input image (required for meta data)
+         */
+        void updateLookupTable(const ImageData* inputImage);
+
+        std::vector<LookupEntry> _lookupTable;  ///< Cached lookup table, one entry per target pixel
+
+        cgt::svec3 _tableInputSize;             ///< Input image size the lookup table was computed for
+        cgt::ivec2 _tableTargetSize;            ///< Target size the lookup table was computed for
+        cgt::vec2 _tableOrigin;                 ///< Fan origin the lookup table was computed for
+        cgt::vec2 _tableAngles;                 ///< Fan angles the lookup table was computed for
+        cgt::vec2 _tableLengths;                ///< Fan lengths the lookup table was computed for
+
         static const std::string loggerCat_;
     };
 
@@ -0,0 +1,408 @@
+// ================================================================================================
+// 
+// This file is part of the CAMPVis Software Framework.
+// 
+// If not explicitly stated otherwise: Copyright (C) 2012-2015, all rights reserved,
+//      Christian Schulte zu Berge <christian.szb@in.tum.de>
+//      Chair for Computer Aided Medical Procedures
+//      Technische Universitaet Muenchen
+//      Boltzmannstr. 3, 85748 Garching b. Muenchen, Germany
+// 
+// For a full list of authors and contributors, please refer to the file "AUTHORS.txt".
+// 
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file 
+// except in compliance with the License. You may obtain a copy of the License at
+// 
+// http://www.apache.org/licenses/LICENSE-2.0
+// 
+// Unless required by applicable law or agreed to in writing, software distributed under the 
+// License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, 
+// either express or implied. See the License for the specific language governing permissions 
+// and limitations under the License.
+// 
+// ================================================================================================
+
+
+#include "fiberbvh.h"
+
+#include "cgt/assert.h"
+#include "modules/dti/datastructures/fiberdata.h"
+
+#include <tbb/tbb.h>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <utility>
+
+namespace campvis {
+namespace dti {
+
+    namespace {
+
+        /// Spreads the lower 10 bits of \a v so that there are two zero bits between each of them.
+        inline uint32_t expandBits(uint32_t v) {
+            v = (v * 0x00010001u) & 0xFF0000FFu;
+            v = (v * 0x00000101u) & 0x0F00F00Fu;
+            v = (v * 0x00000011u) & 0xC30C30C3u;
+            v = (v * 0x00000005u) & 0x49249249u;
+            return v;
+        }
+
+        /// Computes the 30 bit Morton code of \a p, which must be in [0, 1]^3.
+        inline uint32_t mortonCode(const cgt::vec3& p) {
+            uint32_t x = static_cast<uint32_t>(std::min(std::max(p.x * 1024.f, 0.f), 1023.f));
+            uint32_t y = static_cast<uint32_t>(std::min(std::max(p.y * 1024.f, 0.f), 1023.f));
+            uint32_t z = static_cast<uint32_t>(std::min(std::max(p.z * 1024.f, 0.f), 1023.f));
+            return (expandBits(x) << 2) | (expandBits(y) << 1) | expandBits(z);
+        }
+
+        inline bool isEmpty(const FiberBvh::Node& node) {
+            return node._llf.x > node._urb.x;
+        }
+
+        inline FiberBvh::Node emptyNode() {
+            FiberBvh::Node toReturn;
+            toReturn._llf = cgt::vec3(std::numeric_limits<float>::max());
+            toReturn._urb = cgt::vec3(-std::numeric_limits<float>::max());
+            return toReturn;
+        }
+
+        /// Classifies the box [llf, urb] against the axis-aligned box [boxLlf, boxUrb].
+        inline FiberBvh::Classification classifyBox(const cgt::vec3& llf, const cgt::vec3& urb, const cgt::vec3& boxLlf, const cgt::vec3& boxUrb) {
+            for (size_t i = 0; i < 3; ++i) {
+                if (urb[i] < boxLlf[i] || llf[i] > boxUrb[i])
+                    return FiberBvh::OUTSIDE;
+            }
+            for (size_t i = 0; i < 3; ++i) {
+                if (llf[i] < boxLlf[i] || urb[i] > boxUrb[i])
+                    return FiberBvh::INTERSECTING;
+            }
+            return FiberBvh::INSIDE;
+        }
+
+        /// Classifies the box [llf, urb] against the sphere around \a center with squared radius \a radius2.
+        inline FiberBvh::Classification classifySphere(const cgt::vec3& llf, const cgt::vec3& urb, const cgt::vec3& center, float radius2) {
+            cgt::vec3 nearest = cgt::clamp(center, llf, urb) - center;
+            if (cgt::dot(nearest, nearest) > radius2)
+                return FiberBvh::OUTSIDE;
+
+            cgt::vec3 farthest = cgt::max(cgt::abs(llf - center), cgt::abs(urb - center));
+            return (cgt::dot(farthest, farthest) <= radius2) ? FiberBvh::INSIDE : FiberBvh::INTERSECTING;
+        }
+
+        /// Classifies the box [llf, urb] against the frustum \a frustum.
+        inline FiberBvh::Classification classifyFrustum(const cgt::vec3& llf, const cgt::vec3& urb, const cgt::Frustum& frustum) {
+            bool inside = true;
+
+            // same plane setup as in cgt::Frustum::isCulled(): the normals point outwards.
+            for (int i = 0; i < 6; ++i) {
+                const cgt::vec3& normal = frustum.getNormal(i);
+                const cgt::vec3& pos = (i < 4) ? frustum.campos() : ((i == 4) ? frustum.nearp() : frustum.farp());
+
+                // corners of the box with minimal and maximal distance to the plane
+                cgt::vec3 minCorner((normal.x >= 0.f) ? llf.x : urb.x, (normal.y >= 0.f) ? llf.y : urb.y, (normal.z >= 0.f) ? llf.z : urb.z);
+                cgt::vec3 maxCorner((normal.x >= 0.f) ? urb.x : llf.x, (normal.y >= 0.f) ? urb.y : llf.y, (normal.z >= 0.f) ? urb.z : llf.z);
+
+                if (cgt::dot(normal, minCorner - pos) >= 0.f)
+                    return FiberBvh::OUTSIDE;
+                if (cgt::dot(normal, maxCorner - pos) >= 0.f)
+                    inside = false;
+            }
+
+            return inside ? FiberBvh::INSIDE : FiberBvh::INTERSECTING;
+        }
+
+        /// Returns whether the segment from \a a to \a b intersects the axis-aligned box [boxLlf, boxUrb].
+        inline bool segmentIntersectsBox(const cgt::vec3& a, const cgt::vec3& b, const cgt::vec3& boxLlf, const cgt::vec3& boxUrb) {
+            cgt::vec3 direction = b - a;
+            float tMin = 0.f;
+            float tMax = 1.f;
+
+            for (size_t i = 0; i < 3; ++i) {
+                if (std::abs(direction[i]) < std::numeric_limits<float>::epsilon()) {
+                    if (a[i] < boxLlf[i] || a[i] > boxUrb[i])
+                        return false;
+                }
+                else {
+                    float t1 = (boxLlf[i] - a[i]) / direction[i];
+                    float t2 = (boxUrb[i] - a[i]) / direction[i];
+                    tMin = std::max(tMin, std::min(t1, t2));
+                    tMax = std::min(tMax, std::max(t1, t2));
+                    if (tMin > tMax)
+                        return false;
+                }
+            }
+
+            return true;
+        }
+
+        /// Returns whether the segment from \a a to \a b intersects the sphere around \a center with squared radius \a radius2.
+        inline bool segmentIntersectsSphere(const cgt::vec3& a, const cgt::vec3& b, const cgt::vec3& center, float radius2) {
+            cgt::vec3 direction = b - a;
+            float length2 = cgt::dot(direction, direction);
+            float t = (length2 > 0.f) ? std::min(std::max(cgt::dot(center - a, direction) / length2, 0.f), 1.f) : 0.f;
+            cgt::vec3 difference = a + t * direction - center;
+            return cgt::dot(difference, difference) <= radius2;
+        }
+
+    }
+
+// ================================================================================================
+
+    FiberBvh::FiberBvh(const FiberData& fibers)
+        : _numFibers(fibers.numFibers())
+        , _firstLeaf(0)
+    {
+        const std::vector<cgt::vec3>& vertices = fibers.getVertices();
+        const std::vector<size_t>& offsets = fibers.getFiberOffsets();
+
+        // compute where the segments of each fiber start, single vertices get a degenerate segment
+        std::vector<size_t> segmentOffsets(_numFibers + 1, 0);
+        for (size_t f = 0; f < _numFibers; ++f) {
+            size_t numVertices = offsets[f+1] - offsets[f];
+            segmentOffsets[f+1] = segmentOffsets[f] + ((numVertices > 1) ? numVertices - 1 : numVertices);
+        }
+
+        const size_t numSegments = segmentOffsets.back();
+        if (numSegments == 0)
+            return;
+
+        std::vector<Segment> segments(numSegments);
+        tbb::parallel_for(tbb::blocked_range<size_t>(0, _numFibers), [&] (const tbb::blocked_range<size_t>& range) {
+            for (size_t f = range.begin(); f != range.end(); ++f) {
+                for (size_t s = segmentOffsets[f]; s < segmentOffsets[f+1]; ++s) {
+                    size_t v = offsets[f] + (s - segmentOffsets[f]);
+                    segments[s]._start = vertices[v];
+                    segments[s]._end = vertices[std::min(v + 1, offsets[f+1] - 1)];
+                    segments[s]._fiber = f;
+                }
+            }
+        });
+
+        // sort the segments along the Morton curve of their centers
+        cgt::Bounds centerBounds = tbb::parallel_reduce(
+            tbb::blocked_range<size_t>(0, numSegments), cgt::Bounds(),
+            [&] (const tbb::blocked_range<size_t>& range, cgt::Bounds b) -> cgt::Bounds {
+                for (size_t s = range.begin(); s != range.end(); ++s)
+                    b.addPoint((segments[s]._start + segments[s]._end) * .5f);
+                return b;
+            },
+            [] (cgt::Bounds a, const cgt::Bounds& b) -> cgt::Bounds {
+                if (b.isDefined())
+                    a.addVolume(b);
+                return a;
+            });
+
+        const cgt::vec3 llf = centerBounds.getLLF();
+        const cgt::vec3 extent = cgt::max(centerBounds.getURB() - llf, cgt::vec3(std::numeric_limits<float>::epsilon()));
+
+        std::vector< std::pair<uint32_t, size_t> > codes(numSegments);
+        tbb::parallel_for(tbb::blocked_range<size_t>(0, numSegments), [&] (const tbb::blocked_range<size_t>& range) {
+            for (size_t s = range.begin(); s != range.end(); ++s)
+                codes[s] = std::make_pair(mortonCode(((segments[s]._start + segments[s]._end) * .5f - llf) / extent), s);
+        });
+        tbb::parallel_sort(codes.begin(), codes.end());
+
+        _segments.resize(numSegments);
+        tbb::parallel_for(tbb::blocked_range<size_t>(0, numSegments), [&] (const tbb::blocked_range<size_t>& range) {
+            for (size_t s = range.begin(); s != range.end(); ++s)
+                _segments[s] = segments[codes[s].second];
+        });
+
+        // build the complete binary tree bottom-up
+        const size_t numLeaves = (numSegments + LEAF_SIZE - 1) / LEAF_SIZE;
+        size_t numLeavesPadded = 1;
+        while (numLeavesPadded < numLeaves)
+            numLeavesPadded *= 2;
+
+        _firstLeaf = numLeavesPadded - 1;
+        _nodes.resize(_firstLeaf + numLeaves, emptyNode());
+
+        tbb::parallel_for(tbb::blocked_range<size_t>(0, numLeaves), [&] (const tbb::blocked_range<size_t>& range) {
+            for (size_t l = range.begin(); l != range.end(); ++l) {
+                Node& node = _nodes[_firstLeaf + l];
+                for (size_t s = l * LEAF_SIZE; s < std::min(numSegments, (l + 1) * LEAF_SIZE); ++s) {
+                    node._llf = cgt::min(node._llf, cgt::min(_segments[s]._start, _segments[s]._end));
+                    node._urb = cgt::max(node._urb, cgt::max(_segments[s]._start, _segments[s]._end));
+                }
+            }
+        });
+
+        for (size_t levelEnd = _firstLeaf; levelEnd > 0; levelEnd /= 2) {
+            size_t levelBegin = levelEnd / 2;
+            tbb::parallel_for(tbb::blocked_range<size_t>(levelBegin, levelEnd), [&] (const tbb::blocked_range<size_t>& range) {
+                for (size_t n = range.begin(); n != range.end(); ++n) {
+                    for (size_t c = 2*n + 1; c <= 2*n + 2 && c < _nodes.size(); ++c) {
+                        _nodes[n]._llf = cgt::min(_nodes[n]._llf, _nodes[c]._llf);
+                        _nodes[n]._urb = cgt::max(_nodes[n]._urb, _nodes[c]._urb);
+                    }
+                }
+            });
+        }
+    }
+
+    FiberBvh::~FiberBvh() {
+
+    }
+
+    template<typename NODETEST, typename SEGMENTTEST>
+    void FiberBvh::query(const NODETEST& nodeTest, const SEGMENTTEST& segmentTest, std::vector<uint8_t>& mask, MaskOperation operation) const {
+        // Traverse the subtrees below a fixed level in parallel, each thread collects the ranges
+        // of hit segments locally. Ranges keep the output small for nodes completely inside.
+        typedef std::vector< std::pair<size_t, size_t> > RangeVector;
+        tbb::enumerable_thread_specific<RangeVector> localHits;
+
+        size_t firstNode = 0;
+        while (firstNode < _firstLeaf && firstNode < 63)
+            firstNode = 2*firstNode + 1;
+        const size_t lastNode = std::min(2*firstNode + 1, _nodes.size());
+
+        tbb::parallel_for(tbb::blocked_range<size_t>(firstNode, std::max(firstNode, lastNode), 1), [&] (const tbb::blocked_range<size_t>& range) {
+            RangeVector& hits = localHits.local();
+            size_t stack[64];
+
+            for (size_t root = range.begin(); root != range.end(); ++root) {
+                size_t stackSize = 0;
+                stack[stackSize++] = root;
+
+                while (stackSize > 0) {
+                    size_t n = stack[--stackSize];
+                    if (n >= _nodes.size() || isEmpty(_nodes[n]))
+                        continue;
+
+                    Classification c = nodeTest(_nodes[n]);
+                    if (c == INSIDE) {
+                        appendSegmentRange(getSegmentRange(n), hits);
+                    }
+                    else if (c == INTERSECTING) {
+                        if (n >= _firstLeaf) {
+                            std::pair<size_t, size_t> leafRange = getSegmentRange(n);
+                            for (size_t s = leafRange.first; s < leafRange.second; ++s) {
+                                if (segmentTest(_segments[s]))
+                                    appendSegmentRange(std::make_pair(s, s + 1), hits);
+                            }
+                        }
+                        else {
+                            stack[stackSize++] = 2*n + 2;
+                            stack[stackSize++] = 2*n + 1;
+                        }
+                    }
+                }
+            }
+        });
+
+        std::vector<uint8_t> hitMask(_numFibers, 0);
+        for (tbb::enumerable_thread_specific<RangeVector>::const_iterator it = localHits.begin(); it != localHits.end(); ++it) {
+            for (RangeVector::const_iterator rit = it->begin(); rit != it->end(); ++rit) {
+                for (size_t s = rit->first; s < rit->second; ++s)
+                    hitMask[_segments[s]._fiber] = 1;
+            }
+        }
+
+        if (operation == SET) {
+            mask.swap(hitMask);
+            return;
+        }
+
+        cgtAssert(mask.size() == _numFibers, "Mask size must match the number of fibers!");
+        for (size_t f = 0; f < _numFibers; ++f) {
+            switch (operation) {
+                case INTERSECT:
+                    mask[f] = mask[f] && hitMask[f];
+                    break;
+                case SUBTRACT:
+                    mask[f] = mask[f] && !hitMask[f];
+                    break;
+                case UNITE:
+                    mask[f] = mask[f] || hitMask[f];
+                    break;
+                default:
+                    break;
+            }
+        }
+    }
+
+    std::pair<size_t, size_t> FiberBvh::getSegmentRange(size_t nodeIndex) const {
+        // find the range of leaves below nodeIndex
+        size_t first = nodeIndex;
+        size_t last = nodeIndex;
+        while (first < _firstLeaf) {
+            first = 2*first + 1;
+            last = 2*last + 2;
+        }
+
+        return std::make_pair((first - _firstLeaf) * LEAF_SIZE, std::min(_segments.size(), (last - _firstLeaf + 1) * LEAF_SIZE));
+    }
+
+    void FiberBvh::appendSegmentRange(const std::pair<size_t, size_t>& range, std::vector< std::pair<size_t, size_t> >& ranges) {
+        if (! ranges.empty() && ranges.back().second == range.first)
+            ranges.back().second = range.second;
+        else
+            ranges.push_back(range);
+    }
+
+    void FiberBvh::queryBox(const cgt::Bounds& box, std::vector<uint8_t>& mask, MaskOperation operation /*= SET*/) const {
+        if (! box.isDefined()) {
+            query([] (const Node&) { return OUTSIDE; }, [] (const Segment&) { return false; }, mask, operation);
+            return;
+        }
+
+        const cgt::vec3 boxLlf = box.getLLF();
+        const cgt::vec3 boxUrb = box.getURB();
+        query(
+            [&] (const Node& node) { return classifyBox(node._llf, node._urb, boxLlf, boxUrb); },
+            [&] (const Segment& segment) { return segmentIntersectsBox(segment._start, segment._end, boxLlf, boxUrb); },
+            mask, operation);
+    }
+
+    void FiberBvh::querySphere(const cgt::vec3& center, float radius, std::vector<uint8_t>& mask, MaskOperation operation /*= SET*/) const {
+        const float radius2 = radius * radius;
+        query(
+            [&] (const Node& node) { return classifySphere(node._llf, node._urb, center, radius2); },
+            [&] (const Segment& segment) { return segmentIntersectsSphere(segment._start, segment._end, center, radius2); },
+            mask, operation);
+    }
+
+    void FiberBvh::queryPlane(const cgt::vec3& normal, float distance, std::vector<uint8_t>& mask, MaskOperation operation /*= SET*/) const {
+        query(
+            [&] (const Node& node) -> Classification {
+                float radius = cgt::dot(cgt::abs(normal), (node._urb - node._llf) * .5f);
+                float centerDistance = cgt::dot(normal, (node._urb + node._llf) * .5f) - distance;
+                return (std::abs(centerDistance) > radius) ? OUTSIDE : INTERSECTING;
+            },
+            [&] (const Segment& segment) -> bool {
+                float d1 = cgt::dot(normal, segment._start) - distance;
+                float d2 = cgt::dot(normal, segment._end) - distance;
+                return std::min(d1, d2) <= 0.f && std::max(d1, d2) >= 0.f;
+            },
+            mask, operation);
+    }
+
+    void FiberBvh::queryFrustum(const cgt::Frustum& frustum, std::vector<uint8_t>& mask, MaskOperation operation /*= SET*/) const {
+        query(
+            [&] (const Node& node) { return classifyFrustum(node._llf, node._urb, frustum); },
+            [&] (const Segment& segment) { return classifyFrustum(cgt::min(segment._start, segment._end), cgt::max(segment._start, segment._end), frustum) != OUTSIDE; },
+            mask, operation);
+    }
+
+    size_t FiberBvh::getNumFibers() const {
+        return _numFibers;
+    }
+
+    size_t FiberBvh::getNumSegments() const {
+        return _segments.size();
+    }
+
+    cgt::Bounds FiberBvh::getBounds() const {
+        if (_nodes.empty() || isEmpty(_nodes.front()))
+            return cgt::Bounds();
+        return cgt::Bounds(_nodes.front()._llf, _nodes.front()._urb);
+    }
+
+    size_t FiberBvh::getLocalMemoryFootprint() const {
+        return sizeof(*this) + _segments.size() * sizeof(Segment) + _nodes.size() * sizeof(Node);
+    }
+
+}
+}
@@ -0,0 +1,194 @@
+// ================================================================================================
+// 
+// This file is part of the CAMPVis Software Framework.
+// 
+// If not explicitly stated otherwise: Copyright (C) 2012-2015, all rights reserved,
+//      Christian Schulte zu Berge <christian.szb@in.tum.de>
+//      Chair for Computer Aided Medical Procedures
+//      Technische Universitaet Muenchen
+//      Boltzmannstr. 3, 85748 Garching b. Muenchen, Germany
+// 
+// For a full list of authors and contributors, please refer to the file "AUTHORS.txt".
+// 
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file 
+// except in compliance with the License. You may obtain a copy of the License at
+// 
+// http://www.apache.org/licenses/LICENSE-2.0
+// 
+// Unless required by applicable law or agreed to in writing, software distributed under the 
+// License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, 
+// either express or implied. See the License for the specific language governing permissions 
+// and limitations under the License.
+// 
+// ================================================================================================
+
+
+#ifndef FIBERBVH_H__
+#define FIBERBVH_H__
+
+#include "cgt/bounds.h"
+#include "cgt/frustum.h"
+#include "cgt/vector.h"
+
+#include "modules/modulesapi.h"
+
+#include <utility>
+#include <vector>
+
+namespace campvis {
+namespace dti {
+    class FiberData;
+
+    /**
+     * Bounding volume hierarchy over the segments of a FiberData object for fast spatial queries
+     * such as ROI selection and view-frustum culling.
+     * 
+     * The segments are sorted along a Morton curve and grouped into leaves of LEAF_SIZE segments,
+     * which form the lowest level of a complete binary tree stored in heap layout (children of 
+     * node i are 2i+1 and 2i+2). This keeps construction fully parallel and the traversal free of
+     * pointers. The BVH stores its own copy of the segment end points, so it is immutable and 
+     * independent of the lifetime of the FiberData it was built from.
+     * 
+     * All queries return their result as mask with one element per fiber, which can be combined
+     * with an existing mask to implement inclusion and exclusion ROIs and then be handed to 
+     * FiberData::setVisibility().
+     */
+    class CAMPVIS_MODULES_API FiberBvh {
+    public:
+        /// How to combine the result of a query with an existing mask
+        enum MaskOperation {
+            SET,            ///< mask = hit
+            INTERSECT,      ///< mask = mask && hit (e.g. inclusion ROI)
+            SUBTRACT,       ///< mask = mask && !hit (e.g. exclusion ROI)
+            UNITE           ///< mask = mask || hit
+        };
+
+        /**
+         * Builds the BVH over all segments of \a fibers in parallel.
+         * Fibers consisting of a single vertex are represented by a degenerate segment.
+         * \param   fibers  Fiber data to build the BVH for.
+         */
+        explicit FiberBvh(const FiberData& fibers);
+
+        /**
+         * Destructor
+         */
+        ~FiberBvh();
+
+        /**
+         * Finds all fibers having at least one segment intersecting the axis-aligned box \a box.
+         * \param   box         Axis-aligned box in world coordinates.
+         * \param   mask        Mask with one element per fiber to write the result to.
+         * \param   operation   How to combine the result with the current content of \a mask.
+         */
+        void queryBox(const cgt::Bounds& box, std::vector<uint8_t>& mask, MaskOperation operation = SET) const;
+
+        /**
+         * Finds all fibers having at least one segment intersecting the given sphere.
+         * \param   center      Center of the sphere in world coordinates.
+         * \param   radius      Radius of the sphere.
+         * \param   mask        Mask with one element per fiber to write the result to.
+         * \param   operation   How to combine the result with the current content of \a mask.
+         */
+        void querySphere(const cgt::vec3& center, float radius, std::vector<uint8_t>& mask, MaskOperation operation = SET) const;
+
+        /**
+         * Finds all fibers crossing or touching the plane of all points x with dot(normal, x) == distance.
+         * \param   normal      Normal of the plane.
+         * \param   distance    Distance of the plane to the origin along \a normal.
+         * \param   mask        Mask with one element per fiber to write the result to.
+         * \param   operation   How to combine the result with the current content of \a mask.
+         */
+        void queryPlane(const cgt::vec3& normal, float distance, std::vector<uint8_t>& mask, MaskOperation operation = SET) const;
+
+        /**
+         * Finds all fibers that are potentially visible in the view frustum \a frustum.
+         * The test is conservative, it uses the bounding box of each segment.
+         * \note    \a frustum must be up to date, see cgt::Camera::updateFrustum().
+         * \param   frustum     View frustum in world coordinates.
+         * \param   mask        Mask with one element per fiber to write the result to.
+         * \param   operation   How to combine the result with the current content of \a mask.
+         */
+        void queryFrustum(const cgt::Frustum& frustum, std::vector<uint8_t>& mask, MaskOperation operation = SET) const;
+
+        /**
+         * Returns the number of fibers of the FiberData this BVH was built from.
+         * \return  _numFibers
+         */
+        size_t getNumFibers() const;
+
+        /**
+         * Returns the number of segments in this BVH.
+         * \return  _segments.size()
+         */
+        size_t getNumSegments() const;
+
+        /**
+         * Returns the bounds of all segments in this BVH.
+         * \return  The bounds of the root node, undefined if the BVH is empty.
+         */
+        cgt::Bounds getBounds() const;
+
+        /**
+         * Returns the amount of memory used by this BVH in bytes.
+         * \return  The local memory footprint of this BVH.
+         */
+        size_t getLocalMemoryFootprint() const;
+
+        /// Classification of a node or segment against a query volume
+        enum Classification {
+            OUTSIDE,        ///< completely outside the query volume
+            INTERSECTING,   ///< partially inside the query volume
+            INSIDE          ///< completely inside the query volume
+        };
+
+        /// A single fiber segment
+        struct Segment {
+            cgt::vec3 _start;   ///< Start point of the segment
+            cgt::vec3 _end;     ///< End point of the segment
+            size_t _fiber;      ///< Index of the fiber this segment belongs to
+        };
+
+        /// Axis-aligned bounding box of a BVH node, empty nodes have _llf > _urb
+        struct Node {
+            cgt::vec3 _llf;     ///< Lower left front corner
+            cgt::vec3 _urb;     ///< Upper right back corner
+        };
+
+        static const size_t LEAF_SIZE = 8;      ///< Number of segments per leaf
+
+    private:
+        /**
+         * Traverses the BVH and applies the result to \a mask.
+         * \param   nodeTest    Functor classifying a Node against the query volume.
+         * \param   segmentTest Functor returning whether a Segment intersects the query volume.
+         * \param   mask        Mask with one element per fiber to write the result to.
+         * \param   operation   How to combine the result with the current content of \a mask.
+         */
+        template<typename NODETEST, typename SEGMENTTEST>
+        void query(const NODETEST& nodeTest, const SEGMENTTEST& segmentTest, std::vector<uint8_t>& mask, MaskOperation operation) const;
+
+        /**
+         * Returns the range of segments [first, second) below node \a nodeIndex.
+         * \param   nodeIndex   Index of the node in _nodes.
+         * \return  The range of indices into _segments below node \a nodeIndex.
+         */
+        std::pair<size_t, size_t> getSegmentRange(size_t nodeIndex) const;
+
+        /**
+         * Appends \a range to \a ranges, merging it with the last range if they are adjacent.
+         * \param   range   Range of segments to append.
+         * \param   ranges  Vector of segment ranges to append to.
+         */
+        static void appendSegmentRange(const std::pair<size_t, size_t>& range, std::vector< std::pair<size_t, size_t> >& ranges);
+
+        size_t _numFibers;                  ///< Number of fibers of the FiberData this BVH was built from
+        std::vector<Segment> _segments;     ///< All segments sorted along the Morton curve
+        std::vector<Node> _nodes;           ///< Nodes of the BVH in heap layout
+        size_t _firstLeaf;                  ///< Index of the first leaf node in _nodes
+    };
+
+}
+}
+
+#endif // FIBERBVH_H__
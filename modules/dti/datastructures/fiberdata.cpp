@@ -24,10 +24,13 @@
 
 #include "fiberdata.h"
 
+#include "cgt/assert.h"
 #include "cgt/buffer.h"
 #include "cgt/logmanager.h"
 #include "cgt/vertexarrayobject.h"
 
+#include "modules/dti/datastructures/fiberbvh.h"
+
 namespace campvis {
 namespace dti {
 
@@ -39,12 +42,20 @@ namespace dti {
         , _vboFiberStartIndices(0)
         , _vboFiberCounts(0)
     {
+        _offsets.push_back(0);
     }
 
     FiberData::FiberData(const FiberData& rhs)
         : AbstractData(rhs)
         , _vertices(rhs._vertices)
-        , _fibers(rhs._fibers)
+        , _offsets(rhs._offsets)
+        , _lengths(rhs._lengths)
+        , _segmentIds(rhs._segmentIds)
+        , _visible(rhs._visible)
+        , _selected(rhs._selected)
+        , _pointAttributes(rhs._pointAttributes)
+        , _fiberAttributes(rhs._fiberAttributes)
+        , _bvh(rhs.getBvhIfBuilt())
         , _vertexBuffer(0)
         , _tangentBuffer(0)
         , _buffersInitialized(false)
@@ -66,7 +77,17 @@ namespace dti {
         AbstractData::operator=(rhs);
 
         _vertices = rhs._vertices;
-        _fibers = rhs._fibers;
+        _offsets = rhs._offsets;
+        _lengths = rhs._lengths;
+        _segmentIds = rhs._segmentIds;
+        _visible = rhs._visible;
+        _selected = rhs._selected;
+        _pointAttributes = rhs._pointAttributes;
+        _fiberAttributes = rhs._fiberAttributes;
+        {
+            tbb::mutex::scoped_lock lock(_bvhMutex);
+            _bvh = rhs.getBvhIfBuilt();
+        }
 
         // delete old VBOs and null pointers
         delete _vertexBuffer;
@@ -82,45 +103,137 @@ namespace dti {
 
     void FiberData::addFiber(const std::deque<cgt::vec3>& vertices) {
         _vertices.insert(_vertices.end(), vertices.begin(), vertices.end());
-        _fibers.push_back(Fiber(_vertices.size() - vertices.size(), _vertices.size()));
-        _buffersInitialized = false;
+        appendFiber(_vertices.size());
     }
 
     void FiberData::addFiber(const std::vector<cgt::vec3>& vertices) {
         _vertices.insert(_vertices.end(), vertices.begin(), vertices.end());
-        _fibers.push_back(Fiber(_vertices.size() - vertices.size(), _vertices.size()));
+        appendFiber(_vertices.size());
+    }
+
+    void FiberData::addFibers(const std::vector<cgt::vec3>& vertices, const std::vector<size_t>& offsets) {
+        cgtAssert(! offsets.empty() && offsets.front() == 0 && offsets.back() == vertices.size(), "Offsets do not match vertices!");
+
+        size_t base = _vertices.size();
+        _vertices.insert(_vertices.end(), vertices.begin(), vertices.end());
+        for (size_t i = 1; i < offsets.size(); ++i)
+            appendFiber(base + offsets[i]);
+    }
+
+    void FiberData::setFibers(std::vector<cgt::vec3>& vertices, std::vector<size_t>& offsets) {
+        cgtAssert(! offsets.empty() && offsets.front() == 0 && offsets.back() == vertices.size(), "Offsets do not match vertices!");
+
+        _vertices.swap(vertices);
+        _offsets.swap(offsets);
+
+        size_t n = numFibers();
+        _lengths.assign(n, 0.f);
+        _segmentIds.assign(n, 0);
+        _visible.assign(n, true);
+        _selected.assign(n, false);
+        _pointAttributes.clear();
+        _fiberAttributes.clear();
+        resetBvh();
         _buffersInitialized = false;
     }
 
+    void FiberData::addPointAttribute(const std::string& name, std::vector<float>& values) {
+        cgtAssert(values.size() == _vertices.size(), "Number of attribute values must match the number of vertices!");
+
+        _pointAttributes.push_back(Attribute());
+        _pointAttributes.back()._name = name;
+        _pointAttributes.back()._values.swap(values);
+    }
+
+    void FiberData::addFiberAttribute(const std::string& name, std::vector<float>& values) {
+        cgtAssert(values.size() == numFibers(), "Number of attribute values must match the number of fibers!");
+
+        _fiberAttributes.push_back(Attribute());
+        _fiberAttributes.back()._name = name;
+        _fiberAttributes.back()._values.swap(values);
+    }
+
+    size_t FiberData::getNumPointAttributes() const {
+        return _pointAttributes.size();
+    }
+
+    const std::string& FiberData::getPointAttributeName(size_t index) const {
+        return _pointAttributes[index]._name;
+    }
+
+    const std::vector<float>& FiberData::getPointAttribute(size_t index) const {
+        return _pointAttributes[index]._values;
+    }
+
+    size_t FiberData::getNumFiberAttributes() const {
+        return _fiberAttributes.size();
+    }
+
+    const std::string& FiberData::getFiberAttributeName(size_t index) const {
+        return _fiberAttributes[index]._name;
+    }
+
+    const std::vector<float>& FiberData::getFiberAttribute(size_t index) const {
+        return _fiberAttributes[index]._values;
+    }
+
+    void FiberData::appendFiber(size_t endIndex) {
+        _offsets.push_back(endIndex);
+        _lengths.push_back(0.f);
+        _segmentIds.push_back(0);
+        _visible.push_back(true);
+        _selected.push_back(false);
+        resetBvh();
+        _buffersInitialized = false;
+
+        for (size_t i = 0; i < _pointAttributes.size(); ++i)
+            _pointAttributes[i]._values.resize(endIndex, 0.f);
+        for (size_t i = 0; i < _fiberAttributes.size(); ++i)
+            _fiberAttributes[i]._values.push_back(0.f);
+    }
+
+    void FiberData::reserve(size_t numVertices, size_t numFibers) {
+        _vertices.reserve(numVertices);
+        _offsets.reserve(numFibers + 1);
+        _lengths.reserve(numFibers);
+        _segmentIds.reserve(numFibers);
+        _visible.reserve(numFibers);
+        _selected.reserve(numFibers);
+    }
+
     void FiberData::clear() {
-        _fibers.clear();
         _vertices.clear();
+        _offsets.assign(1, 0);
+        _lengths.clear();
+        _segmentIds.clear();
+        _visible.clear();
+        _selected.clear();
+        _pointAttributes.clear();
+        _fiberAttributes.clear();
+        resetBvh();
         _buffersInitialized = false;
     }
 
     void FiberData::updateLengths() const {
-        for (size_t i = 0; i < _fibers.size(); ++i) {
-            _fibers[i]._length = 0.0f;
+        for (size_t i = 0; i < numFibers(); ++i) {
+            _lengths[i] = 0.0f;
 
-            for (size_t j = _fibers[i]._startIndex + 1; j < _fibers[i]._endIndex; ++j)
-                _fibers[i]._length += distance(_vertices[j-1], _vertices[j]);
+            for (size_t j = _offsets[i] + 1; j < _offsets[i+1]; ++j)
+                _lengths[i] += distance(_vertices[j-1], _vertices[j]);
         }
     }
 
     size_t FiberData::numFibers() const {
-        return _fibers.size();
+        return _offsets.size() - 1;
     }
 
     size_t FiberData::numSegments() const {
-        size_t sum = 0;
-        for (std::vector<Fiber>::const_iterator it = _fibers.begin(); it != _fibers.end(); ++it) 
-            sum += (it->_endIndex - it->_startIndex);
-        return sum;
+        return _vertices.size() - numFibers();
     }
 
 
     bool FiberData::empty() const {
-        return _fibers.empty();
+        return numFibers() == 0;
     }
 
     FiberData* FiberData::clone() const {
@@ -130,7 +243,16 @@ namespace dti {
 
     size_t FiberData::getLocalMemoryFootprint() const {
         size_t sum = _vertices.size() * sizeof(cgt::vec3);
-        sum += _fibers.size() * sizeof(Fiber);
+        sum += _offsets.size() * sizeof(size_t);
+        sum += numFibers() * (sizeof(float) + sizeof(int) + 2 * sizeof(uint8_t));
+        for (size_t i = 0; i < _pointAttributes.size(); ++i)
+            sum += _pointAttributes[i]._values.size() * sizeof(float);
+        for (size_t i = 0; i < _fiberAttributes.size(); ++i)
+            sum += _fiberAttributes[i]._values.size() * sizeof(float);
+
+        std::shared_ptr<const FiberBvh> bvh = getBvhIfBuilt();
+        if (bvh != nullptr)
+            sum += bvh->getLocalMemoryFootprint();
         sum += sizeof(*this);
         return sum;
     }
@@ -146,38 +268,32 @@ namespace dti {
     }
 
     void FiberData::createGlBuffers() const {
-        if (_buffersInitialized || _fibers.empty() || _vertices.empty())
+        if (_buffersInitialized || empty() || _vertices.empty())
             return;
 
         // reset everything
         delete _vertexBuffer;
         delete _tangentBuffer;
-        delete [] _vboFiberStartIndices;
-        delete [] _vboFiberCounts;
-        _vboFiberArraySize = 0;
-        _vboFiberStartIndices = new GLint[_vertices.size()];
-        _vboFiberCounts = new GLint[_vertices.size()];
 
         std::vector<cgt::vec3> tangents;
         tangents.resize(_vertices.size());
 
-        for (std::vector<Fiber>::const_iterator it = _fibers.begin(); it != _fibers.end(); ++it) {
-            if (it->_visible) {
-                _vboFiberStartIndices[_vboFiberArraySize] = static_cast<GLint>(it->_startIndex);
-                _vboFiberCounts[_vboFiberArraySize] = static_cast<GLsizei>(it->_endIndex - it->_startIndex);
-                ++_vboFiberArraySize;
-            }
+        for (size_t f = 0; f < numFibers(); ++f) {
+            size_t startIndex = _offsets[f];
+            size_t endIndex = _offsets[f+1];
+            if (startIndex == endIndex)
+                continue;
 
             cgt::vec3 dirPrev = cgt::vec3::zero;
             cgt::vec3 dirNext = cgt::vec3::zero;
 
-            for (size_t i = it->_startIndex; i < it->_endIndex-1; ++i) {
+            for (size_t i = startIndex; i < endIndex-1; ++i) {
                 dirNext = _vertices[i+1] - _vertices[i];
                 tangents[i] = cgt::normalize(dirPrev + dirNext);
                 dirPrev = dirNext;
             }
 
-            tangents[it->_endIndex - 1] = dirPrev;
+            tangents[endIndex - 1] = dirPrev;
         }
 
         try {
@@ -197,8 +313,28 @@ namespace dti {
         _buffersInitialized = true;
     }
 
-    void FiberData::render(GLenum mode /*= GL_LINE_STRIP*/) const {
-        if (_fibers.empty() || _vertices.empty())
+    void FiberData::updateDrawList(const std::vector<uint8_t>* cullingMask) const {
+        cgtAssert(cullingMask == nullptr || cullingMask->size() == numFibers(), "Culling mask size must match the number of fibers!");
+
+        // the draw list is cheap to build compared to the buffers, hence we rebuild it for every 
+        // frame so that changing the visibility or culling does not require a buffer upload.
+        delete [] _vboFiberStartIndices;
+        delete [] _vboFiberCounts;
+        _vboFiberArraySize = 0;
+        _vboFiberStartIndices = new GLint[numFibers()];
+        _vboFiberCounts = new GLsizei[numFibers()];
+
+        for (size_t f = 0; f < numFibers(); ++f) {
+            if (_offsets[f] != _offsets[f+1] && _visible[f] && (cullingMask == nullptr || (*cullingMask)[f])) {
+                _vboFiberStartIndices[_vboFiberArraySize] = static_cast<GLint>(_offsets[f]);
+                _vboFiberCounts[_vboFiberArraySize] = static_cast<GLsizei>(_offsets[f+1] - _offsets[f]);
+                ++_vboFiberArraySize;
+            }
+        }
+    }
+
+    void FiberData::render(GLenum mode /*= GL_LINE_STRIP*/, const std::vector<uint8_t>* cullingMask /*= nullptr*/) const {
+        if (empty() || _vertices.empty())
             return;
 
         createGlBuffers();
@@ -207,6 +343,10 @@ namespace dti {
             return;
         }
 
+        updateDrawList(cullingMask);
+        if (_vboFiberArraySize == 0)
+            return;
+
         cgt::VertexArrayObject vao;
         vao.setVertexAttributePointer(0, _vertexBuffer);
         vao.setVertexAttributePointer(1, _tangentBuffer);
@@ -225,18 +365,67 @@ namespace dti {
     }
 
     void FiberData::setVisible(size_t index, bool visibility) {
-        _fibers[index]._visible = visibility;
-        _buffersInitialized = false;
+        _visible[index] = visibility;
+    }
+
+    void FiberData::setVisibility(const std::vector<uint8_t>& mask) {
+        cgtAssert(mask.size() == numFibers(), "Mask size must match the number of fibers!");
+        _visible = mask;
+    }
+
+    const std::vector<uint8_t>& FiberData::getVisibility() const {
+        return _visible;
+    }
+
+    bool FiberData::isVisible(size_t index) const {
+        return _visible[index] != 0;
+    }
+
+    void FiberData::setSelected(size_t index, bool selected) {
+        _selected[index] = selected;
     }
 
-    const std::vector<FiberData::Fiber>& FiberData::getFibers() const {
-        return _fibers;
+    bool FiberData::isSelected(size_t index) const {
+        return _selected[index] != 0;
+    }
+
+    void FiberData::setSegmentId(size_t index, int segmentId) {
+        _segmentIds[index] = segmentId;
+    }
+
+    int FiberData::getSegmentId(size_t index) const {
+        return _segmentIds[index];
+    }
+
+    float FiberData::getLength(size_t index) const {
+        return _lengths[index];
+    }
+
+    const std::vector<size_t>& FiberData::getFiberOffsets() const {
+        return _offsets;
     }
 
     const std::vector<cgt::vec3>& FiberData::getVertices() const {
         return _vertices;
     }
 
+    std::shared_ptr<const FiberBvh> FiberData::getBvh() const {
+        tbb::mutex::scoped_lock lock(_bvhMutex);
+        if (_bvh == nullptr)
+            _bvh = std::shared_ptr<const FiberBvh>(new FiberBvh(*this));
+        return _bvh;
+    }
+
+    std::shared_ptr<const FiberBvh> FiberData::getBvhIfBuilt() const {
+        tbb::mutex::scoped_lock lock(_bvhMutex);
+        return _bvh;
+    }
+
+    void FiberData::resetBvh() {
+        tbb::mutex::scoped_lock lock(_bvhMutex);
+        _bvh.reset();
+    }
+
     std::string FiberData::getTypeAsString() const {
         return "FiberData";
     }
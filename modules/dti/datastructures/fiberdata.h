@@ -32,7 +32,11 @@
 #include "core/datastructures/abstractdata.h"
 #include "modules/modulesapi.h"
 
+#include <tbb/mutex.h>
+
 #include <deque>
+#include <memory>
+#include <string>
 #include <vector>
 
 namespace cgt {
@@ -41,30 +45,25 @@ namespace cgt {
 
 namespace campvis {
 namespace dti {
+    class FiberBvh;
 
     /**
      * Data object storing fiber data.
+     * 
+     * The data is stored as structure of arrays: The vertices of all fibers are stored in one 
+     * contiguous array, fiber i consists of the vertices [_offsets[i], _offsets[i+1]). The 
+     * per-fiber meta information (length, segment label, visibility and selection flags) is 
+     * stored in separate arrays.
+     * 
+     * Optionally, named scalar attributes can be attached per vertex (e.g. the scalars of TrackVis
+     * files) or per fiber (e.g. the TrackVis properties). They are stored as one array each, 
+     * parallel to _vertices or the fibers respectively. Adding fibers pads them with zeros.
+     * 
+     * For spatial queries (ROI selection, frustum culling), a FiberBvh is built on demand by 
+     * getBvh() and shared between copies until the fibers change.
      */
     class CAMPVIS_MODULES_API FiberData : public AbstractData, public IHasWorldBounds {
     public:
-        /**
-         * Struct storing meta information about a single fiber.
-         */
-        struct Fiber {
-            size_t _startIndex;     ///< Start index of the fiber
-            size_t _endIndex;       ///< End index of the fiber (as in STL iterators: points to the element _behind_ the last vertex)
-
-            mutable float _length;  ///< Length of the fiber (cached)
-            int _segmentId;         ///< Label of the fiber
-            bool _visible;          ///< Visibility flag of the fiber
-            bool _selected;         ///< Selected flag of the fiber
-
-            Fiber(size_t startIndex, size_t endIndex) 
-                : _startIndex(startIndex), _endIndex(endIndex), _length(0.f), _segmentId(0), _visible(true), _selected(false) 
-            {};
-        };
-
-
         /**
          * Constructor.
          */
@@ -100,6 +99,88 @@ namespace dti {
          * \param   vertices    Coordinates of the fiber points.
          */
         void addFiber(const std::vector<cgt::vec3>& vertices);
+
+        /**
+         * Adds a batch of fibers stored in the same layout as this data structure.
+         * \param   vertices    Coordinates of the fiber points of all fibers in the batch.
+         * \param   offsets     Offsets of the fibers in \a vertices, fiber i consists of the vertices 
+         *                      [offsets[i], offsets[i+1]). Hence, it has one element more than the 
+         *                      number of fibers and starts with 0.
+         */
+        void addFibers(const std::vector<cgt::vec3>& vertices, const std::vector<size_t>& offsets);
+
+        /**
+         * Replaces all fibers of this data structure by the given ones without copying them:
+         * The contents of \a vertices and \a offsets are swapped into this data structure, all 
+         * attributes and per-fiber meta information are reset.
+         * \param   vertices    Coordinates of the fiber points of all fibers, will contain the old vertices afterwards.
+         * \param   offsets     Offsets of the fibers in \a vertices (see addFibers()), will contain 
+         *                      the old offsets afterwards.
+         */
+        void setFibers(std::vector<cgt::vec3>& vertices, std::vector<size_t>& offsets);
+
+        /**
+         * Adds a named scalar attribute with one value per vertex.
+         * The contents of \a values are swapped into this data structure without copying.
+         * \param   name    Name of the attribute.
+         * \param   values  Attribute values, must have one element per vertex, will be empty afterwards.
+         */
+        void addPointAttribute(const std::string& name, std::vector<float>& values);
+
+        /**
+         * Adds a named scalar attribute with one value per fiber.
+         * The contents of \a values are swapped into this data structure without copying.
+         * \param   name    Name of the attribute.
+         * \param   values  Attribute values, must have one element per fiber, will be empty afterwards.
+         */
+        void addFiberAttribute(const std::string& name, std::vector<float>& values);
+
+        /**
+         * Returns the number of per-vertex attributes.
+         * \return  _pointAttributes.size()
+         */
+        size_t getNumPointAttributes() const;
+
+        /**
+         * Returns the name of the per-vertex attribute with index \a index.
+         * \param   index   Index of the attribute.
+         * \return  _pointAttributes[index]._name
+         */
+        const std::string& getPointAttributeName(size_t index) const;
+
+        /**
+         * Returns the values of the per-vertex attribute with index \a index, parallel to getVertices().
+         * \param   index   Index of the attribute.
+         * \return  _pointAttributes[index]._values
+         */
+        const std::vector<float>& getPointAttribute(size_t index) const;
+
+        /**
+         * Returns the number of per-fiber attributes.
+         * \return  _fiberAttributes.size()
+         */
+        size_t getNumFiberAttributes() const;
+
+        /**
+         * Returns the name of the per-fiber attribute with index \a index.
+         * \param   index   Index of the attribute.
+         * \return  _fiberAttributes[index]._name
+         */
+        const std::string& getFiberAttributeName(size_t index) const;
+
+        /**
+         * Returns the values of the per-fiber attribute with index \a index.
+         * \param   index   Index of the attribute.
+         * \return  _fiberAttributes[index]._values
+         */
+        const std::vector<float>& getFiberAttribute(size_t index) const;
+
+        /**
+         * Reserves memory for the given number of vertices and fibers.
+         * \param   numVertices Total number of vertices to reserve memory for.
+         * \param   numFibers   Total number of fibers to reserve memory for.
+         */
+        void reserve(size_t numVertices, size_t numFibers);
         
         /**
          * Sets the visibility flag of the fiber with index \a index to \a visibility.
@@ -108,6 +189,61 @@ namespace dti {
          */
         void setVisible(size_t index, bool visibility);
 
+        /**
+         * Returns the visibility flag of the fiber with index \a index.
+         * \param   index       Index of the fiber.
+         * \return  _visible[index]
+         */
+        bool isVisible(size_t index) const;
+
+        /**
+         * Sets the visibility flags of all fibers at once, e.g. to the result of a FiberBvh query.
+         * \param   mask    Visibility flag of each fiber, must have numFibers() elements.
+         */
+        void setVisibility(const std::vector<uint8_t>& mask);
+
+        /**
+         * Returns the visibility flags of all fibers.
+         * \return  _visible
+         */
+        const std::vector<uint8_t>& getVisibility() const;
+
+        /**
+         * Sets the selected flag of the fiber with index \a index to \a selected.
+         * \param   index       Index of fiber to update.
+         * \param   selected    New selected flag of fiber \a index.
+         */
+        void setSelected(size_t index, bool selected);
+
+        /**
+         * Returns the selected flag of the fiber with index \a index.
+         * \param   index       Index of the fiber.
+         * \return  _selected[index]
+         */
+        bool isSelected(size_t index) const;
+
+        /**
+         * Sets the segment label of the fiber with index \a index to \a segmentId.
+         * \param   index       Index of fiber to update.
+         * \param   segmentId   New segment label of fiber \a index.
+         */
+        void setSegmentId(size_t index, int segmentId);
+
+        /**
+         * Returns the segment label of the fiber with index \a index.
+         * \param   index       Index of the fiber.
+         * \return  _segmentIds[index]
+         */
+        int getSegmentId(size_t index) const;
+
+        /**
+         * Returns the cached length of the fiber with index \a index.
+         * \note    Call updateLengths() first to compute the lengths.
+         * \param   index       Index of the fiber.
+         * \return  _lengths[index]
+         */
+        float getLength(size_t index) const;
+
         /**
          * Clears this data structure.
          */
@@ -123,7 +259,7 @@ namespace dti {
 
         /**
          * Returns the number of fibers in this data structure.
-         * \return  _fibers.size()
+         * \return  _offsets.size() - 1
          */
         size_t numFibers() const;
 
@@ -134,10 +270,10 @@ namespace dti {
         size_t numSegments() const;
 
         /**
-         * Returns the vector of fibers.
-         * \return  _fibers
+         * Returns the vector of fiber offsets, fiber i consists of the vertices [offsets[i], offsets[i+1]).
+         * \return  _offsets
          */
-        const std::vector<Fiber>& getFibers() const;
+        const std::vector<size_t>& getFiberOffsets() const;
 
         /**
          * Returns the vector of fiber vertices
@@ -145,6 +281,13 @@ namespace dti {
          */
         const std::vector<cgt::vec3>& getVertices() const;
 
+        /**
+         * Returns the bounding volume hierarchy over the fibers of this data structure.
+         * The BVH is built (in parallel) on the first call after the fibers have changed.
+         * \return  _bvh
+         */
+        std::shared_ptr<const FiberBvh> getBvh() const;
+
         /**
          * Returns whether this data structure is empty (i.e. has no fibers).
          */
@@ -158,11 +301,13 @@ namespace dti {
         virtual cgt::Bounds getWorldBounds() const;
 
         /**
-         * Renders the Fiber geometry of this data set in the current OpenGL context.
+         * Renders the visible fibers of this data set in the current OpenGL context.
          * \note    Must be called from a valid openGL context!
-         * \param   mode    OpenGL render mode (defaults to GL_LINE_STRIP).
+         * \param   mode        OpenGL render mode (defaults to GL_LINE_STRIP).
+         * \param   cullingMask Optional additional mask with one element per fiber, only fibers
+         *                      set in this mask are rendered (e.g. the result of FiberBvh::queryFrustum()).
          */
-        void render(GLenum mode = GL_LINE_STRIP) const;
+        void render(GLenum mode = GL_LINE_STRIP, const std::vector<uint8_t>* cullingMask = nullptr) const;
 
         
         /// \see AbstractData::clone()
@@ -175,20 +320,60 @@ namespace dti {
         virtual std::string getTypeAsString() const;
 
     protected:
+        /// A named scalar attribute
+        struct Attribute {
+            std::string _name;              ///< Name of the attribute
+            std::vector<float> _values;     ///< Attribute values
+        };
+
+        /**
+         * Appends the meta data for a new fiber ending at vertex \a endIndex.
+         * \param   endIndex    End index of the fiber (as in STL iterators: points to the element _behind_ the last vertex)
+         */
+        void appendFiber(size_t endIndex);
+
         /**
          * Creates the OpenGL buffers with vertex and tangent data.
          */
         void createGlBuffers() const;
 
-        std::vector<cgt::vec3> _vertices;   ///< The fiber vertex (coordinates) data
-        std::vector<Fiber> _fibers;         ///< The fiber meta data
+        /**
+         * Fills _vboFiberStartIndices and _vboFiberCounts with the fibers to render.
+         * \param   cullingMask Optional additional mask, see render().
+         */
+        void updateDrawList(const std::vector<uint8_t>* cullingMask) const;
+
+        /**
+         * Returns the BVH over the fibers if it has already been built.
+         * \return  _bvh, may be 0
+         */
+        std::shared_ptr<const FiberBvh> getBvhIfBuilt() const;
+
+        /**
+         * Discards the BVH after the fibers have changed, so that getBvh() rebuilds it.
+         */
+        void resetBvh();
+
+        std::vector<cgt::vec3> _vertices;   ///< The fiber vertex (coordinates) data of all fibers
+        std::vector<size_t> _offsets;       ///< Start index of each fiber in _vertices, followed by _vertices.size()
+
+        mutable std::vector<float> _lengths;    ///< Length of each fiber (cached)
+        std::vector<int> _segmentIds;           ///< Label of each fiber
+        std::vector<uint8_t> _visible;          ///< Visibility flag of each fiber
+        std::vector<uint8_t> _selected;         ///< Selected flag of each fiber
+
+        std::vector<Attribute> _pointAttributes;    ///< Optional per-vertex attributes, each parallel to _vertices
+        std::vector<Attribute> _fiberAttributes;    ///< Optional per-fiber attributes
+
+        mutable std::shared_ptr<const FiberBvh> _bvh;   ///< BVH over the fibers (lazy-instantiated), 0 if not yet built
+        mutable tbb::mutex _bvhMutex;                   ///< Mutex protecting _bvh
 
         mutable cgt::BufferObject* _vertexBuffer;   ///< Pointer to OpenGL buffer with vertex data (lazy-instantiated)
         mutable cgt::BufferObject* _tangentBuffer;  ///< Pointer to OpenGL buffer with tangent data (lazy-instantiated)
         mutable bool _buffersInitialized;           ///< flag whether all OpenGL buffers were successfully initialized
 
-        mutable GLint* _vboFiberStartIndices;       ///< VBO start indices for each fiber
-        mutable GLsizei* _vboFiberCounts;           ///< number of indices for each fiber
+        mutable GLint* _vboFiberStartIndices;       ///< VBO start indices for each fiber to render
+        mutable GLsizei* _vboFiberCounts;           ///< number of indices for each fiber to render
         mutable GLsizei _vboFiberArraySize;         ///< number of elements in the above two lists
     };
 
@@ -16,6 +16,7 @@ IF(${ModuleEnabled})
 		modules/dti/glsl/*.vert
 		modules/dti/pipelines/*.h
 		modules/dti/processors/*.h
+		modules/dti/tools/*.h
 	)
 
 	LIST(APPEND ThisModShaderDirectories "modules/dti/glsl")
@@ -25,42 +25,13 @@
 #include "fiberreader.h"
 
 #include "cgt/filesystem.h"
+#include "core/tools/mappedfile.h"
 #include "modules/dti/datastructures/fiberdata.h"
-#include <fstream>
-
-namespace {
-
-    /// File header for TrackVis *.trk files
-    struct trk_header {
-        //                                   SIZE  DESCRIPTION
-        char id_string[6];                   //6   ID string for track file. The first 5 characters must be "TRACK".
-        short int dim[3];                    //6   Dimension of the image volume.
-        float voxel_size[3];                 //12  Voxel size of the image volume.
-        float origin[3];                     //12  Origin of the image volume. This field is not yet being used by TrackVis. That means the origin is always (0, 0, 0).
-        short int n_scalars;                 //2   Number of scalars saved at each track point (besides x, y and z coordinates).
-        char scalar_name[10][20];            //200 Name of each scalar. Can not be longer than 20 characters each. Can only store up to 10 names.
-        short int n_properties;              //2   Number of properties saved at each track.
-        char property_name[10][20];          //200 Name of each property. Can not be longer than 20 characters each. Can only store up to 10 names.
-        float vox_to_ras[4][4];              //64  4x4 matrix for voxel to RAS (crs to xyz) transformation.
-                                             //    If vox_to_ras[3][3] is 0, it means the matrix is not recorded.
-                                             //    This field is added from version 2.
-        char reserved[444];                  //444 Reserved space for future version.
-        char voxel_order[4];                 //4   Storing order of the original image data. Explained here.
-        char pad2[4];                        //4   Paddings.
-        float image_orientation_patient[6];  //24  Image orientation of the original image. As defined in the DICOM header.
-        char pad1[2];                        //2   Paddings.
-        unsigned char invert_x;              //1   Inversion/rotation flags used to generate this track file. For internal use only.
-        unsigned char invert_y;              //1   As above.
-        unsigned char invert_z;              //1   As above.
-        unsigned char swap_xy;               //1   As above.
-        unsigned char swap_yz;               //1   As above.
-        unsigned char swap_zx;               //1   As above.
-        int32_t n_count;                     //4   Number of tracks stored in this track file. 0 means the number was NOT stored.
-        int32_t version;                     //4   Version number. Current version is 2.
-        int32_t hdr_size;                    //4   Size of the header. Used to determine byte swap. Should be 1000.
-    };
+#include "modules/dti/tools/trkheader.h"
 
-}
+#include <tbb/tbb.h>
+
+#include <cstring>
 
 namespace campvis {
 namespace dti {
@@ -86,7 +57,9 @@ namespace dti {
     void FiberReader::updateResult(DataContainer& dataContainer) {
         const std::string& fileName = p_url.getValue();
         if (cgt::FileSystem::fileExtension(fileName) == "trk") {
-            dataContainer.addData(p_outputId.getValue(), readTrkFile(fileName));
+            FiberData* fibers = readTrkFile(fileName);
+            if (fibers != nullptr)
+                dataContainer.addData(p_outputId.getValue(), fibers);
         }
         else {
             LERROR("Unknown file extension.");
@@ -94,54 +67,103 @@ namespace dti {
     }
 
     FiberData* FiberReader::readTrkFile(const std::string& fileName) {
-        cgtAssert(sizeof(trk_header) == 1000, "invalid trk header size!");
-        trk_header header;
-        FiberData* toReturn = nullptr;
+        cgtAssert(sizeof(TrkHeader) == 1000, "invalid trk header size!");
 
-        std::ifstream file(fileName, std::ios::in |std::ios::binary);
-        if (!file) {
+        // map the whole file instead of reading it piecewise
+        MappedFile file(fileName);
+        if (! file.isOpen()) {
             LERROR("Failed to open file: " << fileName);
             return nullptr;
         }
-        if (!file.read((char*)&header, sizeof(header))) {
+        if (file.getSize() < sizeof(TrkHeader)) {
             LERROR("Failed to read header! File: " << fileName);
             return nullptr;
         }
 
-        toReturn = new FiberData();
-        int32_t numPoints;
-
-        //LINFO("n_scalars: " << header.n_scalars);
-        //LINFO("n_properties: " << header.n_properties);
-        float* scalars = new float[header.n_scalars];
-        float* properties = new float[header.n_properties];
-
-        while (file.read(reinterpret_cast<char*>(&numPoints), 4)) {
-            std::vector<cgt::vec3> vertices;
-            vertices.resize(numPoints, cgt::vec3(0.f));
-
-
-            for (int32_t i=0; i<numPoints; ++i) {
-                file.read(reinterpret_cast<char*>(vertices[i].elem), sizeof(cgt::vec3));
+        TrkHeader header;
+        memcpy(&header, file.getData(), sizeof(header));
+        if (strncmp(header.id_string, "TRACK", 5) != 0 || header.hdr_size != sizeof(TrkHeader) || header.n_scalars < 0 || header.n_properties < 0) {
+            LERROR("Invalid or byte-swapped TrackVis header! File: " << fileName);
+            return nullptr;
+        }
 
-                vertices[i] *= p_scaling.getValue();
-                vertices[i] += p_offset.getValue();
+        const char* data = file.getData();
+        const size_t fileSize = file.getSize();
+        const size_t numScalars = static_cast<size_t>(header.n_scalars);
+        const size_t numProperties = static_cast<size_t>(header.n_properties);
+        const size_t pointSize = (3 + numScalars) * sizeof(float);
+
+        // first pass: find the records of all fibers to compute the contiguous layout
+        std::vector<size_t> recordPositions;    // byte position of the first point of each fiber
+        std::vector<size_t> offsets(1, 0);
+        if (header.n_count > 0) {
+            recordPositions.reserve(header.n_count);
+            offsets.reserve(header.n_count + 1);
+        }
 
-                file.read((char*)scalars, sizeof(float) * header.n_scalars);
-                //if(header.n_scalars > 0)
-                //    fibers_.uncertainties_.push_back(scalars[0]);
-                //else
-                //    fibers_.uncertainties_.push_back(0.0f);
+        size_t position = sizeof(TrkHeader);
+        while (position < fileSize) {
+            int32_t numPoints = -1;
+            if (fileSize - position >= sizeof(int32_t))
+                memcpy(&numPoints, data + position, sizeof(int32_t));
+            position += sizeof(int32_t);
+
+            // a truncated file most likely results from an aborted write, hence do not return partial data
+            size_t recordSize = (numPoints < 0) ? fileSize : static_cast<size_t>(numPoints) * pointSize + numProperties * sizeof(float);
+            if (position > fileSize || recordSize > fileSize - position) {
+                LERROR("Fiber " << recordPositions.size() << " is truncated or invalid! File: " << fileName);
+                return nullptr;
             }
 
-            toReturn->addFiber(vertices);
-            file.read((char*) properties, sizeof(float) * header.n_properties);
+            recordPositions.push_back(position);
+            offsets.push_back(offsets.back() + numPoints);
+            position += recordSize;
+        }
+        if (header.n_count > 0 && recordPositions.size() != static_cast<size_t>(header.n_count)) {
+            LERROR("Expected " << header.n_count << " fibers but found " << recordPositions.size() << "! File: " << fileName);
+            return nullptr;
         }
 
-        delete[] scalars;
-        delete[] properties;
-        file.close();
-
+        // second pass: decode all fibers in parallel directly into their final location
+        const size_t numFibers = recordPositions.size();
+        std::vector<cgt::vec3> vertices(offsets.back());
+        std::vector< std::vector<float> > scalars(numScalars, std::vector<float>(offsets.back()));
+        std::vector< std::vector<float> > properties(numProperties, std::vector<float>(numFibers));
+        const cgt::vec3 scaling = p_scaling.getValue();
+        const cgt::vec3 offset = p_offset.getValue();
+
+        tbb::parallel_for(tbb::blocked_range<size_t>(0, numFibers), [&] (const tbb::blocked_range<size_t>& range) {
+            for (size_t f = range.begin(); f != range.end(); ++f) {
+                const char* record = data + recordPositions[f];
+
+                for (size_t i = offsets[f]; i < offsets[f+1]; ++i) {
+                    memcpy(vertices[i].elem, record, sizeof(cgt::vec3));
+                    vertices[i] = vertices[i] * scaling + offset;
+                    record += sizeof(cgt::vec3);
+
+                    for (size_t s = 0; s < numScalars; ++s) {
+                        memcpy(&scalars[s][i], record, sizeof(float));
+                        record += sizeof(float);
+                    }
+                }
+
+                for (size_t p = 0; p < numProperties; ++p) {
+                    memcpy(&properties[p][f], record, sizeof(float));
+                    record += sizeof(float);
+                }
+            }
+        });
+
+        FiberData* toReturn = new FiberData();
+        toReturn->setFibers(vertices, offsets);
+        // the header stores only up to 10 names
+        for (size_t s = 0; s < numScalars; ++s)
+            toReturn->addPointAttribute((s < 10) ? std::string(header.scalar_name[s], strnlen(header.scalar_name[s], 20)) : "", scalars[s]);
+        for (size_t p = 0; p < numProperties; ++p)
+            toReturn->addFiberAttribute((p < 10) ? std::string(header.property_name[p], strnlen(header.property_name[p], 20)) : "", properties[p]);
+
+        // build the spatial index right away, so that the first ROI query or frame is fast
+        toReturn->getBvh();
         return toReturn;
     }
 
@@ -30,6 +30,7 @@
 #include "cgt/textureunit.h"
 
 
+#include "modules/dti/datastructures/fiberbvh.h"
 #include "modules/dti/datastructures/fiberdata.h"
 #include "core/datastructures/cameradata.h"
 #include "core/datastructures/lightsourcedata.h"
@@ -60,6 +61,7 @@ namespace dti {
         , p_coloringMode("ColoringMode", "Coloring Mode", coloringModeOptions, 2)
         , p_lineWidth("LineWidth", "Line width", 2.f, .1f, 10.f, 0.1f)
         , p_enableShading("EnableShading", "Enable Shading", true)
+        , p_enableFrustumCulling("EnableFrustumCulling", "Enable Frustum Culling", true)
         , p_lightId("LightId", "Input Light Source", "lightsource", DataNameProperty::READ)
         , _shader(0)
     {
@@ -72,6 +74,7 @@ namespace dti {
         addProperty(p_lineWidth);
 
         addProperty(p_enableShading, INVALID_RESULT | INVALID_PROPERTIES | INVALID_SHADER);
+        addProperty(p_enableFrustumCulling);
         addProperty(p_lightId);
     }
 
@@ -100,6 +103,14 @@ namespace dti {
             if (p_enableShading.getValue() == false || light != nullptr) {
                 const cgt::Camera& cam = camera->getCamera();
 
+                // determine potentially visible fibers using the fibers' BVH
+                std::vector<uint8_t> frustumMask;
+                if (p_enableFrustumCulling.getValue()) {
+                    cgt::Camera cullingCamera(cam);
+                    cullingCamera.updateFrustum();
+                    strainData->getBvh()->queryFrustum(cullingCamera.getFrustum(), frustumMask);
+                }
+
                 // set modelview and projection matrices
                 FramebufferActivationGuard fag(this);
                 createAndAttachColorTexture();
@@ -124,7 +135,7 @@ namespace dti {
                 glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
                 glLineWidth(p_lineWidth.getValue());
-                strainData->render();
+                strainData->render(GL_LINE_STRIP, p_enableFrustumCulling.getValue() ? &frustumMask : nullptr);
                 glLineWidth(1.f);
 
                 _shader->deactivate();
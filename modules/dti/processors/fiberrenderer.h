@@ -90,6 +90,7 @@ namespace dti {
         FloatProperty p_lineWidth;
 
         BoolProperty p_enableShading;               ///< Flag whether to enable shading
+        BoolProperty p_enableFrustumCulling;        ///< Flag whether to skip fibers outside the view frustum
         DataNameProperty p_lightId;                 ///< Name/ID for the LightSource to use
 
     protected:
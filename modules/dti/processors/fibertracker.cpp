@@ -25,46 +25,68 @@
 #include "fibertracker.h"
 
 #include <tbb/tbb.h>
-#include <tbb/spin_mutex.h>
+#include <tbb/enumerable_thread_specific.h>
 
 #include "core/datastructures/imagerepresentationlocal.h"
+#include "core/tools/voxelview.h"
 #include "modules/dti/datastructures/fiberdata.h"
-#include <deque>
+
+#include <cmath>
+#include <vector>
 
 namespace campvis {
 namespace dti {
 
     const std::string FiberTracker::loggerCat_ = "CAMPVis.modules.io.FiberTracker";
 
+    /**
+     * Thread-local buffer for the fibers tracked by a single thread. Uses the same layout as 
+     * FiberData: fiber i consists of the vertices [_offsets[i], _offsets[i+1]).
+     */
+    struct FiberBuffer {
+        FiberBuffer() : _offsets(1, 0) {};
+
+        std::vector<cgt::vec3> _vertices;   ///< Vertices of all fibers in world coordinates
+        std::vector<size_t> _offsets;       ///< Start index of each fiber, followed by _vertices.size()
+        std::vector<cgt::vec3> _backward;   ///< Scratch buffer for the backward part of the current fiber
+    };
+
+    template<typename BASETYPE>
     class ApplyFiberTracking {
     public:
-        ApplyFiberTracking(const ImageRepresentationLocal* input, const std::vector<cgt::vec3>& seeds, FiberData* output, int numSteps, float stepSize, float strainThreshold, float maximumAngle, tbb::spin_mutex& mutex)
+        ApplyFiberTracking(const VoxelView<BASETYPE, 3>& input, const ImageMappingInformation& mappingInformation, const std::vector<cgt::vec3>& seeds, tbb::enumerable_thread_specific<FiberBuffer>& buffers, int numSteps, float stepSize, float strainThreshold, float maximumAngle)
             : _input(input)
+            , _worldToVoxel(getLinearPart(mappingInformation.getWorldToVoxelMatrix()))
+            , _voxelToWorld(mappingInformation.getVoxelToWorldMatrix())
             , _seeds(seeds)
-            , _output(output)
+            , _buffers(buffers)
             , _numSteps(numSteps)
-            , _stepSize(stepSize)
             , _strainThreshold(strainThreshold * strainThreshold)
-            , _maxAngle(maximumAngle)
-            , _mutex(mutex)
+            , _cosMaxAngle(std::cos(cgt::deg2rad(maximumAngle)))
+            , _upperBounds(input.getSize())
         {
-            _voxelSize = cgt::length(_input->getParent()->getMappingInformation().getVoxelSize());
+            _stepSize = stepSize * cgt::length(mappingInformation.getVoxelSize());
         }
         
         /**
-         * Retrieves a vec3 from \a vol using trilinear interpolation.
+         * Returns the upper left 3x3 submatrix of \a m.
+         * \param   m   affine transformation matrix
+         **/
+        static cgt::mat3 getLinearPart(const cgt::mat4& m) {
+            return cgt::mat3(m.t00, m.t01, m.t02, m.t10, m.t11, m.t12, m.t20, m.t21, m.t22);
+        }
+
+        /**
+         * Retrieves a vec3 from the input volume using trilinear interpolation.
          * \param   position        voxel position
          **/
         inline cgt::vec3 getVec3FloatLinear(const cgt::vec3& position) const {
-            cgt::vec3 result;
-            result.x = _input->getElementNormalizedLinear(position, 0);
-            result.y = _input->getElementNormalizedLinear(position, 1);
-            result.z = _input->getElementNormalizedLinear(position, 2);
-            return result;
+            return _input.getNormalizedLinear(position);
         }
         
         /**
          * Checks whether the angle between \a a and \a b is lower that the given threshold.
+         * Compares the cosines of the angles without any trigonometric functions or square roots.
          *
          * \param   a   direction of first tangent vector in world coordinates
          * \param   b   direction of second tangent vector in world coordinates
@@ -72,8 +94,13 @@ namespace dti {
          * \return  true, if angle is below the threshold.
          **/
         inline bool testTortuosity(const cgt::vec3& a, const cgt::vec3& b) const {
-            float angle = fabs(acos(cgt::dot(a, b) / (cgt::length(a) * cgt::length(b))));
-            return (angle < _maxAngle);
+            // angle < maxAngle <=> dot(a, b) > cos(maxAngle) * |a| * |b|
+            float d = cgt::dot(a, b);
+            float threshold = _cosMaxAngle * _cosMaxAngle * cgt::lengthSq(a) * cgt::lengthSq(b);
+            if (_cosMaxAngle >= 0.f)
+                return d > 0.f && d*d > threshold;
+            else
+                return d >= 0.f || d*d < threshold;
         }
 
         /**
@@ -84,81 +111,160 @@ namespace dti {
          * true, if \a position is within bounds of eigenvalues volume.
          **/
         inline bool testBounds(const cgt::vec3& position) const {
-            const cgt::svec3& dim = _input->getParent()->getSize();
-            cgt::svec3 pos(cgt::ceil(position));
-            return (cgt::hand(cgt::greaterThanEqual(pos, cgt::svec3::zero)) && cgt::hand(cgt::lessThanEqual(pos, dim)));
+            return position.x > -1.f && position.y > -1.f && position.z > -1.f
+                && position.x <= _upperBounds.x && position.y <= _upperBounds.y && position.z <= _upperBounds.z;
         }
+
         /**
-         * Performs fiber tracking of a single fiber to a single direction starting at \a worldPosition 
-         * and stores path in \a result. \a result will NOT contain the start point \a worldPosition.
+         * Performs fiber tracking of a single fiber to a single direction starting at \a voxelPosition 
+         * and appends the path to \a result. \a result will NOT contain the start point.
+         * Integration is performed in voxel space, only the step directions are transformed from
+         * world space, while the world position is accumulated alongside.
          *
+         * \param   voxelPosition   start position in voxel coordinates
          * \param   worldPosition   start position in world coordinates
-         * \param   forwards        flag whether to propagate forwards or backwards from \a worldPosition
-         * \param   maxAngle        maximum angle between two fiber points to continue tracking
-         * \param   result          fiber points will be stored in here - forward tracking will append, backward tracking push front
+         * \param   forwards        flag whether to propagate forwards or backwards from the start position
+         * \param   result          fiber points in world coordinates will be appended to this vector
          **/
-        void performSingleTracking(cgt::vec3 worldPosition, bool forwards, std::deque<cgt::vec3>& result) const {
-            const cgt::mat4& WtV = _input->getParent()->getMappingInformation().getWorldToVoxelMatrix();
-
-            cgt::vec3 voxelPosition = (WtV * cgt::vec4(worldPosition, 1.f)).xyz();
+        void performSingleTracking(cgt::vec3 voxelPosition, cgt::vec3 worldPosition, bool forwards, std::vector<cgt::vec3>& result) const {
             cgt::vec3 direction = getVec3FloatLinear(voxelPosition);
             if (! forwards)
                 direction *= -1.f;
 
             for (int i = 0; i < _numSteps; ++i) {
                 // apply second order runge-kutta integration (Heun method)
-                cgt::vec3 dir1 = getVec3FloatLinear((WtV * cgt::vec4(worldPosition, 1.f)).xyz()) * _stepSize * _voxelSize;
+                cgt::vec3 dir1 = getVec3FloatLinear(voxelPosition) * _stepSize;
                 if (cgt::dot(direction, dir1) < 0)
                     dir1 *= -1.f;
+                cgt::vec3 voxelDir1 = _worldToVoxel * dir1;
 
-                cgt::vec3 dir2 = getVec3FloatLinear((WtV * cgt::vec4(worldPosition + dir1, 1.f)).xyz()) * _stepSize * _voxelSize;
+                cgt::vec3 dir2 = getVec3FloatLinear(voxelPosition + voxelDir1) * _stepSize;
                 if (cgt::dot(direction, dir2) < 0)
                     dir2 *= -1.f;
+                cgt::vec3 voxelDir2 = _worldToVoxel * dir2;
 
                 cgt::vec3 vProp = (dir1 + dir2) * .5f;
                 worldPosition += vProp;
-                voxelPosition = (WtV * cgt::vec4(worldPosition, 1.f)).xyz();
+                voxelPosition += (voxelDir1 + voxelDir2) * .5f;
 
                 // check termination criteria
                 if (cgt::lengthSq(vProp) < _strainThreshold || !testBounds(voxelPosition) || !testTortuosity(direction, vProp))
                     break;
 
                 direction = vProp;
-                if (forwards)
-                    result.push_back(worldPosition);
-                else
-                    result.push_front(worldPosition);
+                result.push_back(worldPosition);
             }
         }
 
         void operator() (const tbb::blocked_range<size_t>& range) const {
+            FiberBuffer& buffer = _buffers.local();
+
             for (size_t i = range.begin(); i != range.end(); ++i) {
-                const cgt::vec3& position = _seeds[i];
+                const cgt::vec3& voxelPosition = _seeds[i];
+                cgt::vec3 worldPosition = (_voxelToWorld * cgt::vec4(voxelPosition, 1.f)).xyz();
 
-                // perform fiber tracking in both directions
-                std::deque<cgt::vec3> vertices;
-                performSingleTracking(position, false, vertices);
-                vertices.push_back(position);
-                performSingleTracking(position, true, vertices);
+                // perform fiber tracking in both directions, the backward part is collected 
+                // separately and then prepended in reverse order
+                buffer._backward.clear();
+                performSingleTracking(voxelPosition, worldPosition, false, buffer._backward);
 
-                if (vertices.size() > 1) {
-                    tbb::spin_mutex::scoped_lock lock(_mutex);
-                    _output->addFiber(vertices);
-                }
+                size_t start = buffer._vertices.size();
+                buffer._vertices.insert(buffer._vertices.end(), buffer._backward.rbegin(), buffer._backward.rend());
+                buffer._vertices.push_back(worldPosition);
+                performSingleTracking(voxelPosition, worldPosition, true, buffer._vertices);
+
+                if (buffer._vertices.size() - start > 1)
+                    buffer._offsets.push_back(buffer._vertices.size());
+                else
+                    buffer._vertices.resize(start);
             }
         }
 
     protected:
-        const ImageRepresentationLocal* _input;
+        VoxelView<BASETYPE, 3> _input;
+        cgt::mat3 _worldToVoxel;            ///< Linear part of the world-to-voxel transformation to transform directions
+        cgt::mat4 _voxelToWorld;
         const std::vector<cgt::vec3>& _seeds;
+        tbb::enumerable_thread_specific<FiberBuffer>& _buffers;
+        int _numSteps;
+        float _stepSize;                    ///< Step size scaled by the voxel size
+        float _strainThreshold;
+        float _cosMaxAngle;                 ///< Cosine of the maximum angle between two fiber segments
+        cgt::vec3 _upperBounds;
+    };
+
+    /**
+     * Dispatches the fiber tracking on the base type of the strain data: Performs uniform seeding
+     * and tracks a fiber from each seed.
+     */
+    class FiberTrackingDispatcher {
+    public:
+        FiberTrackingDispatcher(const ImageMappingInformation& mappingInformation, FiberData* output, int seedDistance, int numSteps, float stepSize, float strainThreshold, float maximumAngle)
+            : _mappingInformation(mappingInformation)
+            , _output(output)
+            , _seedDistance(seedDistance)
+            , _numSteps(numSteps)
+            , _stepSize(stepSize)
+            , _strainThreshold(strainThreshold)
+            , _maxAngle(maximumAngle)
+        {
+        }
+
+        template<typename BASETYPE>
+        void operator() (const VoxelView<BASETYPE, 3>& strainData) const {
+            std::vector<cgt::vec3> seeds = performUniformSeeding(strainData);
+
+            // each thread collects its fibers locally, they are merged once at the end
+            tbb::enumerable_thread_specific<FiberBuffer> buffers;
+            tbb::parallel_for(
+                tbb::blocked_range<size_t>(0, seeds.size()), 
+                ApplyFiberTracking<BASETYPE>(strainData, _mappingInformation, seeds, buffers, _numSteps, _stepSize, _strainThreshold, _maxAngle));
+
+            size_t numVertices = 0;
+            size_t numFibers = 0;
+            for (tbb::enumerable_thread_specific<FiberBuffer>::const_iterator it = buffers.begin(); it != buffers.end(); ++it) {
+                numVertices += it->_vertices.size();
+                numFibers += it->_offsets.size() - 1;
+            }
+
+            _output->reserve(numVertices, numFibers);
+            for (tbb::enumerable_thread_specific<FiberBuffer>::const_iterator it = buffers.begin(); it != buffers.end(); ++it)
+                _output->addFibers(it->_vertices, it->_offsets);
+        }
+
+    protected:
+        /**
+         * Creates seed points uniformly spread over volume.
+         * \param   strainData  Input strain data
+         * \return  vector of seed points in voxel coordinates
+         **/
+        template<typename BASETYPE>
+        std::vector<cgt::vec3> performUniformSeeding(const VoxelView<BASETYPE, 3>& strainData) const {
+            std::vector<cgt::vec3> seeds;
+            float threshold = _strainThreshold * _strainThreshold;
+            size_t inc = static_cast<size_t>(_seedDistance);
+
+            for (size_t z = 0; z < strainData.getSize().z; z += inc) {
+                for (size_t y = 0; y < strainData.getSize().y; y += inc) {
+                    for (size_t x = 0; x < strainData.getSize().x; x += inc) {
+                        cgt::vec3 pos = cgt::vec3(float(x), float(y), float(z));
+                        if (cgt::lengthSq(strainData.getNormalizedLinear(pos)) > threshold) {
+                            seeds.push_back(pos);
+                        }
+                    }
+                }
+            }
+
+            return seeds;
+        }
+
+        const ImageMappingInformation& _mappingInformation;
         FiberData* _output;
+        int _seedDistance;
         int _numSteps;
         float _stepSize;
-        float _voxelSize;
         float _strainThreshold;
         float _maxAngle;
-
-        tbb::spin_mutex& _mutex;
     };
 
     FiberTracker::FiberTracker() 
@@ -192,16 +298,13 @@ namespace dti {
 
         if (strainData != 0) {
             if (strainData.getImageData()->getNumChannels() == 3) {
-                LDEBUG("Generating seeds...");
-                std::vector<cgt::vec3> seeds = performUniformSeeding(*strainData);
-
-                LDEBUG("Generating fibers...");
+                LDEBUG("Generating seeds and fibers...");
                 FiberData* fibers = new FiberData();
-                tbb::spin_mutex mutex;
-                tbb::parallel_for(
-                    tbb::blocked_range<size_t>(0, seeds.size()), 
-                    ApplyFiberTracking(strainData, seeds, fibers, p_numSteps.getValue(), p_stepSize.getValue(), p_strainThreshold.getValue(), p_maximumAngle.getValue(), mutex));
+                FiberTrackingDispatcher dispatcher(strainData->getParent()->getMappingInformation(), fibers, p_seedDistance.getValue(), p_numSteps.getValue(), p_stepSize.getValue(), p_strainThreshold.getValue(), p_maximumAngle.getValue());
+                dispatchVoxelView<3>(strainData, dispatcher);
 
+                // build the spatial index right away, so that the first ROI query or frame is fast
+                fibers->getBvh();
                 LDEBUG("done.");
 
                 data.addData(p_outputID.getValue(), fibers);
@@ -215,33 +318,5 @@ namespace dti {
         }
     }
 
-    std::vector<cgt::vec3> FiberTracker::performUniformSeeding(const ImageRepresentationLocal& strainData) const {
-        std::vector<cgt::vec3> seeds;
-        const cgt::mat4& VtW = strainData.getParent()->getMappingInformation().getVoxelToWorldMatrix();
-        float threshold = p_strainThreshold.getValue() * p_strainThreshold.getValue();
-        int inc = p_seedDistance.getValue();
-
-        for (size_t z = 0; z < strainData.getSize().z; z += inc) {
-            for (size_t y = 0; y < strainData.getSize().y; y += inc) {
-                for (size_t x = 0; x < strainData.getSize().x; x += inc) {
-                    cgt::vec3 pos = cgt::vec3(float(x), float(y), float(z));
-                    if (cgt::lengthSq(getVec3FloatLinear(strainData, pos)) > threshold) {
-                        seeds.push_back((VtW * cgt::vec4(pos, 1.f)).xyz());
-                    }
-                }
-            }
-        }
-
-        return seeds;
-    }
-
-    cgt::vec3 FiberTracker::getVec3FloatLinear(const ImageRepresentationLocal& strainData, const cgt::vec3& position) const {
-        cgt::vec3 result;
-        result.x = strainData.getElementNormalizedLinear(position, 0);
-        result.y = strainData.getElementNormalizedLinear(position, 1);
-        result.z = strainData.getElementNormalizedLinear(position, 2);
-        return result;
-    }
-
 }
 }
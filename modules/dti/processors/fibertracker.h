@@ -36,8 +36,6 @@
 #include <deque>
 
 namespace campvis {
-    class ImageRepresentationLocal;
-
 namespace dti {
 
     /**
@@ -63,6 +61,8 @@ namespace dti {
         virtual const std::string getAuthor() const { return "Christian Schulte zu Berge <christian.szb@in.tum.de>"; };
         /// \see AbstractProcessor::getProcessorState()
         virtual ProcessorState getProcessorState() const { return AbstractProcessor::EXPERIMENTAL; };
+        /// \see AbstractProcessor::supportsConcurrentExecution()
+        virtual bool supportsConcurrentExecution() const { return true; };
 
         DataNameProperty p_strainId;   ///< image ID for input strain data
         DataNameProperty p_outputID;   ///< image ID for output fiber data
@@ -81,21 +81,6 @@ namespace dti {
         /// \see AbstractProcessor::updateResult
         virtual void updateResult(DataContainer& dataContainer);
 
-        /**
-         * Creates seed points uniformly spread over volume and writes them to \a seeds.
-         * \param   strainData  Input strain data
-         * \return  vector of seed points in voxel coordinates
-         **/
-        std::vector<cgt::vec3> performUniformSeeding(const ImageRepresentationLocal& strainData) const;
-
-        /**
-         * Retrieves a vec3 from \a vol using trilinear interpolation.
-         *
-         * \param   vol             volume to get data from
-         * \param   position        voxel position
-         **/
-        inline cgt::vec3 getVec3FloatLinear(const ImageRepresentationLocal& strainData, const cgt::vec3& position) const;
-
         static const std::string loggerCat_;
     };
 
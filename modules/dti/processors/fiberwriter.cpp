@@ -0,0 +1,147 @@
+// ================================================================================================
+// 
+// This file is part of the CAMPVis Software Framework.
+// 
+// If not explicitly stated otherwise: Copyright (C) 2012-2015, all rights reserved,
+//      Christian Schulte zu Berge <christian.szb@in.tum.de>
+//      Chair for Computer Aided Medical Procedures
+//      Technische Universitaet Muenchen
+//      Boltzmannstr. 3, 85748 Garching b. Muenchen, Germany
+// 
+// For a full list of authors and contributors, please refer to the file "AUTHORS.txt".
+// 
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file 
+// except in compliance with the License. You may obtain a copy of the License at
+// 
+// http://www.apache.org/licenses/LICENSE-2.0
+// 
+// Unless required by applicable law or agreed to in writing, software distributed under the 
+// License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, 
+// either express or implied. See the License for the specific language governing permissions 
+// and limitations under the License.
+// 
+// ================================================================================================
+
+
+#include "fiberwriter.h"
+
+#include "cgt/filesystem.h"
+#include "core/datastructures/scopedtypeddata.h"
+#include "modules/dti/datastructures/fiberdata.h"
+#include "modules/dti/tools/trkheader.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <limits>
+
+namespace campvis {
+namespace dti {
+
+    const std::string FiberWriter::loggerCat_ = "CAMPVis.modules.dti.FiberWriter";
+
+    FiberWriter::FiberWriter()
+        : AbstractProcessor()
+        , p_inputId("InputId", "Input Fiber Data Name", "fibers", DataNameProperty::READ)
+        , p_url("Url", "Output File Name", "", StringProperty::SAVE_FILENAME)
+        , p_saveFile("SaveFile", "Save to File")
+    {
+        addProperty(p_inputId, VALID);
+        addProperty(p_url, VALID);
+        addProperty(p_saveFile, INVALID_RESULT | FIRST_FREE_TO_USE_INVALIDATION_LEVEL);
+    }
+
+    FiberWriter::~FiberWriter() {
+
+    }
+
+    void FiberWriter::updateResult(DataContainer& dataContainer) {
+        if (! (getInvalidationLevel() & FIRST_FREE_TO_USE_INVALIDATION_LEVEL))
+            return;
+
+        ScopedTypedData<FiberData> fibers(dataContainer, p_inputId.getValue());
+        if (fibers == nullptr) {
+            LERROR("No suitable input fiber data found.");
+        }
+        else if (cgt::FileSystem::fileExtension(p_url.getValue()) != "trk") {
+            LERROR("Unknown file extension.");
+        }
+        else if (! writeTrkFile(*fibers, p_url.getValue())) {
+            LERROR("Could not write fibers to " << p_url.getValue());
+        }
+
+        validate(FIRST_FREE_TO_USE_INVALIDATION_LEVEL);
+    }
+
+    bool FiberWriter::writeTrkFile(const FiberData& fibers, const std::string& fileName) {
+        cgtAssert(sizeof(TrkHeader) == 1000, "invalid trk header size!");
+
+        const std::vector<cgt::vec3>& vertices = fibers.getVertices();
+        const std::vector<size_t>& offsets = fibers.getFiberOffsets();
+        const size_t numScalars = fibers.getNumPointAttributes();
+        const size_t numProperties = fibers.getNumFiberAttributes();
+        if (numScalars > static_cast<size_t>(std::numeric_limits<short int>::max()) || numProperties > static_cast<size_t>(std::numeric_limits<short int>::max())) {
+            LERRORC(loggerCat_, "Too many fiber attributes for a TrackVis file.");
+            return false;
+        }
+
+        TrkHeader header;
+        memset(&header, 0, sizeof(header));
+        memcpy(header.id_string, "TRACK", 6);
+        header.voxel_size[0] = header.voxel_size[1] = header.voxel_size[2] = 1.f;
+        header.n_scalars = static_cast<short int>(numScalars);
+        for (size_t s = 0; s < std::min(numScalars, size_t(10)); ++s)
+            strncpy(header.scalar_name[s], fibers.getPointAttributeName(s).c_str(), 20);
+        header.n_properties = static_cast<short int>(numProperties);
+        for (size_t p = 0; p < std::min(numProperties, size_t(10)); ++p)
+            strncpy(header.property_name[p], fibers.getFiberAttributeName(p).c_str(), 20);
+        header.n_count = (fibers.numFibers() <= static_cast<size_t>(std::numeric_limits<int32_t>::max())) ? static_cast<int32_t>(fibers.numFibers()) : 0;
+        header.version = 2;
+        header.hdr_size = sizeof(TrkHeader);
+
+        // TrackVis uses the volume dimensions to place the tracks, hence cover the fibers' extent
+        cgt::Bounds bounds = fibers.getWorldBounds();
+        if (bounds.isDefined()) {
+            for (size_t i = 0; i < 3; ++i)
+                header.dim[i] = static_cast<short int>(std::min(std::max(std::ceil(bounds.getURB()[i]), 1.f), 32767.f));
+        }
+
+        std::ofstream file(fileName.c_str(), std::ios::out | std::ios::binary);
+        if (! file.is_open() || file.bad()) {
+            LERRORC(loggerCat_, "Failed to open file: " << fileName);
+            return false;
+        }
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+        std::vector<float> buffer;
+        for (size_t f = 0; f < fibers.numFibers(); ++f) {
+            int32_t numPoints = static_cast<int32_t>(offsets[f+1] - offsets[f]);
+            file.write(reinterpret_cast<const char*>(&numPoints), sizeof(numPoints));
+
+            if (numScalars == 0) {
+                // points are stored exactly like in FiberData, so write them directly
+                if (numPoints > 0)
+                    file.write(reinterpret_cast<const char*>(vertices[offsets[f]].elem), numPoints * sizeof(cgt::vec3));
+            }
+            else {
+                // interleave coordinates and scalars
+                buffer.clear();
+                for (size_t i = offsets[f]; i < offsets[f+1]; ++i) {
+                    buffer.insert(buffer.end(), vertices[i].elem, vertices[i].elem + 3);
+                    for (size_t s = 0; s < numScalars; ++s)
+                        buffer.push_back(fibers.getPointAttribute(s)[i]);
+                }
+                if (! buffer.empty())
+                    file.write(reinterpret_cast<const char*>(&buffer.front()), buffer.size() * sizeof(float));
+            }
+
+            for (size_t p = 0; p < numProperties; ++p)
+                file.write(reinterpret_cast<const char*>(&fibers.getFiberAttribute(p)[f]), sizeof(float));
+        }
+
+        return file.good();
+    }
+
+}
+}
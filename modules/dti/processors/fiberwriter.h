@@ -0,0 +1,90 @@
+// ================================================================================================
+// 
+// This file is part of the CAMPVis Software Framework.
+// 
+// If not explicitly stated otherwise: Copyright (C) 2012-2015, all rights reserved,
+//      Christian Schulte zu Berge <christian.szb@in.tum.de>
+//      Chair for Computer Aided Medical Procedures
+//      Technische Universitaet Muenchen
+//      Boltzmannstr. 3, 85748 Garching b. Muenchen, Germany
+// 
+// For a full list of authors and contributors, please refer to the file "AUTHORS.txt".
+// 
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file 
+// except in compliance with the License. You may obtain a copy of the License at
+// 
+// http://www.apache.org/licenses/LICENSE-2.0
+// 
+// Unless required by applicable law or agreed to in writing, software distributed under the 
+// License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, 
+// either express or implied. See the License for the specific language governing permissions 
+// and limitations under the License.
+// 
+// ================================================================================================
+
+
+#ifndef FIBERWRITER_H__
+#define FIBERWRITER_H__
+
+#include <string>
+
+#include "core/pipeline/abstractprocessor.h"
+#include "core/properties/buttonproperty.h"
+#include "core/properties/datanameproperty.h"
+#include "core/properties/stringproperty.h"
+
+#include "modules/modulesapi.h"
+
+namespace campvis {
+namespace dti {
+    class FiberData;
+
+    /**
+     * Writes Fiber Data into a TrackVis *.trk file.
+     * Per-vertex and per-fiber attributes of the fiber data are stored as TrackVis scalars and 
+     * properties respectively.
+     */
+    class CAMPVIS_MODULES_API FiberWriter : public AbstractProcessor {
+    public:
+        /**
+         * Constructs a new FiberWriter Processor
+         **/
+        FiberWriter();
+
+        /**
+         * Destructor
+         **/
+        virtual ~FiberWriter();
+
+        /// \see AbstractProcessor::getName()
+        virtual const std::string getName() const { return "FiberWriter"; };
+        /// \see AbstractProcessor::getDescription()
+        virtual const std::string getDescription() const { return "Writes Fiber Data into a TrackVis file."; };
+        /// \see AbstractProcessor::getAuthor()
+        virtual const std::string getAuthor() const { return "Christian Schulte zu Berge <christian.szb@in.tum.de>"; };
+        /// \see AbstractProcessor::getProcessorState()
+        virtual ProcessorState getProcessorState() const { return AbstractProcessor::EXPERIMENTAL; };
+
+        DataNameProperty p_inputId;                 ///< ID for input fiber data
+        StringProperty p_url;                       ///< Output file name URL
+        ButtonProperty p_saveFile;                  ///< Button to write the file
+
+        /**
+         * Writes \a fibers into the TrackVis file \a fileName.
+         * \param   fibers      Fiber data to write.
+         * \param   fileName    Name of the file to write.
+         * \return  True on success, false otherwise.
+         */
+        static bool writeTrkFile(const FiberData& fibers, const std::string& fileName);
+
+    protected:
+        /// \see AbstractProcessor::updateResult
+        virtual void updateResult(DataContainer& dataContainer);
+
+        static const std::string loggerCat_;
+    };
+
+}
+}
+
+#endif // FIBERWRITER_H__
@@ -63,6 +63,8 @@ namespace campvis {
         virtual const std::string getAuthor() const { return "Christian Schulte zu Berge <christian.szb@in.tum.de>"; };
         /// \see AbstractProcessor::getProcessorState()
         virtual ProcessorState getProcessorState() const { return AbstractProcessor::EXPERIMENTAL; };
+        /// \see AbstractProcessor::supportsConcurrentExecution()
+        virtual bool supportsConcurrentExecution() const { return true; };
         
         IVec3Property p_size;               ///< Image size
         IntProperty p_numChannels;          ///< Number of channels per element
@@ -24,16 +24,28 @@
 
 #include "vtkimagereader.h"
 
+#include <tbb/atomic.h>
+#include <tbb/parallel_for.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
 #include <iostream>
 #include <fstream>
+#include <limits>
+#include <memory>
 #include <sstream>
 #include <string>
+#include <type_traits>
+#include <vector>
 
 #include "cgt/filesystem.h"
 #include "core/datastructures/imagedata.h"
 #include "core/datastructures/imagerepresentationdisk.h"
 #include "core/datastructures/indexedmeshgeometry.h"
 #include "core/datastructures/genericimagerepresentationlocal.h"
+#include "core/tools/endianhelper.h"
+#include "core/tools/meshoptimizer.h"
 #include "core/tools/stringutils.h"
 
 /*
@@ -41,12 +53,323 @@
  */
 
 namespace campvis {
+    namespace {
+        /// Number of bytes to read from the file in one go when parsing ASCII data.
+        const size_t ASCII_CHUNK_SIZE = 16 * 1024 * 1024;
+
+        /// Approximate number of bytes of ASCII data to parse per task.
+        const size_t ASCII_GRAIN_SIZE = 256 * 1024;
+
+        inline bool isWhitespace(char c) {
+            return c == ' ' || c == '\n' || c == '\r' || c == '\t' || c == '\v' || c == '\f';
+        }
+
+        /**
+         * Parses the integer token starting at \a p and advances \a p to the first character after it.
+         * \param   p       Pointer to the first character of the token, the token must be terminated by whitespace or 0.
+         * \param   value   Output parameter for the parsed value.
+         * \return  False if the token is not a valid integer or out of the range of T.
+         */
+        template<typename T>
+        bool parseNumber(const char*& p, T& value, std::true_type /* isIntegral */) {
+            const bool negative = (*p == '-');
+            const char* digits = (*p == '-' || *p == '+') ? p + 1 : p;
+
+            // largest magnitude representable by T with the token's sign
+            const unsigned long long limit = negative
+                ? (std::numeric_limits<T>::is_signed ? 0ULL - static_cast<unsigned long long>(static_cast<long long>(std::numeric_limits<T>::min())) : 0ULL)
+                : static_cast<unsigned long long>(std::numeric_limits<T>::max());
+            unsigned long long result = 0;
+
+            const char* q = digits;
+            while (*q >= '0' && *q <= '9') {
+                unsigned long long digit = static_cast<unsigned long long>(*q - '0');
+                if (digit > limit || result > (limit - digit) / 10)
+                    return false;
+                result = result * 10 + digit;
+                ++q;
+            }
+
+            if (q == digits || ! (isWhitespace(*q) || *q == 0))
+                return false;
+
+            // negate in the signed domain without overflowing for std::numeric_limits<T>::min()
+            if (negative && result != 0)
+                value = static_cast<T>(-static_cast<long long>(result - 1) - 1);
+            else
+                value = static_cast<T>(result);
+            p = q;
+            return true;
+        }
+
+        /**
+         * Parses the floating point token starting at \a p and advances \a p to the first character after it.
+         * \param   p       Pointer to the first character of the token, the token must be terminated by whitespace or 0.
+         * \param   value   Output parameter for the parsed value.
+         * \return  False if the token is not a valid floating point number or out of the range of T.
+         */
+        template<typename T>
+        bool parseNumber(const char*& p, T& value, std::false_type /* isIntegral */) {
+            char* end = 0;
+            double result = std::strtod(p, &end);
+            if (end == p || ! (isWhitespace(*end) || *end == 0))
+                return false;
+            if (std::abs(result) > std::numeric_limits<T>::max() && ! std::isinf(result))
+                return false;
+
+            value = static_cast<T>(result);
+            p = end;
+            return true;
+        }
+
+        /**
+         * Counts the whitespace-separated tokens in [\a begin, \a end).
+         * \param   begin   Start of the range, must be the start of the buffer or preceded by whitespace.
+         * \param   end     End of the range.
+         * \return  The number of tokens starting in the range.
+         */
+        size_t countTokens(const char* begin, const char* end) {
+            size_t toReturn = 0;
+            bool inToken = false;
+            for (const char* p = begin; p != end; ++p) {
+                bool whitespace = isWhitespace(*p);
+                if (! whitespace && ! inToken)
+                    ++toReturn;
+                inToken = ! whitespace;
+            }
+            return toReturn;
+        }
+
+        /**
+         * Parses \a numValues whitespace-separated ASCII numbers from \a file into \a destination.
+         * The file is read in large chunks, which are split at whitespace boundaries into ranges. 
+         * The tokens in each range are first counted and then converted in parallel. Afterwards, 
+         * \a file is positioned right after the last parsed token.
+         * \param   file            Stream to read from, must be opened in binary mode.
+         * \param   destination     Destination array with at least \a numValues elements.
+         * \param   numValues       Number of values to parse.
+         */
+        template<typename FILE_TYPE, typename C_TYPE>
+        void parseAsciiValues(std::istream& file, C_TYPE* destination, size_t numValues) {
+            typedef typename std::is_integral<FILE_TYPE>::type IsIntegral;
+
+            std::vector<char> buffer;
+            size_t numParsed = 0;
+
+            while (numParsed < numValues) {
+                // append the next chunk to the incomplete token left over from the previous one
+                size_t carry = buffer.size();
+                buffer.resize(carry + ASCII_CHUNK_SIZE + 1);
+                file.read(&buffer[carry], ASCII_CHUNK_SIZE);
+                size_t length = carry + static_cast<size_t>(file.gcount());
+                bool endOfFile = file.eof();
+                buffer[length] = 0;
+
+                // only parse up to the last whitespace, the remainder might be an incomplete token
+                size_t parseEnd = length;
+                if (! endOfFile) {
+                    while (parseEnd > 0 && ! isWhitespace(buffer[parseEnd - 1]))
+                        --parseEnd;
+                    if (parseEnd == 0)
+                        throw cgt::Exception("Could not find any token boundary in ASCII data.");
+                }
+
+                // split into ranges starting at whitespace and count their tokens in parallel
+                size_t numRanges = std::max<size_t>(1, parseEnd / ASCII_GRAIN_SIZE);
+                std::vector<size_t> bounds(numRanges + 1, parseEnd);
+                bounds[0] = 0;
+                for (size_t i = 1; i < numRanges; ++i) {
+                    size_t b = std::max(bounds[i - 1], i * parseEnd / numRanges);
+                    while (b < parseEnd && ! isWhitespace(buffer[b]))
+                        ++b;
+                    bounds[i] = b;
+                }
+
+                std::vector<size_t> offsets(numRanges + 1, 0);
+                tbb::parallel_for(tbb::blocked_range<size_t>(0, numRanges), [&] (const tbb::blocked_range<size_t>& range) {
+                    for (size_t i = range.begin(); i != range.end(); ++i)
+                        offsets[i + 1] = countTokens(&buffer[bounds[i]], &buffer[bounds[i + 1]]);
+                });
+                for (size_t i = 0; i < numRanges; ++i)
+                    offsets[i + 1] += offsets[i];
+
+                // if the chunk contains more tokens than needed, find the end of the last needed one
+                size_t numRemaining = numValues - numParsed;
+                size_t consumedEnd = parseEnd;
+                if (offsets[numRanges] > numRemaining) {
+                    size_t r = 0;
+                    while (offsets[r + 1] < numRemaining)
+                        ++r;
+
+                    const char* p = &buffer[bounds[r]];
+                    for (size_t count = offsets[r]; count < numRemaining; ++count) {
+                        while (isWhitespace(*p))
+                            ++p;
+                        while (! isWhitespace(*p) && *p != 0)
+                            ++p;
+                    }
+                    consumedEnd = p - &buffer[0];
+                }
+
+                // convert the tokens in parallel
+                tbb::atomic<bool> malformed;
+                malformed = false;
+                tbb::parallel_for(tbb::blocked_range<size_t>(0, numRanges), [&] (const tbb::blocked_range<size_t>& range) {
+                    for (size_t i = range.begin(); i != range.end(); ++i) {
+                        const char* p = &buffer[bounds[i]];
+                        const char* end = &buffer[0] + std::min(bounds[i + 1], consumedEnd);
+                        size_t index = numParsed + offsets[i];
+                        FILE_TYPE value;
+
+                        while (p < end) {
+                            if (isWhitespace(*p)) {
+                                ++p;
+                            }
+                            else if (parseNumber(p, value, IsIntegral())) {
+                                destination[index++] = static_cast<C_TYPE>(value);
+                            }
+                            else {
+                                malformed = true;
+                                return;
+                            }
+                        }
+                    }
+                });
+
+                if (malformed)
+                    throw cgt::Exception("Malformed number in ASCII data.");
+
+                numParsed += std::min(offsets[numRanges], numRemaining);
+
+                if (numParsed == numValues) {
+                    // hand the unparsed bytes back to the stream
+                    file.clear();
+                    file.seekg(-static_cast<std::streamoff>(length - consumedEnd), std::ios::cur);
+                }
+                else if (endOfFile) {
+                    throw cgt::Exception("Unexpected end of file while parsing ASCII data.");
+                }
+                else {
+                    buffer.erase(buffer.begin(), buffer.begin() + parseEnd);
+                    buffer.resize(length - parseEnd);
+                }
+            }
+        }
+
+        /**
+         * Reads \a numValues binary values of type FILE_TYPE from \a file into \a destination.
+         * Legacy VTK files store binary data in big endian, hence the values are swapped if necessary.
+         * \param   file            Stream to read from, must be opened in binary mode.
+         * \param   destination     Destination array with at least \a numValues elements.
+         * \param   numValues       Number of values to read.
+         */
+        template<typename FILE_TYPE, typename C_TYPE>
+        void readBinaryValues(std::istream& file, C_TYPE* destination, size_t numValues) {
+            // read straight into the destination if possible, otherwise into a staging buffer
+            std::vector<FILE_TYPE> staging(std::is_same<FILE_TYPE, C_TYPE>::value ? 0 : numValues);
+            FILE_TYPE* buffer = staging.empty() ? reinterpret_cast<FILE_TYPE*>(destination) : &staging.front();
+
+            file.read(reinterpret_cast<char*>(buffer), numValues * sizeof(FILE_TYPE));
+            if (static_cast<size_t>(file.gcount()) != numValues * sizeof(FILE_TYPE))
+                throw cgt::Exception("Unexpected end of file while reading binary data.");
+
+            bool swap = (EndianHelper::getLocalEndianness() != EndianHelper::IS_BIG_ENDIAN);
+            if (! swap && staging.empty())
+                return;
+
+            tbb::parallel_for(tbb::blocked_range<size_t>(0, numValues), [&] (const tbb::blocked_range<size_t>& range) {
+                for (size_t i = range.begin(); i != range.end(); ++i) {
+                    if (swap)
+                        EndianHelper::swapEndian<sizeof(FILE_TYPE)>(reinterpret_cast<char*>(buffer + i));
+                    if (! staging.empty())
+                        destination[i] = static_cast<C_TYPE>(buffer[i]);
+                }
+            });
+        }
+
+        /**
+         * Reads \a numValues values of type FILE_TYPE from \a file into \a destination.
+         * \param   file            Stream to read from, must be opened in binary mode.
+         * \param   destination     Destination array with at least \a numValues elements.
+         * \param   numValues       Number of values to read.
+         * \param   binary          Flag whether the data is stored in binary or ASCII format.
+         */
+        template<typename FILE_TYPE, typename C_TYPE>
+        void readValues(std::istream& file, C_TYPE* destination, size_t numValues, bool binary) {
+            if (numValues == 0)
+                return;
+
+            if (binary)
+                readBinaryValues<FILE_TYPE>(file, destination, numValues);
+            else
+                parseAsciiValues<FILE_TYPE>(file, destination, numValues);
+        }
+
+        /**
+         * Reads floating point values of the VTK data type \a dataType from \a file into \a destination.
+         * \param   file            Stream to read from, must be opened in binary mode.
+         * \param   dataType        VTK data type of the values in lower case, either "float" or "double".
+         * \param   destination     Destination array with at least \a numValues elements.
+         * \param   numValues       Number of values to read.
+         * \param   binary          Flag whether the data is stored in binary or ASCII format.
+         */
+        void readFloatValues(std::istream& file, const std::string& dataType, float* destination, size_t numValues, bool binary) {
+            if (dataType == "double")
+                readValues<double>(file, destination, numValues, binary);
+            else if (dataType == "float")
+                readValues<float>(file, destination, numValues, binary);
+            else
+                throw cgt::Exception("Unsupported data type '" + dataType + "' - expected float or double.");
+        }
+
+        /**
+         * Reads the image data of \a image from \a file and creates its local representation.
+         * \param   file        Stream to read from, must be opened in binary mode.
+         * \param   image       Image to create the representation for.
+         * \param   numPoints   Number of points (elements) stored in the file.
+         * \param   binary      Flag whether the data is stored in binary or ASCII format.
+         * \return  The created representation.
+         */
+        template<typename FILE_TYPE, typename BASETYPE, size_t NUMCHANNELS>
+        ImageRepresentationLocal* readImageData(std::istream& file, ImageData* image, size_t numPoints, bool binary) {
+            typedef typename GenericImageRepresentationLocal<BASETYPE, NUMCHANNELS>::ElementType ElementType;
+
+            ElementType* dataArray = new ElementType[std::max(numPoints, image->getNumElements())];
+            try {
+                readValues<FILE_TYPE>(file, reinterpret_cast<BASETYPE*>(dataArray), numPoints * NUMCHANNELS, binary);
+            }
+            catch (...) {
+                delete [] dataArray;
+                throw;
+            }
+
+            return GenericImageRepresentationLocal<BASETYPE, NUMCHANNELS>::create(image, dataArray);
+        }
+
+        template<typename FILE_TYPE, typename BASETYPE>
+        ImageRepresentationLocal* readImageData(std::istream& file, ImageData* image, size_t numPoints, bool binary) {
+            switch (image->getNumChannels()) {
+                case 1:
+                    return readImageData<FILE_TYPE, BASETYPE, 1>(file, image, numPoints, binary);
+                case 2:
+                    return readImageData<FILE_TYPE, BASETYPE, 2>(file, image, numPoints, binary);
+                case 3:
+                    return readImageData<FILE_TYPE, BASETYPE, 3>(file, image, numPoints, binary);
+                case 4:
+                    return readImageData<FILE_TYPE, BASETYPE, 4>(file, image, numPoints, binary);
+                default:
+                    return 0;
+            }
+        }
+    }
+
     const std::string VtkImageReader::loggerCat_ = "CAMPVis.modules.io.VtkImageReader";
 
     VtkImageReader::VtkImageReader() 
         : AbstractImageReader()
         , p_imageOffset("ImageOffset", "Image Offset in mm", cgt::vec3(0.f), cgt::vec3(-10000.f), cgt::vec3(10000.f), cgt::vec3(0.1f))
         , p_voxelSize("VoxelSize", "Voxel Size in mm", cgt::vec3(1.f), cgt::vec3(-100.f), cgt::vec3(100.f), cgt::vec3(0.1f))
+        , p_optimizeMesh("OptimizeMesh", "Optimize Mesh Vertices", true)
     {
         this->_ext.push_back("vtk");
         this->p_targetImageID.setValue("VtkImageReader.output");
@@ -55,6 +378,7 @@ namespace campvis {
         addProperty(p_targetImageID);
         addProperty(p_imageOffset);
         addProperty(p_voxelSize);
+        addProperty(p_optimizeMesh);
     }
 
     VtkImageReader::~VtkImageReader() {
@@ -67,9 +391,17 @@ namespace campvis {
         return StringUtils::trim(toReturn);
     }
 
+    std::string getNextNonEmptyLine(std::ifstream& file) {
+        std::string toReturn;
+        while (toReturn.empty() && file.good())
+            toReturn = getTrimmedLine(file);
+        return toReturn;
+    }
+
     void VtkImageReader::updateResult(DataContainer& data) {
         try {
-            std::ifstream file(p_url.getValue().c_str(), std::ifstream::in);
+            // open in binary mode, since the payload may be binary and we need reliable seeking
+            std::ifstream file(p_url.getValue().c_str(), std::ifstream::in | std::ifstream::binary);
             if (!file.is_open() || file.bad())
                 throw cgt::FileException("Could not open file " + p_url.getValue() + " for reading.", p_url.getValue());
 
@@ -82,20 +414,21 @@ namespace campvis {
             getTrimmedLine(file);
 
             // this line is the format
+            bool binary = false;
             curLine = StringUtils::lowercase(getTrimmedLine(file));
             if (curLine == "binary")
-                throw cgt::FileException("Binary data format currently unsupported.", p_url.getValue());
+                binary = true;
             else if (curLine != "ascii")
                 throw cgt::FileException("Unsupported format in vtk file - expected binary or ascii.", p_url.getValue());
 
             // now comes the dataset structure
-            curLine = StringUtils::lowercase(getTrimmedLine(file));
+            curLine = StringUtils::lowercase(getNextNonEmptyLine(file));
             std::vector<std::string> splitted = StringUtils::split(curLine, " ");
             if (splitted.size() == 2 && splitted[0] == "dataset") {
                 if (splitted[1] == "structured_points")
-                    parseStructuredPoints(data, file);
+                    parseStructuredPoints(data, file, binary);
                 else if (splitted[1] == "polydata")
-                    parsePolydata(data, file);
+                    parsePolydata(data, file, binary);
                 else 
                     throw cgt::FileException("Unsupported dataset structure in vtk file - expected \"DATASET STRUCTURED_POINTS\" or \"DATASET POLYDATA\".", p_url.getValue());
             }
@@ -114,7 +447,7 @@ namespace campvis {
         }
     }
 
-    void VtkImageReader::parseStructuredPoints(DataContainer& data, std::ifstream& file) throw (cgt::Exception, std::exception) {
+    void VtkImageReader::parseStructuredPoints(DataContainer& data, std::ifstream& file, bool binary) throw (cgt::Exception, std::exception) {
         // init optional parameters with sane default values
         size_t dimensionality = 3;
         cgt::svec3 size(static_cast<size_t>(0));
@@ -148,7 +481,7 @@ namespace campvis {
         }
 
         // now come the dataset attributes "POINT_DATA ..."
-        curLine = StringUtils::lowercase(getTrimmedLine(file));
+        curLine = StringUtils::lowercase(getNextNonEmptyLine(file));
         splitted = StringUtils::split(curLine, " ");
         if (splitted.size() != 2 || splitted[0] != "point_data")
             throw cgt::FileException("Unsupported dataset attribute '" + splitted[0] + "' in vtk file - expected \"POINT_DATA n\".", p_url.getValue());
@@ -158,62 +491,64 @@ namespace campvis {
             throw cgt::FileException("Number of points in dataset (" + splitted[0] + ") doesn't match dimensions: " + StringUtils::toString(size), p_url.getValue());
 
         // now comes the data description block "FIELD ..."
-        curLine = StringUtils::lowercase(getTrimmedLine(file));
+        curLine = StringUtils::lowercase(getNextNonEmptyLine(file));
         splitted = StringUtils::split(curLine, " ");
         if (splitted.size() != 3 || splitted[0] != "field")
             throw cgt::FileException("Unsupported dataset attribute '" + splitted[0] + "' in vtk file - expected \"FIELD ...\".", p_url.getValue());
         size_t numArrays = StringUtils::fromString<size_t>(splitted[2]);
 
-        if (numArrays != 1)
-            throw cgt::FileException("Multiple arrays in data set currently not supported - too lazy...", p_url.getValue());
+        // Each array is described by "arrayName numComponents numTuples dataType" followed by the data.
+        // The first array is stored as p_targetImageID, all further ones as p_targetImageID.arrayName.
+        for (size_t arrayIndex = 0; arrayIndex < numArrays; ++arrayIndex) {
+            curLine = getNextNonEmptyLine(file);
+            splitted = StringUtils::split(curLine, " ");
+            if (splitted.size() != 4)
+                throw cgt::FileException("Unexpected array description '" + curLine + "' in vtk file - expected \"arrayName numComponents numTuples dataType\".", p_url.getValue());
 
-        curLine = StringUtils::lowercase(getTrimmedLine(file));
-        splitted = StringUtils::split(curLine, " ");
-        size_t numTuples = StringUtils::fromString<size_t>(splitted[1]);
-        size_t numProcessors = StringUtils::fromString<size_t>(splitted[2]);
+            std::string arrayName = splitted[0];
+            size_t numComponents = StringUtils::fromString<size_t>(splitted[1]);
+            size_t numTuples = StringUtils::fromString<size_t>(splitted[2]);
+            std::string dataType = StringUtils::lowercase(splitted[3]);
 
-        if (numTuples * numProcessors != numPoints)
-            throw cgt::FileException("Number of points in dataset doesn't match dimensions of data field", p_url.getValue());
+            if (numTuples != numPoints)
+                throw cgt::FileException("Number of points in dataset doesn't match dimensions of data field " + arrayName, p_url.getValue());
+            if (numComponents < 1 || numComponents > 4)
+                throw cgt::FileException("Unsupported number of components in data field " + arrayName + " - expected 1 to 4.", p_url.getValue());
 
-        ImageData* image = new ImageData(dimensionality, size, 1);
-        ImageRepresentationLocal* rep = 0;
+            std::unique_ptr<ImageData> image(new ImageData(dimensionality, size, numComponents));
+            ImageRepresentationLocal* rep = 0;
 
-#define DISPATCH_PARSING(VTK_TYPE, C_TYPE, TMP_TYPE) \
+#define DISPATCH_PARSING(VTK_TYPE, C_TYPE, FILE_TYPE) \
     do { \
-        if (splitted[3] == VTK_TYPE) { \
-            C_TYPE* dataArray = new C_TYPE[numPoints]; \
-            TMP_TYPE tmp; \
-            for (size_t i = 0; i < numPoints && file.good(); ++i) { \
-                file >> tmp; \
-                dataArray[i] = static_cast<C_TYPE>(tmp); \
-            } \
-            rep = GenericImageRepresentationLocal<C_TYPE, 1>::create(image, dataArray); \
-        } \
+        if (rep == 0 && dataType == VTK_TYPE) \
+            rep = readImageData<FILE_TYPE, C_TYPE>(file, image.get(), numPoints, binary); \
     } while (0)
 
-        DISPATCH_PARSING("unsigned_char"    , uint8_t, uint16_t);
-        DISPATCH_PARSING("char"             , int8_t, int16_t);
-        DISPATCH_PARSING("unsigned_short"   , uint16_t, uint16_t);
-        DISPATCH_PARSING("short"            , int16_t, int16_t);
-        DISPATCH_PARSING("unsigned_int"     , uint32_t, uint32_t);
-        DISPATCH_PARSING("int"              , int32_t, int32_t);
-        DISPATCH_PARSING("float"            , float, float);
-
-        if (rep != 0) {
-            // all parsing done - lets create the image:
-            image->setMappingInformation(ImageMappingInformation(size, imageOffset + p_imageOffset.getValue(), voxelSize + p_voxelSize.getValue()));
-            data.addData(p_targetImageID.getValue(), image);
-        }
-        else {
-            throw cgt::FileException("Error while parsing the data.", p_url.getValue());
+            DISPATCH_PARSING("unsigned_char"    , uint8_t, uint8_t);
+            DISPATCH_PARSING("char"             , int8_t, int8_t);
+            DISPATCH_PARSING("unsigned_short"   , uint16_t, uint16_t);
+            DISPATCH_PARSING("short"            , int16_t, int16_t);
+            DISPATCH_PARSING("unsigned_int"     , uint32_t, uint32_t);
+            DISPATCH_PARSING("int"              , int32_t, int32_t);
+            DISPATCH_PARSING("float"            , float, float);
+            DISPATCH_PARSING("double"           , float, double);
+
+            if (rep != 0) {
+                // all parsing done - lets create the image:
+                image->setMappingInformation(ImageMappingInformation(size, imageOffset + p_imageOffset.getValue(), voxelSize + p_voxelSize.getValue()));
+                data.addData((arrayIndex == 0) ? p_targetImageID.getValue() : p_targetImageID.getValue() + "." + arrayName, image.release());
+            }
+            else {
+                throw cgt::FileException("Error while parsing the data of field " + arrayName + ".", p_url.getValue());
+            }
         }
     }
 
-    void VtkImageReader::parsePolydata(DataContainer& data, std::ifstream& file) throw (cgt::Exception, std::exception) {
+    void VtkImageReader::parsePolydata(DataContainer& data, std::ifstream& file, bool binary) throw (cgt::Exception, std::exception) {
         std::string curLine;
         std::vector<std::string> splitted;
 
-        std::vector<uint16_t> indices;
+        std::vector<uint32_t> indices;
         std::vector<cgt::vec3> vertices;
         std::vector<cgt::vec3> normals;
 
@@ -224,46 +559,70 @@ namespace campvis {
             if (splitted.size() == 3 && splitted[0] == "points") {
                 size_t numVertices = StringUtils::fromString<size_t>(splitted[1]);
                 vertices.resize(numVertices, cgt::vec3(0.f));
-
-                // TODO: make parsing more robust...
-                for (size_t i = 0; i < numVertices; ++i) {
-                    file >> vertices[i].x >> vertices[i].y >> vertices[i].z;
-                }
+                if (numVertices > 0)
+                    readFloatValues(file, splitted[2], vertices.front().elem, 3 * numVertices, binary);
             }
             else if (splitted.size() == 3 && splitted[0] == "polygons") {
                 size_t numPolygons = StringUtils::fromString<size_t>(splitted[1]);
                 size_t numIndices = StringUtils::fromString<size_t>(splitted[2]);
-                indices.resize(numIndices, 0);
-                size_t i = 0;
-
-                // TODO: make parsing more robust...
-                for (size_t j = 0; j < numPolygons && i < numIndices; ++j) {
-                    int tmp;
-                    file >> tmp >> indices[i++];
-                    file >> indices[i++];
-                    file >> indices[i++];
+                std::vector<int32_t> cells(numIndices, 0);
+                readValues<int32_t>(file, cells.data(), numIndices, binary);
+
+                // each cell is stored as its number of points followed by the point indices, polygons are triangulated as fans
+                indices.reserve(3 * numIndices);
+                for (size_t j = 0, i = 0; j < numPolygons && i < numIndices; ++j) {
+                    if (cells[i] < 0)
+                        throw cgt::FileException("Polygon with negative number of points in vtk file.", p_url.getValue());
+                    size_t numCellPoints = static_cast<size_t>(cells[i++]);
+                    if (numCellPoints > numIndices - i)
+                        throw cgt::FileException("Polygon exceeds the given number of indices in vtk file.", p_url.getValue());
+                    for (size_t k = 0; k < numCellPoints; ++k) {
+                        if (cells[i + k] < 0)
+                            throw cgt::FileException("Polygon references a negative point index in vtk file.", p_url.getValue());
+                    }
+
+                    for (size_t k = 2; k < numCellPoints; ++k) {
+                        indices.push_back(static_cast<uint32_t>(cells[i]));
+                        indices.push_back(static_cast<uint32_t>(cells[i + k - 1]));
+                        indices.push_back(static_cast<uint32_t>(cells[i + k]));
+                    }
+                    i += numCellPoints;
                 }
             }
             if (splitted.size() == 2 && splitted[0] == "point_data") {
                 size_t numPoints = StringUtils::fromString<size_t>(splitted[1]);
 
-                curLine = StringUtils::lowercase(getTrimmedLine(file));
+                curLine = StringUtils::lowercase(getNextNonEmptyLine(file));
                 splitted = StringUtils::split(curLine, " ");
 
                 if (splitted.size() == 3 && splitted[0] == "normals") {
                     normals.resize(numPoints, cgt::vec3(0.f));
-
-                    // TODO: make parsing more robust...
-                    for (size_t i = 0; i < numPoints; ++i) {
-                        file >> normals[i].x >> normals[i].y >> normals[i].z;
-                    }
+                    if (numPoints > 0)
+                        readFloatValues(file, splitted[2], normals.front().elem, 3 * numPoints, binary);
                 }
             }
         }
 
+        for (size_t i = 0; i < indices.size(); ++i) {
+            if (indices[i] >= vertices.size())
+                throw cgt::FileException("Polygon references a point that does not exist in vtk file.", p_url.getValue());
+        }
+        if (! normals.empty() && normals.size() != vertices.size())
+            throw cgt::FileException("Number of normals does not match number of points in vtk file.", p_url.getValue());
+
+        if (p_optimizeMesh.getValue()) {
+            // reorder the triangles for the vertex cache first, so that the deduplication sorts the vertices by their first use
+            size_t numVertices = vertices.size();
+            indices = MeshOptimizer::optimizeVertexCache(indices, numVertices);
+
+            std::vector<cgt::vec3> texCoords;
+            std::vector<cgt::vec4> colors;
+            MeshOptimizer::deduplicateVertices(indices, vertices, texCoords, colors, normals);
+            LDEBUG("Optimized mesh: " << numVertices << " -> " << vertices.size() << " vertices, " << indices.size() / 3 << " triangles.");
+        }
+
         // all parsing done - lets create the image:
         IndexedMeshGeometry* g = new IndexedMeshGeometry(indices, vertices, std::vector<cgt::vec3>(), std::vector<cgt::vec4>(), normals);
         data.addData(p_targetImageID.getValue(), g);
     }
-    
 }
\ No newline at end of file
@@ -32,12 +32,15 @@
 #include "core/pipeline/abstractprocessor.h"
 #include "core/properties/datanameproperty.h"
 #include "core/properties/floatingpointproperty.h"
+#include "core/properties/genericproperty.h"
 
 #include "modules/modulesapi.h"
 
 namespace campvis {
     /**
      * Reads a VTK image file into the pipeline.
+     * Supports legacy VTK files in ASCII and BINARY format containing either STRUCTURED_POINTS 
+     * with one or more FIELD arrays or POLYDATA. ASCII data is parsed in parallel.
      *
      * \note    Full format specification at http://www.vtk.org/VTK/img/file-formats.pdf
      */
@@ -61,17 +64,35 @@ namespace campvis {
         virtual const std::string getAuthor() const { return "Christian Schulte zu Berge <christian.szb@in.tum.de>"; };
         /// \see AbstractProcessor::getProcessorState()
         virtual ProcessorState getProcessorState() const { return AbstractProcessor::EXPERIMENTAL; };
+        /// \see AbstractProcessor::supportsConcurrentExecution()
+        virtual bool supportsConcurrentExecution() const { return true; };
         
         Vec3Property p_imageOffset;         ///< Image Offset in mm
         Vec3Property p_voxelSize;           ///< Voxel Size in mm
+        BoolProperty p_optimizeMesh;        ///< Flag whether to deduplicate and reorder the vertices of POLYDATA meshes
 
     protected:
         /// \see AbstractProcessor::updateResult
         virtual void updateResult(DataContainer& dataContainer);
 
-        void parseStructuredPoints(DataContainer& data, std::ifstream& file) throw (cgt::Exception, std::exception);
+        /**
+         * Parses a STRUCTURED_POINTS dataset and stores each of its FIELD arrays as image.
+         * The first array is stored as p_targetImageID, all further ones as p_targetImageID.arrayName.
+         * \param   data    DataContainer to store the images in.
+         * \param   file    File to read from, positioned after the DATASET line, must be opened in binary mode.
+         * \param   binary  Flag whether the data is stored in binary (big endian) or ASCII format.
+         */
+        void parseStructuredPoints(DataContainer& data, std::ifstream& file, bool binary) throw (cgt::Exception, std::exception);
 
-        void parsePolydata(DataContainer& data, std::ifstream& file) throw (cgt::Exception, std::exception);
+        /**
+         * Parses a POLYDATA dataset and stores it as IndexedMeshGeometry.
+         * If p_optimizeMesh is set, duplicate vertices are merged and the triangles are 
+         * reordered for the GPU's vertex cache.
+         * \param   data    DataContainer to store the geometry in.
+         * \param   file    File to read from, positioned after the DATASET line, must be opened in binary mode.
+         * \param   binary  Flag whether the data is stored in binary (big endian) or ASCII format.
+         */
+        void parsePolydata(DataContainer& data, std::ifstream& file, bool binary) throw (cgt::Exception, std::exception);
 
         static const std::string loggerCat_;
     };
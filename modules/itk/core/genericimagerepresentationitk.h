@@ -29,10 +29,13 @@
 #include "core/datastructures/imagedata.h"
 #include "core/tools/weaklytypedpointer.h"
 #include "modules/itk/core/itktypetraits.h"
+#include "modules/itk/core/sharedimportimagecontainer.h"
 
 #include <itkImage.h>
+#include <tbb/spin_mutex.h>
 
 #include <cstring>  // needed for memcpy
+#include <memory>
 
 namespace campvis {
     /**
@@ -200,6 +203,10 @@ namespace campvis {
 
         /**
          * Returns a pointer to the itk image.
+         * \note    If the pixel buffer is shared with a GenericImageRepresentationLocal (see 
+         *          isBufferShared()), it is copied first so that the returned image may be modified
+         *          (copy-on-write). Filters working in-place on an image obtained via the const 
+         *          getItkImage() bypass this mechanism - don't do that.
          * \return  _itkImage
          */
         typename ItkImageType::Pointer getItkImage();
@@ -210,6 +217,20 @@ namespace campvis {
          */
         typename ItkImageType::ConstPointer getItkImage() const;
 
+        /**
+         * Returns shared ownership of the pixel buffer of the ITK image, so that it can be aliased
+         * by a GenericImageRepresentationLocal without copying it. The buffer stays valid as long
+         * as the returned pointer is alive, even if this representation copies its buffer on write.
+         * \return  Object keeping the pixel buffer of _itkImage alive.
+         */
+        std::shared_ptr<void> getBufferOwner() const;
+
+        /**
+         * Returns whether the pixel buffer of the ITK image is currently shared with another image representation.
+         * \return  True if writing to the buffer would affect another representation.
+         */
+        bool isBufferShared() const;
+
     protected:
         /**
          * Creates a new strongly typed ImageData object storing the image in the local memory.
@@ -219,8 +240,16 @@ namespace campvis {
          */
         GenericImageRepresentationItk(ImageData* parent, typename ItkImageType::Pointer itkImage);
 
+        /**
+         * Replaces the pixel container of _itkImage by a private copy if the buffer is shared.
+         */
+        void makeBufferUnique();
+
         typename ItkImageType::Pointer _itkImage;
 
+        mutable std::shared_ptr<void> _bufferOwner;     ///< Shared ownership of _itkImage's pixel container handed out by getBufferOwner(), may be 0
+        mutable tbb::spin_mutex _bufferOwnerMutex;      ///< Mutex protecting _bufferOwner
+
     };
 
 // = Template implementation ======================================================================
@@ -270,6 +299,7 @@ namespace campvis {
 
     template<typename BASETYPE, size_t NUMCHANNELS, size_t DIMENSIONALITY>
     typename GenericImageRepresentationItk<BASETYPE, NUMCHANNELS, DIMENSIONALITY>::ItkImageType::Pointer campvis::GenericImageRepresentationItk<BASETYPE, NUMCHANNELS, DIMENSIONALITY>::getItkImage() {
+        makeBufferUnique();
         return _itkImage;
     }
 
@@ -277,6 +307,48 @@ namespace campvis {
     typename GenericImageRepresentationItk<BASETYPE, NUMCHANNELS, DIMENSIONALITY>::ItkImageType::ConstPointer campvis::GenericImageRepresentationItk<BASETYPE, NUMCHANNELS, DIMENSIONALITY>::getItkImage() const {
         return typename ItkImageType::ConstPointer(_itkImage);
     }
+
+    template<typename BASETYPE, size_t NUMCHANNELS, size_t DIMENSIONALITY>
+    std::shared_ptr<void> campvis::GenericImageRepresentationItk<BASETYPE, NUMCHANNELS, DIMENSIONALITY>::getBufferOwner() const {
+        typedef typename ItkImageType::PixelContainerConstPointer ContainerPointer;
+
+        tbb::spin_mutex::scoped_lock lock(_bufferOwnerMutex);
+        if (_bufferOwner == nullptr)
+            _bufferOwner = std::shared_ptr<ContainerPointer>(new ContainerPointer(_itkImage->GetPixelContainer()));
+        return _bufferOwner;
+    }
+
+    template<typename BASETYPE, size_t NUMCHANNELS, size_t DIMENSIONALITY>
+    bool campvis::GenericImageRepresentationItk<BASETYPE, NUMCHANNELS, DIMENSIONALITY>::isBufferShared() const {
+        typedef SharedImportImageContainer<typename ItkImageType::PixelContainer::ElementIdentifier, typename ItkImageType::PixelType> SharedContainerType;
+
+        {
+            tbb::spin_mutex::scoped_lock lock(_bufferOwnerMutex);
+            if (_bufferOwner.use_count() > 1)
+                return true;
+        }
+
+        const SharedContainerType* sharedContainer = dynamic_cast<const SharedContainerType*>(_itkImage->GetPixelContainer());
+        return (sharedContainer != nullptr && sharedContainer->IsShared());
+    }
+
+    template<typename BASETYPE, size_t NUMCHANNELS, size_t DIMENSIONALITY>
+    void campvis::GenericImageRepresentationItk<BASETYPE, NUMCHANNELS, DIMENSIONALITY>::makeBufferUnique() {
+        if (! isBufferShared())
+            return;
+
+        typedef typename ItkImageType::PixelContainer PixelContainer;
+        const PixelContainer* oldContainer = _itkImage->GetPixelContainer();
+
+        typename PixelContainer::Pointer newContainer = PixelContainer::New();
+        newContainer->Reserve(oldContainer->Size());
+        memcpy(newContainer->GetBufferPointer(), oldContainer->GetBufferPointer(), oldContainer->Size() * sizeof(typename ItkImageType::PixelType));
+        _itkImage->SetPixelContainer(newContainer);
+
+        // whoever shares the old buffer keeps it alive on its own
+        tbb::spin_mutex::scoped_lock lock(_bufferOwnerMutex);
+        _bufferOwner.reset();
+    }
 }
 
 #endif // GENERICIMAGEREPRESENTATIONITK_H__
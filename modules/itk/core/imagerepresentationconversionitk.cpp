@@ -58,19 +58,9 @@ namespace campvis {
             typedef GenericImageRepresentationItk<basetype, numchannels, dimensionality>::ElementType ElementType; \
             const ItkElementType* pixelData = tester->getItkImage()->GetBufferPointer(); \
             \
-            ItkImageType::RegionType region; \
-            region = tester->getItkImage()->GetBufferedRegion(); \
-            \
-            ItkImageType::SizeType s = region.GetSize(); \
-            cgt::svec3 size(s[0], 1, 1); \
-            if (dimensionality >= 2) \
-                size.y = s[1]; \
-            if (dimensionality == 3) \
-                size.z = s[2]; \
-            \
-            ElementType* pixelDataCopy = new ElementType[cgt::hmul(size)]; \
-            memcpy(pixelDataCopy, pixelData, cgt::hmul(size) * TypeTraits<basetype, numchannels>::elementSize); \
-            return GenericImageRepresentationLocal<basetype, numchannels>::create(const_cast<ImageData*>(source->getParent()), pixelDataCopy); \
+            /* alias the ITK buffer instead of copying it, both sides copy it before writing as long as it is shared */ \
+            ElementType* sharedPixelData = const_cast<ElementType*>(reinterpret_cast<const ElementType*>(pixelData)); \
+            return GenericImageRepresentationLocal<basetype, numchannels>::create(const_cast<ImageData*>(source->getParent()), sharedPixelData, tester->getBufferOwner()); \
         }
 
 #define DISPATCH_ITK_TO_GENERIC_LOCAL_CONVERSION_ND(numchannels, dimensionality) \
@@ -35,8 +35,7 @@
 #include "core/datastructures/genericimagerepresentationlocal.h"
 
 #include "modules/itk/core/genericimagerepresentationitk.h"
-
-#include <itkImportImageFilter.h>
+#include "modules/itk/core/sharedimportimagecontainer.h"
 
 namespace campvis {
 
@@ -114,10 +113,9 @@ namespace campvis {
                 return nullptr;
 
             // we perform the conversion in two steps to reuse existing code:
-            // We first convert to ImageRepresentationLocal of matching type, which we then convert 
-            // to the target type if necessary.
-            // This is not very efficient in terms of performance (costs twice CPU and RAM) but
-            // needs very little code. :)
+            // We first convert to ImageRepresentationLocal of matching type, which shares the 
+            // ITK pixel buffer and hence is cheap. Only if the type does not match, we then 
+            // convert to the target type, which costs a copy.
             ImageRepresentationLocal* localRepWithMatchingType = LocalFromItkConversion::tryConvertFrom(source);
 
             // check whether type already matches
@@ -144,7 +142,8 @@ namespace campvis {
             typedef typename GenericImageRepresentationItk<BASETYPE, NUMCHANNELS, DIMENSIONALITY>::ItkImageType ItkImageType;
 
             if (const GenericImageRepresentationLocal<BASETYPE, NUMCHANNELS>* tester = dynamic_cast< const GenericImageRepresentationLocal<BASETYPE, NUMCHANNELS>* >(source)) {
-                typename itk::ImportImageFilter<ItkElementType, DIMENSIONALITY>::Pointer importer = itk::ImportImageFilter<ItkElementType, DIMENSIONALITY>::New();
+                typedef typename ItkImageType::PixelType PixelType;
+                typedef SharedImportImageContainer<typename ItkImageType::PixelContainer::ElementIdentifier, PixelType> ContainerType;
 
                 typename ItkImageType::SizeType size;
                 size[0] = tester->getSize().x;
@@ -159,21 +158,21 @@ namespace campvis {
                 typename ItkImageType::RegionType region;
                 region.SetSize(size);
                 region.SetIndex(start);
-                importer->SetRegion(region);
-
-                importer->SetSpacing(tester->getParent()->getMappingInformation().getVoxelSize().elem);
-                importer->SetOrigin(tester->getParent()->getMappingInformation().getOffset().elem);
 
-                typedef typename ItkImageType::PixelType PixelType;
+                // alias the local buffer instead of copying it, the container keeps it alive.
+                // Both sides copy the buffer before writing to it as long as it is shared.
+                // (const_cast is valid here since nobody writes to shared memory)
                 const PixelType* pixelData = reinterpret_cast<const PixelType*>(tester->getImageData());
-                importer->SetImportPointer(const_cast<PixelType*>(pixelData), tester->getNumElements(), false);
-                importer->Update();
-
-                typename ItkImageType::Pointer itkImage = importer->GetOutput();
-                if (itkImage.IsNotNull())
-                    return GenericImageRepresentationItk<BASETYPE, NUMCHANNELS, DIMENSIONALITY>::create(const_cast<ImageData*>(tester->getParent()), itkImage); // const_cast perfectly valid here
-                else
-                    return nullptr;
+                typename ContainerType::Pointer container = ContainerType::New();
+                container->SetSharedImportPointer(const_cast<PixelType*>(pixelData), tester->getNumElements(), tester->getDataOwner());
+
+                typename ItkImageType::Pointer itkImage = ItkImageType::New();
+                itkImage->SetRegions(region);
+                itkImage->SetSpacing(tester->getParent()->getMappingInformation().getVoxelSize().elem);
+                itkImage->SetOrigin(tester->getParent()->getMappingInformation().getOffset().elem);
+                itkImage->SetPixelContainer(container);
+
+                return GenericImageRepresentationItk<BASETYPE, NUMCHANNELS, DIMENSIONALITY>::create(const_cast<ImageData*>(tester->getParent()), itkImage); // const_cast perfectly valid here
             }
 
             return nullptr;
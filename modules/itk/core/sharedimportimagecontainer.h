@@ -0,0 +1,95 @@
+// ================================================================================================
+// 
+// This file is part of the CAMPVis Software Framework.
+// 
+// If not explicitly stated otherwise: Copyright (C) 2012-2015, all rights reserved,
+//      Christian Schulte zu Berge <christian.szb@in.tum.de>
+//      Chair for Computer Aided Medical Procedures
+//      Technische Universitaet Muenchen
+//      Boltzmannstr. 3, 85748 Garching b. Muenchen, Germany
+// 
+// For a full list of authors and contributors, please refer to the file "AUTHORS.txt".
+// 
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file 
+// except in compliance with the License. You may obtain a copy of the License at
+// 
+// http://www.apache.org/licenses/LICENSE-2.0
+// 
+// Unless required by applicable law or agreed to in writing, software distributed under the 
+// License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, 
+// either express or implied. See the License for the specific language governing permissions 
+// and limitations under the License.
+// 
+// ================================================================================================
+
+
+#ifndef SHAREDIMPORTIMAGECONTAINER_H__
+#define SHAREDIMPORTIMAGECONTAINER_H__
+
+#include <itkImportImageContainer.h>
+
+#include <memory>
+
+namespace campvis {
+    /**
+     * ITK pixel container aliasing memory that is owned by someone else.
+     * In contrast to itk::ImportImageContainer with LetContainerManageMemory set to false, this
+     * container holds shared ownership of the imported memory, so that it stays valid as long as 
+     * the container (i.e. the ITK image) is alive. This allows to hand the buffer of a 
+     * GenericImageRepresentationLocal to ITK without copying it.
+     * 
+     * \tparam  TElementIdentifier  Type used to index the elements, see itk::ImportImageContainer
+     * \tparam  TElement            Type of a single pixel, see itk::ImportImageContainer
+     */
+    template<typename TElementIdentifier, typename TElement>
+    class SharedImportImageContainer : public itk::ImportImageContainer<TElementIdentifier, TElement> {
+    public:
+        typedef SharedImportImageContainer                                  Self;
+        typedef itk::ImportImageContainer<TElementIdentifier, TElement>     Superclass;
+        typedef itk::SmartPointer<Self>                                     Pointer;
+        typedef itk::SmartPointer<const Self>                               ConstPointer;
+
+        itkNewMacro(Self);
+        itkTypeMacro(SharedImportImageContainer, ImportImageContainer);
+
+        /**
+         * Sets the memory this container aliases.
+         * \param   ptr     Pointer to the memory to import, must stay valid as long as \a owner is alive.
+         * \param   num     Number of elements in \a ptr.
+         * \param   owner   Object owning the memory of \a ptr, this container keeps it alive.
+         */
+        void SetSharedImportPointer(TElement* ptr, TElementIdentifier num, std::shared_ptr<void> owner) {
+            this->SetImportPointer(ptr, num, false);
+            _owner = owner;
+        }
+
+        /**
+         * Returns the owner of the imported memory.
+         * \return  _owner
+         */
+        std::shared_ptr<void> GetOwner() const {
+            return _owner;
+        }
+
+        /**
+         * Returns whether somebody else (i.e. the originating representation) shares the imported memory.
+         * \return  _owner.use_count() > 1
+         */
+        bool IsShared() const {
+            return _owner.use_count() > 1;
+        }
+
+    protected:
+        SharedImportImageContainer() {};
+        virtual ~SharedImportImageContainer() {};
+
+    private:
+        SharedImportImageContainer(const Self&); // not implemented
+        void operator=(const Self&); // not implemented
+
+        std::shared_ptr<void> _owner;       ///< Owner of the imported memory
+    };
+
+}
+
+#endif // SHAREDIMPORTIMAGECONTAINER_H__
@@ -25,6 +25,13 @@
 #include "ivusbatchreader.h"
 
 #include <IL/il.h>
+#include <IL/ilu.h>
+#include <tbb/tbb.h>
+
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <new>
 
 #include "cgt/logmanager.h"
 #include "cgt/filesystem.h"
@@ -32,7 +39,59 @@
 #include "core/tools/stringutils.h"
 
 namespace campvis {
+
+    namespace {
+        /// Relevant fields of an uncompressed BMP header
+        struct BmpInfo {
+            size_t _dataOffset;     ///< Offset of the pixel data in the file
+            size_t _headerSize;     ///< Size of the info header
+            int _width;             ///< Image width
+            int _height;            ///< Image height (always positive)
+            bool _topDown;          ///< Flag whether rows are stored top-down
+            int _bitsPerPixel;      ///< Bits per pixel, one of 8, 24, 32
+            size_t _numColors;      ///< Number of palette entries, 0 means default
+        };
+
+        inline uint32_t readLE32(const uint8_t* p) {
+            return static_cast<uint32_t>(p[0]) | (static_cast<uint32_t>(p[1]) << 8) | (static_cast<uint32_t>(p[2]) << 16) | (static_cast<uint32_t>(p[3]) << 24);
+        }
+
+        inline uint16_t readLE16(const uint8_t* p) {
+            return static_cast<uint16_t>(p[0] | (p[1] << 8));
+        }
+
+        /**
+         * Parses the header of an uncompressed 8/24/32 bit BMP file.
+         * \return  False if the data is no BMP file or uses an unsupported encoding.
+         */
+        bool parseBmpHeader(const uint8_t* data, size_t length, BmpInfo& info) {
+            if (length < 54 || data[0] != 'B' || data[1] != 'M')
+                return false;
+
+            info._dataOffset = readLE32(data + 10);
+            info._headerSize = readLE32(data + 14);
+            int32_t height = static_cast<int32_t>(readLE32(data + 22));
+            info._width = static_cast<int32_t>(readLE32(data + 18));
+            info._height = std::abs(height);
+            info._topDown = (height < 0);
+            info._bitsPerPixel = readLE16(data + 28);
+            uint32_t compression = readLE32(data + 30);
+            info._numColors = readLE32(data + 46);
+
+            // only BI_RGB is supported, everything else is left to DevIL
+            if (info._headerSize < 40 || compression != 0 || info._width <= 0 || info._height == 0)
+                return false;
+            return (info._bitsPerPixel == 8 || info._bitsPerPixel == 24 || info._bitsPerPixel == 32);
+        }
+
+        /// Converts RGB to luminance using the same weights as DevIL's IL_LUMINANCE conversion.
+        inline uint8_t toLuminance(uint8_t r, uint8_t g, uint8_t b) {
+            return static_cast<uint8_t>(0.212671f * r + 0.715160f * g + 0.072169f * b);
+        }
+    }
+
     const std::string IvusBatchReader::loggerCat_ = "CAMPVis.modules.vis.IvusBatchReader";
+    tbb::mutex IvusBatchReader::_devilMutex;
 
     IvusBatchReader::IvusBatchReader(IVec2Property* viewportSizeProp)
         : VisualizationProcessor(viewportSizeProp)
@@ -63,55 +122,55 @@ namespace campvis {
 
         std::vector<std::string> files = cgt::FileSystem::listFiles(p_inputDirectory.getValue(), true);
         files.erase(std::remove_if(files.begin(), files.end(), [&] (const std::string& s) -> bool { return cgt::FileSystem::fileExtension(s, true) != ext; } ), files.end());
+        if (files.empty()) {
+            LERROR("No images with extension '" << ext << "' found in " << p_inputDirectory.getValue());
+            return;
+        }
 
-        cgt::ivec3 imageSize(0, 0, static_cast<int>(files.size()));
-        uint8_t* buffer = nullptr;
+        for (size_t i = 0; i < files.size(); ++i)
+            files[i] = p_inputDirectory.getValue() + "/" + files[i];
 
-        for (size_t i = 0; i < files.size(); ++i) {
-            std::string filename = p_inputDirectory.getValue() + "/" + files[i];
+        // determine the volume size from the first image, so that we can allocate the whole buffer up front
+        cgt::ivec2 sliceSize;
+        if (! readBmpHeader(files.front(), sliceSize, nullptr) && ! readDevilSize(files.front(), sliceSize)) {
+            LERROR("Could not load image: " << files.front());
+            return;
+        }
 
-            // prepare DevIL
-            ILuint img;
-            ilGenImages(1, &img);
-            ilBindImage(img);
+        cgt::ivec3 imageSize(sliceSize.x, sliceSize.y, static_cast<int>(files.size()));
+        const size_t numBytesPerSlice = sizeof(uint8_t) * sliceSize.x * sliceSize.y;
+        LINFO("Loading " << files.size() << " images of size " << sliceSize << ", allocating " << (numBytesPerSlice * files.size()) / (1024*1024) << " MB.");
 
-            // try load file
-            if (! ilLoadImage(filename.c_str())) {
-                LERROR("Could not load image: " << filename);
-                delete [] buffer;
-                return;
-            }
+        uint8_t* buffer = new (std::nothrow) uint8_t[numBytesPerSlice * files.size()];
+        if (buffer == nullptr) {
+            LERROR("Could not allocate memory for " << files.size() << " images.");
+            return;
+        }
 
-            // prepare buffer and perform dimensions check
-            if (i == 0) {
-                imageSize.x = ilGetInteger(IL_IMAGE_WIDTH);
-                imageSize.y = ilGetInteger(IL_IMAGE_HEIGHT);
+        // decode all images concurrently directly into their slices
+        tbb::atomic<size_t> numLoaded;
+        tbb::atomic<bool> failed;
+        numLoaded = 0;
+        failed = false;
 
-                buffer = new uint8_t[cgt::hmul(imageSize)];
-            }
-            else {
-                if (imageSize.x != ilGetInteger(IL_IMAGE_WIDTH)) {
-                    LERROR("Could not load images: widths do not match!");
-                    delete [] buffer;
-                    return;
-                }
-                if (imageSize.y != ilGetInteger(IL_IMAGE_HEIGHT)) {
-                    LERROR("Could not load images: heights do not match!");
-                    delete [] buffer;
+        tbb::parallel_for(tbb::blocked_range<size_t>(0, files.size()), [&] (const tbb::blocked_range<size_t>& range) {
+            std::vector<uint8_t> fileBuffer;
+            for (size_t i = range.begin(); i != range.end() && !failed; ++i) {
+                uint8_t* slice = buffer + i * numBytesPerSlice;
+                // only fall back to DevIL for files we cannot decode natively, errors have been reported already
+                BmpResult result = readBmp(files[i], sliceSize, slice, fileBuffer);
+                if (result == BMP_FAILED || (result == BMP_UNSUPPORTED && ! readDevil(files[i], sliceSize, slice))) {
+                    failed = true;
                     return;
                 }
-            }
 
-            // get data from image and transform to single intensity image:
-            ilCopyPixels(0, 0, 0, imageSize.x, imageSize.y, 1, IL_LUMINANCE, IL_UNSIGNED_BYTE, buffer + (sizeof(uint8_t) * i * imageSize.x * imageSize.y));
-            ILint err = ilGetError();
-            if (err != IL_NO_ERROR) {
-                LERROR("Error during conversion: " << iluErrorString(err));
-                delete [] buffer;
-                return;
+                s_progress.emitSignal(++numLoaded, files.size());
             }
+        });
 
-            ilDeleteImage(img);
+        if (failed) {
+            delete [] buffer;
+            return;
         }
 
         ImageData* id = new ImageData(3, imageSize, 1);
@@ -122,5 +181,127 @@ namespace campvis {
         validate(AbstractProcessor::INVALID_RESULT);
     }
 
+    bool IvusBatchReader::readBmpHeader(const std::string& filename, cgt::ivec2& size, std::vector<uint8_t>* fileBuffer) {
+        std::ifstream file(filename.c_str(), std::ios::in | std::ios::binary);
+        if (! file.is_open())
+            return false;
+
+        BmpInfo info;
+        uint8_t header[54];
+        if (! file.read(reinterpret_cast<char*>(header), sizeof(header)) || ! parseBmpHeader(header, sizeof(header), info))
+            return false;
+
+        size = cgt::ivec2(info._width, info._height);
+
+        if (fileBuffer != nullptr) {
+            file.seekg(0, std::ios::end);
+            fileBuffer->resize(static_cast<size_t>(file.tellg()));
+            file.seekg(0, std::ios::beg);
+            if (! file.read(reinterpret_cast<char*>(&fileBuffer->front()), fileBuffer->size()))
+                fileBuffer->resize(static_cast<size_t>(file.gcount()));
+        }
+        return true;
+    }
+
+    IvusBatchReader::BmpResult IvusBatchReader::readBmp(const std::string& filename, const cgt::ivec2& expectedSize, uint8_t* slice, std::vector<uint8_t>& fileBuffer) {
+        cgt::ivec2 size;
+        if (! readBmpHeader(filename, size, &fileBuffer))
+            return BMP_UNSUPPORTED;
+
+        if (size != expectedSize) {
+            LERROR("Could not load images: size of " << filename << " does not match!");
+            return BMP_FAILED;
+        }
+
+        // the header has been parsed from the start of the file already, hence it is only missing if the file is truncated
+        BmpInfo info;
+        bool complete = parseBmpHeader(fileBuffer.data(), fileBuffer.size(), info);
+
+        const size_t rowStride = ((static_cast<size_t>(info._width) * info._bitsPerPixel + 31) / 32) * 4;
+        if (! complete || info._dataOffset + rowStride * info._height > fileBuffer.size()) {
+            LERROR("Could not load image: " << filename << " is truncated.");
+            return BMP_FAILED;
+        }
+
+        // build a luminance lookup table for palette images
+        uint8_t palette[256];
+        if (info._bitsPerPixel == 8) {
+            size_t paletteOffset = 14 + info._headerSize;
+            size_t numColors = (info._numColors > 0) ? std::min<size_t>(info._numColors, 256) : 256;
+            for (size_t i = 0; i < 256; ++i) {
+                // the palette ends before the pixel data, which lies within fileBuffer as checked above
+                if (i < numColors && paletteOffset + 4*i + 3 < info._dataOffset) {
+                    const uint8_t* bgr = &fileBuffer[paletteOffset + 4*i];
+                    palette[i] = toLuminance(bgr[2], bgr[1], bgr[0]);
+                }
+                else {
+                    palette[i] = static_cast<uint8_t>(i);
+                }
+            }
+        }
+
+        // BMP rows are stored bottom-up unless the height is negative, which matches our lower-left origin
+        const size_t bytesPerPixel = info._bitsPerPixel / 8;
+        for (int y = 0; y < info._height; ++y) {
+            const uint8_t* src = &fileBuffer[info._dataOffset + rowStride * (info._topDown ? (info._height - 1 - y) : y)];
+            uint8_t* dst = slice + static_cast<size_t>(y) * info._width;
+
+            if (info._bitsPerPixel == 8) {
+                for (int x = 0; x < info._width; ++x)
+                    dst[x] = palette[src[x]];
+            }
+            else {
+                for (int x = 0; x < info._width; ++x, src += bytesPerPixel)
+                    dst[x] = toLuminance(src[2], src[1], src[0]);
+            }
+        }
+
+        return BMP_OK;
+    }
+
+    bool IvusBatchReader::readDevilSize(const std::string& filename, cgt::ivec2& size) {
+        tbb::mutex::scoped_lock lock(_devilMutex);
+
+        ILuint img;
+        ilGenImages(1, &img);
+        ilBindImage(img);
+
+        bool success = (ilLoadImage(filename.c_str()) == IL_TRUE);
+        if (success)
+            size = cgt::ivec2(ilGetInteger(IL_IMAGE_WIDTH), ilGetInteger(IL_IMAGE_HEIGHT));
+
+        ilDeleteImages(1, &img);
+        return success;
+    }
+
+    bool IvusBatchReader::readDevil(const std::string& filename, const cgt::ivec2& expectedSize, uint8_t* slice) {
+        // DevIL operates on a global bound image, hence only one thread may use it at a time
+        tbb::mutex::scoped_lock lock(_devilMutex);
+
+        ILuint img;
+        ilGenImages(1, &img);
+        ilBindImage(img);
+
+        bool success = false;
+        if (! ilLoadImage(filename.c_str())) {
+            LERROR("Could not load image: " << filename);
+        }
+        else if (expectedSize.x != ilGetInteger(IL_IMAGE_WIDTH) || expectedSize.y != ilGetInteger(IL_IMAGE_HEIGHT)) {
+            LERROR("Could not load images: size of " << filename << " does not match!");
+        }
+        else {
+            // get data from image and transform to single intensity image:
+            ilCopyPixels(0, 0, 0, expectedSize.x, expectedSize.y, 1, IL_LUMINANCE, IL_UNSIGNED_BYTE, slice);
+            ILint err = ilGetError();
+            if (err != IL_NO_ERROR)
+                LERROR("Error during conversion: " << iluErrorString(err));
+            else
+                success = true;
+        }
+
+        ilDeleteImages(1, &img);
+        return success;
+    }
+
 }
 
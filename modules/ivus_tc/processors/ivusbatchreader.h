@@ -31,10 +31,18 @@
 #include "modules/modulesapi.h"
 #include "modules/devil/processors/devilimagereader.h"
 
+#include <tbb/mutex.h>
+
+#include <vector>
+
 namespace campvis {
 
     /**
      * Reads a batch of IVUS images from a directory and stacks them into a 3D volume.
+     * 
+     * The volume is allocated up front based on the size of the first image, the images are then 
+     * decoded concurrently directly into their slices. Uncompressed BMP files are decoded natively,
+     * all other formats go through DevIL, which is not thread-safe and hence serialized.
      */
     class CAMPVIS_MODULES_API IvusBatchReader : public VisualizationProcessor {
     public:
@@ -71,11 +79,59 @@ namespace campvis {
         Vec3Property p_imageSpacing;                     ///< Image spacing
         DataNameProperty p_outputImage;             ///< image ID for output image
 
+        /// Signal emitted whenever a slice has been loaded, parameters are number of loaded slices and total number of slices.
+        sigslot::signal2<size_t, size_t> s_progress;
 
     protected:
+        /// Result of decoding a file with readBmp()
+        enum BmpResult {
+            BMP_OK,                 ///< The file has been decoded successfully
+            BMP_UNSUPPORTED,        ///< The file is no BMP file that can be decoded natively, try DevIL instead
+            BMP_FAILED              ///< The file is a supported BMP file but could not be decoded (e.g. size mismatch or truncated)
+        };
+
         /// \see AbstractProcessor::updateResult
         virtual void updateResult(DataContainer& dataContainer);
 
+        /**
+         * Reads the size of the BMP file \a filename and optionally the whole file into \a fileBuffer.
+         * \param  filename    File to read
+         * \param  size        Receives the image size
+         * \param  fileBuffer  Receives the file contents, may be nullptr. Contains only the readable
+         *                     part of the file if reading fails.
+         * \return True if \a filename is an uncompressed BMP file that can be decoded natively.
+         */
+        static bool readBmpHeader(const std::string& filename, cgt::ivec2& size, std::vector<uint8_t>* fileBuffer);
+
+        /**
+         * Decodes the uncompressed BMP file \a filename into a luminance slice. Thread-safe.
+         * \param  filename        File to read
+         * \param  expectedSize    Expected size of the image
+         * \param  slice           Output buffer for the luminance slice
+         * \param  fileBuffer      Scratch buffer for the file contents
+         * \return BMP_OK on success, BMP_UNSUPPORTED if the file is no supported BMP file, BMP_FAILED on error.
+         */
+        static BmpResult readBmp(const std::string& filename, const cgt::ivec2& expectedSize, uint8_t* slice, std::vector<uint8_t>& fileBuffer);
+
+        /**
+         * Reads the size of \a filename using DevIL.
+         * \param  filename    File to read
+         * \param  size        Receives the image size
+         * \return True on success.
+         */
+        static bool readDevilSize(const std::string& filename, cgt::ivec2& size);
+
+        /**
+         * Decodes \a filename into a luminance slice using DevIL. Serialized by _devilMutex.
+         * \param  filename        File to read
+         * \param  expectedSize    Expected size of the image
+         * \param  slice           Output buffer for the luminance slice
+         * \return True on success.
+         */
+        static bool readDevil(const std::string& filename, const cgt::ivec2& expectedSize, uint8_t* slice);
+
+        static tbb::mutex _devilMutex;              ///< DevIL is not thread-safe, hence all calls to it are serialized
+
         static const std::string loggerCat_;
     };
 
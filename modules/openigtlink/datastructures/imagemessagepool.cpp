@@ -0,0 +1,75 @@
+// ================================================================================================
+// 
+// This file is part of the CAMPVis Software Framework.
+// 
+// If not explicitly stated otherwise: Copyright (C) 2012-2015, all rights reserved,
+//      Christian Schulte zu Berge <christian.szb@in.tum.de>
+//      Chair for Computer Aided Medical Procedures
+//      Technische Universitaet Muenchen
+//      Boltzmannstr. 3, 85748 Garching b. Muenchen, Germany
+// 
+// For a full list of authors and contributors, please refer to the file "AUTHORS.txt".
+// 
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file 
+// except in compliance with the License. You may obtain a copy of the License at
+// 
+// http://www.apache.org/licenses/LICENSE-2.0
+// 
+// Unless required by applicable law or agreed to in writing, software distributed under the 
+// License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, 
+// either express or implied. See the License for the specific language governing permissions 
+// and limitations under the License.
+// 
+// ================================================================================================
+
+
+#include "imagemessagepool.h"
+
+namespace campvis {
+
+    std::shared_ptr<ImageMessagePool> ImageMessagePool::create(size_t maxFreeMessages) {
+        return std::shared_ptr<ImageMessagePool>(new ImageMessagePool(maxFreeMessages));
+    }
+
+    ImageMessagePool::ImageMessagePool(size_t maxFreeMessages) {
+        _maxFreeMessages = maxFreeMessages;
+        _numAllocated = 0;
+    }
+
+    ImageMessagePool::~ImageMessagePool() {
+    }
+
+    std::shared_ptr<igtl::ImageMessage> ImageMessagePool::acquire() {
+        igtl::ImageMessage::Pointer message;
+        if (! _freeMessages.try_pop(message)) {
+            message = igtl::ImageMessage::New();
+            ++_numAllocated;
+        }
+
+        // hold an additional reference as long as the shared pointer is alive
+        igtl::ImageMessage* rawMessage = message.GetPointer();
+        rawMessage->Register();
+
+        std::shared_ptr<ImageMessagePool> pool = shared_from_this();
+        return std::shared_ptr<igtl::ImageMessage>(rawMessage, [pool] (igtl::ImageMessage* m) { pool->release(m); });
+    }
+
+    void ImageMessagePool::release(igtl::ImageMessage* message) {
+        if (static_cast<size_t>(_freeMessages.size()) < _maxFreeMessages)
+            _freeMessages.push(igtl::ImageMessage::Pointer(message));
+        message->UnRegister();
+    }
+
+    void ImageMessagePool::setMaxFreeMessages(size_t maxFreeMessages) {
+        _maxFreeMessages = maxFreeMessages;
+
+        igtl::ImageMessage::Pointer message;
+        while (static_cast<size_t>(_freeMessages.size()) > _maxFreeMessages && _freeMessages.try_pop(message))
+            message = nullptr;
+    }
+
+    size_t ImageMessagePool::getNumAllocated() const {
+        return _numAllocated;
+    }
+
+}
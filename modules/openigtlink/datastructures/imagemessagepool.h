@@ -0,0 +1,106 @@
+// ================================================================================================
+// 
+// This file is part of the CAMPVis Software Framework.
+// 
+// If not explicitly stated otherwise: Copyright (C) 2012-2015, all rights reserved,
+//      Christian Schulte zu Berge <christian.szb@in.tum.de>
+//      Chair for Computer Aided Medical Procedures
+//      Technische Universitaet Muenchen
+//      Boltzmannstr. 3, 85748 Garching b. Muenchen, Germany
+// 
+// For a full list of authors and contributors, please refer to the file "AUTHORS.txt".
+// 
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file 
+// except in compliance with the License. You may obtain a copy of the License at
+// 
+// http://www.apache.org/licenses/LICENSE-2.0
+// 
+// Unless required by applicable law or agreed to in writing, software distributed under the 
+// License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, 
+// either express or implied. See the License for the specific language governing permissions 
+// and limitations under the License.
+// 
+// ================================================================================================
+
+
+#ifndef IMAGEMESSAGEPOOL_H__
+#define IMAGEMESSAGEPOOL_H__
+
+#include <igtlImageMessage.h>
+
+#include <tbb/atomic.h>
+#include <tbb/concurrent_queue.h>
+
+#include "modules/modulesapi.h"
+
+#include <memory>
+
+namespace campvis {
+
+    /**
+     * Pool of recycled OpenIGTLink IMAGE messages.
+     * 
+     * Receiving an image message into a pooled message reuses its pack buffer as long as the
+     * image size does not change, so that the image data can be received and unpacked in place
+     * without any allocation. The acquired messages are handed out as shared pointers whose 
+     * deleter returns the message to the pool. Hence, they can directly serve as data owner for
+     * ImageRepresentationLocals wrapping the scalar data without copying it.
+     * 
+     * \note    The pool must be created through create(), as the handed out messages keep their 
+     *          pool alive.
+     */
+    class CAMPVIS_MODULES_API ImageMessagePool : public std::enable_shared_from_this<ImageMessagePool> {
+    public:
+        /**
+         * Creates a new ImageMessagePool.
+         * \param   maxFreeMessages Maximum number of unused messages to keep for recycling.
+         * \return  A shared pointer to the new pool.
+         */
+        static std::shared_ptr<ImageMessagePool> create(size_t maxFreeMessages);
+
+        /**
+         * Destructor
+         */
+        ~ImageMessagePool();
+
+        /**
+         * Acquires a message from the pool, creates a new one if the pool is empty.
+         * The message is returned to the pool once the last reference to it is released.
+         * \note    This method is thread-safe.
+         * \return  A shared pointer to a recycled or new image message.
+         */
+        std::shared_ptr<igtl::ImageMessage> acquire();
+
+        /**
+         * Sets the maximum number of unused messages to keep for recycling.
+         * \param   maxFreeMessages Maximum number of unused messages to keep.
+         */
+        void setMaxFreeMessages(size_t maxFreeMessages);
+
+        /**
+         * Returns the total number of messages allocated by this pool.
+         * \return  _numAllocated
+         */
+        size_t getNumAllocated() const;
+
+    private:
+        /**
+         * Private constructor, use create().
+         * \param   maxFreeMessages Maximum number of unused messages to keep for recycling.
+         */
+        explicit ImageMessagePool(size_t maxFreeMessages);
+
+        /**
+         * Returns \a message to the pool or discards it if the pool is full.
+         * \param   message Message to release.
+         */
+        void release(igtl::ImageMessage* message);
+
+        tbb::concurrent_bounded_queue<igtl::ImageMessage::Pointer> _freeMessages;   ///< Unused messages ready for recycling
+        tbb::atomic<size_t> _maxFreeMessages;                                       ///< Maximum number of unused messages to keep
+        tbb::atomic<size_t> _numAllocated;                                          ///< Total number of allocated messages
+    };
+
+}
+
+#endif // IMAGEMESSAGEPOOL_H__
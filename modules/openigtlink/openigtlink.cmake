@@ -16,6 +16,7 @@ IF(ModuleEnabled)
             modules/openigtlink/pipelines/*.cpp
             modules/openigtlink/processors/*.cpp
             modules/openigtlink/datastructures/*.cpp
+            modules/openigtlink/tools/*.cpp
             modules/openigtlink/*.cpp
         )
 
@@ -27,6 +28,7 @@ IF(ModuleEnabled)
             modules/openigtlink/pipelines/*.h
             modules/openigtlink/processors/*.h
             modules/openigtlink/datastructures/*.h
+            modules/openigtlink/tools/*.h
         )
 
         # Define the GLSL shader path, so that all needed shaders will be deployed to target directory
@@ -30,10 +30,13 @@ namespace campvis {
 
     StreamingOIGTLDemo::StreamingOIGTLDemo(DataContainer& dc)
         : AutoEvaluationPipeline(dc, getId())
+        , p_runLoopbackBenchmark("RunLoopbackBenchmark", "Run Loopback Benchmark", false)
     {
         addProcessor(&_igtlClient);
         addProcessor(&_matrixProcessor);
 
+        addProperty(p_runLoopbackBenchmark);
+
         //addEventListenerToBack(&_ve);
     }
 
@@ -58,6 +61,7 @@ namespace campvis {
     }
 
     void StreamingOIGTLDemo::deinit() {
+        _loopbackServer.stop();
         _canvasSize.s_changed.disconnect(this);
         AutoEvaluationPipeline::deinit();
     }
@@ -68,5 +72,31 @@ namespace campvis {
     void StreamingOIGTLDemo::onProcessorValidated(AbstractProcessor *processor) {
     }
 
+    void StreamingOIGTLDemo::onPropertyChanged(const AbstractProperty* prop) {
+        if (prop == &p_runLoopbackBenchmark) {
+            if (p_runLoopbackBenchmark.getValue()) {
+                // stream synthetic images as fast as possible through a local server
+                _igtlClient.disconnect();
+                if (_loopbackServer.start(_igtlClient.p_port.getValue(), "ImagerClient", cgt::ivec2(640, 480), 0.f)) {
+                    _igtlClient.p_address.setValue("127.0.0.1");
+                    _igtlClient.p_receiveImages.setValue(true);
+                    _igtlClient.resetImageStatistics();
+                    _igtlClient.connect();
+                }
+            }
+            else {
+                _igtlClient.disconnect();
+                _loopbackServer.stop();
+
+                OpenIGTLinkClient::ImageStatistics stats = _igtlClient.getImageStatistics();
+                LINFO("Loopback benchmark: received " << stats._numReceived << " images at " << stats._framesPerSecond << " frames/s, "
+                    << stats._numDropped << " dropped, latency avg " << stats._averageLatency * 1000.0 << " ms, max " << stats._maxLatency * 1000.0 << " ms.");
+            }
+        }
+        else {
+            AutoEvaluationPipeline::onPropertyChanged(prop);
+        }
+    }
+
 
 }
\ No newline at end of file
@@ -27,6 +27,7 @@
 
 #include "modules/modulesapi.h"
 #include "modules/openigtlink/processors/openigtlinkclient.h"
+#include "modules/openigtlink/tools/igtlloopbackserver.h"
 #include "modules/base/processors/matrixprocessor.h"
 
 #include "core/pipeline/autoevaluationpipeline.h"
@@ -64,8 +65,14 @@ namespace campvis {
          */
         virtual void onProcessorValidated(AbstractProcessor *processor);
 
+        /// \see AbstractPipeline::onPropertyChanged
+        virtual void onPropertyChanged(const AbstractProperty* prop);
+
         OpenIGTLinkClient _igtlClient;
         MatrixProcessor _matrixProcessor;
+
+        BoolProperty p_runLoopbackBenchmark;    ///< Streams synthetic images from a local server to _igtlClient
+        IgtlLoopbackServer _loopbackServer;     ///< Local server for the loopback benchmark
     };
 
 }
@@ -31,10 +31,21 @@
 #include <igtlPositionMessage.h>
 
 #include "core/datastructures/imagedata.h"
+#include "core/datastructures/imageseries.h"
 #include "core/datastructures/genericimagerepresentationlocal.h"
 #include "core/tools/stringutils.h"
 
+#include <igtlTimeStamp.h>
+
+#include <algorithm>
+
 namespace campvis {
+
+    static const GenericOption<std::string> frameDropPolicies[2] = {
+        GenericOption<std::string>("latestWins", "Keep Latest Image Only"),
+        GenericOption<std::string>("queue", "Queue Images (up to Ring Buffer Size)")
+    };
+
     const std::string OpenIGTLinkClient::loggerCat_ = "CAMPVis.modules.openigtlink.client";
 
     OpenIGTLinkClient::OpenIGTLinkClient() 
@@ -52,6 +63,12 @@ namespace campvis {
         , p_voxelSize("VoxelSize", "Voxel Size in mm", cgt::vec3(1.f), cgt::vec3(-100.f), cgt::vec3(100.f), cgt::vec3(0.1f))
         , p_receivePositions("ReceivePositions", "Receive POSITION Messages", true)
         , p_targetPositionPrefix("targetPositionsPrefix", "Target Position Prefix", "IGTL.position.")
+        , p_ringBufferSize("RingBufferSize", "Number of Images to Keep", 1, 1, 100)
+        , p_frameDropPolicy("FrameDropPolicy", "Frame Drop Policy", frameDropPolicies, 2)
+        , _imagePool(ImageMessagePool::create(4))
+        , _firstImageTime(0.0)
+        , _lastImageTime(0.0)
+        , _latencySum(0.0)
         , _stopExecution()
         , _receiverThread(nullptr)
         , _receiverRunning()
@@ -74,6 +91,10 @@ namespace campvis {
         addProperty(p_voxelSize, VALID);
         addProperty(p_receivePositions, INVALID_PROPERTIES);
         addProperty(p_targetPositionPrefix, VALID);
+        addProperty(p_ringBufferSize, VALID);
+        addProperty(p_frameDropPolicy, VALID);
+
+        resetImageStatistics();
 
         invalidate(INVALID_PROPERTIES);
 
@@ -116,62 +137,37 @@ namespace campvis {
 
         if(p_receiveImages.getValue()) 
         {
+            // only hold the lock for taking over the received messages
+            std::map<std::string, std::deque< std::shared_ptr<igtl::ImageMessage> > > receivedImages;
             _imageMutex.lock();
-            for(auto it = _receivedImages.begin(), end = _receivedImages.end(); it != end; ++it)
-            {
-                igtl::ImageMessage::Pointer imageMessage = it->second;    
-                WeaklyTypedPointer wtp;
-                wtp._pointer = new uint8_t[imageMessage->GetImageSize()];
-#ifdef IGTL_CLIENT_DEBUGGING
-                LDEBUG("Image has " << imageMessage->GetNumComponents() << " components and is of size " << imageMessage->GetImageSize());
-#endif
-                memcpy(wtp._pointer, imageMessage->GetScalarPointer(), imageMessage->GetImageSize());
-                wtp._numChannels = imageMessage->GetNumComponents();
-
-                switch (imageMessage->GetScalarType()) {
-                case igtl::ImageMessage::TYPE_INT8:
-                    wtp._baseType = WeaklyTypedPointer::INT8; break;
-                case igtl::ImageMessage::TYPE_UINT8:
-                    wtp._baseType = WeaklyTypedPointer::UINT8; break;
-                case igtl::ImageMessage::TYPE_INT16:
-                    wtp._baseType = WeaklyTypedPointer::INT16; break;
-                case igtl::ImageMessage::TYPE_UINT16:
-                    wtp._baseType = WeaklyTypedPointer::UINT16; break;
-                case igtl::ImageMessage::TYPE_INT32:
-                    wtp._baseType = WeaklyTypedPointer::INT32; break;
-                case igtl::ImageMessage::TYPE_UINT32:
-                    wtp._baseType = WeaklyTypedPointer::UINT32; break;
-                case igtl::ImageMessage::TYPE_FLOAT32:
-                    wtp._baseType = WeaklyTypedPointer::FLOAT; break;
-                default:
-                    LERROR("Error while receiving IGTL IMAGE message: unsupported type: " << imageMessage->GetScalarType());
-                    return;
-                }
-
-                cgt::vec3 imageOffset(0.f);
-                cgt::vec3 voxelSize(1.f);
-                cgt::ivec3 size_i(1);
+            receivedImages.swap(_receivedImages);
+            _imageMutex.unlock();
 
-                imageMessage->GetSpacing(voxelSize.elem);
-                imageMessage->GetDimensions(size_i.elem);
-                cgt::svec3 size(size_i);
-                imageMessage->GetOrigin(imageOffset.elem);
+            const size_t ringBufferSize = static_cast<size_t>(p_ringBufferSize.getValue());
+            _imagePool->setMaxFreeMessages(ringBufferSize + 2);
 
-                // If the voxel size boundled with the packet is practically 0.0f, make it 1.0f
-                // this makes sure we don't get invalid mapping informations (non invertable matrix)
-                if (minElem(voxelSize) <= 1e-10f) {
-                    voxelSize = cgt::vec3(1.0f);
+            for(auto it = receivedImages.begin(), end = receivedImages.end(); it != end; ++it)
+            {
+                std::deque<DataHandle>& ringBuffer = _imageRingBuffers[it->first];
+                for (auto msgIt = it->second.begin(); msgIt != it->second.end(); ++msgIt) {
+                    ImageData* image = createImageData(*msgIt);
+                    if (image != nullptr)
+                        ringBuffer.push_back(DataHandle(image));
+                }
+                while (ringBuffer.size() > ringBufferSize)
+                    ringBuffer.pop_front();
+
+                if (ringBuffer.empty())
+                    continue;
+
+                data.addDataHandle(p_targetImagePrefix.getValue() + it->first, ringBuffer.back());
+                if (ringBufferSize > 1) {
+                    ImageSeries* series = new ImageSeries();
+                    for (auto rbIt = ringBuffer.begin(); rbIt != ringBuffer.end(); ++rbIt)
+                        series->addImage(*rbIt);
+                    data.addData(p_targetImagePrefix.getValue() + it->first + ".series", series);
                 }
-
-                size_t dimensionality = (size_i[2] == 1) ? ((size_i[1] == 1) ? 1 : 2) : 3;
-                ImageData* image = new ImageData(dimensionality, size, wtp._numChannels);
-                ImageRepresentationLocal::create(image, wtp);
-
-                image->setMappingInformation(ImageMappingInformation(size, p_imageOffset.getValue(), voxelSize * p_voxelSize.getValue()));
-                data.addData(p_targetImagePrefix.getValue() + it->first, image);
             }
-            _receivedImages.clear();
-            _imageMutex.unlock();
         }
 
         if(p_receivePositions.getValue())
@@ -189,6 +185,79 @@ namespace campvis {
         validate(INVALID_RESULT);
     }
 
+    ImageData* OpenIGTLinkClient::createImageData(const std::shared_ptr<igtl::ImageMessage>& imageMessage) {
+        WeaklyTypedPointer wtp;
+        wtp._pointer = imageMessage->GetScalarPointer();
+        wtp._numChannels = imageMessage->GetNumComponents();
+#ifdef IGTL_CLIENT_DEBUGGING
+        LDEBUG("Image has " << imageMessage->GetNumComponents() << " components and is of size " << imageMessage->GetImageSize());
+#endif
+
+        switch (imageMessage->GetScalarType()) {
+        case igtl::ImageMessage::TYPE_INT8:
+            wtp._baseType = WeaklyTypedPointer::INT8; break;
+        case igtl::ImageMessage::TYPE_UINT8:
+            wtp._baseType = WeaklyTypedPointer::UINT8; break;
+        case igtl::ImageMessage::TYPE_INT16:
+            wtp._baseType = WeaklyTypedPointer::INT16; break;
+        case igtl::ImageMessage::TYPE_UINT16:
+            wtp._baseType = WeaklyTypedPointer::UINT16; break;
+        case igtl::ImageMessage::TYPE_INT32:
+            wtp._baseType = WeaklyTypedPointer::INT32; break;
+        case igtl::ImageMessage::TYPE_UINT32:
+            wtp._baseType = WeaklyTypedPointer::UINT32; break;
+        case igtl::ImageMessage::TYPE_FLOAT32:
+            wtp._baseType = WeaklyTypedPointer::FLOAT; break;
+        default:
+            LERROR("Error while receiving IGTL IMAGE message: unsupported type: " << imageMessage->GetScalarType());
+            return nullptr;
+        }
+
+        cgt::vec3 imageOffset(0.f);
+        cgt::vec3 voxelSize(1.f);
+        cgt::ivec3 size_i(1);
+
+        imageMessage->GetSpacing(voxelSize.elem);
+        imageMessage->GetDimensions(size_i.elem);
+        cgt::svec3 size(size_i);
+        imageMessage->GetOrigin(imageOffset.elem);
+
+        // If the voxel size boundled with the packet is practically 0.0f, make it 1.0f
+        // this makes sure we don't get invalid mapping informations (non invertable matrix)
+        if (minElem(voxelSize) <= 1e-10f) {
+            voxelSize = cgt::vec3(1.0f);
+        }
+
+        size_t dimensionality = (size_i[2] == 1) ? ((size_i[1] == 1) ? 1 : 2) : 3;
+        ImageData* image = new ImageData(dimensionality, size, wtp._numChannels);
+
+        // wrap the received scalars, the message is returned to the pool once the image is deleted
+        ImageRepresentationLocal::create(image, wtp, imageMessage);
+
+        image->setMappingInformation(ImageMappingInformation(size, p_imageOffset.getValue(), voxelSize * p_voxelSize.getValue()));
+        return image;
+    }
+
+    OpenIGTLinkClient::ImageStatistics OpenIGTLinkClient::getImageStatistics() const {
+        tbb::mutex::scoped_lock lock(_statisticsMutex);
+        ImageStatistics toReturn = _statistics;
+        toReturn._averageLatency = (_statistics._numReceived > 0) ? _latencySum / _statistics._numReceived : 0.0;
+        toReturn._framesPerSecond = (_statistics._numReceived > 1 && _lastImageTime > _firstImageTime) ? (_statistics._numReceived - 1) / (_lastImageTime - _firstImageTime) : 0.0;
+        return toReturn;
+    }
+
+    void OpenIGTLinkClient::resetImageStatistics() {
+        tbb::mutex::scoped_lock lock(_statisticsMutex);
+        _statistics._numReceived = 0;
+        _statistics._numDropped = 0;
+        _statistics._framesPerSecond = 0.0;
+        _statistics._averageLatency = 0.0;
+        _statistics._maxLatency = 0.0;
+        _firstImageTime = 0.0;
+        _lastImageTime = 0.0;
+        _latencySum = 0.0;
+    }
+
     void OpenIGTLinkClient::updateProperties(DataContainer& dataContainer) {
         p_targetImagePrefix.setVisible(p_receiveImages.getValue());
 
@@ -196,6 +265,8 @@ namespace campvis {
         p_voxelSize.setVisible(p_receiveImages.getValue());
         p_targetTransformPrefix.setVisible(p_receiveImages.getValue() || p_receiveTransforms.getValue());
         p_targetPositionPrefix.setVisible(p_receivePositions.getValue());
+        p_ringBufferSize.setVisible(p_receiveImages.getValue());
+        p_frameDropPolicy.setVisible(p_receiveImages.getValue());
 
         validate(INVALID_PROPERTIES);
     }
@@ -319,9 +390,8 @@ namespace campvis {
         LDEBUG("Receiving IMAGE data type.");
 #endif
 
-        // Create a message buffer to receive transform data
-        igtl::ImageMessage::Pointer imgMsg;
-        imgMsg = igtl::ImageMessage::New();
+        // Take a recycled message to receive the image data into
+        std::shared_ptr<igtl::ImageMessage> imgMsg = _imagePool->acquire();
         imgMsg->SetMessageHeader(header);
         imgMsg->AllocatePack();
 
@@ -334,11 +404,41 @@ namespace campvis {
 
         if (c & igtl::MessageHeader::UNPACK_BODY) // if CRC check is OK
         {
+            // measure the latency from the time stamp of the sender
+            igtl::TimeStamp::Pointer sendTime = igtl::TimeStamp::New();
+            igtl::TimeStamp::Pointer receiveTime = igtl::TimeStamp::New();
+            imgMsg->GetTimeStamp(sendTime);
+            receiveTime->GetTime();
+            double latency = receiveTime->GetTimeStamp() - sendTime->GetTimeStamp();
+
             // put the message pointer into our locked buffer
+            size_t numDropped = 0;
             _imageMutex.lock();
-            _receivedImages[imgMsg->GetDeviceName()] = imgMsg;
+            std::deque< std::shared_ptr<igtl::ImageMessage> >& queue = _receivedImages[imgMsg->GetDeviceName()];
+            if (p_frameDropPolicy.getOptionValue() == "latestWins") {
+                numDropped = queue.size();
+                queue.clear();
+            }
+            else {
+                while (queue.size() >= static_cast<size_t>(p_ringBufferSize.getValue())) {
+                    queue.pop_front();
+                    ++numDropped;
+                }
+            }
+            queue.push_back(imgMsg);
             _imageMutex.unlock();
 
+            {
+                tbb::mutex::scoped_lock lock(_statisticsMutex);
+                if (_statistics._numReceived == 0)
+                    _firstImageTime = receiveTime->GetTimeStamp();
+                _lastImageTime = receiveTime->GetTimeStamp();
+                ++_statistics._numReceived;
+                _statistics._numDropped += numDropped;
+                _latencySum += latency;
+                _statistics._maxLatency = std::max(_statistics._maxLatency, latency);
+            }
+
             // Retrieve the image data
             int   size[3];          // image dimension
             float spacing[3];       // spacing (mm/pixel)
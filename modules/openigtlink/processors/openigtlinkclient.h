@@ -27,8 +27,10 @@
 
 //#define IGTL_CLIENT_DEBUGGING
 
+#include <deque>
 #include <string>
 #include <map>
+#include <memory>
 
 #include <igtlOSUtil.h>
 #include <igtlClientSocket.h>
@@ -45,9 +47,13 @@
 #include "core/properties/buttonproperty.h"
 #include "core/properties/datanameproperty.h"
 #include "core/properties/floatingpointproperty.h"
+#include "core/properties/numericproperty.h"
+#include "core/properties/optionproperty.h"
+#include "core/datastructures/datahandle.h"
 #include "core/datastructures/imagedata.h"
 
 #include "modules/modulesapi.h"
+#include "modules/openigtlink/datastructures/imagemessagepool.h"
 
 
 namespace campvis {
@@ -56,6 +62,10 @@ namespace campvis {
      * Processes the messages according to the currently set properties p_receiveTransform, p_receivePositions
      * and p_receiveImage and puts them into the received data into the respective data containers.
      * This Class contains modified code from the OpenIGTLink ReceiveClient example.
+     * 
+     * IMAGE messages are received into recycled messages of an ImageMessagePool and wrapped into
+     * ImageData without copying. The most recent p_ringBufferSize images of each device are kept
+     * in a ring buffer, which is additionally exposed as ImageSeries if it holds more than one image.
      */
     class CAMPVIS_MODULES_API OpenIGTLinkClient : public AbstractProcessor {
     public:
@@ -104,6 +114,31 @@ namespace campvis {
         BoolProperty p_receivePositions;       ///< toggle receiving IMAGE messages
         StringProperty p_targetPositionPrefix;   ///< image ID prefix for read images
 
+        IntProperty p_ringBufferSize;       ///< Number of most recent images to keep per device
+        GenericOptionProperty<std::string> p_frameDropPolicy;  ///< What to do with images received faster than they are consumed
+
+        /// Statistics on the received IMAGE messages
+        struct ImageStatistics {
+            size_t _numReceived;            ///< Number of received images
+            size_t _numDropped;             ///< Number of images dropped before being put into the DataContainer
+            double _framesPerSecond;        ///< Average receive rate
+            double _averageLatency;         ///< Average latency between sending and receiving in seconds
+            double _maxLatency;             ///< Maximum latency between sending and receiving in seconds
+        };
+
+        /**
+         * Returns the statistics on the received IMAGE messages since the last reset.
+         * \note   The latency is computed from the message time stamp and hence only meaningful
+         *          if the clocks of server and client are synchronized (e.g. for a local server).
+         * \return The current image statistics.
+         */
+        ImageStatistics getImageStatistics() const;
+
+        /**
+         * Resets the statistics on the received IMAGE messages.
+         */
+        void resetImageStatistics();
+
         /**
          * Updates the data container with the latest received transformation/position/image data
          * \param   dataContainer    DataContainer to work on
@@ -138,18 +173,33 @@ namespace campvis {
         /// Receive a IMAGE message from the OpenIGTLink socket and put into the local buffers
         int ReceiveImage(igtl::Socket* socket, igtl::MessageHeader::Pointer& header);
 
+        /**
+         * Creates an ImageData wrapping the scalars of \a imageMessage without copying them.
+         * \param  imageMessage    Unpacked IMAGE message, is kept alive by the returned image.
+         * \return A new ImageData or nullptr if the message has an unsupported scalar type.
+         */
+        ImageData* createImageData(const std::shared_ptr<igtl::ImageMessage>& imageMessage);
+
         //igtl connection
         igtl::ClientSocket::Pointer _socket;
         
         //data
         std::map<std::string, cgt::mat4> _receivedTransforms;        ///< the transforms that has been received by the igtl worker thread, mapped by device name
-        std::map<std::string, igtl::ImageMessage::Pointer> _receivedImages;  ///< the image messages received by the igtl worker thread, mapped by device name
+        std::map<std::string, std::deque< std::shared_ptr<igtl::ImageMessage> > > _receivedImages;  ///< the image messages received by the igtl worker thread, mapped by device name
+        std::map<std::string, std::deque<DataHandle> > _imageRingBuffers;  ///< the most recent images put into the DataContainer, mapped by device name
+        std::shared_ptr<ImageMessagePool> _imagePool;           ///< pool of recycled image messages to receive into
         std::map<std::string, PositionMessageData> _receivedPositions; ///< position message data received by the igtl worker thread, mapped by device name        
 
         tbb::mutex _transformMutex;                             ///< mutex to control access to _receivedTransforms
         tbb::mutex _imageMutex;                                 ///< mutex to control access to _receivedImages
         tbb::mutex _positionMutex;                              ///< mutex to control access to _receivedPositions
 
+        mutable tbb::mutex _statisticsMutex;                    ///< mutex to control access to the image statistics
+        ImageStatistics _statistics;                            ///< statistics on the received images
+        double _firstImageTime;                                 ///< time stamp of the first image since the last reset
+        double _lastImageTime;                                  ///< time stamp of the last received image
+        double _latencySum;                                     ///< sum of the latencies of all received images
+
         static const std::string loggerCat_;
 
         // this is thread management stuff
@@ -0,0 +1,166 @@
+// ================================================================================================
+// 
+// This file is part of the CAMPVis Software Framework.
+// 
+// If not explicitly stated otherwise: Copyright (C) 2012-2015, all rights reserved,
+//      Christian Schulte zu Berge <christian.szb@in.tum.de>
+//      Chair for Computer Aided Medical Procedures
+//      Technische Universitaet Muenchen
+//      Boltzmannstr. 3, 85748 Garching b. Muenchen, Germany
+// 
+// For a full list of authors and contributors, please refer to the file "AUTHORS.txt".
+// 
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file 
+// except in compliance with the License. You may obtain a copy of the License at
+// 
+// http://www.apache.org/licenses/LICENSE-2.0
+// 
+// Unless required by applicable law or agreed to in writing, software distributed under the 
+// License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, 
+// either express or implied. See the License for the specific language governing permissions 
+// and limitations under the License.
+// 
+// ================================================================================================
+
+
+#include "igtlloopbackserver.h"
+
+#include <igtlImageMessage.h>
+#include <igtlTimeStamp.h>
+
+#include <tbb/tick_count.h>
+
+#include "cgt/logmanager.h"
+
+#include <chrono>
+#include <cstring>
+
+namespace campvis {
+    const std::string IgtlLoopbackServer::loggerCat_ = "CAMPVis.modules.openigtlink.IgtlLoopbackServer";
+
+    IgtlLoopbackServer::IgtlLoopbackServer()
+        : _imageSize(0)
+        , _framesPerSecond(0.f)
+        , _thread(nullptr)
+    {
+        _stopExecution = false;
+        _running = false;
+        _numFramesSent = 0;
+        _sendDuration = 0;
+    }
+
+    IgtlLoopbackServer::~IgtlLoopbackServer() {
+        stop();
+    }
+
+    bool IgtlLoopbackServer::start(int port, const std::string& deviceName, const cgt::ivec2& imageSize, float framesPerSecond) {
+        stop();
+
+        _serverSocket = igtl::ServerSocket::New();
+        if (_serverSocket->CreateServer(port) < 0) {
+            LERROR("Cannot create a server socket on port " << port);
+            _serverSocket = nullptr;
+            return false;
+        }
+
+        _deviceName = deviceName;
+        _imageSize = imageSize;
+        _framesPerSecond = framesPerSecond;
+        _numFramesSent = 0;
+        _sendDuration = 0;
+        _stopExecution = false;
+        _running = true;
+        _thread = new std::thread(&IgtlLoopbackServer::run, this);
+
+        LINFO("Loopback server listening on port " << port);
+        return true;
+    }
+
+    void IgtlLoopbackServer::stop() {
+        if (_thread == nullptr)
+            return;
+
+        _stopExecution = true;
+        if (_thread->joinable())
+            _thread->join();
+        delete _thread;
+        _thread = nullptr;
+
+        if (_serverSocket)
+            _serverSocket->CloseSocket();
+        _serverSocket = nullptr;
+
+        LINFO("Loopback server sent " << _numFramesSent << " frames at " << getFramesPerSecond() << " frames/s.");
+    }
+
+    bool IgtlLoopbackServer::isRunning() const {
+        return _running;
+    }
+
+    size_t IgtlLoopbackServer::getNumFramesSent() const {
+        return _numFramesSent;
+    }
+
+    double IgtlLoopbackServer::getFramesPerSecond() const {
+        size_t duration = _sendDuration;
+        return (duration > 0) ? (1e6 * _numFramesSent) / duration : 0.0;
+    }
+
+    void IgtlLoopbackServer::run() {
+        // prepare the message once, only the content and time stamp change per frame
+        int size[3] = { _imageSize.x, _imageSize.y, 1 };
+        int offset[3] = { 0, 0, 0 };
+        float spacing[3] = { 1.f, 1.f, 1.f };
+
+        igtl::ImageMessage::Pointer imageMessage = igtl::ImageMessage::New();
+        imageMessage->SetDimensions(size);
+        imageMessage->SetSpacing(spacing);
+        imageMessage->SetScalarType(igtl::ImageMessage::TYPE_UINT8);
+        imageMessage->SetNumComponents(1);
+        imageMessage->SetDeviceName(_deviceName.c_str());
+        imageMessage->SetSubVolume(size, offset);
+        imageMessage->AllocateScalars();
+
+        igtl::TimeStamp::Pointer timeStamp = igtl::TimeStamp::New();
+        const std::chrono::microseconds frameInterval(_framesPerSecond > 0.f ? static_cast<long long>(1e6f / _framesPerSecond) : 0);
+
+        while (! _stopExecution) {
+            igtl::ClientSocket::Pointer socket = _serverSocket->WaitForConnection(100);
+            if (! socket)
+                continue;
+
+            LINFO("Loopback client connected.");
+            tbb::tick_count startTime = tbb::tick_count::now();
+            std::chrono::steady_clock::time_point nextFrame = std::chrono::steady_clock::now();
+
+            while (! _stopExecution) {
+                // fill the image with a moving gradient, so that consecutive frames differ
+                uint8_t* scalars = static_cast<uint8_t*>(imageMessage->GetScalarPointer());
+                for (int y = 0; y < size[1]; ++y)
+                    memset(scalars + y * size[0], static_cast<int>((y + _numFramesSent) & 0xFF), size[0]);
+
+                timeStamp->GetTime();
+                imageMessage->SetTimeStamp(timeStamp);
+                imageMessage->Pack();
+
+                if (socket->Send(imageMessage->GetPackPointer(), imageMessage->GetPackSize()) == 0) {
+                    LINFO("Loopback client disconnected.");
+                    break;
+                }
+
+                ++_numFramesSent;
+                _sendDuration = static_cast<size_t>((tbb::tick_count::now() - startTime).seconds() * 1e6);
+
+                if (frameInterval.count() > 0) {
+                    nextFrame += frameInterval;
+                    std::this_thread::sleep_until(nextFrame);
+                }
+            }
+
+            socket->CloseSocket();
+        }
+
+        _running = false;
+    }
+
+}
@@ -0,0 +1,114 @@
+// ================================================================================================
+// 
+// This file is part of the CAMPVis Software Framework.
+// 
+// If not explicitly stated otherwise: Copyright (C) 2012-2015, all rights reserved,
+//      Christian Schulte zu Berge <christian.szb@in.tum.de>
+//      Chair for Computer Aided Medical Procedures
+//      Technische Universitaet Muenchen
+//      Boltzmannstr. 3, 85748 Garching b. Muenchen, Germany
+// 
+// For a full list of authors and contributors, please refer to the file "AUTHORS.txt".
+// 
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file 
+// except in compliance with the License. You may obtain a copy of the License at
+// 
+// http://www.apache.org/licenses/LICENSE-2.0
+// 
+// Unless required by applicable law or agreed to in writing, software distributed under the 
+// License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, 
+// either express or implied. See the License for the specific language governing permissions 
+// and limitations under the License.
+// 
+// ================================================================================================
+
+
+#ifndef IGTLLOOPBACKSERVER_H__
+#define IGTLLOOPBACKSERVER_H__
+
+#include <igtlServerSocket.h>
+
+#include <cgt/vector.h>
+
+#include <ext/threading.h>
+#include <tbb/atomic.h>
+
+#include "modules/modulesapi.h"
+
+#include <string>
+
+namespace campvis {
+
+    /**
+     * Minimal local OpenIGTLink server streaming synthetic IMAGE messages.
+     * 
+     * Intended for benchmarking the throughput and latency of OpenIGTLinkClient: Each message is
+     * time-stamped right before sending, so that a client on the same machine can compute the 
+     * transport latency from the message time stamp.
+     */
+    class CAMPVIS_MODULES_API IgtlLoopbackServer {
+    public:
+        /**
+         * Creates a new IgtlLoopbackServer, use start() to start serving.
+         */
+        IgtlLoopbackServer();
+
+        /**
+         * Destructor, stops the server if running.
+         */
+        ~IgtlLoopbackServer();
+
+        /**
+         * Starts the server thread, which waits for a client and then streams images to it.
+         * \param   port            Port to listen on
+         * \param   deviceName      Device name of the sent messages
+         * \param   imageSize       Size of the sent images
+         * \param   framesPerSecond Frame rate to send with, 0 sends as fast as possible
+         * \return  True if the server socket could be created.
+         */
+        bool start(int port, const std::string& deviceName, const cgt::ivec2& imageSize, float framesPerSecond);
+
+        /**
+         * Stops the server thread and closes all connections.
+         */
+        void stop();
+
+        /**
+         * Returns whether the server thread is running.
+         * \return  _running
+         */
+        bool isRunning() const;
+
+        /**
+         * Returns the number of frames sent since start().
+         * \return  _numFramesSent
+         */
+        size_t getNumFramesSent() const;
+
+        /**
+         * Returns the average send rate since the first client connected.
+         * \return  Number of sent frames per second.
+         */
+        double getFramesPerSecond() const;
+
+    private:
+        /// Main method of the server thread.
+        void run();
+
+        igtl::ServerSocket::Pointer _serverSocket;  ///< Server socket accepting the client
+        std::string _deviceName;                    ///< Device name of the sent messages
+        cgt::ivec2 _imageSize;                      ///< Size of the sent images
+        float _framesPerSecond;                     ///< Frame rate to send with, 0 for unlimited
+
+        std::thread* _thread;                       ///< Server thread
+        tbb::atomic<bool> _stopExecution;           ///< Flag whether the server thread should stop
+        tbb::atomic<bool> _running;                 ///< Flag whether the server thread is running
+        tbb::atomic<size_t> _numFramesSent;         ///< Number of frames sent since start()
+        tbb::atomic<size_t> _sendDuration;          ///< Time since the first client connected in microseconds
+
+        static const std::string loggerCat_;
+    };
+
+}
+
+#endif // IGTLLOOPBACKSERVER_H__
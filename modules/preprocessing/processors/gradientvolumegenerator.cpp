@@ -31,9 +31,46 @@
 
 #include "core/datastructures/imagedata.h"
 #include "core/datastructures/genericimagerepresentationlocal.h"
+#include "core/tools/voxelview.h"
 
 namespace campvis {
 
+    namespace {
+        /**
+         * Computes the gradients of a single-channel image using central differences, writing
+         * vec4(gradient, gradient magnitude) to the output representation.
+         */
+        struct GradientFunctor {
+            GradientFunctor(GenericImageRepresentationLocal<float, 4>* output, const cgt::vec3& voxelSize)
+                : _output(output)
+                , _voxelSize(voxelSize)
+            {}
+
+            template<typename BASETYPE>
+            void operator() (const VoxelView<BASETYPE, 1>& input) const {
+                const cgt::svec3& size = input.getSize();
+                cgt::vec4* out = _output->getImageData();
+                const cgt::vec3 voxelSize = _voxelSize;
+
+                tbb::parallel_for(tbb::blocked_range2d<size_t>(0, size.z, 0, size.y), [&] (const tbb::blocked_range2d<size_t>& range) {
+                    for (size_t z = range.rows().begin(); z != range.rows().end(); ++z) {
+                        for (size_t y = range.cols().begin(); y != range.cols().end(); ++y) {
+                            size_t index = input.positionToIndex(cgt::svec3(0, y, z));
+                            for (size_t x = 0; x < size.x; ++x, ++index) {
+                                // central differences point from higher to lower intensities to stay compatible with the former implementation
+                                cgt::vec3 gradient = -input.getGradient(cgt::svec3(x, y, z)) / voxelSize;
+                                out[index] = cgt::vec4(gradient, cgt::length(gradient));
+                            }
+                        }
+                    }
+                });
+            }
+
+            GenericImageRepresentationLocal<float, 4>* _output;
+            cgt::vec3 _voxelSize;
+        };
+    }
+
     const std::string GradientVolumeGenerator::loggerCat_ = "CAMPVis.modules.classification.GradientVolumeGenerator";
 
     GradientVolumeGenerator::GradientVolumeGenerator()
@@ -56,35 +93,12 @@ namespace campvis {
             ImageData* id = new ImageData(input->getDimensionality(), input->getSize(), 4);
             GenericImageRepresentationLocal<float, 4>* output = GenericImageRepresentationLocal<float, 4>::create(id, 0);
 
-            tbb::parallel_for(tbb::blocked_range<size_t>(0, input->getNumElements()), [&] (const tbb::blocked_range<size_t>& range) {
-                for (size_t i = range.begin(); i != range.end(); ++i) {
-                    cgt::svec3 pos = input->getParent()->indexToPosition(i);
-                    const cgt::svec3& size = input->getSize();
-
-                    float dx, dy, dz, mdx, mdy, mdz;
-                    dx = dy = dz = mdx = mdy = mdz = 0.f;
-
-                    if (pos.x != size.x - 1)
-                        dx = input->getElementNormalized(pos + cgt::svec3(1, 0, 0), 0);
-                    if (pos.y != size.y - 1)
-                        dy = input->getElementNormalized(pos + cgt::svec3(0, 1, 0), 0);
-                    if (pos.z != size.z - 1)
-                        dz = input->getElementNormalized(pos + cgt::svec3(0, 0, 1), 0);
-
-                    if (pos.x != 0)
-                        mdx = input->getElementNormalized(pos + cgt::svec3(-1, 0, 0), 0);
-                    if (pos.y != 0)
-                        mdy = input->getElementNormalized(pos + cgt::svec3(0, -1, 0), 0);
-                    if (pos.z != 0)
-                        mdz = input->getElementNormalized(pos + cgt::svec3(0, 0, -1), 0);
-
-
-                    cgt::vec3 gradient(mdx - dx, mdy - dy, mdz - dz);
-                    gradient /= input->getParent()->getMappingInformation().getVoxelSize() * cgt::vec3(2.f);
-
-                    output->setElement(i, cgt::vec4(gradient, cgt::length(gradient)));
-                }
-            });
+            GradientFunctor functor(output, input->getParent()->getMappingInformation().getVoxelSize());
+            if (! dispatchVoxelView<1>(input, functor)) {
+                LERROR("Gradient computation is only supported for single-channel images.");
+                delete id;
+                return;
+            }
 
             data.addData(p_targetImageID.getValue(), id);
         }
@@ -59,6 +59,8 @@ namespace campvis {
         virtual const std::string getAuthor() const { return "Christian Schulte zu Berge <christian.szb@in.tum.de>"; };
         /// \see AbstractProcessor::getProcessorState()
         virtual ProcessorState getProcessorState() const { return AbstractProcessor::EXPERIMENTAL; };
+        /// \see AbstractProcessor::supportsConcurrentExecution()
+        virtual bool supportsConcurrentExecution() const { return true; };
 
         DataNameProperty p_sourceImageID;   ///< ID for input volume
         DataNameProperty p_targetImageID;   ///< ID for output gradient volume
@@ -67,9 +67,41 @@ namespace campvis {
             ImageRepresentationLocal* output = input->clone(id);
 
             if (p_filterMode.getOptionValue() == "median") {
-                tbb::parallel_for(
-                    tbb::blocked_range<size_t>(0, input->getNumElements()), 
-                    ImageFilterMedian(input, output, p_kernelSize.getValue()));
+                // dispatch the typed median filter, tiling the image into slabs of adjacent rows
+                const ImageRepresentationLocal* inputRep = input;
+                tbb::blocked_range2d<size_t> rows(0, inputRep->getSize().z, 0, inputRep->getSize().y);
+                size_t kernelSize = p_kernelSize.getValue();
+
+#define PERFORM_TYPED_MEDIAN_FILTER(BASETYPE) \
+                tbb::parallel_for(rows, ImageFilterMedianTyped<BASETYPE>( \
+                    static_cast<const GenericImageRepresentationLocal<BASETYPE, 1>*>(inputRep), \
+                    static_cast<GenericImageRepresentationLocal<BASETYPE, 1>*>(output), \
+                    kernelSize)); \
+                break;
+
+                switch (inputRep->getWeaklyTypedPointer()._baseType) {
+                    case WeaklyTypedPointer::UINT8:
+                        PERFORM_TYPED_MEDIAN_FILTER(uint8_t)
+                    case WeaklyTypedPointer::INT8:
+                        PERFORM_TYPED_MEDIAN_FILTER(int8_t)
+                    case WeaklyTypedPointer::UINT16:
+                        PERFORM_TYPED_MEDIAN_FILTER(uint16_t)
+                    case WeaklyTypedPointer::INT16:
+                        PERFORM_TYPED_MEDIAN_FILTER(int16_t)
+                    case WeaklyTypedPointer::UINT32:
+                        PERFORM_TYPED_MEDIAN_FILTER(uint32_t)
+                    case WeaklyTypedPointer::INT32:
+                        PERFORM_TYPED_MEDIAN_FILTER(int32_t)
+                    case WeaklyTypedPointer::FLOAT:
+                        PERFORM_TYPED_MEDIAN_FILTER(float)
+                    default:
+                        tbb::parallel_for(
+                            tbb::blocked_range<size_t>(0, input->getNumElements()), 
+                            ImageFilterMedian(input, output, p_kernelSize.getValue()));
+                        break;
+                }
+
+#undef PERFORM_TYPED_MEDIAN_FILTER
             }
 
             data.addData(p_targetImageID.getValue(), id);
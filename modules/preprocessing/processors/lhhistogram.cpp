@@ -35,27 +35,28 @@
 #include "core/datastructures/genericimagerepresentationlocal.h"
 #include "core/datastructures/imagerepresentationgl.h"
 #include "core/tools/concurrenthistogram.h"
+#include "core/tools/voxelview.h"
 
 namespace campvis {
+    template<typename BASETYPE>
     class LHGenerator {
     public:
-        LHGenerator(const ImageRepresentationLocal* intensities, const GenericImageRepresentationLocal<float, 4>* gradients, ImageRepresentationLocal* fl, ImageRepresentationLocal* fh, float epsilon)
+        LHGenerator(const VoxelView<BASETYPE, 1>& intensities, const VoxelView<float, 4>& gradients, GenericImageRepresentationLocal<float, 1>* fl, GenericImageRepresentationLocal<float, 1>* fh, float epsilon)
             : _intensities(intensities)
             , _gradients(gradients)
-            , _fl(fl)
-            , _fh(fh)
+            , _fl(fl->getImageData())
+            , _fh(fh->getImageData())
             , _epsilon(epsilon)
         {
-            cgtAssert(_intensities->getDimensionality() == _gradients->getDimensionality(), "Dimensionality of intensities volumes must match!");
-            cgtAssert(_intensities->getSize() == _gradients->getSize(), "Size of intensities volumes must match!");
+            cgtAssert(_intensities.getSize() == _gradients.getSize(), "Size of intensities volumes must match!");
         }
 
         void operator() (const tbb::blocked_range<size_t>& range) const {
             for (size_t i = range.begin(); i != range.end(); ++i) {
-                cgt::svec3 pos = _intensities->getParent()->indexToPosition(i);
+                cgt::svec3 pos = _intensities.indexToPosition(i);
 
-                const cgt::vec4& gradient = _gradients->getElement(i);
-                float fl = _intensities->getElementNormalized(i, 0);
+                const cgt::vec4& gradient = _gradients.getElement(i);
+                float fl = _intensities.getNormalized(i, 0);
                 float fh = fl;
 
                 if (gradient.w > 0) {
@@ -66,44 +67,55 @@ namespace campvis {
                     fl = std::min(forwardIntensity, backwardIntensity);
                 }
 
-                _fl->setElementNormalized(i, 0, fl);
-                _fh->setElementNormalized(i, 0, fh);
+                _fl[i] = fl;
+                _fh[i] = fh;
             }
         }
 
     protected:
-        cgt::vec4 getGradientLinear(const cgt::vec3& position) const {
-            cgt::vec4 result;
-            result.x = _gradients->getElementNormalizedLinear(position, 0);
-            result.y = _gradients->getElementNormalizedLinear(position, 1);
-            result.z = _gradients->getElementNormalizedLinear(position, 2);
-            result.w = _gradients->getElementNormalizedLinear(position, 3);
-            return result;
-        }
-
         float integrateHeun(cgt::vec3 position, const cgt::vec4& direction) const {
             cgt::vec4 gradient1 = direction;
             cgt::vec3 stepSize(.25f);
-            cgt::vec3 size(_intensities->getSize());
+            cgt::vec3 size(_intensities.getSize());
             size_t numSteps = 0;
 
             while (abs(gradient1.w) < _epsilon) {
-                cgt::vec4 gradient2 = getGradientLinear(position + cgt::normalize(gradient1.xyz()) * stepSize/2.f);
+                cgt::vec4 gradient2 = _gradients.getNormalizedLinear(position + cgt::normalize(gradient1.xyz()) * stepSize/2.f);
                 position += cgt::normalize((gradient1 + gradient2).xyz()) * stepSize;
-                gradient1 = getGradientLinear(position);
+                gradient1 = _gradients.getNormalizedLinear(position);
                 ++numSteps;
 
                 if (numSteps > 128 || cgt::hor(cgt::lessThan(position, cgt::vec3::zero)) || cgt::hor(cgt::greaterThan(position, size)))
                     break;
             }
 
-            return _intensities->getElementNormalizedLinear(position, 0);;
+            return _intensities.getNormalizedLinear(position, 0);
+        }
+
+        VoxelView<BASETYPE, 1> _intensities;
+        VoxelView<float, 4> _gradients;
+        float* _fl;
+        float* _fh;
+        float _epsilon;
+    };
+
+    /// Dispatches LHGenerator on the base type of the intensities image.
+    struct LHGeneratorDispatcher {
+        LHGeneratorDispatcher(const VoxelView<float, 4>& gradients, GenericImageRepresentationLocal<float, 1>* fl, GenericImageRepresentationLocal<float, 1>* fh, float epsilon)
+            : _gradients(gradients)
+            , _fl(fl)
+            , _fh(fh)
+            , _epsilon(epsilon)
+        {}
+
+        template<typename BASETYPE>
+        void operator() (const VoxelView<BASETYPE, 1>& intensities) const {
+            tbb::parallel_for(tbb::blocked_range<size_t>(0, intensities.getNumElements()), LHGenerator<BASETYPE>(intensities, _gradients, _fl, _fh, _epsilon));
         }
 
-        const ImageRepresentationLocal* _intensities;
-        const GenericImageRepresentationLocal<float, 4>* _gradients;
-        ImageRepresentationLocal* _fl;
-        ImageRepresentationLocal* _fh;
+        VoxelView<float, 4> _gradients;
+        GenericImageRepresentationLocal<float, 1>* _fl;
+        GenericImageRepresentationLocal<float, 1>* _fh;
         float _epsilon;
     };
 
@@ -111,25 +123,33 @@ namespace campvis {
 
     class LHHistogramGenerator {
     public:
-        LHHistogramGenerator(const ImageRepresentationLocal* fl, const ImageRepresentationLocal* fh, ConcurrentGenericHistogramND<float, 2>* histogram)
+        LHHistogramGenerator(const VoxelView<float, 1>& fl, const VoxelView<float, 1>& fh, ConcurrentGenericHistogramND<float, 2>* histogram)
             : _fl(fl)
             , _fh(fh)
             , _histogram(histogram)
         {
-            cgtAssert(_fh->getDimensionality() == _fl->getDimensionality(), "Dimensionality of input volumes must match!");
-            cgtAssert(_fh->getSize() == _fl->getSize(), "Size of input volumes must match!");
+            cgtAssert(_fh.getSize() == _fl.getSize(), "Size of input volumes must match!");
         }
 
 
     void operator() (const tbb::blocked_range<size_t>& range) const {
-        for (size_t i = range.begin(); i != range.end(); ++i) {
-            float values[2] = { _fl->getElementNormalized(i, 0), _fh->getElementNormalized(i, 0) };
-            _histogram->addSample(values);
+        static const size_t BATCH_SIZE = 256;
+        float values[2 * BATCH_SIZE];
+        const float* fl = _fl.getData();
+        const float* fh = _fh.getData();
+
+        for (size_t start = range.begin(); start < range.end(); start += BATCH_SIZE) {
+            const size_t count = std::min(BATCH_SIZE, range.end() - start);
+            for (size_t i = 0; i < count; ++i) {
+                values[2*i] = fl[start + i];
+                values[2*i + 1] = fh[start + i];
+            }
+            _histogram->addSamples(values, count);
         }
     }
     protected:
-        const ImageRepresentationLocal* _fl;
-        const ImageRepresentationLocal* _fh;
+        VoxelView<float, 1> _fl;
+        VoxelView<float, 1> _fh;
         ConcurrentGenericHistogramND<float, 2>* _histogram;
     };
 
@@ -159,21 +179,28 @@ namespace campvis {
         GenericImageRepresentationLocal<float, 4>::ScopedRepresentation gradients(data, p_gradientsId.getValue());
 
         if (intensities != 0 && gradients != 0) {
+            if (intensities->getParent()->getNumChannels() != 1) {
+                LERROR("LH histogram computation is only supported for single-channel intensity images.");
+                return;
+            }
+
             ImageData* imgFl = new ImageData(intensities->getDimensionality(), intensities->getSize(), 1);
-            ImageRepresentationLocal* fl = GenericImageRepresentationLocal<float, 1>::create(imgFl, 0);
+            GenericImageRepresentationLocal<float, 1>* fl = GenericImageRepresentationLocal<float, 1>::create(imgFl, 0);
 
             ImageData* imgFh = new ImageData(intensities->getDimensionality(), intensities->getSize(), 1);
-            ImageRepresentationLocal* fh = GenericImageRepresentationLocal<float, 1>::create(imgFh, 0);
+            GenericImageRepresentationLocal<float, 1>* fh = GenericImageRepresentationLocal<float, 1>::create(imgFh, 0);
 
             const GenericImageRepresentationLocal<float, 4>* ggg = gradients;
-            tbb::parallel_for(tbb::blocked_range<size_t>(0, intensities->getNumElements()), LHGenerator(intensities, ggg, fl, fh, .003f));
+            LHGeneratorDispatcher generator(VoxelView<float, 4>(ggg), fl, fh, .003f);
+            dispatchVoxelView<1>(intensities, generator);
 
             Interval<float> interval = intensities->getNormalizedIntensityRange();
             float mins[2] = { interval.getLeft(), interval.getLeft() };
             float maxs[2] = { interval.getRight(), interval.getRight() };
             size_t numBuckets[2] = { 256, 256 };
             ConcurrentGenericHistogramND<float, 2> lhHistogram(mins, maxs, numBuckets);
-            tbb::parallel_for(tbb::blocked_range<size_t>(0, intensities->getNumElements()), LHHistogramGenerator(fl, fh, &lhHistogram));
+            tbb::parallel_for(tbb::blocked_range<size_t>(0, intensities->getNumElements()), LHHistogramGenerator(VoxelView<float, 1>(fl), VoxelView<float, 1>(fh), &lhHistogram));
+            lhHistogram.mergeLocalBuckets();
 
             // TODO: ugly hack...
             float* tmp = new float[256*256];
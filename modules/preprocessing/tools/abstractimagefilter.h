@@ -29,6 +29,13 @@
 #include "cgt/assert.h"
 #include "modules/modulesapi.h"
 
+#include "core/datastructures/genericimagerepresentationlocal.h"
+#include "core/tools/typetraits.h"
+
+#include <algorithm>
+#include <limits>
+#include <memory>
+#include <type_traits>
 #include <vector>
 
 namespace campvis {
@@ -46,6 +53,244 @@ namespace campvis {
         size_t _kernelSize;
     };
 
+// = Typed median filter ==========================================================================
+
+    /**
+     * Traits for the typed median filter defining whether and how the values of a base type can
+     * be mapped to histogram bins.
+     * Base types with NUMBITS == 0 are not suitable for histogram-based median filtering.
+     * \tparam  T   Base type of the image data.
+     */
+    template<typename T>
+    struct MedianFilterTraits {
+        static const size_t NUMBITS = 0;
+        static size_t toBin(T value) { return 0; };
+        static T fromBin(size_t bin) { return T(0); };
+    };
+
+    /**
+     * Template specialization for 8 bit and 16 bit integer types.
+     * Maps the value range of T linearly to the bins [0, 2^NUMBITS).
+     */
+    template<typename T, size_t N>
+    struct IntegerMedianFilterTraits {
+        static const size_t NUMBITS = N;
+        static size_t toBin(T value) { return static_cast<size_t>(static_cast<int>(value) - std::numeric_limits<T>::min()); };
+        static T fromBin(size_t bin) { return static_cast<T>(static_cast<int>(bin) + std::numeric_limits<T>::min()); };
+    };
+
+    template<> struct MedianFilterTraits<uint8_t> : public IntegerMedianFilterTraits<uint8_t, 8> {};
+    template<> struct MedianFilterTraits<int8_t> : public IntegerMedianFilterTraits<int8_t, 8> {};
+    template<> struct MedianFilterTraits<uint16_t> : public IntegerMedianFilterTraits<uint16_t, 16> {};
+    template<> struct MedianFilterTraits<int16_t> : public IntegerMedianFilterTraits<int16_t, 16> {};
+
+
+    /**
+     * Histogram over 2^NUMBITS bins supporting fast insertion, removal and median queries as 
+     * needed for sliding window median filtering (Huang's algorithm).
+     * Uses an additional coarse histogram over 2^(NUMBITS/2) bins, so that a median query touches
+     * at most 2 * 2^(NUMBITS/2) bins (as proposed by Perreault and Hebert).
+     * \tparam  NUMBITS     Number of bits of the histogrammed values.
+     */
+    template<size_t NUMBITS>
+    class SlidingMedianHistogram {
+    public:
+        SlidingMedianHistogram()
+            : _coarse(size_t(1) << COARSE_BITS, 0)
+            , _fine(size_t(1) << NUMBITS, 0)
+            , _count(0)
+        {};
+
+        /// Adds a sample to bin \a bin.
+        void add(size_t bin) {
+            ++_fine[bin];
+            ++_coarse[bin >> FINE_BITS];
+            ++_count;
+        };
+
+        /// Removes a sample from bin \a bin.
+        void remove(size_t bin) {
+            --_fine[bin];
+            --_coarse[bin >> FINE_BITS];
+            --_count;
+        };
+
+        /// Returns the number of samples in the histogram.
+        size_t getCount() const {
+            return _count;
+        };
+
+        /**
+         * Returns the bin of the sample with rank getCount()/2, which is the median for odd sample
+         * counts and the upper median for even sample counts.
+         * \note    The histogram must not be empty.
+         */
+        size_t getMedianBin() const {
+            const size_t rank = _count / 2;
+            size_t accumulated = 0;
+
+            size_t coarseBin = 0;
+            while (accumulated + _coarse[coarseBin] <= rank)
+                accumulated += _coarse[coarseBin++];
+
+            size_t bin = coarseBin << FINE_BITS;
+            while (accumulated + _fine[bin] <= rank)
+                accumulated += _fine[bin++];
+
+            return bin;
+        };
+
+    private:
+        static const size_t COARSE_BITS = NUMBITS / 2;
+        static const size_t FINE_BITS = NUMBITS - COARSE_BITS;
+
+        std::vector<uint32_t> _coarse;  ///< coarse histogram, each bin accumulates 2^FINE_BITS fine bins
+        std::vector<uint32_t> _fine;    ///< fine histogram
+        size_t _count;                  ///< total number of samples
+    };
+
+
+    /**
+     * Median filter for single-channel images working directly on the typed image data of a
+     * GenericImageRepresentationLocal<BASETYPE, 1>, hence without any virtual calls per voxel.
+     * 
+     *  - 8 bit and 16 bit integer images are filtered with a sliding-window histogram along 
+     *    each row, so that each step only adds and removes one column of the kernel.
+     *  - All other base types select the median from a per-thread scratch buffer.
+     * 
+     * Yields the same results as ImageFilterMedian. The range to process are z-slices and rows,
+     * so that tiles cover adjacent rows of the same slabs and neighbouring rows stay in cache.
+     * 
+     * \tparam  BASETYPE    Base type of the image data.
+     */
+    template<typename BASETYPE>
+    struct ImageFilterMedianTyped {
+    public:
+        /// Type of the input and output image representation
+        typedef GenericImageRepresentationLocal<BASETYPE, 1> ImageType;
+        /// Type of the per-thread histogram
+        typedef SlidingMedianHistogram<MedianFilterTraits<BASETYPE>::NUMBITS> HistogramType;
+
+        ImageFilterMedianTyped(const ImageType* input, ImageType* output, size_t kernelSize)
+            : _input(input)
+            , _output(output)
+            , _kernelSize(kernelSize)
+            , _histograms(new tbb::enumerable_thread_specific<HistogramType>())
+            , _scratch(new tbb::enumerable_thread_specific< std::vector<BASETYPE> >())
+        {
+            cgtAssert(input != 0, "Input image must not be 0.");
+            cgtAssert(output != 0, "Output image must not be 0.");
+            cgtAssert(kernelSize > 0, "Kernel Size must be greater 0.");
+        };
+
+        /**
+         * Filters all rows in the given range.
+         * \param   range   Range of slices (rows of \a range) and rows (cols of \a range) to filter.
+         */
+        void operator() (const tbb::blocked_range2d<size_t>& range) const {
+            const size_t halfKernelDim = _kernelSize / 2;
+            const cgt::svec3& size = _input->getSize();
+
+            for (size_t z = range.rows().begin(); z != range.rows().end(); ++z) {
+                size_t zmin = z >= halfKernelDim ? z - halfKernelDim : 0;
+                size_t zmax = std::min(z + halfKernelDim, size.z - 1);
+
+                for (size_t y = range.cols().begin(); y != range.cols().end(); ++y) {
+                    size_t ymin = y >= halfKernelDim ? y - halfKernelDim : 0;
+                    size_t ymax = std::min(y + halfKernelDim, size.y - 1);
+
+                    filterRow(z, y, cgt::svec2(ymin, ymax), cgt::svec2(zmin, zmax), std::integral_constant<bool, (MedianFilterTraits<BASETYPE>::NUMBITS > 0)>());
+                }
+            }
+        };
+
+    protected:
+        /**
+         * Converts \a value the same way as ImageFilterMedian does by normalizing to float and
+         * denormalizing back, so that the results of both filters are bit-identical.
+         */
+        static BASETYPE roundTrip(BASETYPE value) {
+            return TypeNormalizer::denormalizeFromFloat<BASETYPE>(TypeNormalizer::normalizeToFloat(value));
+        };
+
+        /// Filters row (\a y, \a z) using a sliding-window histogram.
+        void filterRow(size_t z, size_t y, const cgt::svec2& yRange, const cgt::svec2& zRange, std::true_type) const {
+            const size_t halfKernelDim = _kernelSize / 2;
+            const cgt::svec3& size = _input->getSize();
+            const BASETYPE* input = _input->getImageData();
+            BASETYPE* output = _output->getImageData() + (z * size.y + y) * size.x;
+            HistogramType& histogram = _histograms->local();
+
+            // adds/removes all voxels of column x within the kernel to/from the histogram
+            auto updateColumn = [&] (size_t x, bool add) {
+                for (size_t zz = zRange.x; zz <= zRange.y; ++zz) {
+                    const BASETYPE* column = input + zz * size.x * size.y + x;
+                    for (size_t yy = yRange.x; yy <= yRange.y; ++yy) {
+                        size_t bin = MedianFilterTraits<BASETYPE>::toBin(column[yy * size.x]);
+                        if (add)
+                            histogram.add(bin);
+                        else
+                            histogram.remove(bin);
+                    }
+                }
+            };
+
+            for (size_t x = 0; x <= std::min(halfKernelDim, size.x - 1); ++x)
+                updateColumn(x, true);
+
+            for (size_t x = 0; x < size.x; ++x) {
+                output[x] = roundTrip(MedianFilterTraits<BASETYPE>::fromBin(histogram.getMedianBin()));
+
+                // slide the window one voxel to the right
+                if (x + halfKernelDim + 1 < size.x)
+                    updateColumn(x + halfKernelDim + 1, true);
+                if (x >= halfKernelDim)
+                    updateColumn(x - halfKernelDim, false);
+            }
+
+            // clear the histogram for the next row
+            for (size_t x = (size.x > halfKernelDim ? size.x - halfKernelDim : 0); x < size.x; ++x)
+                updateColumn(x, false);
+
+            cgtAssert(histogram.getCount() == 0, "Histogram should be empty after filtering a row.");
+        };
+
+        /// Filters row (\a y, \a z) by selecting the median from a per-thread scratch buffer.
+        void filterRow(size_t z, size_t y, const cgt::svec2& yRange, const cgt::svec2& zRange, std::false_type) const {
+            const size_t halfKernelDim = _kernelSize / 2;
+            const cgt::svec3& size = _input->getSize();
+            const BASETYPE* input = _input->getImageData();
+            BASETYPE* output = _output->getImageData() + (z * size.y + y) * size.x;
+            std::vector<BASETYPE>& values = _scratch->local();
+
+            for (size_t x = 0; x < size.x; ++x) {
+                size_t xmin = x >= halfKernelDim ? x - halfKernelDim : 0;
+                size_t xmax = std::min(x + halfKernelDim, size.x - 1);
+
+                values.clear();
+                for (size_t zz = zRange.x; zz <= zRange.y; ++zz) {
+                    for (size_t yy = yRange.x; yy <= yRange.y; ++yy) {
+                        const BASETYPE* row = input + (zz * size.y + yy) * size.x;
+                        values.insert(values.end(), row + xmin, row + xmax + 1);
+                    }
+                }
+
+                size_t medianPosition = values.size() / 2;
+                std::nth_element(values.begin(), values.begin() + medianPosition, values.end());
+                output[x] = roundTrip(values[medianPosition]);
+            }
+        };
+
+        const ImageType* _input;
+        ImageType* _output;
+        size_t _kernelSize;
+
+        /// Per-thread histograms, shared between all copies of this functor.
+        std::shared_ptr< tbb::enumerable_thread_specific<HistogramType> > _histograms;
+        /// Per-thread scratch buffers, shared between all copies of this functor.
+        std::shared_ptr< tbb::enumerable_thread_specific< std::vector<BASETYPE> > > _scratch;
+    };
+
 }
 
 #endif // ABSTRACTIMAGEFILTER_H__
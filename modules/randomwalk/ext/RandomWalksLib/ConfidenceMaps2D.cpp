@@ -10,6 +10,9 @@ ConfidenceMaps2D::~ConfidenceMaps2D()
 
 void ConfidenceMaps2D::setMatrix2D(const std::vector<double> * matrix, int rows, int cols, bool normalizeValues)
 {
+	// The sparsity pattern of the Laplacian only depends on the matrix size
+	this->invalidateLaplacian(rows != this->rows || cols != this->cols);
+
 	this->matrix = matrix;
 	this->rows = rows;
 	this->cols = cols;
@@ -70,7 +73,9 @@ void ConfidenceMaps2D::assembleLaplacianEdges()
 	// Numerical limit to avoid division by zero and add to the weights to avoid zero weights in Laplacian
 	const double epsilon = 1.0e-5;
 
-	this->L.resize(numel,numel);
+	// Keep the existing sparsity pattern if available and only update the weights
+	if(!isStructureAvailable)
+		this->L.resize(numel,numel);
 
 	// Find min and max weights
 
@@ -120,7 +125,8 @@ void ConfidenceMaps2D::assembleLaplacianEdges()
 	// Reserve 5 non-zero entries for each column.
 	// This is the case for the 4-connected lattice.
 	// Always reserve more than less entries (this is very crucial for performance)
-	L.reserve(VectorXi::Constant(numel,5));
+	if(!isStructureAvailable)
+		L.reserve(VectorXi::Constant(numel,5));
 
 	// Horizontal edges
 	for(int i=0; i<= numel-rows-1; i++)
@@ -135,8 +141,7 @@ void ConfidenceMaps2D::assembleLaplacianEdges()
 		weight = (weight - min_weight) / diff;
 		weight = exp(-beta*weight) + epsilon; // Compute Gaussian weighting
 
-		L.insert(i,i+rows) = -weight;
-		L.insert(i+rows,i) = -weight;
+		setEdgeWeight(i,i+rows,weight);
 	}
 
 	// Vertical edges
@@ -148,8 +153,7 @@ void ConfidenceMaps2D::assembleLaplacianEdges()
 			weight = (weight - min_weight) / diff;
 			weight = exp(-beta*weight) + epsilon; // Compute Gaussian weighting
 
-			L.insert(i+j,i+j+1) = -weight;
-			L.insert(i+j+1,i+j) = -weight;
+			setEdgeWeight(i+j,i+j+1,weight);
 		}
 	}
 }
\ No newline at end of file
@@ -1,7 +1,12 @@
 #include "ConfidenceMaps2DFacade.h"
 
 
-ConfidenceMaps2DFacade::ConfidenceMaps2DFacade()
+ConfidenceMaps2DFacade::ConfidenceMaps2DFacade():
+rows(0),
+cols(0),
+alpha(-1.0),
+beta(-1.0),
+gamma(-1.0)
 {
 }
 
@@ -11,6 +16,14 @@ ConfidenceMaps2DFacade::~ConfidenceMaps2DFacade()
 
 std::vector<double> ConfidenceMaps2DFacade::computeMap(double beta, double gamma)
 {
+	// The previous solution is no good initial guess if the parameters changed
+	if(beta != this->beta || gamma != this->gamma)
+	{
+		maps2D.resetSolver();
+		this->beta = beta;
+		this->gamma = gamma;
+	}
+
 	maps2D.setBeta(beta);
 	maps2D.setGamma(gamma);
 
@@ -21,8 +34,21 @@ std::vector<double> ConfidenceMaps2DFacade::computeMap(double beta, double gamma
 
 void ConfidenceMaps2DFacade::setImage(std::vector<double> &image, int rows, int cols, double alpha, bool normalizeValues)
 {
+	if(alpha != this->alpha)
+	{
+		maps2D.resetSolver();
+		this->alpha = alpha;
+	}
+
 	maps2D.setAlpha(alpha);
 	maps2D.setMatrix2D(&image,rows,cols,normalizeValues);
+
+	// Seeds only depend on the image size, keep them (and thereby the sparsity pattern) otherwise
+	if(rows == this->rows && cols == this->cols)
+		return;
+
+	this->rows = rows;
+	this->cols = cols;
 	this->seeds.clear();
 	this->labels.clear();
 
@@ -61,4 +87,14 @@ void ConfidenceMaps2DFacade::setImage(std::vector<double> &image, int rows, int
 void ConfidenceMaps2DFacade::setSolver(std::string solver, int iterations, double tolerance)
 {
 	maps2D.setSolver(solver,iterations,tolerance);
+}
+
+int ConfidenceMaps2DFacade::getLastIterations() const
+{
+	return maps2D.getLastIterations();
+}
+
+double ConfidenceMaps2DFacade::getLastSolveTime() const
+{
+	return maps2D.getLastSolveTime();
 }
\ No newline at end of file
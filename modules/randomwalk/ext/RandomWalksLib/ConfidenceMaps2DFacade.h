@@ -32,14 +32,28 @@ public:
 	std::vector<double> computeMap(double beta = 100, double gamma = 0.06);
 
 	/// Set external image 2D as vector with column-major ordering
+	/** The facade can be reused for a sequence of images (e.g. an ultrasound stream). As long as the image size
+	 *	and the parameters do not change, the sparsity pattern, symbolic factorization and the previous solution
+	 *	(as initial guess for iterative solvers) are reused. */
 	void setImage(std::vector<double> &image, int rows, int cols, double alpha=2.0, bool normalizeValues=false );
 
 	/// Set desired solver (default Eigen LLT)
 	void setSolver(std::string solver, int iterations = 2000, double tolerance = 1.0e-7);
+
+	/// Get number of solver iterations needed for the last map (0 for direct solvers)
+	int getLastIterations() const;
+
+	/// Get time in milliseconds needed to compute the last map
+	double getLastSolveTime() const;
 private:
 	ConfidenceMaps2D maps2D; ///< Implementation of confidence estimation
 	std::vector<int> seeds; ///< Seeds/boundary conditions
 	std::vector<int> labels; ///< Labels for seeds
+	int rows; ///< # rows of the current image
+	int cols; ///< # cols of the current image
+	double alpha; ///< Alpha parameter of the last map
+	double beta; ///< Beta parameter of the last map
+	double gamma; ///< Gamma parameter of the last map
 };
 
 #endif
\ No newline at end of file
@@ -1,13 +1,24 @@
 #include "RandomWalksCore.h"
 #include "SparseSolverFactory.h"
+#include <chrono>
+#include <cmath>
 #include <iostream>
 
 RandomWalksCore::RandomWalksCore():
+matrix(0),
+rows(0),
+cols(0),
+numel(0),
+isStructureAvailable(false),
+lastSolveTime(0.0),
 sparseSolver(0),
-isLaplaceAvailable(false)
+isLaplaceAvailable(false),
+solverType("Eigen-LLT"),
+solverIterations(2000),
+solverTolerance(1.0e-7)
 {
 	solverFactory = new SparseSolverFactory();
-	sparseSolver = solverFactory->createSolver("Eigen-LLT");
+	sparseSolver = solverFactory->createSolver(solverType);
 }
 
 RandomWalksCore::~RandomWalksCore()
@@ -23,10 +34,27 @@ RandomWalksCore::~RandomWalksCore()
 
 void RandomWalksCore::setSolver(std::string solver, int iterations, double tolerance)
 {
+	// Keep the current solver including its state from previous solutions if nothing changed
+	if(sparseSolver!=0 && solver == solverType && iterations == solverIterations && tolerance == solverTolerance)
+		return;
+
 	if(sparseSolver!=0)
 		delete sparseSolver;
 
 	sparseSolver = solverFactory->createSolver(solver, iterations, tolerance);
+	solverType = solver;
+	solverIterations = iterations;
+	solverTolerance = tolerance;
+}
+
+void RandomWalksCore::resetSolver()
+{
+	sparseSolver->reset();
+}
+
+int RandomWalksCore::getLastIterations() const
+{
+	return sparseSolver->getLastIterations();
 }
 
 std::vector<double> RandomWalksCore::solve()
@@ -38,6 +66,8 @@ std::vector<double> RandomWalksCore::solve()
 		return nullSolution;
 	}
 
+	std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+
 	if(!isLaplaceAvailable)
 	{
 		//std::cout << "Solving..." << std::endl;
@@ -46,16 +76,29 @@ std::vector<double> RandomWalksCore::solve()
 		this->assembleLaplacianEdges(); // First edges, because those are implementation dependent
 		//std::cout << "Assemble Degree..." << std::endl;
 		this->assembleDegree(); // Then complete with degree
-		//std::cout << "Unique indices..." << std::endl;
-		this->generateUniqueIndices();
+
+		if(!isStructureAvailable)
+		{
+			//std::cout << "Unique indices..." << std::endl;
+			this->L.makeCompressed();
+			this->generateUniqueIndices();
+			this->assemble_Lu_b();
+			this->sparseSolver->reset();
+			isStructureAvailable = true;
+		}
 		isLaplaceAvailable = true;
 	}
 	//std::cout << "Assemble Ax = b..." << std::endl;
-	this->assemble_Lu_b();
+	this->update_Lu_b();
 
 	//std::cout << "Boundary conditions applied..." << std::endl;
 	//std::cout << "Solving sparse Ax=b..." << std::endl;
-	return this->sparseSolver->solve_Ax_b(Lu,b,numel,uidx,labels,seeds,active_label);
+	if(rows > 0 && cols > 0)
+		this->sparseSolver->setLatticeSize(rows, cols, numel / (rows*cols));
+	std::vector<double> solution = this->sparseSolver->solve_Ax_b(Lu,b,numel,uidx,labels,seeds,active_label);
+
+	lastSolveTime = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+	return solution;
 }
 
 void RandomWalksCore::setLabeling(const std::vector<int>  * seeds, const std::vector<int> * labels, int active_label, int num_labels)
@@ -65,49 +108,107 @@ void RandomWalksCore::setLabeling(const std::vector<int>  * seeds, const std::ve
 	this->active_label = active_label;
 	this->num_labels = num_labels;
 	this->isLaplaceAvailable = false;
+	this->isStructureAvailable = false;
+}
+
+void RandomWalksCore::invalidateLaplacian(bool structureChanged)
+{
+	this->isLaplaceAvailable = false;
+	if(structureChanged)
+		this->isStructureAvailable = false;
+}
+
+void RandomWalksCore::setEdgeWeight(int i, int j, double weight)
+{
+	if(isStructureAvailable)
+	{
+		// .coeffRef only performs a binary search in the column as the entries already exist
+		L.coeffRef(i,j) = -weight;
+		L.coeffRef(j,i) = -weight;
+	}
+	else
+	{
+		L.insert(i,j) = -weight;
+		L.insert(j,i) = -weight;
+	}
 }
 
 void RandomWalksCore::assemble_Lu_b()
 {
-	const int n = static_cast<int>(seeds->size());// # marked nodes
 	const int q = static_cast<int>(numel-seeds->size()); // # unmarked nodes
 
-	// Permutation matrix to get UNMARKED COLUMNS
-	SparseMatrix<double> Cu(numel,q);
-
+	// For each node its index in Lu if unmarked, its label as -label-1 if marked
+	std::vector<int> nodeIndex(numel);
 	for (int i=0; i<q; i++)
 	{
-		Cu.insert(uidx[i],i) = 1.0; // InsertBack because we know for this column that we place the last entry into the inner vector Eigen storage format. Its more efficient than insert.
+		nodeIndex[uidx[i]] = i;
+	}
+	for (size_t i=0; i<seeds->size(); i++)
+	{
+		nodeIndex[(*seeds)[i]] = -(*labels)[i]-1;
 	}
 
-	// Cu.transpose() means actually rows unmarked. Once again A^T C A is encountered.
-	this->Lu = Cu.transpose() * L * Cu;
+	// The unmarked columns of L in the order of uidx form the columns of Lu and B^T.
+	// As uidx is sorted, the row order within each column is preserved.
+	const int * outer = L.outerIndexPtr();
+	const int * inner = L.innerIndexPtr();
+	int nnz = 0;
+	for (int i=0; i<q; i++)
+	{
+		for (int k=outer[uidx[i]]; k<outer[uidx[i]+1]; k++)
+		{
+			if(nodeIndex[inner[k]] >= 0)
+				nnz++;
+		}
+	}
 
-	// Permutation matrix to get MARKED COLUMNS
-	SparseMatrix<double> Cm(numel,n);
+	this->Lu.resize(q,q);
+	this->Lu.reserve(nnz);
+	this->luValueIndices.clear();
+	this->luValueIndices.reserve(nnz);
+	this->boundaryEntries.clear();
 
-	for (int i=0; i<n; i++)
+	for (int i=0; i<q; i++)
 	{
-		Cm.insert((*seeds)[i],i) = 1.0;
+		this->Lu.startVec(i);
+		for (int k=outer[uidx[i]]; k<outer[uidx[i]+1]; k++)
+		{
+			int node = nodeIndex[inner[k]];
+			if(node >= 0)
+			{
+				this->Lu.insertBack(node,i) = 0.0;
+				this->luValueIndices.push_back(k);
+			}
+			else
+			{
+				// L is symmetric, hence L(uidx[i],seed) = L(seed,uidx[i])
+				BoundaryEntry entry = {i, k, -node-1};
+				this->boundaryEntries.push_back(entry);
+			}
+		}
 	}
-	SparseMatrix<double> Bt(q,n);
+	this->Lu.finalize();
 
-	Bt = Cu.transpose() * L * Cm;
+	this->b.resize(q);
+}
 
-	SparseMatrix<double> M(n,num_labels);
+void RandomWalksCore::update_Lu_b()
+{
+	const double * values = L.valuePtr();
 
-	for (int i=0; i<num_labels; i++)
+	double * luValues = this->Lu.valuePtr();
+	for (size_t i=0; i<luValueIndices.size(); i++)
 	{
-		for(int j=0; j<n; j++)
-		{
-			if((*labels)[j] == i)
-				M.insert(j,i) = 1.0;
-		}
+		luValues[i] = values[luValueIndices[i]];
 	}
 
-	SparseVector<double> CL(M.cols());
-	CL.insert(active_label) = 1.0;
-	this->b = -Bt*M*CL;
+	// b = -B^T M with M(n,1) = 1 for marked nodes n with the active label
+	this->b.setZero();
+	for (size_t i=0; i<boundaryEntries.size(); i++)
+	{
+		if(boundaryEntries[i].label == active_label)
+			this->b[boundaryEntries[i].row] -= values[boundaryEntries[i].valueIndex];
+	}
 }
 
 void RandomWalksCore::generateUniqueIndices()
@@ -130,6 +231,7 @@ void RandomWalksCore::generateUniqueIndices()
 	}
 
 	// Vecotr of unmarked nodes. Marked nodes are in seeds vector
+	uidx.clear();
 	uidx.reserve(q);
 
 	for(int i=0; i<numel; i++)
@@ -144,6 +246,7 @@ void RandomWalksCore::assembleDegree()
 	// Filling the degree (diagonal) of Lacency matrix
 	// Equals the sum of the row or column. Both are equivalent but looping throught the inner loop
 	// is more efficient for Eigen. Therefore, since we declared an column-major matrix we sum up the column entries.
+	// If the sparsity pattern is already available, the diagonal exists and is overwritten.
 
 	double degree = 0.0;
 
@@ -152,8 +255,13 @@ void RandomWalksCore::assembleDegree()
 		degree = 0.0;
 		for (SparseMatrix<double>::InnerIterator it(L,k); it; ++it)
 		{
-			degree += it.value();
+			if(it.index() != k)
+				degree += it.value();
 		}
-		L.insert(k,k) = abs(degree);
+
+		if(isStructureAvailable)
+			L.coeffRef(k,k) = std::abs(degree);
+		else
+			L.insert(k,k) = std::abs(degree);
 	}
 }
\ No newline at end of file
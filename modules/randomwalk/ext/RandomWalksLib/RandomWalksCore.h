@@ -41,14 +41,26 @@ public:
 		Eigen-LLT
 		Eigen-CG
 		Eigen-CG-Custom
+		Multigrid-CG
 		Vienna-CG-CPU
 		Vienna-CG-GPU
 	*/
+	/** The current solver and its state are kept if the parameters did not change. */
 	void setSolver(std::string solver, int iterations = 2000, double tolerance = 1.0e-7);
 
+	/// Discard any state the solver keeps from previous solutions (initial guess, factorization)
+	/** Should be called when the problem parameters change significantly, so that the previous solution is no good initial guess anymore. */
+	void resetSolver();
+
 	/// Solve the random walks problem, i.e, Lu x = -B^T M
 	std::vector<double> solve();
 
+	/// Get number of iterations the solver needed for the last solution (0 for direct solvers)
+	int getLastIterations() const;
+
+	/// Get time in milliseconds needed for the last call to solve() including the system assembly
+	double getLastSolveTime() const {return lastSolveTime;};
+
 	/// Set labeling including seeds
 	/** The matrix is given in each concrete implementation as it can be 2D and 3D */
 	void setLabeling(const std::vector<int>  * seeds, const std::vector<int> * labels, int active_label, int num_labels);
@@ -64,7 +76,16 @@ protected:
 	/** After inserting the edge connections and weights in the Laplacian simply compute the degree and fill the diagonal with it */
 	void assembleDegree();
 
-	/// Assemble block matrix Lu and the rhs for the solver b.
+	/// Set the weight of the edge between the nodes i and j in the Laplacian
+	/** Inserts the entries when assembling the Laplacian for the first time. Once the sparsity pattern is
+	 * available the existing entries are overwritten in place, which is considerably faster. */
+	void setEdgeWeight(int i, int j, double weight);
+
+	/// Mark the Laplacian as outdated, e.g. because the data matrix changed
+	/** \param structureChanged If true, also the sparsity pattern is rebuilt (e.g. because the matrix size changed). */
+	void invalidateLaplacian(bool structureChanged);
+
+	/// Assemble sparsity pattern of block matrix Lu and the rhs for the solver b.
 	/*
 	Sorted Laplace matrix for random walks/circuit problem
 
@@ -85,10 +106,14 @@ protected:
 
 	Accessing entries in sparse matrices in Eigen using for example coeff costs log(rho*outer_size)!
 
-	Therefore, we assemble the matrices through matrix operations with permutation matrix.
+	Therefore, we pick the entries of Lu and B^T directly from the compressed Laplacian once and remember their positions,
+	so that the values can be updated by update_Lu_b() without touching the sparsity pattern again.
 	*/
 	void assemble_Lu_b();
 
+	/// Copy the current values of the Laplacian into Lu and compute the rhs b for the active label
+	void update_Lu_b();
+
 	/// Generates which indices are unmarked
 	void generateUniqueIndices();
 
@@ -102,11 +127,28 @@ protected:
 
 	int numel; ///< # numel = rows * cols
 
+	/// Is the sparsity pattern of the Laplacian and Lu available
+	/** Once available, the Laplacian can be updated in place (see setEdgeWeight) */
+	bool isStructureAvailable;
+
 private:
+	/// Entry of B^T contributing to the rhs b
+	struct BoundaryEntry
+	{
+		int row; ///< Row in Lu/b
+		int valueIndex; ///< Index of the entry in the value array of L
+		int label; ///< Label of the marked node
+	};
 
 	SparseMatrix<double> Lu; ///< Block Matrix Lu from L
 
-	SparseVector<double> b; ///< rhs solution
+	VectorXd b; ///< rhs solution
+
+	std::vector<int> luValueIndices; ///< For each entry of Lu the index of the corresponding entry in the value array of L
+
+	std::vector<BoundaryEntry> boundaryEntries; ///< Entries of B^T, i.e. unmarked rows and marked columns of L
+
+	double lastSolveTime; ///< Time needed for the last solution in milliseconds
 
 	SparseSolverInterface * sparseSolver; ///< Sparse solver to be used for Ax=b
 
@@ -133,6 +175,12 @@ private:
 	bool isLaplaceAvailable;
 
 	SparseSolverFactory * solverFactory; ///< Factory for different solvers
+
+	std::string solverType; ///< Type of the current solver
+
+	int solverIterations; ///< Iterations of the current solver
+
+	double solverTolerance; ///< Tolerance of the current solver
 };
 
 #endif
\ No newline at end of file
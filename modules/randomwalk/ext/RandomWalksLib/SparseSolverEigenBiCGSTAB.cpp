@@ -7,17 +7,27 @@ SparseSolverEigenBiCGSTAB::SparseSolverEigenBiCGSTAB( int iterations, double tol
 	this->tolerance = tolerance;
 }
 
-std::vector<double> SparseSolverEigenBiCGSTAB::solve_Ax_b( SparseMatrix<double> A, SparseVector<double> b, int numel, std::vector<int> & uidx, const std::vector<int> * labels, const std::vector<int> * seeds, int active_label )
+void SparseSolverEigenBiCGSTAB::reset()
 {
-	VectorXd b_dense = b;
+	x_previous.resize(0);
+}
 
+std::vector<double> SparseSolverEigenBiCGSTAB::solve_Ax_b( const SparseMatrix<double> & A, const VectorXd & b, int numel, std::vector<int> & uidx, const std::vector<int> * labels, const std::vector<int> * seeds, int active_label )
+{
 	// Eigen Conjugate Gradient Solver, by default Jacobi Preconditioning is used
-	BiCGSTAB<SparseMatrix<double> > bcg;
 	bcg.setMaxIterations(iterations);
 	bcg.setTolerance(tolerance);
 
 	bcg.compute(A);
-	VectorXd x_dense = bcg.solve(b_dense);
+	// Warm start with the previous solution if available
+	if(x_previous.rows() == b.rows())
+		x_previous = bcg.solveWithGuess(b, x_previous);
+	else
+		x_previous = bcg.solve(b);
+
+	lastIterations = bcg.iterations();
+	lastError = bcg.error();
+	const VectorXd & x_dense = x_previous;
 
 	std::vector<double> xmat(numel);
 
@@ -6,17 +6,27 @@ SparseSolverEigenCG::SparseSolverEigenCG(int iterations, double tolerance)
 	this->tolerance = tolerance;
 }
 
-std::vector<double> SparseSolverEigenCG::solve_Ax_b(SparseMatrix<double> A, SparseVector<double> b, int numel, std::vector<int> & uidx, const std::vector<int> * labels, const std::vector<int> * seeds, int active_label)
+void SparseSolverEigenCG::reset()
 {
-	VectorXd b_dense = b;
+	x_previous.resize(0);
+}
 
+std::vector<double> SparseSolverEigenCG::solve_Ax_b(const SparseMatrix<double> & A, const VectorXd & b, int numel, std::vector<int> & uidx, const std::vector<int> * labels, const std::vector<int> * seeds, int active_label)
+{
 	// Eigen Conjugate Gradient Solver, by default Jacobi Preconditioning is used
-	ConjugateGradient<SparseMatrix<double> > cg;
 	cg.setMaxIterations(iterations);
 	cg.setTolerance(tolerance);
 
 	cg.compute(A);
-	VectorXd x_dense = cg.solve(b_dense);
+	// Warm start with the previous solution if available
+	if(x_previous.rows() == b.rows())
+		x_previous = cg.solveWithGuess(b, x_previous);
+	else
+		x_previous = cg.solve(b);
+
+	lastIterations = cg.iterations();
+	lastError = cg.error();
+	const VectorXd & x_dense = x_previous;
 
 	std::vector<double> xmat(numel);
 
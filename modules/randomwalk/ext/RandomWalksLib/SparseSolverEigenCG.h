@@ -17,10 +17,16 @@ class SparseSolverEigenCG: public SparseSolverInterface
 public:
 	SparseSolverEigenCG(int iterations, double tolerance);
 	/// Solver with CG
-	virtual std::vector<double> solve_Ax_b(SparseMatrix<double> A, SparseVector<double> b, int numel, std::vector<int> & uidx, const std::vector<int> * labels, const std::vector<int> * seeds, int active_label);
+	/** The previous solution is used as initial guess, which considerably speeds up convergence for slowly changing systems. */
+	virtual std::vector<double> solve_Ax_b(const SparseMatrix<double> & A, const VectorXd & b, int numel, std::vector<int> & uidx, const std::vector<int> * labels, const std::vector<int> * seeds, int active_label);
+
+	/// Discard the previous solution
+	virtual void reset();
 private:
 	int iterations; ///< CG iterations
 	double tolerance; ///< CG tolerance
+	ConjugateGradient<SparseMatrix<double> > cg; ///< Iterative solver, kept to avoid reallocations
+	VectorXd x_previous; ///< Previous solution used as initial guess
 };
 
 #endif
\ No newline at end of file
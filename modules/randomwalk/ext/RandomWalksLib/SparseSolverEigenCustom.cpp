@@ -6,10 +6,18 @@ SparseSolverEigenCustom::SparseSolverEigenCustom(int iterations, double toleranc
 	this->tolerance = tolerance;
 }
 
-std::vector<double> SparseSolverEigenCustom::solve_Ax_b(SparseMatrix<double> A, SparseVector<double> b, int numel, std::vector<int> & uidx, const std::vector<int> * labels, const std::vector<int> * seeds, int active_label)
+void SparseSolverEigenCustom::reset()
 {
-	// Custom solver
-	SparseVector<double> x = this->cgSolveSparse(A,b,iterations,tolerance);
+	x_previous.resize(0);
+}
+
+std::vector<double> SparseSolverEigenCustom::solve_Ax_b(const SparseMatrix<double> & A, const VectorXd & b, int numel, std::vector<int> & uidx, const std::vector<int> * labels, const std::vector<int> * seeds, int active_label)
+{
+	// Custom solver, warm started with the previous solution if available
+	if(x_previous.rows() != b.rows())
+		x_previous = SparseVector<double>(b.rows());
+	x_previous = this->cgSolveSparse(A,b.sparseView(),x_previous,iterations,tolerance);
+	const SparseVector<double> & x = x_previous;
 
 	std::vector<double> xmat(numel);
 
@@ -30,12 +38,12 @@ std::vector<double> SparseSolverEigenCustom::solve_Ax_b(SparseMatrix<double> A,
 	return xmat;
 }
 
-SparseVector<double> SparseSolverEigenCustom::cgSolveSparse(const SparseMatrix<double> & A,const SparseVector<double> & b,int iter, double residual)
+SparseVector<double> SparseSolverEigenCustom::cgSolveSparse(const SparseMatrix<double> & A,const SparseVector<double> & b,const SparseVector<double> & x0,int iter, double residual)
 {
 	SparseVector<double> r(b.rows());
 	SparseVector<double> p(b.rows());
 	SparseVector<double> Ap(b.rows());
-	SparseVector<double> x(b.rows());
+	SparseVector<double> x(x0);
 
 	r = b - A *x;
 	p = r;
@@ -43,6 +51,7 @@ SparseVector<double> SparseSolverEigenCustom::cgSolveSparse(const SparseMatrix<d
 	double rTr,pTAp,alpha,beta,rTrnew,rnorm;
 	SparseVector<double> vtemp;
 	bool isConverged = false;
+	lastIterations = iter;
 	for(int k=0;k<iter;k++)
 	{
 		Ap = A*p;
@@ -56,9 +65,11 @@ SparseVector<double> SparseSolverEigenCustom::cgSolveSparse(const SparseMatrix<d
 		x = x + (alpha * p);
 		r = r - (alpha * Ap);
 		rnorm = r.norm();
+		lastError = rnorm;
 		if(rnorm<residual)
 		{
 			isConverged = true;
+			lastIterations = k+1;
 			break;
 		}
 
@@ -17,11 +17,15 @@ class SparseSolverEigenCustom : public SparseSolverInterface
 public:
 	SparseSolverEigenCustom(int iterations, double tolerance);
 	/// Solver with CG
-	virtual std::vector<double> solve_Ax_b(SparseMatrix<double> A, SparseVector<double> b, int numel, std::vector<int> & uidx, const std::vector<int> * labels, const std::vector<int> * seeds, int active_label);
+	virtual std::vector<double> solve_Ax_b(const SparseMatrix<double> & A, const VectorXd & b, int numel, std::vector<int> & uidx, const std::vector<int> * labels, const std::vector<int> * seeds, int active_label);
+
+	/// Discard the previous solution
+	virtual void reset();
 private:
-	SparseVector<double> cgSolveSparse(const SparseMatrix<double> & A,const SparseVector<double> & b,int iter, double residual);
+	SparseVector<double> cgSolveSparse(const SparseMatrix<double> & A,const SparseVector<double> & b,const SparseVector<double> & x0,int iter, double residual);
 	int iterations; ///< CG iterations
 	double tolerance; ///< CG tolerance
+	SparseVector<double> x_previous; ///< Previous solution used as initial guess
 };
 
 #endif
\ No newline at end of file
@@ -1,22 +1,33 @@
 #include "SparseSolverEigenLLT.h"
-#include <Eigen/SparseCholesky>
 
-std::vector<double> SparseSolverEigenLLT::solve_Ax_b(SparseMatrix<double> A, SparseVector<double> b, int numel, std::vector<int> & uidx, const std::vector<int> * labels, const std::vector<int> * seeds, int active_label)
+SparseSolverEigenLLT::SparseSolverEigenLLT():
+isPatternAnalyzed(false)
 {
-	SimplicialLLT<SparseMatrix<double> > solver;
+}
 
-	// Convert to dense format for solver compatibility - this might become a memory issue
-	VectorXd b_dense = b;
+void SparseSolverEigenLLT::reset()
+{
+	isPatternAnalyzed = false;
+}
 
-	// LLT Decomposition
-	solver.compute(A);
+std::vector<double> SparseSolverEigenLLT::solve_Ax_b(const SparseMatrix<double> & A, const VectorXd & b, int numel, std::vector<int> & uidx, const std::vector<int> * labels, const std::vector<int> * seeds, int active_label)
+{
+	// LLT Decomposition, the ordering and symbolic decomposition only depend on the sparsity pattern
+	if(!isPatternAnalyzed)
+	{
+		solver.analyzePattern(A);
+		isPatternAnalyzed = true;
+	}
+	solver.factorize(A);
 
 	/*if(solver.info()!=true) {
 	  std::cout << "Decomposition failed!\n";
 	}*/
 
 	// Solve system with decomposition
-	VectorXd x_dense = solver.solve(b_dense);
+	VectorXd x_dense = solver.solve(b);
+	lastIterations = 0;
+	lastError = 0.0;
 
 	/*if(solver.info()!=true) {
 		std::cout << "Solver failed!\n";
@@ -6,6 +6,7 @@
 #define SPARSE_SOLVER_EIGEN_LLT_H__
 
 #include "SparseSolverInterface.h"
+#include <Eigen/SparseCholesky>
 
 /** \brief	Direct Eigen solver using LLT  for random walks system
  *	\author	Athanasios Karamalis
@@ -15,8 +16,15 @@
 class SparseSolverEigenLLT : public SparseSolverInterface
 {
 public:
+	SparseSolverEigenLLT();
 	/// Solver with direct LLT (Cholesky Decomposition)
-	// TODO Save decomposition for next solution
-	virtual std::vector<double> solve_Ax_b(SparseMatrix<double> A, SparseVector<double> b, int numel, std::vector<int> & uidx, const std::vector<int> * labels, const std::vector<int> * seeds, int active_label);
+	/** The symbolic decomposition is kept and only the numerical factorization is recomputed as long as the sparsity pattern does not change. */
+	virtual std::vector<double> solve_Ax_b(const SparseMatrix<double> & A, const VectorXd & b, int numel, std::vector<int> & uidx, const std::vector<int> * labels, const std::vector<int> * seeds, int active_label);
+
+	/// Discard the symbolic decomposition
+	virtual void reset();
+private:
+	SimplicialLLT<SparseMatrix<double> > solver; ///< Cholesky decomposition
+	bool isPatternAnalyzed; ///< Is the symbolic decomposition of the current sparsity pattern available
 };
 #endif
\ No newline at end of file
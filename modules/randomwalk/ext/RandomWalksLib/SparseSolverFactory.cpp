@@ -3,6 +3,7 @@
 #include "SparseSolverEigenCG.h"
 #include "SparseSolverEigenBiCGSTAB.h"
 #include "SparseSolverEigenCustom.h"
+#include "SparseSolverMultigridCG.h"
 
 #ifdef RANDOMWALKSLIB_HAS_OPENCL
 #include "SparseSolverViennaCPU.h"
@@ -35,6 +36,11 @@ SparseSolverInterface * SparseSolverFactory::createSolver(std::string type, int
 		SparseSolverInterface * solver = new SparseSolverEigenCustom(iterations,tolerance);
 		return solver;
 	}
+	else if(type.compare("Multigrid-CG")==0)
+	{
+		SparseSolverInterface * solver = new SparseSolverMultigridCG(iterations,tolerance);
+		return solver;
+	}
 	else
 	{
 		return new SparseSolverEigenLLT();
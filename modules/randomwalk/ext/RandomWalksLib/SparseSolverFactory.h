@@ -22,6 +22,7 @@ public:
 		Eigen-CG
 		Eigen-BiCGSTAB
 		Eigen-CG-Custom
+		Multigrid-CG
 		Vienna-CG-CPU
 		Vienna-CG-GPU
 	*/
@@ -20,9 +20,29 @@ using namespace Eigen;
 class SparseSolverInterface
 {
 public:
+	SparseSolverInterface() : lastIterations(0), lastError(0.0) {};
+	virtual ~SparseSolverInterface() {};
+
 	/// Solver random walks system LuX=b, matrix returned as vector in column-major order
-	virtual std::vector<double> solve_Ax_b(SparseMatrix<double> A, SparseVector<double> b, int numel, std::vector<int> & uidx, const std::vector<int> * labels, const std::vector<int> * seeds, int active_label) = 0;
-private:
+	/** Solvers may keep state between consecutive calls (factorizations, the previous solution as initial guess)
+	 *	as long as the sparsity pattern of A does not change. */
+	virtual std::vector<double> solve_Ax_b(const SparseMatrix<double> & A, const VectorXd & b, int numel, std::vector<int> & uidx, const std::vector<int> * labels, const std::vector<int> * seeds, int active_label) = 0;
+
+	/// Discard any state kept from previous solutions, called whenever the sparsity pattern or the parameters of the system change
+	virtual void reset() {};
+
+	/// Set the size of the lattice the system was assembled on. Used by solvers exploiting the regular grid structure.
+	/** Node (r,c,s) of the lattice has the index r + c*rows + s*rows*cols, the indices of the unmarked nodes are given by uidx. */
+	virtual void setLatticeSize(int rows, int cols, int stacks) {};
+
+	/// Get number of iterations needed for the last solution (0 for direct solvers)
+	int getLastIterations() const {return lastIterations;};
+
+	/// Get estimated relative error of the last solution
+	double getLastError() const {return lastError;};
+protected:
+	int lastIterations; ///< Iterations needed for the last solution
+	double lastError; ///< Estimated relative error of the last solution
 };
 
 #endif
\ No newline at end of file
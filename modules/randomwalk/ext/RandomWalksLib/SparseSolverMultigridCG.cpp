@@ -0,0 +1,361 @@
+#include "SparseSolverMultigridCG.h"
+
+#include <tbb/tbb.h>
+#include <algorithm>
+
+namespace
+{
+	/// Maximum number of nodes on the coarsest level, which is solved directly
+	const size_t MAX_COARSE_NODES = 1024;
+
+	/// Number of pre- and post-smoothing sweeps
+	const int SMOOTHING_SWEEPS = 2;
+
+
+	/// Compute r = b - A x in parallel. As A is symmetric, each row of the product is given by the corresponding column of A.
+	void computeResidual(const SparseMatrix<double> & A, const VectorXd & x, const VectorXd & b, VectorXd & r)
+	{
+		r.resize(b.rows());
+		const int * outer = A.outerIndexPtr();
+		const int * inner = A.innerIndexPtr();
+		const double * values = A.valuePtr();
+
+		tbb::parallel_for(tbb::blocked_range<int>(0, static_cast<int>(A.outerSize())), [&] (const tbb::blocked_range<int> & range) {
+			for (int j=range.begin(); j!=range.end(); ++j)
+			{
+				double sum = 0.0;
+				for (int k=outer[j]; k<outer[j+1]; ++k)
+					sum += values[k] * x[inner[k]];
+				r[j] = b[j] - sum;
+			}
+		});
+	}
+
+	/// Compute y = A x in parallel for symmetric A
+	void multiply(const SparseMatrix<double> & A, const VectorXd & x, VectorXd & y)
+	{
+		y.resize(x.rows());
+		const int * outer = A.outerIndexPtr();
+		const int * inner = A.innerIndexPtr();
+		const double * values = A.valuePtr();
+
+		tbb::parallel_for(tbb::blocked_range<int>(0, static_cast<int>(A.outerSize())), [&] (const tbb::blocked_range<int> & range) {
+			for (int j=range.begin(); j!=range.end(); ++j)
+			{
+				double sum = 0.0;
+				for (int k=outer[j]; k<outer[j+1]; ++k)
+					sum += values[k] * x[inner[k]];
+				y[j] = sum;
+			}
+		});
+	}
+}
+
+SparseSolverMultigridCG::SparseSolverMultigridCG(int iterations, double tolerance):
+latticeRows(0),
+latticeCols(0),
+latticeStacks(0),
+fineMatrix(0),
+isHierarchyAvailable(false)
+{
+	this->iterations = iterations;
+	this->tolerance = tolerance;
+}
+
+void SparseSolverMultigridCG::reset()
+{
+	isHierarchyAvailable = false;
+	x_previous.resize(0);
+}
+
+void SparseSolverMultigridCG::setLatticeSize(int rows, int cols, int stacks)
+{
+	if(rows != latticeRows || cols != latticeCols || stacks != latticeStacks)
+	{
+		latticeRows = rows;
+		latticeCols = cols;
+		latticeStacks = stacks;
+		reset();
+	}
+}
+
+const SparseMatrix<double> & SparseSolverMultigridCG::getMatrix(size_t level) const
+{
+	return (level == 0) ? *fineMatrix : levels[level].A;
+}
+
+std::vector<double> SparseSolverMultigridCG::solve_Ax_b(const SparseMatrix<double> & A, const VectorXd & b, int numel, std::vector<int> & uidx, const std::vector<int> * labels, const std::vector<int> * seeds, int active_label)
+{
+	fineMatrix = &A;
+
+	if(!isHierarchyAvailable || levels.front().lattice.size() != static_cast<size_t>(A.rows()))
+	{
+		setupHierarchy(A, uidx);
+		isHierarchyAvailable = true;
+	}
+	updateHierarchy();
+
+	// Preconditioned CG, warm started with the previous solution if available
+	VectorXd x = VectorXd::Zero(b.rows());
+	if(x_previous.rows() == b.rows())
+		x = x_previous;
+
+	VectorXd r, p, Ap;
+	computeResidual(A, x, b, r);
+
+	const double bnorm = (b.norm() > 0.0) ? b.norm() : 1.0;
+	double rnorm = r.norm();
+
+	levels.front().b = r;
+	vCycle(0);
+	p = levels.front().x;
+	double rz = r.dot(p);
+
+	int k = 0;
+	for(; k<iterations && rnorm/bnorm >= tolerance; k++)
+	{
+		multiply(A, p, Ap);
+		double alpha = rz / p.dot(Ap);
+		x += alpha * p;
+		r -= alpha * Ap;
+		rnorm = r.norm();
+
+		levels.front().b = r;
+		vCycle(0);
+		const VectorXd & z = levels.front().x;
+
+		double rzNew = r.dot(z);
+		double beta = rzNew / rz;
+		rz = rzNew;
+		p = z + beta * p;
+	}
+
+	lastIterations = k;
+	lastError = rnorm / bnorm;
+	x_previous = x;
+
+	std::vector<double> xmat(numel);
+
+	for (int i=0; i<x.rows(); i++)
+	{
+		double val = x(i);
+		xmat[uidx[i]] = val;
+	}
+
+	for (size_t i=0; i<seeds->size(); i++)
+	{
+		if((*labels)[i] == active_label)
+			xmat[(*seeds)[i]] = 1.0;
+		else
+			xmat[(*seeds)[i]] = 0.0;
+	}
+
+	return xmat;
+}
+
+void SparseSolverMultigridCG::setupHierarchy(const SparseMatrix<double> & A, const std::vector<int> & uidx)
+{
+	levels.clear();
+	levels.resize(1);
+
+	Level & finest = levels.front();
+	finest.lattice.assign(uidx.begin(), uidx.begin() + A.rows());
+	if(latticeRows > 0 && latticeCols > 0 && latticeStacks > 0)
+	{
+		finest.rows = latticeRows;
+		finest.cols = latticeCols;
+		finest.stacks = latticeStacks;
+	}
+	else
+	{
+		// Without lattice information, aggregate neighbouring indices
+		finest.rows = *std::max_element(uidx.begin(), uidx.end()) + 1;
+		finest.cols = 1;
+		finest.stacks = 1;
+	}
+
+	while(levels.back().lattice.size() > MAX_COARSE_NODES && levels.back().rows*levels.back().cols*levels.back().stacks > 1)
+	{
+		levels.push_back(Level());
+		Level & fine = levels[levels.size()-2];
+		Level & coarse = levels.back();
+		const SparseMatrix<double> & fineA = getMatrix(levels.size()-2);
+
+		// Aggregate blocks of 2x2(x2) lattice nodes
+		coarse.rows = (fine.rows + 1) / 2;
+		coarse.cols = (fine.cols + 1) / 2;
+		coarse.stacks = (fine.stacks + 1) / 2;
+
+		std::vector<int> coarseIndex(coarse.rows * coarse.cols * coarse.stacks, -1);
+		fine.aggregates.resize(fine.lattice.size());
+		for (size_t i=0; i<fine.lattice.size(); i++)
+		{
+			int node = fine.lattice[i];
+			int r = node % fine.rows;
+			int c = (node / fine.rows) % fine.cols;
+			int s = node / (fine.rows * fine.cols);
+			int coarseNode = (r/2) + (c/2) * coarse.rows + (s/2) * coarse.rows * coarse.cols;
+
+			if(coarseIndex[coarseNode] < 0)
+			{
+				coarseIndex[coarseNode] = static_cast<int>(coarse.lattice.size());
+				coarse.lattice.push_back(coarseNode);
+			}
+			fine.aggregates[i] = coarseIndex[coarseNode];
+		}
+
+		// Sparsity pattern of the Galerkin product P^T A P
+		const int * outer = fineA.outerIndexPtr();
+		const int * inner = fineA.innerIndexPtr();
+		const int numCoarse = static_cast<int>(coarse.lattice.size());
+
+		std::vector<Triplet<double> > triplets;
+		triplets.reserve(fineA.nonZeros());
+		for (int j=0; j<fineA.outerSize(); j++)
+		{
+			for (int k=outer[j]; k<outer[j+1]; k++)
+				triplets.push_back(Triplet<double>(fine.aggregates[inner[k]], fine.aggregates[j], 0.0));
+		}
+		coarse.A.resize(numCoarse, numCoarse);
+		coarse.A.setFromTriplets(triplets.begin(), triplets.end());
+		coarse.A.makeCompressed();
+
+		// Remember for each fine entry the position of its coarse entry
+		const int * coarseOuter = coarse.A.outerIndexPtr();
+		const int * coarseInner = coarse.A.innerIndexPtr();
+		fine.galerkinIndices.resize(fineA.nonZeros());
+		for (int j=0; j<fineA.outerSize(); j++)
+		{
+			int J = fine.aggregates[j];
+			for (int k=outer[j]; k<outer[j+1]; k++)
+			{
+				const int * pos = std::lower_bound(coarseInner + coarseOuter[J], coarseInner + coarseOuter[J+1], fine.aggregates[inner[k]]);
+				fine.galerkinIndices[k] = static_cast<int>(pos - coarseInner);
+			}
+		}
+
+		// Stop if the aggregation does not reduce the problem size anymore
+		if(coarse.lattice.size() == fine.lattice.size())
+		{
+			levels.pop_back();
+			levels.back().aggregates.clear();
+			levels.back().galerkinIndices.clear();
+			break;
+		}
+	}
+
+	// Red-black partitioning of the lattice nodes, aggregating 2x2(x2) blocks preserves the 4/6-neighbourhood
+	for (size_t l=0; l<levels.size(); l++)
+	{
+		Level & level = levels[l];
+		level.colors[0].clear();
+		level.colors[1].clear();
+		for (size_t i=0; i<level.lattice.size(); i++)
+		{
+			int node = level.lattice[i];
+			int r = node % level.rows;
+			int c = (node / level.rows) % level.cols;
+			int s = node / (level.rows * level.cols);
+			level.colors[(r + c + s) % 2].push_back(static_cast<int>(i));
+		}
+	}
+
+	coarseSolver.analyzePattern(getMatrix(levels.size()-1));
+}
+
+void SparseSolverMultigridCG::updateHierarchy()
+{
+	for (size_t l=0; l<levels.size(); l++)
+	{
+		Level & level = levels[l];
+		const SparseMatrix<double> & A = getMatrix(l);
+		const int * outer = A.outerIndexPtr();
+		const int * inner = A.innerIndexPtr();
+		const double * values = A.valuePtr();
+
+		level.invDiagonal.resize(A.rows());
+		tbb::parallel_for(tbb::blocked_range<int>(0, static_cast<int>(A.outerSize())), [&] (const tbb::blocked_range<int> & range) {
+			for (int j=range.begin(); j!=range.end(); ++j)
+			{
+				double diagonal = 1.0;
+				for (int k=outer[j]; k<outer[j+1]; ++k)
+				{
+					if(inner[k] == j)
+						diagonal = values[k];
+				}
+				level.invDiagonal[j] = 1.0 / diagonal;
+			}
+		});
+
+		if(l+1 < levels.size())
+		{
+			SparseMatrix<double> & coarseA = levels[l+1].A;
+			double * coarseValues = coarseA.valuePtr();
+			std::fill(coarseValues, coarseValues + coarseA.nonZeros(), 0.0);
+			for (size_t k=0; k<level.galerkinIndices.size(); k++)
+				coarseValues[level.galerkinIndices[k]] += values[k];
+		}
+	}
+
+	coarseSolver.factorize(getMatrix(levels.size()-1));
+}
+
+void SparseSolverMultigridCG::smooth(size_t level, bool forward)
+{
+	Level & lv = levels[level];
+	const SparseMatrix<double> & A = getMatrix(level);
+	const int * outer = A.outerIndexPtr();
+	const int * inner = A.innerIndexPtr();
+	const double * values = A.valuePtr();
+
+	// Nodes of the same color are not coupled, hence each half sweep can be performed in parallel
+	for (int half=0; half<2; half++)
+	{
+		const std::vector<int> & nodes = lv.colors[forward ? half : 1-half];
+		tbb::parallel_for(tbb::blocked_range<size_t>(0, nodes.size()), [&] (const tbb::blocked_range<size_t> & range) {
+			for (size_t n=range.begin(); n!=range.end(); ++n)
+			{
+				int j = nodes[n];
+				double sum = 0.0;
+				for (int k=outer[j]; k<outer[j+1]; ++k)
+					sum += values[k] * lv.x[inner[k]];
+				lv.x[j] += lv.invDiagonal[j] * (lv.b[j] - sum);
+			}
+		});
+	}
+}
+
+void SparseSolverMultigridCG::vCycle(size_t level)
+{
+	Level & lv = levels[level];
+
+	if(level+1 == levels.size())
+	{
+		lv.x = coarseSolver.solve(lv.b);
+		return;
+	}
+
+	// Pre-smoothing
+	lv.x = VectorXd::Zero(lv.b.rows());
+	for (int i=0; i<SMOOTHING_SWEEPS; i++)
+		smooth(level, true);
+
+	// Restrict residual to coarser level and solve there
+	Level & coarse = levels[level+1];
+	computeResidual(getMatrix(level), lv.x, lv.b, lv.r);
+	coarse.b = VectorXd::Zero(coarse.lattice.size());
+	for (size_t i=0; i<lv.aggregates.size(); i++)
+		coarse.b[lv.aggregates[i]] += lv.r[i];
+
+	vCycle(level+1);
+
+	// Prolongate correction
+	tbb::parallel_for(tbb::blocked_range<int>(0, static_cast<int>(lv.x.rows())), [&] (const tbb::blocked_range<int> & range) {
+		for (int i=range.begin(); i!=range.end(); ++i)
+			lv.x[i] += coarse.x[lv.aggregates[i]];
+	});
+
+	// Post-smoothing in reverse order to keep the preconditioner symmetric
+	for (int i=0; i<SMOOTHING_SWEEPS; i++)
+		smooth(level, false);
+}
\ No newline at end of file
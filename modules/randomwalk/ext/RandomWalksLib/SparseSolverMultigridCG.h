@@ -0,0 +1,81 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#ifndef SPARSE_SOLVER_MULTIGRID_CG_H__
+#define SPARSE_SOLVER_MULTIGRID_CG_H__
+
+#include "SparseSolverInterface.h"
+#include <Eigen/SparseCholesky>
+
+/** \brief	Multigrid preconditioned Conjugate Gradient solver for random walks system
+ *
+ *	Exploits the regular 4/6-neighbour lattice of the random walks graph: The unmarked nodes of each level are
+ *	aggregated geometrically into blocks of 2x2(x2) lattice nodes, which form the nodes of the next coarser level.
+ *	The coarse systems are given by the Galerkin product P^T A P with the piecewise constant prolongation P and
+ *	the coarsest system is solved directly. One V-cycle with symmetric red-black Gauss-Seidel smoothing serves as
+ *	preconditioner for CG. Matrix-vector products, smoothing and grid transfers are parallelized with TBB.
+ *
+ *	The aggregation and the coarse sparsity patterns only depend on the sparsity pattern of A and are kept between
+ *	consecutive solutions, the previous solution is used as initial guess.
+ */
+class SparseSolverMultigridCG : public SparseSolverInterface
+{
+public:
+	SparseSolverMultigridCG(int iterations, double tolerance);
+
+	/// Solver with multigrid preconditioned CG, A is expected in compressed format
+	virtual std::vector<double> solve_Ax_b(const SparseMatrix<double> & A, const VectorXd & b, int numel, std::vector<int> & uidx, const std::vector<int> * labels, const std::vector<int> * seeds, int active_label);
+
+	/// Discard the multigrid hierarchy and the previous solution
+	virtual void reset();
+
+	/// Set the lattice size used for the geometric aggregation
+	virtual void setLatticeSize(int rows, int cols, int stacks);
+private:
+	/// Single level of the multigrid hierarchy
+	struct Level
+	{
+		SparseMatrix<double> A; ///< System matrix (unused on the finest level, which uses the given matrix)
+		VectorXd invDiagonal; ///< Inverse diagonal of the system matrix for smoothing
+		std::vector<int> lattice; ///< Lattice index of each node
+		int rows; ///< # rows of the lattice
+		int cols; ///< # cols of the lattice
+		int stacks; ///< # stacks of the lattice
+		std::vector<int> aggregates; ///< For each node its node on the next coarser level
+		std::vector<int> galerkinIndices; ///< For each entry of A the index of its entry in the value array of the next coarser A
+		VectorXd x; ///< Solution of the current V-cycle
+		VectorXd b; ///< rhs of the current V-cycle
+		VectorXd r; ///< Residual
+		std::vector<int> colors[2]; ///< Nodes partitioned into red and black lattice nodes
+	};
+
+	/// Get the system matrix of the given level
+	const SparseMatrix<double> & getMatrix(size_t level) const;
+
+	/// Build the aggregation and coarse sparsity patterns for the sparsity pattern of A
+	void setupHierarchy(const SparseMatrix<double> & A, const std::vector<int> & uidx);
+
+	/// Compute the values of the coarse systems and factorize the coarsest one
+	void updateHierarchy();
+
+	/// Apply one V-cycle starting at the given level to levels[level].b, the result is stored in levels[level].x
+	void vCycle(size_t level);
+
+	/// Perform one red-black Gauss-Seidel sweep on the given level, black nodes first if not forward
+	void smooth(size_t level, bool forward);
+
+	int iterations; ///< CG iterations
+	double tolerance; ///< CG tolerance
+	int latticeRows; ///< # rows of the finest lattice
+	int latticeCols; ///< # cols of the finest lattice
+	int latticeStacks; ///< # stacks of the finest lattice
+
+	const SparseMatrix<double> * fineMatrix; ///< System matrix of the current solution
+	std::vector<Level> levels; ///< Multigrid hierarchy, finest level first
+	SimplicialLDLT<SparseMatrix<double> > coarseSolver; ///< Direct solver for the coarsest level
+	bool isHierarchyAvailable; ///< Is the hierarchy available for the current sparsity pattern
+	VectorXd x_previous; ///< Previous solution used as initial guess
+};
+
+#endif
\ No newline at end of file
@@ -39,11 +39,12 @@
 
 namespace campvis {
 
-    static const GenericOption<std::string> solvers[4] = {
+    static const GenericOption<std::string> solvers[5] = {
         GenericOption<std::string>("Eigen-LLT", "Eigen-LLT"),
         GenericOption<std::string>("Eigen-CG", "Eigen-CG"),
         GenericOption<std::string>("Eigen-BiCGSTAB", "Eigen-BiCGSTAB"),
         GenericOption<std::string>("Eigen-CG-Custom", "Eigen-CG-Custom"),
+        GenericOption<std::string>("Multigrid-CG", "Multigrid-CG"),
     };
 
     const std::string ConfidenceMapGenerator::loggerCat_ = "CAMPVis.modules.classification.ConfidenceMapGenerator";
@@ -56,10 +57,11 @@ namespace campvis {
         , p_beta("Beta", "Beta Parameter", 100.f, 1.f, 1000.f, 0.1f)
         , p_gamma("Gamma", "Gamma Parameter", .06f, .01f, 1.f)
         , p_normalizeValues("NormalizeValues", "Normalize Values", false)
-        , p_solver("FilterMode", "Filter Mode", solvers, 4)
+        , p_solver("FilterMode", "Filter Mode", solvers, 5)
         , p_numSteps("NumSteps", "Number of Solver Steps", 1000, 100, 5000)
-
-        
+        , p_temporalFiltering("TemporalFiltering", "Temporal Filtering", true)
+        , _lastSolverIterations(0)
+        , _lastSolveTime(0.0)
     {
         addProperty(p_sourceImageID);
         addProperty(p_targetImageID);
@@ -69,16 +71,24 @@ namespace campvis {
         addProperty(p_normalizeValues);
         addProperty(p_solver);
         addProperty(p_numSteps);
+        addProperty(p_temporalFiltering);
     }
 
     ConfidenceMapGenerator::~ConfidenceMapGenerator() {
+        for (size_t i = 0; i < _solverContexts.size(); ++i)
+            delete _solverContexts[i];
+    }
 
+    int ConfidenceMapGenerator::getLastSolverIterations() const {
+        return _lastSolverIterations;
+    }
+
+    double ConfidenceMapGenerator::getLastSolveTime() const {
+        return _lastSolveTime;
     }
 
     void ConfidenceMapGenerator::updateResult(DataContainer& data) {
         ImageRepresentationLocal::ScopedRepresentation input(data, p_sourceImageID.getValue());
-        GenericImageRepresentationLocal<float, 1>::ScopedRepresentation previousResult(data, p_targetImageID.getValue());
-        GenericImageRepresentationLocal<float, 1>::ScopedRepresentation velocities(data, p_targetImageID.getValue() + "velocities");
 
         if (input != 0 && input->getDimensionality() >= 2) {
             const cgt::svec3& imageSize = input->getSize();
@@ -86,11 +96,18 @@ namespace campvis {
             size_t numElementsPerSlice = cgt::hmul(input->getSize().xy());
             float* outputValues = new float[numElements];
 
+            // keep one solver context per slice, so that each slice is warm started from its previous result
+            for (size_t i = imageSize.z; i < _solverContexts.size(); ++i)
+                delete _solverContexts[i];
+            _solverContexts.resize(imageSize.z, nullptr);
+            for (size_t i = 0; i < _solverContexts.size(); ++i) {
+                if (_solverContexts[i] == nullptr)
+                    _solverContexts[i] = new ConfidenceMaps2DFacade();
+                _solverContexts[i]->setSolver(p_solver.getOptionValue(), p_numSteps.getValue());
+            }
+
             // compute the Confidence Map
             tbb::parallel_for(tbb::blocked_range<size_t>(0, imageSize.z), [&] (const tbb::blocked_range<size_t>& range) {
-                // Get each slice of the range through the confidence map generator
-                ConfidenceMaps2DFacade _cmGenerator;
-                _cmGenerator.setSolver(p_solver.getOptionValue(), p_numSteps.getValue());
                 size_t offset = numElementsPerSlice * range.begin();
 
                 std::vector<double> inputValues;
@@ -108,8 +125,9 @@ namespace campvis {
                     }
 
                     // compute confidence map
-                    _cmGenerator.setImage(inputValues, static_cast<int>(input->getSize().y), static_cast<int>(input->getSize().x), p_alpha.getValue(), p_normalizeValues.getValue());
-                    std::vector<double> tmp = _cmGenerator.computeMap(p_beta.getValue(), p_gamma.getValue());
+                    ConfidenceMaps2DFacade& cmGenerator = *_solverContexts[slice];
+                    cmGenerator.setImage(inputValues, static_cast<int>(input->getSize().y), static_cast<int>(input->getSize().x), p_alpha.getValue(), p_normalizeValues.getValue());
+                    std::vector<double> tmp = cmGenerator.computeMap(p_beta.getValue(), p_gamma.getValue());
 
                     // copy and transpose back
                     for (size_t i = 0; i < numElementsPerSlice; ++i) {
@@ -122,57 +140,96 @@ namespace campvis {
                 }
             });
 
-            // perform alpha-beta filtering to avoid flickering:
+            _lastSolverIterations = 0;
+            _lastSolveTime = 0.0;
+            for (size_t i = 0; i < _solverContexts.size(); ++i) {
+                _lastSolverIterations += _solverContexts[i]->getLastIterations();
+                _lastSolveTime = std::max(_lastSolveTime, _solverContexts[i]->getLastSolveTime());
+            }
+            LDEBUG("Computed confidence map in " << _lastSolveTime << " ms with " << _lastSolverIterations << " solver iterations.");
+
             ImageData* output = new ImageData(input->getDimensionality(), cgt::svec3(input->getSize().x, input->getSize().y, 1), 1);
             auto outRep = GenericImageRepresentationLocal<float, 1>::create(output, outputValues);
 
-            float dt = 0.5f;
-            float a = 0.36f;
-            float b = 0.005f;
+            // perform alpha-beta filtering to avoid flickering:
+            if (p_temporalFiltering.getValue())
+                filterTemporally(data, outRep);
 
-            if (previousResult && velocities && previousResult->getNumElements() == outRep->getNumElements() && velocities->getNumElements() == outRep->getNumElements()) {
-                // we have a previous result, so perform the filtering
-                tbb::parallel_for(tbb::blocked_range<size_t>(0, outRep->getNumElements()), [&] (const tbb::blocked_range<size_t>& range) {
-                    for (size_t i = range.begin(); i != range.end(); ++i) {
-                        float xk = previousResult->getElement(i) + (velocities->getElement(i) * dt);
-                        float vk = velocities->getElement(i);
+            data.addData(p_targetImageID.getValue(), output);
+        }
+        else {
+            LDEBUG("No suitable input image found.");
+        }
+    }
 
-                        float rk = outRep->getElement(i) - xk;
+    void ConfidenceMapGenerator::applyTemporalFilter(DataContainer& dataContainer, const ImageData* confidenceMap) {
+        const GenericImageRepresentationLocal<float, 1>* rep = (confidenceMap != nullptr) ? confidenceMap->getRepresentation< GenericImageRepresentationLocal<float, 1> >() : nullptr;
+        if (rep == nullptr) {
+            LERROR("Cannot filter confidence map: no suitable image given.");
+            return;
+        }
 
-                        xk += a * rk;
-                        vk += (b*rk) / dt;
+        float* values = new float[rep->getNumElements()];
+        std::copy(rep->getImageData(), rep->getImageData() + rep->getNumElements(), values);
 
-                        outRep->setElement(i, xk);
-                        const_cast<GenericImageRepresentationLocal<float, 1>*>(&*velocities)->setElement(i, vk);
-                    }
-                });
-            }
-            else {
-                // we don't have a previous result, so initialize the filtering
-                ImageData* velocityImage = new ImageData(input->getDimensionality(), cgt::svec3(input->getSize().x, input->getSize().y, 1), 1);
-                auto veloRep = GenericImageRepresentationLocal<float, 1>::create(velocityImage, nullptr);
+        ImageData* output = new ImageData(confidenceMap->getDimensionality(), confidenceMap->getSize(), 1);
+        auto outRep = GenericImageRepresentationLocal<float, 1>::create(output, values);
+        filterTemporally(dataContainer, outRep);
 
-                tbb::parallel_for(tbb::blocked_range<size_t>(0, outRep->getNumElements()), [&] (const tbb::blocked_range<size_t>& range) {
-                    for (size_t i = range.begin(); i != range.end(); ++i) {
-                        float xk = 0.f;
-                        float vk = 0.f;
-                        float rk = outRep->getElement(i) - xk;
+        dataContainer.addData(p_targetImageID.getValue(), output);
+    }
 
-                        xk += a * rk;
-                        vk += (b*rk) / dt;
+    void ConfidenceMapGenerator::filterTemporally(DataContainer& data, GenericImageRepresentationLocal<float, 1>* outRep) {
+        GenericImageRepresentationLocal<float, 1>::ScopedRepresentation previousResult(data, p_targetImageID.getValue());
+        GenericImageRepresentationLocal<float, 1>::ScopedRepresentation velocities(data, p_targetImageID.getValue() + "velocities");
+        const ImageData* output = outRep->getParent();
 
-                        veloRep->setElement(i, vk);
-                    }
-                });
+        float dt = 0.5f;
+        float a = 0.36f;
+        float b = 0.005f;
 
-                // save the velocity map for the filtering
-                data.addData(p_targetImageID.getValue() + "velocities", velocityImage);
-            }
+        if (previousResult && velocities && previousResult->getNumElements() == outRep->getNumElements() && velocities->getNumElements() == outRep->getNumElements()) {
+            // the velocity map is updated in place, so make sure its buffer is not shared with other
+            // representations (e.g. an ITK image) first
+            GenericImageRepresentationLocal<float, 1>* velocityRep = const_cast<GenericImageRepresentationLocal<float, 1>*>(&*velocities);
+            velocityRep->ensureUnique();
 
-            data.addData(p_targetImageID.getValue(), output);
+            // we have a previous result, so perform the filtering
+            tbb::parallel_for(tbb::blocked_range<size_t>(0, outRep->getNumElements()), [&] (const tbb::blocked_range<size_t>& range) {
+                for (size_t i = range.begin(); i != range.end(); ++i) {
+                    float xk = previousResult->getElement(i) + (velocities->getElement(i) * dt);
+                    float vk = velocities->getElement(i);
+
+                    float rk = outRep->getElement(i) - xk;
+
+                    xk += a * rk;
+                    vk += (b*rk) / dt;
+
+                    outRep->setElement(i, xk);
+                    velocityRep->setElement(i, vk);
+                }
+            });
         }
         else {
-            LDEBUG("No suitable input image found.");
+            // we don't have a previous result, so initialize the filtering
+            ImageData* velocityImage = new ImageData(output->getDimensionality(), output->getSize(), 1);
+            auto veloRep = GenericImageRepresentationLocal<float, 1>::create(velocityImage, nullptr);
+
+            tbb::parallel_for(tbb::blocked_range<size_t>(0, outRep->getNumElements()), [&] (const tbb::blocked_range<size_t>& range) {
+                for (size_t i = range.begin(); i != range.end(); ++i) {
+                    float xk = 0.f;
+                    float vk = 0.f;
+                    float rk = outRep->getElement(i) - xk;
+
+                    xk += a * rk;
+                    vk += (b*rk) / dt;
+
+                    veloRep->setElement(i, vk);
+                }
+            });
+
+            // save the velocity map for the filtering
+            data.addData(p_targetImageID.getValue() + "velocities", velocityImage);
         }
     }
 
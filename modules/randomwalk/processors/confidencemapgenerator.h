@@ -26,6 +26,7 @@
 #define CONFIDENCEMAPGENERATOR_H__
 
 #include "core/pipeline/abstractprocessor.h"
+#include "core/datastructures/genericimagerepresentationlocal.h"
 #include "core/properties/datanameproperty.h"
 #include "core/properties/floatingpointproperty.h"
 #include "core/properties/numericproperty.h"
@@ -33,9 +34,17 @@
 
 #include "modules/modulesapi.h"
 
+#include <vector>
+
+class ConfidenceMaps2DFacade;
+
 namespace campvis {
     /**
      * Creates Confidence Maps for Ultrasound Images.
+     * 
+     * The solver context of each slice (sparsity pattern, symbolic factorization and previous 
+     * solution) is kept between consecutive invocations, so that subsequent frames of an ultrasound
+     * stream are solved considerably faster as long as the image size and parameters do not change.
      * TODO: Clean up pre-MICCAI mess!
      */
     class CAMPVIS_MODULES_API ConfidenceMapGenerator : public AbstractProcessor {
@@ -68,11 +77,48 @@ namespace campvis {
         BoolProperty p_normalizeValues;                 ///< Flag whether to normalize the values before computation
         GenericOptionProperty<std::string> p_solver;    ///< Solver to use
         IntProperty p_numSteps;
+        BoolProperty p_temporalFiltering;               ///< Flag whether to apply alpha-beta filtering over consecutive frames
+
+        /**
+         * Applies the temporal alpha-beta filter to the given unfiltered confidence map and stores 
+         * the filtered result in \a dataContainer under p_targetImageID.
+         * The previous result and its velocities are taken from (and updated in) \a dataContainer.
+         * This allows computing the unfiltered maps of several frames concurrently (with 
+         * p_temporalFiltering disabled) and filtering them afterwards in frame order.
+         * \param  dataContainer   DataContainer holding the previous result, receives the filtered map
+         * \param  confidenceMap   Unfiltered confidence map as computed by this processor
+         */
+        void applyTemporalFilter(DataContainer& dataContainer, const ImageData* confidenceMap);
+
+        /**
+         * Returns the total number of solver iterations needed for the last confidence map.
+         * \return  Sum of the solver iterations over all slices (0 for direct solvers)
+         */
+        int getLastSolverIterations() const;
+
+        /**
+         * Returns the time needed to solve the last confidence map.
+         * \return  Maximum solve time over all slices in milliseconds
+         */
+        double getLastSolveTime() const;
 
     protected:
         /// \see AbstractProcessor::updateResult
         virtual void updateResult(DataContainer& dataContainer);
 
+        /**
+         * Performs the alpha-beta filtering of \a confidenceMap in-place using the previous result 
+         * and velocities in \a dataContainer and stores the updated velocities in \a dataContainer.
+         * \param  dataContainer   DataContainer holding the previous result
+         * \param  confidenceMap   Confidence map to filter
+         */
+        void filterTemporally(DataContainer& dataContainer, GenericImageRepresentationLocal<float, 1>* confidenceMap);
+
+        /// Persistent solver context for each slice of the input image
+        std::vector<ConfidenceMaps2DFacade*> _solverContexts;
+        int _lastSolverIterations;          ///< Total number of solver iterations for the last confidence map
+        double _lastSolveTime;              ///< Maximum solve time over all slices for the last confidence map in ms
+
         static const std::string loggerCat_;
     };
 
@@ -55,6 +55,12 @@ uniform TextureParameters3D _volumeTextureParams;
 uniform sampler1D _transferFunction;
 uniform TFParameters1D _transferFunctionParams;
 
+#ifdef ENABLE_PRE_INTEGRATION
+// Pre-integrated transfer function
+uniform sampler2D _preIntegrationTable;
+uniform bool _usePreIntegration;
+#endif
+
 
 uniform LightSource _lightSource;
 uniform vec3 _cameraPosition;
@@ -82,13 +88,25 @@ vec4 performRaycasting(in vec3 entryPoint, in vec3 exitPoint, in vec2 texCoords)
 
     jitterEntryPoint(entryPoint, direction, _samplingStepSize * _jitterStepSizeMultiplier);
 
+#ifdef ENABLE_PRE_INTEGRATION
+    float previousIntensity = texture(_volume, entryPoint).r;
+#endif
+
     while (t < tend) {
         // compute sample position
         vec3 samplePosition = entryPoint.rgb + t * direction;
 
         // lookup intensity and TF
         float intensity = texture(_volume, samplePosition).r;
+#ifdef ENABLE_PRE_INTEGRATION
+        // classify the whole segment between the previous and the current sample
+        vec4 color = _usePreIntegration
+            ? lookupPreIntegratedTF(_preIntegrationTable, _transferFunctionParams, previousIntensity, intensity)
+            : lookupTF(_transferFunction, _transferFunctionParams, intensity);
+        previousIntensity = intensity;
+#else
         vec4 color = lookupTF(_transferFunction, _transferFunctionParams, intensity);
+#endif
 
 #ifdef ENABLE_SHADOWING
         // simple and expensive implementation of hard shadows
@@ -0,0 +1,470 @@
+// ================================================================================================
+// 
+// This file is part of the CAMPVis Software Framework.
+// 
+// If not explicitly stated otherwise: Copyright (C) 2012-2015, all rights reserved,
+//      Christian Schulte zu Berge <christian.szb@in.tum.de>
+//      Chair for Computer Aided Medical Procedures
+//      Technische Universitaet Muenchen
+//      Boltzmannstr. 3, 85748 Garching b. Muenchen, Germany
+// 
+// For a full list of authors and contributors, please refer to the file "AUTHORS.txt".
+// 
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file 
+// except in compliance with the License. You may obtain a copy of the License at
+// 
+// http://www.apache.org/licenses/LICENSE-2.0
+// 
+// Unless required by applicable law or agreed to in writing, software distributed under the 
+// License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, 
+// either express or implied. See the License for the specific language governing permissions 
+// and limitations under the License.
+// 
+// ================================================================================================
+
+
+#include "cpuraycaster.h"
+
+#include "cgt/logmanager.h"
+
+#include <tbb/tbb.h>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include "core/classification/geometry1dtransferfunction.h"
+#include "core/classification/simpletransferfunction.h"
+#include "core/datastructures/cameradata.h"
+#include "core/datastructures/genericimagerepresentationlocal.h"
+#include "core/datastructures/imagedata.h"
+#include "core/datastructures/imagerepresentationlocal.h"
+#include "core/datastructures/renderdata.h"
+#include "core/tools/minmaxblockindex.h"
+#include "core/tools/voxelview.h"
+
+namespace campvis {
+
+    namespace {
+        /// Base sampling interval for the opacity correction, must match the GLSL raycasters
+        const float SAMPLING_BASE_INTERVAL_RCP = 200.f;
+
+        /**
+         * Traces the rays of all pixels in tiles of CpuRaycaster::TILE_SIZE^2 pixels in parallel.
+         * Each tile is traversed in packets of CpuRaycaster::PACKET_SIZE horizontally adjacent rays,
+         * whose per-ray computations are laid out as structure of arrays and performed branch-free
+         * for all rays of the packet, so that the compiler can vectorize them.
+         */
+        struct RaycastingFunctor {
+            static const size_t P = CpuRaycaster::PACKET_SIZE;
+
+            RaycastingFunctor(const cgt::ivec2& imageSize, const std::vector<cgt::vec3>& entries, const std::vector<cgt::vec3>& exits, 
+                              const std::vector<cgt::vec4>& lut, const cgt::vec2& intensityDomain, float samplingStepSize,
+                              const cgt::svec3& numBricks, const std::vector<uint8_t>& emptyBricks, const cgt::mat4& textureToClip,
+                              cgt::col4* colors, float* depths)
+                : _imageSize(imageSize)
+                , _entries(entries)
+                , _exits(exits)
+                , _lut(lut)
+                , _intensityDomain(intensityDomain)
+                , _samplingStepSize(samplingStepSize)
+                , _numBricks(numBricks)
+                , _emptyBricks(emptyBricks)
+                , _textureToClip(textureToClip)
+                , _colors(colors)
+                , _depths(depths)
+            {}
+
+            template<typename BASETYPE>
+            void operator() (const VoxelView<BASETYPE, 1>& volume) const {
+                const size_t width = static_cast<size_t>(_imageSize.x);
+                const size_t height = static_cast<size_t>(_imageSize.y);
+                const size_t T = CpuRaycaster::TILE_SIZE;
+
+                tbb::parallel_for(tbb::blocked_range2d<size_t>(0, height, T, 0, width, T), [&] (const tbb::blocked_range2d<size_t>& tile) {
+                    for (size_t y = tile.rows().begin(); y != tile.rows().end(); ++y) {
+                        for (size_t x = tile.cols().begin(); x < tile.cols().end(); x += P) {
+                            tracePacket(volume, y * width + x, std::min(P, tile.cols().end() - x));
+                        }
+                    }
+                }, tbb::simple_partitioner());
+            }
+
+            template<typename BASETYPE>
+            void tracePacket(const VoxelView<BASETYPE, 1>& volume, size_t firstPixel, size_t numRays) const {
+                const size_t B = CpuRaycaster::BRICK_SIZE;
+                const cgt::svec3& size = volume.getSize();
+                const cgt::vec3 sizeF(size);
+                const cgt::vec3 maxPosition = sizeF - cgt::vec3(1.f);
+                const size_t strideY = size.x;
+                const size_t strideZ = size.x * size.y;
+                const BASETYPE* data = volume.getData();
+
+                const float step = _samplingStepSize;
+                const float alphaExponent = step * SAMPLING_BASE_INTERVAL_RCP;
+                const float lutSize = static_cast<float>(_lut.size());
+                const size_t lutMax = _lut.size() - 1;
+                const float domainMin = _intensityDomain.x;
+                const float domainScale = 1.f / (_intensityDomain.y - _intensityDomain.x);
+                const bool skipEmptySpace = ! _emptyBricks.empty();
+
+                // ray setup, the ray parameter is always computed from the sample index instead of being
+                // accumulated, so that empty space skipping does not change the sample positions
+                float ox[P], oy[P], oz[P], dx[P], dy[P], dz[P], t[P], tEnd[P], firstHit[P];
+                size_t sampleIndex[P];
+                cgt::vec4 result[P];
+                bool active[P];
+                for (size_t l = 0; l < P; ++l) {
+                    cgt::vec3 entry(0.f), direction(0.f);
+                    tEnd[l] = 0.f;
+                    if (l < numRays) {
+                        entry = _entries[firstPixel + l];
+                        direction = _exits[firstPixel + l] - entry;
+                        tEnd[l] = cgt::length(direction);
+                        if (tEnd[l] > 0.f)
+                            direction /= tEnd[l];
+                    }
+
+                    ox[l] = entry.x;     oy[l] = entry.y;     oz[l] = entry.z;
+                    dx[l] = direction.x; dy[l] = direction.y; dz[l] = direction.z;
+                    sampleIndex[l] = 0;
+                    t[l] = 0.f;
+                    firstHit[l] = -1.f;
+                    result[l] = cgt::vec4(0.f);
+                    active[l] = (tEnd[l] > 0.f);
+                }
+
+                for (;;) {
+                    bool anyActive = false;
+                    for (size_t l = 0; l < P; ++l)
+                        anyActive |= active[l];
+                    if (! anyActive)
+                        break;
+
+                    // compute sample positions in voxel coordinates, clamped to the volume
+                    float px[P], py[P], pz[P];
+                    bool sample[P];
+                    for (size_t l = 0; l < P; ++l) {
+                        px[l] = std::min(std::max((ox[l] + t[l] * dx[l]) * sizeF.x - .5f, 0.f), maxPosition.x);
+                        py[l] = std::min(std::max((oy[l] + t[l] * dy[l]) * sizeF.y - .5f, 0.f), maxPosition.y);
+                        pz[l] = std::min(std::max((oz[l] + t[l] * dz[l]) * sizeF.z - .5f, 0.f), maxPosition.z);
+                        sample[l] = active[l];
+                    }
+
+                    // advance rays in transparent bricks to their last sample within the brick
+                    if (skipEmptySpace) {
+                        for (size_t l = 0; l < P; ++l) {
+                            if (! active[l])
+                                continue;
+
+                            const cgt::svec3 brick(
+                                std::min(static_cast<size_t>(px[l]) / B, _numBricks.x - 1),
+                                std::min(static_cast<size_t>(py[l]) / B, _numBricks.y - 1),
+                                std::min(static_cast<size_t>(pz[l]) / B, _numBricks.z - 1));
+                            if (! _emptyBricks[(brick.z * _numBricks.y + brick.y) * _numBricks.x + brick.x])
+                                continue;
+
+                            const float origin[3] = { ox[l], oy[l], oz[l] };
+                            const float direction[3] = { dx[l], dy[l], dz[l] };
+                            float tExit = tEnd[l];
+                            for (size_t axis = 0; axis < 3; ++axis) {
+                                if (direction[axis] == 0.f)
+                                    continue;
+                                float bound = static_cast<float>((brick[axis] + (direction[axis] > 0.f ? 1 : 0)) * B);
+                                tExit = std::min(tExit, (((bound + .5f) / sizeF[axis]) - origin[axis]) / direction[axis]);
+                            }
+
+                            // stop one sample short of the exit, so that rounding never skips a sample of the next brick
+                            const float lastInside = std::ceil(tExit / step) - 1.f;
+                            sampleIndex[l] = std::max(sampleIndex[l] + 1, (lastInside > 0.f) ? static_cast<size_t>(lastInside) : size_t(0));
+                            t[l] = static_cast<float>(sampleIndex[l]) * step;
+                            sample[l] = false;
+                            active[l] = (t[l] < tEnd[l]);
+                        }
+                    }
+
+                    // trilinear interpolation
+                    float values[P];
+                    for (size_t l = 0; l < P; ++l) {
+                        const size_t x0 = static_cast<size_t>(px[l]);
+                        const size_t y0 = static_cast<size_t>(py[l]);
+                        const size_t z0 = static_cast<size_t>(pz[l]);
+                        const float fx = px[l] - static_cast<float>(x0);
+                        const float fy = py[l] - static_cast<float>(y0);
+                        const float fz = pz[l] - static_cast<float>(z0);
+                        const size_t ix = (x0 + 1 < size.x) ? 1 : 0;
+                        const size_t iy = (y0 + 1 < size.y) ? strideY : 0;
+                        const size_t iz = (z0 + 1 < size.z) ? strideZ : 0;
+                        const BASETYPE* v = data + x0 + y0 * strideY + z0 * strideZ;
+
+                        const float c00 = TypeNormalizer::normalizeToFloat(v[0])       * (1.f - fx) + TypeNormalizer::normalizeToFloat(v[ix])           * fx;
+                        const float c10 = TypeNormalizer::normalizeToFloat(v[iy])      * (1.f - fx) + TypeNormalizer::normalizeToFloat(v[iy + ix])      * fx;
+                        const float c01 = TypeNormalizer::normalizeToFloat(v[iz])      * (1.f - fx) + TypeNormalizer::normalizeToFloat(v[iz + ix])      * fx;
+                        const float c11 = TypeNormalizer::normalizeToFloat(v[iz + iy]) * (1.f - fx) + TypeNormalizer::normalizeToFloat(v[iz + iy + ix]) * fx;
+                        values[l] = (c00 * (1.f - fy) + c10 * fy) * (1.f - fz) + (c01 * (1.f - fy) + c11 * fy) * fz;
+                    }
+
+                    // transfer function lookup with linear filtering, intensities outside the TF domain are transparent
+                    cgt::vec4 colors[P];
+                    for (size_t l = 0; l < P; ++l) {
+                        const float x = (values[l] - domainMin) * domainScale;
+                        const float u = std::min(std::max(x * lutSize - .5f, 0.f), static_cast<float>(lutMax));
+                        const size_t i0 = static_cast<size_t>(u);
+                        const size_t i1 = std::min(i0 + 1, lutMax);
+                        const float f = u - static_cast<float>(i0);
+                        colors[l] = (x >= 0.f && x <= 1.f) ? (_lut[i0] * (1.f - f) + _lut[i1] * f) : cgt::vec4(0.f);
+                    }
+
+                    // compositing, same as in simpleraycaster.frag
+                    for (size_t l = 0; l < P; ++l) {
+                        if (! sample[l])
+                            continue;
+
+                        cgt::vec4& color = colors[l];
+                        cgt::vec4& res = result[l];
+                        if (color.a > 0.f) {
+                            color.a = 1.f - std::pow(1.f - color.a, alphaExponent);
+                            const float weight = color.a * (1.f - res.a);
+                            res.r += color.r * weight;
+                            res.g += color.g * weight;
+                            res.b += color.b * weight;
+                            res.a += weight;
+                        }
+
+                        if (firstHit[l] < 0.f && res.a > 0.f)
+                            firstHit[l] = t[l];
+
+                        // early ray termination
+                        if (res.a > .975f) {
+                            res.a = 1.f;
+                            active[l] = false;
+                        }
+
+                        t[l] = static_cast<float>(++sampleIndex[l]) * step;
+                        active[l] = active[l] && (t[l] < tEnd[l]);
+                    }
+                }
+
+                // write results
+                for (size_t l = 0; l < numRays; ++l) {
+                    const cgt::vec4 color = cgt::clamp(result[l], cgt::vec4(0.f), cgt::vec4(1.f)) * 255.f + cgt::vec4(.5f);
+                    _colors[firstPixel + l] = cgt::col4(color);
+
+                    float depth = 1.f;
+                    if (firstHit[l] >= 0.f) {
+                        const cgt::vec4 clip = _textureToClip * cgt::vec4(ox[l] + firstHit[l] * dx[l], oy[l] + firstHit[l] * dy[l], oz[l] + firstHit[l] * dz[l], 1.f);
+                        depth = cgt::clamp(clip.z / clip.w * .5f + .5f, 0.f, 1.f);
+                    }
+                    _depths[firstPixel + l] = depth;
+                }
+            }
+
+            cgt::ivec2 _imageSize;
+            const std::vector<cgt::vec3>& _entries;
+            const std::vector<cgt::vec3>& _exits;
+            const std::vector<cgt::vec4>& _lut;
+            cgt::vec2 _intensityDomain;
+            float _samplingStepSize;
+            cgt::svec3 _numBricks;
+            const std::vector<uint8_t>& _emptyBricks;
+            cgt::mat4 _textureToClip;
+            cgt::col4* _colors;
+            float* _depths;
+        };
+    }
+
+    const std::string CpuRaycaster::loggerCat_ = "CAMPVis.modules.vis.CpuRaycaster";
+
+    CpuRaycaster::CpuRaycaster()
+        : AbstractProcessor()
+        , p_sourceImageID("sourceImageID", "Input Image", "", DataNameProperty::READ)
+        , p_entryImageID("entryImageID", "Input Entry Points Image (optional)", "", DataNameProperty::READ)
+        , p_exitImageID("exitImageID", "Input Exit Points Image (optional)", "", DataNameProperty::READ)
+        , p_camera("Camera", "Camera ID", "camera", DataNameProperty::READ)
+        , p_targetImageID("targetImageID", "Output Image", "", DataNameProperty::WRITE)
+        , p_outputSize("OutputSize", "Output Size (without entry/exit points)", cgt::ivec2(512), cgt::ivec2(1), cgt::ivec2(8192))
+        , p_transferFunction("TransferFunction", "Transfer Function", new SimpleTransferFunction(256))
+        , p_samplingRate("SamplingRate", "Sampling Rate", 2.f, 0.1f, 10.f, 0.1f)
+        , p_enableEmptySpaceSkipping("EnableEmptySpaceSkipping", "Enable Empty Space Skipping", true)
+        , _brickIndex(BRICK_SIZE)
+    {
+        addProperty(p_sourceImageID, INVALID_PROPERTIES | INVALID_RESULT);
+        addProperty(p_entryImageID);
+        addProperty(p_exitImageID);
+        addProperty(p_camera);
+        addProperty(p_targetImageID);
+        addProperty(p_outputSize);
+        addProperty(p_transferFunction);
+        addProperty(p_samplingRate);
+        addProperty(p_enableEmptySpaceSkipping);
+    }
+
+    CpuRaycaster::~CpuRaycaster() {
+
+    }
+
+    void CpuRaycaster::updateResult(DataContainer& data) {
+        ImageRepresentationLocal::ScopedRepresentation image(data, p_sourceImageID.getValue());
+        ScopedTypedData<CameraData> camera(data, p_camera.getValue());
+
+        if (image == 0 || camera == 0) {
+            LDEBUG("No suitable input image or camera found.");
+            return;
+        }
+        if (image->getDimensionality() != 3 || image->getParent()->getNumChannels() != 1) {
+            LERROR("Input image must be a single-channel volume.");
+            return;
+        }
+
+        std::vector<cgt::vec4> lut;
+        if (! computeLookupTable(lut) || lut.empty()) {
+            LERROR("Transfer function type is not supported, use a Geometry1DTransferFunction or SimpleTransferFunction.");
+            return;
+        }
+
+        const ImageMappingInformation& mi = image->getParent()->getMappingInformation();
+        cgt::Camera cam = camera->getCamera();
+        cgt::ivec2 imageSize = p_outputSize.getValue();
+        std::vector<cgt::vec3> entries, exits;
+
+        ScopedTypedData<RenderData> entryPoints(data, p_entryImageID.getValue(), true);
+        ScopedTypedData<RenderData> exitPoints(data, p_exitImageID.getValue(), true);
+        if (entryPoints != 0 && exitPoints != 0) {
+            // use the given entry/exit points, downloads them from OpenGL if necessary
+            const ImageRepresentationLocal* entryRep = entryPoints->getColorTexture()->getRepresentation<ImageRepresentationLocal>();
+            const ImageRepresentationLocal* exitRep = exitPoints->getColorTexture()->getRepresentation<ImageRepresentationLocal>();
+            if (entryRep == 0 || exitRep == 0 || entryRep->getSize() != exitRep->getSize()) {
+                LERROR("Could not access entry/exit points or their sizes mismatch.");
+                return;
+            }
+
+            imageSize = cgt::ivec2(static_cast<int>(entryRep->getSize().x), static_cast<int>(entryRep->getSize().y));
+            entries.resize(entryRep->getNumElements());
+            exits.resize(entries.size());
+            tbb::parallel_for(tbb::blocked_range<size_t>(0, entries.size()), [&] (const tbb::blocked_range<size_t>& range) {
+                for (size_t i = range.begin(); i != range.end(); ++i) {
+                    for (size_t c = 0; c < 3; ++c) {
+                        entries[i][c] = entryRep->getElementNormalized(i, c);
+                        exits[i][c] = exitRep->getElementNormalized(i, c);
+                    }
+                }
+            });
+        }
+        else {
+            // intersect the camera rays with the volume's bounding box in texture coordinates
+            cam.setWindowRatio(static_cast<float>(imageSize.x) / static_cast<float>(imageSize.y));
+            cgt::mat4 clipToWorld;
+            (cam.getProjectionMatrix() * cam.getViewMatrix()).invert(clipToWorld);
+            const cgt::mat4 clipToTexture = mi.getWorldToTextureMatrix() * clipToWorld;
+
+            entries.resize(cgt::hmul(imageSize));
+            exits.resize(entries.size());
+            tbb::parallel_for(tbb::blocked_range<int>(0, imageSize.y), [&] (const tbb::blocked_range<int>& range) {
+                for (int y = range.begin(); y != range.end(); ++y) {
+                    for (int x = 0; x < imageSize.x; ++x) {
+                        const cgt::vec2 ndc = (cgt::vec2(static_cast<float>(x), static_cast<float>(y)) + cgt::vec2(.5f)) / cgt::vec2(imageSize) * 2.f - cgt::vec2(1.f);
+                        const cgt::vec4 nearPoint = clipToTexture * cgt::vec4(ndc, -1.f, 1.f);
+                        const cgt::vec4 farPoint = clipToTexture * cgt::vec4(ndc, 1.f, 1.f);
+                        const cgt::vec3 from = nearPoint.xyz() / nearPoint.w;
+                        const cgt::vec3 direction = farPoint.xyz() / farPoint.w - from;
+
+                        float tMin = 0.f, tMax = 1.f;
+                        for (size_t axis = 0; axis < 3 && tMin <= tMax; ++axis) {
+                            if (direction[axis] == 0.f) {
+                                if (from[axis] < 0.f || from[axis] > 1.f)
+                                    tMax = -1.f;
+                                continue;
+                            }
+                            float t0 = -from[axis] / direction[axis];
+                            float t1 = (1.f - from[axis]) / direction[axis];
+                            tMin = std::max(tMin, std::min(t0, t1));
+                            tMax = std::min(tMax, std::max(t0, t1));
+                        }
+
+                        const size_t index = static_cast<size_t>(y) * imageSize.x + x;
+                        entries[index] = (tMin < tMax) ? from + tMin * direction : cgt::vec3(0.f);
+                        exits[index] = (tMin < tMax) ? from + tMax * direction : cgt::vec3(0.f);
+                    }
+                }
+            });
+        }
+
+        // classify the bricks of the min/max index with the current transfer function
+        std::vector<uint8_t> emptyBricks;
+        const cgt::vec2& domain = p_transferFunction.getTF()->getIntensityDomain();
+        if (p_enableEmptySpaceSkipping.getValue()) {
+            _brickIndex.update(image, image.getDataHandle());
+            const std::vector<cgt::vec2>& brickRanges = _brickIndex.getBlockRanges();
+
+            std::vector<size_t> opaqueTexels(lut.size() + 1, 0);
+            for (size_t i = 0; i < lut.size(); ++i)
+                opaqueTexels[i + 1] = opaqueTexels[i] + (lut[i].a > 0.f ? 1 : 0);
+
+            const float lutMax = static_cast<float>(lut.size() - 1);
+            emptyBricks.resize(brickRanges.size());
+            for (size_t i = 0; i < brickRanges.size(); ++i) {
+                const float left = std::max(brickRanges[i].x, domain.x);
+                const float right = std::min(brickRanges[i].y, domain.y);
+                if (left > right) {
+                    emptyBricks[i] = 1;
+                    continue;
+                }
+
+                // conservatively include the neighboring texels of the linear TF filtering
+                const float uLeft = cgt::clamp((left - domain.x) / (domain.y - domain.x) * lut.size() - .5f, 0.f, lutMax);
+                const float uRight = cgt::clamp((right - domain.x) / (domain.y - domain.x) * lut.size() - .5f, 0.f, lutMax);
+                const size_t first = static_cast<size_t>(uLeft) > 0 ? static_cast<size_t>(uLeft) - 1 : 0;
+                const size_t last = std::min(static_cast<size_t>(uRight) + 2, lut.size() - 1);
+                emptyBricks[i] = (opaqueTexels[last + 1] == opaqueTexels[first]) ? 1 : 0;
+            }
+        }
+
+        // trace the rays
+        const float samplingStepSize = 1.f / (p_samplingRate.getValue() * cgt::max(image->getSize()));
+        const cgt::mat4 textureToClip = cam.getProjectionMatrix() * cam.getViewMatrix() * mi.getTextureToWorldMatrix();
+        const cgt::svec3 outputSize(imageSize.x, imageSize.y, 1);
+
+        ImageData* colorImage = new ImageData(2, outputSize, 4);
+        GenericImageRepresentationLocal<uint8_t, 4>* colorRep = GenericImageRepresentationLocal<uint8_t, 4>::create(colorImage, 0);
+        ImageData* depthImage = new ImageData(2, outputSize, 1);
+        GenericImageRepresentationLocal<float, 1>* depthRep = GenericImageRepresentationLocal<float, 1>::create(depthImage, 0);
+
+        RaycastingFunctor functor(imageSize, entries, exits, lut, domain, samplingStepSize, _brickIndex.getNumBlocks(), emptyBricks, textureToClip, colorRep->getImageData(), depthRep->getImageData());
+        dispatchVoxelView<1>(image, functor);
+
+        RenderData* rd = new RenderData();
+        rd->addColorTexture(colorImage);
+        rd->setDepthTexture(depthImage);
+        data.addData(p_targetImageID.getValue(), rd);
+    }
+
+    void CpuRaycaster::updateProperties(DataContainer& dataContainer) {
+        ScopedTypedData<ImageData> img(dataContainer, p_sourceImageID.getValue());
+        p_transferFunction.setImageHandle(img.getDataHandle());
+    }
+
+    bool CpuRaycaster::computeLookupTable(std::vector<cgt::vec4>& lut) {
+        AbstractTransferFunction* tf = p_transferFunction.getTF();
+
+        if (Geometry1DTransferFunction* gtf = dynamic_cast<Geometry1DTransferFunction*>(tf)) {
+            gtf->rasterize(lut);
+            return true;
+        }
+        else if (SimpleTransferFunction* stf = dynamic_cast<SimpleTransferFunction*>(tf)) {
+            // same quantization as in SimpleTransferFunction::createTexture()
+            const size_t size = stf->getSize().x;
+            const cgt::col4& left = stf->getLeftColor();
+            const cgt::vec4 diff = cgt::vec4(stf->getRightColor()) - cgt::vec4(left);
+            lut.resize(size);
+            for (size_t i = 0; i < size; ++i) {
+                const float multiplier = (size > 1) ? static_cast<float>(i) / (size - 1) : 0.f;
+                for (size_t j = 0; j < 4; ++j)
+                    lut[i][j] = static_cast<float>(static_cast<uint8_t>(left[j] + diff[j] * multiplier)) / 255.f;
+            }
+            return true;
+        }
+
+        return false;
+    }
+
+}
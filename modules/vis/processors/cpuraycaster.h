@@ -0,0 +1,125 @@
+// ================================================================================================
+// 
+// This file is part of the CAMPVis Software Framework.
+// 
+// If not explicitly stated otherwise: Copyright (C) 2012-2015, all rights reserved,
+//      Christian Schulte zu Berge <christian.szb@in.tum.de>
+//      Chair for Computer Aided Medical Procedures
+//      Technische Universitaet Muenchen
+//      Boltzmannstr. 3, 85748 Garching b. Muenchen, Germany
+// 
+// For a full list of authors and contributors, please refer to the file "AUTHORS.txt".
+// 
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file 
+// except in compliance with the License. You may obtain a copy of the License at
+// 
+// http://www.apache.org/licenses/LICENSE-2.0
+// 
+// Unless required by applicable law or agreed to in writing, software distributed under the 
+// License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, 
+// either express or implied. See the License for the specific language governing permissions 
+// and limitations under the License.
+// 
+// ================================================================================================
+
+
+#ifndef CPURAYCASTER_H__
+#define CPURAYCASTER_H__
+
+#include <string>
+#include <vector>
+
+#include "core/pipeline/abstractprocessor.h"
+#include "core/properties/datanameproperty.h"
+#include "core/properties/floatingpointproperty.h"
+#include "core/properties/genericproperty.h"
+#include "core/properties/numericproperty.h"
+#include "core/properties/transferfunctionproperty.h"
+#include "core/tools/minmaxblockindex.h"
+
+#include "modules/modulesapi.h"
+
+namespace campvis {
+    /**
+     * Performs a simple direct volume ray casting entirely on the CPU, hence, it does not need an
+     * OpenGL context and can be used for headless rendering (e.g. thumbnails on batch servers).
+     * 
+     * Produces the same results as SimpleRaycaster without shading and jittering. Rays either start
+     * and end at the entry/exit points given as RenderData (e.g. from an EEPGenerator) or, if these
+     * are not present, at the intersections of the camera rays with the volume's bounding box. The
+     * result is a RenderData with a local RGBA8 color and a local float depth image, which is
+     * uploaded to OpenGL on demand by the image representation conversion.
+     * 
+     * The image is split into tiles rendered in parallel. Within a tile, packets of PACKET_SIZE
+     * adjacent rays are traced together with all per-ray computations (sample positions, trilinear
+     * interpolation weights, TF lookups) laid out as structure of arrays, so that the compiler can
+     * vectorize them. Rays terminate early once they are opaque and skip bricks of BRICK_SIZE^3 cells
+     * that are fully transparent under the current transfer function.
+     * 
+     * \note    Only 1D transfer functions computable on the CPU are supported, i.e. 
+     *          Geometry1DTransferFunction and SimpleTransferFunction.
+     */
+    class CAMPVIS_MODULES_API CpuRaycaster : public AbstractProcessor {
+    public:
+        /// Number of cells per brick edge of the min/max brick index used for empty space skipping
+        static const size_t BRICK_SIZE = 8;
+        /// Edge length of the image tiles which are rendered in parallel
+        static const size_t TILE_SIZE = 16;
+        /// Number of adjacent rays traced together
+        static const size_t PACKET_SIZE = 8;
+
+        /**
+         * Constructs a new CpuRaycaster Processor
+         **/
+        CpuRaycaster();
+
+        /**
+         * Destructor
+         **/
+        virtual ~CpuRaycaster();
+
+        /// To be used in ProcessorFactory static methods
+        static const std::string getId() { return "CpuRaycaster"; };
+        /// \see AbstractProcessor::getName()
+        virtual const std::string getName() const { return getId(); };
+        /// \see AbstractProcessor::getDescription()
+        virtual const std::string getDescription() const { return "Performs a multithreaded direct volume ray casting on the CPU without need for OpenGL."; };
+        /// \see AbstractProcessor::getAuthor()
+        virtual const std::string getAuthor() const { return "Christian Schulte zu Berge <christian.szb@in.tum.de>"; };
+        /// \see AbstractProcessor::getProcessorState()
+        virtual ProcessorState getProcessorState() const { return AbstractProcessor::EXPERIMENTAL; };
+        /// \see AbstractProcessor::supportsConcurrentExecution()
+        virtual bool supportsConcurrentExecution() const { return true; };
+
+        DataNameProperty p_sourceImageID;                ///< image ID for input image
+        DataNameProperty p_entryImageID;                 ///< image ID for the optional entry points image
+        DataNameProperty p_exitImageID;                  ///< image ID for the optional exit points image
+        DataNameProperty p_camera;                       ///< Camera used for ray casting
+        DataNameProperty p_targetImageID;                ///< image ID for output image
+
+        IVec2Property p_outputSize;                      ///< Size of the output image if no entry/exit points are given
+        TransferFunctionProperty p_transferFunction;     ///< Transfer function
+        FloatProperty p_samplingRate;                    ///< Ray casting sampling rate
+        BoolProperty p_enableEmptySpaceSkipping;         ///< Flag whether to skip transparent bricks
+
+    protected:
+        /// \see AbstractProcessor::updateResult
+        virtual void updateResult(DataContainer& dataContainer);
+        /// \see AbstractProcessor::updateProperties
+        virtual void updateProperties(DataContainer& dataContainer);
+
+        /**
+         * Computes the RGBA lookup table of the current transfer function on the CPU.
+         * \param   lut     Lookup table to fill
+         * \return  False if the transfer function type is not supported.
+         */
+        bool computeLookupTable(std::vector<cgt::vec4>& lut);
+
+        MinMaxBlockIndex _brickIndex;           ///< Min/max brick index of the input image, cached between executions
+
+        static const std::string loggerCat_;
+    };
+
+}
+
+#endif // CPURAYCASTER_H__
@@ -33,7 +33,7 @@
 #include "core/datastructures/imagedata.h"
 #include "core/datastructures/imagerepresentationgl.h"
 #include "core/datastructures/renderdata.h"
-#include "core/datastructures/renderdata.h"
+#include "core/datastructures/flatmeshgeometry.h"
 #include "core/datastructures/meshgeometry.h"
 #include "core/pipeline/processordecoratormasking.h"
 
@@ -85,9 +85,20 @@ namespace campvis {
 
     void EEPGenerator::updateResult(DataContainer& data) {
         ImageRepresentationGL::ScopedRepresentation img(data, p_sourceImageID.getValue());
-        ScopedTypedData<MeshGeometry> proxyGeometry(data, p_geometryID.getValue());
+        ScopedTypedData<GeometryData> proxyData(data, p_geometryID.getValue());
         ScopedTypedData<CameraData> camera(data, p_camera.getValue());
 
+        // accept both FlatMeshGeometry and MeshGeometry proxies, the latter are converted
+        const GeometryData* proxy = proxyData;
+        const FlatMeshGeometry* proxyGeometry = dynamic_cast<const FlatMeshGeometry*>(proxy);
+        std::unique_ptr<FlatMeshGeometry> convertedProxy;
+        if (proxyGeometry == nullptr) {
+            if (const MeshGeometry* mesh = dynamic_cast<const MeshGeometry*>(proxy)) {
+                convertedProxy.reset(new FlatMeshGeometry(*mesh));
+                proxyGeometry = convertedProxy.get();
+            }
+        }
+
         if (img != nullptr && proxyGeometry != nullptr && _shader != nullptr && camera != nullptr) {
             if (img->getDimensionality() == 3) {
                 const cgt::Camera& cam = camera->getCamera();
@@ -98,7 +109,7 @@ namespace campvis {
                 // clip proxy geometry against near-plane to support camera in volume
                 // FIXME:   In some cases, the near plane is not rendered correctly...
                 float nearPlaneDistToOrigin = cgt::dot(cam.getPosition(), -cam.getLook()) - cam.getNearDist() - .002f;
-                MeshGeometry clipped = proxyGeometry->clipAgainstPlane(nearPlaneDistToOrigin, -cam.getLook(), true, 0.02f);
+                FlatMeshGeometry clipped = proxyGeometry->clipAgainstPlane(nearPlaneDistToOrigin, -cam.getLook(), true, 0.02f);
 
                 // start render setup
                 _shader->activate();
@@ -0,0 +1,393 @@
+// ================================================================================================
+// 
+// This file is part of the CAMPVis Software Framework.
+// 
+// If not explicitly stated otherwise: Copyright (C) 2012-2015, all rights reserved,
+//      Christian Schulte zu Berge <christian.szb@in.tum.de>
+//      Chair for Computer Aided Medical Procedures
+//      Technische Universitaet Muenchen
+//      Boltzmannstr. 3, 85748 Garching b. Muenchen, Germany
+// 
+// For a full list of authors and contributors, please refer to the file "AUTHORS.txt".
+// 
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file 
+// except in compliance with the License. You may obtain a copy of the License at
+// 
+// http://www.apache.org/licenses/LICENSE-2.0
+// 
+// Unless required by applicable law or agreed to in writing, software distributed under the 
+// License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, 
+// either express or implied. See the License for the specific language governing permissions 
+// and limitations under the License.
+// 
+// ================================================================================================
+
+
+#include "isosurfaceextractor.h"
+
+#include "cgt/logmanager.h"
+
+#include <tbb/tbb.h>
+
+#include <algorithm>
+#include <limits>
+
+#include "core/datastructures/imagedata.h"
+#include "core/datastructures/imagerepresentationlocal.h"
+#include "core/datastructures/indexedmeshgeometry.h"
+#include "core/tools/minmaxblockindex.h"
+#include "core/tools/voxelview.h"
+
+namespace campvis {
+
+    namespace {
+        /// Cell edges given by their two corners, where corner i is located at (i & 1, (i >> 1) & 1, i >> 2).
+        /// Edges 0-3 are aligned with the x axis, 4-7 with the y axis and 8-11 with the z axis.
+        const int EDGE_CORNERS[12][2] = {
+            { 0, 1 }, { 2, 3 }, { 4, 5 }, { 6, 7 },
+            { 0, 2 }, { 1, 3 }, { 4, 6 }, { 5, 7 },
+            { 0, 4 }, { 1, 5 }, { 2, 6 }, { 3, 7 }
+        };
+
+        /// Cell faces given by their four corners in cyclic order
+        const int FACE_CORNERS[6][4] = {
+            { 0, 2, 6, 4 }, { 1, 3, 7, 5 },
+            { 0, 1, 5, 4 }, { 2, 3, 7, 6 },
+            { 0, 1, 3, 2 }, { 4, 5, 7, 6 }
+        };
+
+        cgt::vec3 cornerPosition(int corner) {
+            return cgt::vec3(static_cast<float>(corner & 1), static_cast<float>((corner >> 1) & 1), static_cast<float>(corner >> 2));
+        }
+
+        cgt::vec3 edgeCenter(int edge) {
+            return (cornerPosition(EDGE_CORNERS[edge][0]) + cornerPosition(EDGE_CORNERS[edge][1])) * .5f;
+        }
+
+        int findEdge(int c0, int c1) {
+            for (int e = 0; e < 12; ++e) {
+                if ((EDGE_CORNERS[e][0] == c0 && EDGE_CORNERS[e][1] == c1) || (EDGE_CORNERS[e][0] == c1 && EDGE_CORNERS[e][1] == c0))
+                    return e;
+            }
+            return -1;
+        }
+
+        /**
+         * Marching cubes case table listing the triangles of each of the 256 corner configurations
+         * as triples of cell edges. Bit i of the configuration is set if corner i is inside.
+         * 
+         * Instead of hard-coding the classic table, it is generated by cutting off the inside corners
+         * on each cell face and chaining the resulting segments to closed polygons. Ambiguous faces
+         * are always resolved by separating the inside corners. As this decision only depends on the
+         * face itself, adjacent cells agree on it and the resulting surface is watertight.
+         */
+        struct CaseTable {
+            CaseTable() {
+                for (int c = 0; c < 256; ++c) {
+                    // each intersected edge is shared by two faces, hence it has exactly two neighbors
+                    int neighbors[12][2];
+                    int numNeighbors[12] = { 0 };
+
+                    for (int f = 0; f < 6; ++f) {
+                        const int* fc = FACE_CORNERS[f];
+                        int crossed[4];
+                        int numCrossed = 0;
+                        for (int k = 0; k < 4; ++k) {
+                            if (((c >> fc[k]) & 1) != ((c >> fc[(k+1) % 4]) & 1))
+                                crossed[numCrossed++] = findEdge(fc[k], fc[(k+1) % 4]);
+                        }
+
+                        if (numCrossed == 2) {
+                            addSegment(crossed[0], crossed[1], neighbors, numNeighbors);
+                        }
+                        else if (numCrossed == 4) {
+                            for (int k = 0; k < 4; ++k) {
+                                if ((c >> fc[k]) & 1)
+                                    addSegment(findEdge(fc[(k+3) % 4], fc[k]), findEdge(fc[k], fc[(k+1) % 4]), neighbors, numNeighbors);
+                            }
+                        }
+                    }
+
+                    // chain the segments into closed polygons and triangulate them as fans
+                    bool visited[12] = { false };
+                    for (int start = 0; start < 12; ++start) {
+                        if (numNeighbors[start] == 0 || visited[start])
+                            continue;
+
+                        std::vector<int> polygon;
+                        int previous = -1;
+                        int current = start;
+                        do {
+                            visited[current] = true;
+                            polygon.push_back(current);
+                            int next = (neighbors[current][0] != previous) ? neighbors[current][0] : neighbors[current][1];
+                            previous = current;
+                            current = next;
+                        } while (current != start);
+
+                        // orient the polygon counter-clockwise when seen from the outside
+                        cgt::vec3 normal(0.f);
+                        cgt::vec3 outward(0.f);
+                        for (size_t i = 0; i < polygon.size(); ++i) {
+                            normal += cgt::cross(edgeCenter(polygon[i]), edgeCenter(polygon[(i+1) % polygon.size()]));
+                            int insideCorner = ((c >> EDGE_CORNERS[polygon[i]][0]) & 1) ? EDGE_CORNERS[polygon[i]][0] : EDGE_CORNERS[polygon[i]][1];
+                            outward += edgeCenter(polygon[i]) - cornerPosition(insideCorner);
+                        }
+                        if (cgt::dot(normal, outward) < 0.f)
+                            std::reverse(polygon.begin(), polygon.end());
+
+                        for (size_t i = 1; i + 1 < polygon.size(); ++i) {
+                            triangles[c].push_back(static_cast<uint8_t>(polygon[0]));
+                            triangles[c].push_back(static_cast<uint8_t>(polygon[i]));
+                            triangles[c].push_back(static_cast<uint8_t>(polygon[i+1]));
+                        }
+                    }
+                }
+            }
+
+            static void addSegment(int e0, int e1, int neighbors[12][2], int* numNeighbors) {
+                neighbors[e0][numNeighbors[e0]++] = e1;
+                neighbors[e1][numNeighbors[e1]++] = e0;
+            }
+
+            std::vector<uint8_t> triangles[256];    ///< Edge triples of the triangles of each configuration
+        };
+
+        const CaseTable s_caseTable;
+
+        /**
+         * Extracts the isosurface of a single-channel image using marching cubes, visiting only
+         * blocks whose intensity range contains the iso value.
+         * 
+         * Work is split into slabs of one block layer each. The first pass creates one vertex per 
+         * intersected edge, identified by the linear index of its first voxel times 3 plus its axis,
+         * so that the keys of each slab are sorted. The second pass triangulates the cells and looks 
+         * up the shared vertices of their edges in the slab owning them.
+         */
+        struct MarchingCubesFunctor {
+            /// Intersected edges of a single slab
+            struct Slab {
+                std::vector<size_t> keys;           ///< Sorted edge keys
+                std::vector<cgt::vec3> vertices;    ///< Vertex positions in voxel coordinates
+                std::vector<cgt::vec3> gradients;   ///< Interpolated image gradients in voxel coordinates
+                std::vector<uint32_t> indices;      ///< Triangles of the cells of this slab
+            };
+
+            MarchingCubesFunctor(float isoValue, bool computeNormals, const cgt::svec3& numBlocks, const std::vector<cgt::vec2>& blockRanges)
+                : _isoValue(isoValue)
+                , _computeNormals(computeNormals)
+                , _numBlocks(numBlocks)
+                , _blockRanges(blockRanges)
+            {}
+
+            template<typename BASETYPE>
+            void operator() (const VoxelView<BASETYPE, 1>& input) {
+                const size_t B = IsosurfaceExtractor::BLOCK_SIZE;
+                const cgt::svec3& size = input.getSize();
+                const size_t strides[3] = { 1, input.positionToIndex(cgt::svec3(0, 1, 0)), input.positionToIndex(cgt::svec3(0, 0, 1)) };
+                const float isoValue = _isoValue;
+                const bool computeNormals = _computeNormals;
+                const cgt::svec3 numBlocks = _numBlocks;
+                const std::vector<cgt::vec2>& blockRanges = _blockRanges;
+
+                auto isActive = [&] (size_t bx, size_t by, size_t bz) -> bool {
+                    const cgt::vec2& minMax = blockRanges[(bz * numBlocks.y + by) * numBlocks.x + bx];
+                    return minMax.x < isoValue && minMax.y >= isoValue;
+                };
+
+                std::vector<Slab> slabs(numBlocks.z);
+
+                // first pass: create vertices on all intersected edges
+                tbb::parallel_for(tbb::blocked_range<size_t>(0, numBlocks.z, 1), [&] (const tbb::blocked_range<size_t>& range) {
+                    for (size_t bz = range.begin(); bz != range.end(); ++bz) {
+                        Slab& slab = slabs[bz];
+                        const size_t zEnd = (bz == numBlocks.z - 1) ? size.z : (bz + 1) * B;
+
+                        for (size_t z = bz * B; z < zEnd; ++z) {
+                            for (size_t y = 0; y < size.y; ++y) {
+                                const size_t by = std::min(y / B, numBlocks.y - 1);
+
+                                for (size_t bx = 0; bx < numBlocks.x; ++bx) {
+                                    if (! isActive(bx, by, bz))
+                                        continue;
+
+                                    const size_t xEnd = (bx == numBlocks.x - 1) ? size.x : (bx + 1) * B;
+                                    size_t index = input.positionToIndex(cgt::svec3(bx * B, y, z));
+                                    for (size_t x = bx * B; x < xEnd; ++x, ++index) {
+                                        const cgt::svec3 position(x, y, z);
+                                        const float value = input.getNormalized(index, 0);
+                                        const bool inside = (value >= isoValue);
+
+                                        for (size_t axis = 0; axis < 3; ++axis) {
+                                            if (position[axis] + 1 >= size[axis])
+                                                continue;
+
+                                            const float neighborValue = input.getNormalized(index + strides[axis], 0);
+                                            if ((neighborValue >= isoValue) == inside)
+                                                continue;
+
+                                            const float t = (isoValue - value) / (neighborValue - value);
+                                            cgt::svec3 neighbor(position);
+                                            neighbor[axis] += 1;
+
+                                            cgt::vec3 vertex(position);
+                                            vertex[axis] += t;
+                                            slab.keys.push_back(index * 3 + axis);
+                                            slab.vertices.push_back(vertex);
+                                            if (computeNormals)
+                                                slab.gradients.push_back((1.f - t) * input.getGradient(position) + t * input.getGradient(neighbor));
+                                        }
+                                    }
+                                }
+                            }
+                        }
+                    }
+                });
+
+                _slabOffsets.assign(numBlocks.z + 1, 0);
+                for (size_t bz = 0; bz < numBlocks.z; ++bz)
+                    _slabOffsets[bz + 1] = _slabOffsets[bz] + slabs[bz].keys.size();
+
+                // second pass: triangulate the cells of all active blocks
+                tbb::parallel_for(tbb::blocked_range<size_t>(0, numBlocks.z, 1), [&] (const tbb::blocked_range<size_t>& range) {
+                    for (size_t bz = range.begin(); bz != range.end(); ++bz) {
+                        std::vector<uint32_t>& indices = slabs[bz].indices;
+                        const size_t zEnd = std::min((bz + 1) * B, size.z - 1);
+
+                        for (size_t z = bz * B; z < zEnd; ++z) {
+                            for (size_t y = 0; y < size.y - 1; ++y) {
+                                const size_t by = y / B;
+
+                                for (size_t bx = 0; bx < numBlocks.x; ++bx) {
+                                    if (! isActive(bx, by, bz))
+                                        continue;
+
+                                    const size_t xEnd = std::min((bx + 1) * B, size.x - 1);
+                                    size_t index = input.positionToIndex(cgt::svec3(bx * B, y, z));
+                                    for (size_t x = bx * B; x < xEnd; ++x, ++index) {
+                                        size_t corners[8];
+                                        int configuration = 0;
+                                        for (int i = 0; i < 8; ++i) {
+                                            corners[i] = index + (i & 1) + ((i >> 1) & 1) * strides[1] + (i >> 2) * strides[2];
+                                            if (input.getNormalized(corners[i], 0) >= isoValue)
+                                                configuration |= (1 << i);
+                                        }
+
+                                        const std::vector<uint8_t>& triangles = s_caseTable.triangles[configuration];
+                                        for (size_t i = 0; i < triangles.size(); ++i) {
+                                            const int firstCorner = EDGE_CORNERS[triangles[i]][0];
+                                            const size_t key = corners[firstCorner] * 3 + triangles[i] / 4;
+                                            const size_t owner = std::min((z + (firstCorner >> 2)) / B, numBlocks.z - 1);
+
+                                            const std::vector<size_t>& keys = slabs[owner].keys;
+                                            std::vector<size_t>::const_iterator it = std::lower_bound(keys.begin(), keys.end(), key);
+                                            cgtAssert(it != keys.end() && *it == key, "Intersected edge without vertex, this should not happen!");
+                                            indices.push_back(static_cast<uint32_t>(_slabOffsets[owner] + (it - keys.begin())));
+                                        }
+                                    }
+                                }
+                            }
+                        }
+                    }
+                });
+
+                // gather the per-slab results
+                _vertices.resize(_slabOffsets.back());
+                _gradients.resize(computeNormals ? _slabOffsets.back() : 0);
+                size_t numIndices = 0;
+                for (size_t bz = 0; bz < numBlocks.z; ++bz)
+                    numIndices += slabs[bz].indices.size();
+                _indices.clear();
+                _indices.reserve(numIndices);
+
+                for (size_t bz = 0; bz < numBlocks.z; ++bz) {
+                    std::copy(slabs[bz].vertices.begin(), slabs[bz].vertices.end(), _vertices.begin() + _slabOffsets[bz]);
+                    if (computeNormals)
+                        std::copy(slabs[bz].gradients.begin(), slabs[bz].gradients.end(), _gradients.begin() + _slabOffsets[bz]);
+                    _indices.insert(_indices.end(), slabs[bz].indices.begin(), slabs[bz].indices.end());
+                }
+            }
+
+            float _isoValue;
+            bool _computeNormals;
+            cgt::svec3 _numBlocks;
+            const std::vector<cgt::vec2>& _blockRanges;
+
+            std::vector<size_t> _slabOffsets;       ///< Index of the first vertex of each slab
+            std::vector<cgt::vec3> _vertices;       ///< Vertex positions in voxel coordinates
+            std::vector<cgt::vec3> _gradients;      ///< Image gradients at the vertices in voxel coordinates
+            std::vector<uint32_t> _indices;         ///< Triangle list
+        };
+    }
+
+    const std::string IsosurfaceExtractor::loggerCat_ = "CAMPVis.modules.vis.IsosurfaceExtractor";
+
+    IsosurfaceExtractor::IsosurfaceExtractor()
+        : AbstractProcessor()
+        , p_sourceImageID("InputVolume", "Input Volume ID", "volume", DataNameProperty::READ)
+        , p_geometryID("OutputGeometry", "Output Geometry ID", "isosurface", DataNameProperty::WRITE)
+        , p_isoValue("IsoValue", "Iso Value", .5f, 0.f, 1.f, .001f)
+        , p_computeNormals("ComputeNormals", "Compute Vertex Normals", true)
+        , _blockIndex(BLOCK_SIZE)
+    {
+        addProperty(p_sourceImageID, INVALID_RESULT | INVALID_PROPERTIES);
+        addProperty(p_geometryID);
+        addProperty(p_isoValue);
+        addProperty(p_computeNormals);
+    }
+
+    IsosurfaceExtractor::~IsosurfaceExtractor() {
+
+    }
+
+    void IsosurfaceExtractor::updateResult(DataContainer& data) {
+        ImageRepresentationLocal::ScopedRepresentation input(data, p_sourceImageID.getValue());
+
+        if (input != 0) {
+            const cgt::svec3& size = input->getSize();
+            if (input->getDimensionality() != 3 || input->getParent()->getNumChannels() != 1 || size.x < 2 || size.y < 2 || size.z < 2) {
+                LERROR("Isosurface extraction is only supported for single-channel 3D images.");
+                return;
+            }
+
+            _blockIndex.update(input, input.getDataHandle());
+
+            MarchingCubesFunctor functor(p_isoValue.getValue(), p_computeNormals.getValue(), _blockIndex.getNumBlocks(), _blockIndex.getBlockRanges());
+            dispatchVoxelView<1>(input, functor);
+
+            // transform into world space, gradients transform with the inverse transpose
+            const cgt::mat4& voxelToWorld = input->getParent()->getMappingInformation().getVoxelToWorldMatrix();
+            const cgt::mat4 gradientToWorld = cgt::transpose(input->getParent()->getMappingInformation().getWorldToVoxelMatrix());
+            std::vector<cgt::vec3> normals(functor._gradients.size());
+
+            tbb::parallel_for(tbb::blocked_range<size_t>(0, functor._vertices.size(), 4096), [&] (const tbb::blocked_range<size_t>& range) {
+                for (size_t i = range.begin(); i != range.end(); ++i) {
+                    functor._vertices[i] = (voxelToWorld * cgt::vec4(functor._vertices[i], 1.f)).xyz();
+                    if (! normals.empty()) {
+                        // gradients point towards higher intensities, normals towards the outside
+                        cgt::vec3 gradient = (gradientToWorld * cgt::vec4(functor._gradients[i], 0.f)).xyz();
+                        float length = cgt::length(gradient);
+                        normals[i] = (length > 0.f) ? -gradient / length : cgt::vec3(0.f);
+                    }
+                }
+            });
+
+            LDEBUG("Extracted isosurface with " << functor._vertices.size() << " vertices and " << functor._indices.size() / 3 << " triangles.");
+            data.addData(p_geometryID.getValue(), new IndexedMeshGeometry(functor._indices, functor._vertices, std::vector<cgt::vec3>(), std::vector<cgt::vec4>(), normals));
+        }
+        else {
+            LDEBUG("No suitable input image found.");
+        }
+    }
+
+    void IsosurfaceExtractor::updateProperties(DataContainer& dataContainer) {
+        ImageRepresentationLocal::ScopedRepresentation input(dataContainer, p_sourceImageID.getValue());
+
+        if (input != 0) {
+            const Interval<float>& range = input->getNormalizedIntensityRange();
+            p_isoValue.setMinValue(range.getLeft());
+            p_isoValue.setMaxValue(range.getRight());
+        }
+    }
+
+}
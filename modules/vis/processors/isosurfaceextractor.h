@@ -0,0 +1,97 @@
+// ================================================================================================
+// 
+// This file is part of the CAMPVis Software Framework.
+// 
+// If not explicitly stated otherwise: Copyright (C) 2012-2015, all rights reserved,
+//      Christian Schulte zu Berge <christian.szb@in.tum.de>
+//      Chair for Computer Aided Medical Procedures
+//      Technische Universitaet Muenchen
+//      Boltzmannstr. 3, 85748 Garching b. Muenchen, Germany
+// 
+// For a full list of authors and contributors, please refer to the file "AUTHORS.txt".
+// 
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file 
+// except in compliance with the License. You may obtain a copy of the License at
+// 
+// http://www.apache.org/licenses/LICENSE-2.0
+// 
+// Unless required by applicable law or agreed to in writing, software distributed under the 
+// License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, 
+// either express or implied. See the License for the specific language governing permissions 
+// and limitations under the License.
+// 
+// ================================================================================================
+
+
+#ifndef ISOSURFACEEXTRACTOR_H__
+#define ISOSURFACEEXTRACTOR_H__
+
+#include <string>
+#include <vector>
+
+#include "core/pipeline/abstractprocessor.h"
+#include "core/properties/datanameproperty.h"
+#include "core/properties/floatingpointproperty.h"
+#include "core/properties/genericproperty.h"
+#include "core/tools/minmaxblockindex.h"
+
+#include "modules/modulesapi.h"
+
+namespace campvis {
+    /**
+     * Extracts an isosurface of a single-channel volume as IndexedMeshGeometry using a parallel
+     * marching cubes implementation on the CPU.
+     * 
+     * The volume is partitioned into blocks of BLOCK_SIZE^3 cells whose intensity ranges are cached
+     * between executions, so that changing only the iso value skips all blocks not containing the
+     * isosurface without touching the volume again. Vertices are shared between adjacent cells,
+     * hence the resulting mesh is indexed and watertight inside the volume.
+     */
+    class CAMPVIS_MODULES_API IsosurfaceExtractor : public AbstractProcessor {
+    public:
+        /// Number of cells per block edge of the min/max block index
+        static const size_t BLOCK_SIZE = 8;
+
+        /**
+         * Constructs a new IsosurfaceExtractor Processor
+         **/
+        IsosurfaceExtractor();
+
+        /**
+         * Destructor
+         **/
+        virtual ~IsosurfaceExtractor();
+
+        /// To be used in ProcessorFactory static methods
+        static const std::string getId() { return "IsosurfaceExtractor"; };
+        /// \see AbstractProcessor::getName()
+        virtual const std::string getName() const { return getId(); };
+        /// \see AbstractProcessor::getDescription()
+        virtual const std::string getDescription() const { return "Extracts an isosurface of the input volume as indexed triangle mesh using marching cubes."; };
+        /// \see AbstractProcessor::getAuthor()
+        virtual const std::string getAuthor() const { return "Christian Schulte zu Berge <christian.szb@in.tum.de>"; };
+        /// \see AbstractProcessor::getProcessorState()
+        virtual ProcessorState getProcessorState() const { return AbstractProcessor::EXPERIMENTAL; };
+        /// \see AbstractProcessor::supportsConcurrentExecution()
+        virtual bool supportsConcurrentExecution() const { return true; };
+
+        DataNameProperty p_sourceImageID;   ///< ID for input volume
+        DataNameProperty p_geometryID;      ///< ID for output geometry
+
+        FloatProperty p_isoValue;           ///< Iso value in normalized intensities
+        BoolProperty p_computeNormals;      ///< Flag whether to compute per-vertex normals from the image gradient
+
+    protected:
+        /// \see AbstractProcessor::updateResult
+        virtual void updateResult(DataContainer& dataContainer);
+        /// \see AbstractProcessor::updateProperties
+        virtual void updateProperties(DataContainer& dataContainer);
+
+        MinMaxBlockIndex _blockIndex;           ///< Min/max block index of the input image, cached between executions
+
+        static const std::string loggerCat_;
+    };
+
+}
+
+#endif // ISOSURFACEEXTRACTOR_H__
@@ -32,7 +32,7 @@
 #include "core/datastructures/imagedata.h"
 #include "core/datastructures/imagerepresentationgl.h"
 #include "core/datastructures/geometrydatafactory.h"
-#include "core/datastructures/meshgeometry.h"
+#include "core/datastructures/flatmeshgeometry.h"
 
 namespace campvis {
     const std::string ProxyGeometryGenerator::loggerCat_ = "CAMPVis.modules.vis.ProxyGeometryGenerator";
@@ -71,7 +71,7 @@ namespace campvis {
                 cgt::vec3 texURB(static_cast<float>(p_clipX.getValue().y), static_cast<float>(p_clipY.getValue().y), static_cast<float>(p_clipZ.getValue().y));
                 texURB /= numSlices;
 
-                std::unique_ptr<MeshGeometry> cube = GeometryDataFactory::createCube(volumeExtent, cgt::Bounds(texLLF, texURB));
+                std::unique_ptr<FlatMeshGeometry> cube = GeometryDataFactory::createFlatCube(volumeExtent, cgt::Bounds(texLLF, texURB));
                 data.addData(p_geometryID.getValue(), cube.release());
             }
             else {
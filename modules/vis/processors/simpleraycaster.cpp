@@ -24,6 +24,7 @@
 
 #include "simpleraycaster.h"
 
+#include "core/classification/geometry1dtransferfunction.h"
 #include "core/tools/quadrenderer.h"
 #include "core/datastructures/lightsourcedata.h"
 #include "core/datastructures/renderdata.h"
@@ -41,6 +42,7 @@ namespace campvis {
         , p_lightId("LightId", "Input Light Source", "lightsource", DataNameProperty::READ)
         , p_enableShadowing("EnableShadowing", "Enable Hard Shadows (Expensive!)", false)
         , p_shadowIntensity("ShadowIntensity", "Shadow Intensity", .5f, .0f, 1.f)
+        , p_enablePreIntegration("EnablePreIntegration", "Enable Pre-Integrated TF", false)
     {
         addDecorator(new ProcessorDecoratorGradient());
 
@@ -49,6 +51,7 @@ namespace campvis {
         addProperty(p_enableShadowing, INVALID_RESULT | INVALID_PROPERTIES | INVALID_SHADER);
         addProperty(p_shadowIntensity);
         p_shadowIntensity.setVisible(false);
+        addProperty(p_enablePreIntegration, INVALID_RESULT | INVALID_SHADER);
 
         decoratePropertyCollection(this);
     }
@@ -84,6 +87,16 @@ namespace campvis {
                 _shader->setUniform("_shadowIntensity", p_shadowIntensity.getValue());
             }
 
+            cgt::TextureUnit preIntegrationUnit;
+            if (p_enablePreIntegration.getValue()) {
+                Geometry1DTransferFunction* tf = dynamic_cast<Geometry1DTransferFunction*>(p_transferFunction.getTF());
+                if (tf != nullptr)
+                    tf->bindPreIntegrationTable(_shader, preIntegrationUnit);
+                else
+                    LDEBUG("Pre-integration requires a Geometry1DTransferFunction, falling back to regular TF lookup.");
+                _shader->setUniform("_usePreIntegration", tf != nullptr);
+            }
+
             glEnable(GL_DEPTH_TEST);
             glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
             QuadRdr.renderQuad();
@@ -109,6 +122,8 @@ namespace campvis {
             toReturn += "#define ENABLE_SHADING\n";
         if (p_enableShadowing.getValue())
             toReturn += "#define ENABLE_SHADOWING\n";
+        if (p_enablePreIntegration.getValue())
+            toReturn += "#define ENABLE_PRE_INTEGRATION\n";
         return toReturn;
     }
 
@@ -77,6 +77,7 @@ namespace campvis {
 
         BoolProperty p_enableShadowing;             ///< Flag whether to enable shadowing
         FloatProperty p_shadowIntensity;            ///< Shadow intensity
+        BoolProperty p_enablePreIntegration;        ///< Flag whether to use the pre-integrated TF (requires a Geometry1DTransferFunction)
     
     protected:
         /// \see AbstractProcessor::updateProperties()
@@ -82,12 +82,24 @@ namespace campvis {
 
             cgt::vec3 inPlaneA = cgt::normalize(cgt::cross(n, temp)) * 0.5f * p_size.getValue();
 
+            cgt::vec3 inPlaneB = cgt::cross(n, inPlaneA);
+
             const cgt::vec3& base = p_mirrorCenter.getValue();
 
+            // rotate incrementally around n instead of building one quaternion per vertex
             float angle = 2.f * cgt::PIf / static_cast<float>(p_numVertices.getValue());
+            const float cosAngle = std::cos(angle);
+            const float sinAngle = std::sin(angle);
+            float c = 1.f;
+            float s = 0.f;
+
+            vertices.reserve(p_numVertices.getValue());
             for (int i = 0; i < p_numVertices.getValue(); ++i) {
-                cgt::vec3 dir = cgt::quat::rotate(inPlaneA, angle * static_cast<float>(i), n);
-                vertices.push_back(cgt::vec3(base + dir));
+                vertices.push_back(base + inPlaneA * c + inPlaneB * s);
+
+                float tmp = c * cosAngle - s * sinAngle;
+                s = s * cosAngle + c * sinAngle;
+                c = tmp;
             }
 
             FaceGeometry* mirror = new FaceGeometry(vertices);
@@ -35,11 +35,13 @@
 
 #include "modules/vis/processors/advoptimizedraycaster.h"
 #include "modules/vis/processors/contextpreservingraycaster.h"
+#include "modules/vis/processors/cpuraycaster.h"
 #include "modules/vis/processors/depthdarkening.h"
 #include "modules/vis/processors/drrraycaster.h"
 #include "modules/vis/processors/eepgenerator.h"
 #include "modules/vis/processors/geometryrenderer.h"
 #include "modules/vis/processors/ipsviraycaster.h"
+#include "modules/vis/processors/isosurfaceextractor.h"
 #include "modules/vis/processors/mprrenderer.h"
 #include "modules/vis/processors/orientationoverlay.h"
 #include "modules/vis/processors/proxygeometrygenerator.h"
@@ -68,11 +70,13 @@ namespace campvis {
 
     template class SmartProcessorRegistrar<AdvOptimizedRaycaster>;
     template class SmartProcessorRegistrar<ContextPreservingRaycaster>;
+    template class SmartProcessorRegistrar<CpuRaycaster>;
     template class SmartProcessorRegistrar<DepthDarkening>;
     template class SmartProcessorRegistrar<DRRRaycaster>;
     template class SmartProcessorRegistrar<EEPGenerator>;
     template class SmartProcessorRegistrar<GeometryRenderer>;
     template class SmartProcessorRegistrar<IpsviRaycaster>;
+    template class SmartProcessorRegistrar<IsosurfaceExtractor>;
     template class SmartProcessorRegistrar<MprRenderer>;
     template class SmartProcessorRegistrar<OrientationOverlay>;
     template class SmartProcessorRegistrar<ProxyGeometryGenerator>;
@@ -0,0 +1,144 @@
+// ================================================================================================
+// 
+// This file is part of the CAMPVis Software Framework.
+// 
+// If not explicitly stated otherwise: Copyright (C) 2012-2015, all rights reserved,
+//      Christian Schulte zu Berge <christian.szb@in.tum.de>
+//      Chair for Computer Aided Medical Procedures
+//      Technische Universitaet Muenchen
+//      Boltzmannstr. 3, 85748 Garching b. Muenchen, Germany
+// 
+// For a full list of authors and contributors, please refer to the file "AUTHORS.txt".
+// 
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file 
+// except in compliance with the License. You may obtain a copy of the License at
+// 
+// http://www.apache.org/licenses/LICENSE-2.0
+// 
+// Unless required by applicable law or agreed to in writing, software distributed under the 
+// License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, 
+// either express or implied. See the License for the specific language governing permissions 
+// and limitations under the License.
+// 
+// ================================================================================================
+
+#include "gtest/gtest.h"
+
+#include "core/classification/geometry1dtransferfunction.h"
+#include "core/classification/tfgeometry1d.h"
+
+#include <cmath>
+
+using namespace campvis;
+
+/**
+ * Test class for the CPU-side lookup and pre-integration tables of Geometry1DTransferFunction.
+ */
+class Geometry1DTransferFunctionTest : public testing::Test {
+protected:
+    Geometry1DTransferFunctionTest()
+        : _size(64)
+    {
+        _tf = createTF();
+        _geometry = _tf->getGeometries().front();
+    }
+
+    ~Geometry1DTransferFunctionTest() {
+        _tf->deinit();
+        delete _tf;
+    }
+
+    Geometry1DTransferFunction* createTF() const {
+        Geometry1DTransferFunction* toReturn = new Geometry1DTransferFunction(_size);
+        toReturn->addGeometry(TFGeometry1D::createQuad(cgt::vec2(.25f, .75f), cgt::col4(255, 0, 0, 32), cgt::col4(0, 0, 255, 224)));
+        toReturn->addGeometry(TFGeometry1D::createQuad(cgt::vec2(.5f, .6f), cgt::col4(0, 255, 0, 255), cgt::col4(0, 255, 0, 255)));
+        return toReturn;
+    }
+
+    size_t _size;
+    Geometry1DTransferFunction* _tf;
+    TFGeometry1D* _geometry;
+};
+
+/**
+ * Tests that the CPU rasterization samples the geometries at the texel centers and lets later geometries win.
+ */
+TEST_F(Geometry1DTransferFunctionTest, rasterizeTest) {
+    std::vector<cgt::vec4> lut;
+    _tf->rasterize(lut);
+    ASSERT_EQ(_size, lut.size());
+
+    for (size_t i = 0; i < _size; ++i) {
+        float x = (static_cast<float>(i) + .5f) / static_cast<float>(_size);
+        if (x >= .5f && x <= .6f) {
+            EXPECT_EQ(cgt::vec4(0.f, 1.f, 0.f, 1.f), lut[i]);
+        }
+        else if (x >= .25f && x <= .75f) {
+            float t = (x - .25f) / .5f;
+            EXPECT_NEAR(1.f - t, lut[i].r, 1e-5f);
+            EXPECT_NEAR(t, lut[i].b, 1e-5f);
+            EXPECT_NEAR((32.f + t * 192.f) / 255.f, lut[i].a, 1e-5f);
+        }
+        else {
+            EXPECT_EQ(cgt::vec4(0.f), lut[i]);
+        }
+    }
+}
+
+/**
+ * Tests the basic properties of the pre-integration table: its diagonal equals the lookup table,
+ * it is symmetric and segments of constant color and opacity keep them.
+ */
+TEST_F(Geometry1DTransferFunctionTest, preIntegrationTableTest) {
+    EXPECT_TRUE(_tf->updatePreIntegrationTable());
+    EXPECT_FALSE(_tf->updatePreIntegrationTable());
+
+    std::vector<cgt::vec4> lut;
+    _tf->rasterize(lut);
+    const std::vector<cgt::vec4>& table = _tf->getPreIntegrationTable();
+    ASSERT_EQ(_size * _size, table.size());
+
+    for (size_t f = 0; f < _size; ++f) {
+        EXPECT_EQ(lut[f], table[f * _size + f]);
+        for (size_t b = 0; b < _size; ++b) {
+            EXPECT_EQ(table[f * _size + b], table[b * _size + f]);
+            EXPECT_GE(table[f * _size + b].a, 0.f);
+            EXPECT_LE(table[f * _size + b].a, 1.f);
+        }
+    }
+
+    // texels 33 to 37 are covered by the constant green quad
+    EXPECT_NEAR(0.f, table[33 * _size + 37].r, 1e-5f);
+    EXPECT_NEAR(1.f, table[33 * _size + 37].g, 1e-5f);
+    EXPECT_NEAR(1.f, table[33 * _size + 37].a, 1e-5f);
+
+    // fully transparent segments stay transparent
+    EXPECT_EQ(0.f, table[2 * _size + 10].a);
+}
+
+/**
+ * Tests that incrementally updating the pre-integration table after a keypoint edit yields the
+ * same table as building it from scratch.
+ */
+TEST_F(Geometry1DTransferFunctionTest, incrementalUpdateTest) {
+    _tf->updatePreIntegrationTable();
+
+    Geometry1DTransferFunction* reference = createTF();
+    _geometry->getKeyPoints().back()._color = cgt::col4(255, 255, 0, 96);
+    _geometry->s_changed.emitSignal();
+    reference->getGeometries().front()->getKeyPoints().back()._color = cgt::col4(255, 255, 0, 96);
+
+    EXPECT_TRUE(_tf->updatePreIntegrationTable());
+    EXPECT_TRUE(reference->updatePreIntegrationTable());
+
+    const std::vector<cgt::vec4>& table = _tf->getPreIntegrationTable();
+    const std::vector<cgt::vec4>& referenceTable = reference->getPreIntegrationTable();
+    ASSERT_EQ(referenceTable.size(), table.size());
+    for (size_t i = 0; i < table.size(); ++i) {
+        for (size_t c = 0; c < 4; ++c)
+            EXPECT_NEAR(referenceTable[i][c], table[i][c], 1e-5f);
+    }
+
+    reference->deinit();
+    delete reference;
+}
@@ -33,6 +33,8 @@
 
 #include "core/datastructures/datahandle.h"
 #include "core/datastructures/imagedata.h"
+#include "core/datastructures/imagerepresentationdisk.h"
+#include "core/datastructures/genericimagerepresentationlocal.h"
 
 using namespace campvis;
 
@@ -112,3 +114,58 @@ TEST_F(DataContainerTest, concurrentAccessTest) {
     EXPECT_NE(_data, this->_dc0->getData("data1").getData());
     EXPECT_EQ(_data, dh.getData());
 }
+
+/**
+ * Creates a 3D float image of the given size with a deterministic pattern.
+ */
+static ImageData* createFloatImage(const cgt::svec3& size, float offset) {
+    ImageData* toReturn = new ImageData(3, size, 1);
+    float* data = new float[cgt::hmul(size)];
+    for (size_t i = 0; i < cgt::hmul(size); ++i)
+        data[i] = offset + static_cast<float>(i);
+    GenericImageRepresentationLocal<float, 1>::create(toReturn, data);
+    return toReturn;
+}
+
+/**
+ * Tests the memory budget.
+ *
+ * The least recently used image, which is not referenced elsewhere, should be spilled 
+ * to disk and transparently reloaded on the next getRepresentation().
+ */
+TEST_F(DataContainerTest, memoryBudgetTest) {
+    cgt::svec3 size(16, 16, 16);
+    this->_dc0->addData("image1", createFloatImage(size, 0.f));
+    this->_dc0->addData("image2", createFloatImage(size, 1000.f));
+    DataHandle dh3 = this->_dc0->addData("image3", createFloatImage(size, 2000.f));
+
+    // touch image1, so that image2 becomes the least recently used one
+    this->_dc0->getData("image1");
+
+    size_t footprint = this->_dc0->getMemoryFootprint();
+    this->_dc0->setMemoryBudget(footprint - 1);
+    EXPECT_EQ(footprint - 1, this->_dc0->getMemoryBudget());
+    EXPECT_LT(this->_dc0->getMemoryFootprint(), footprint);
+
+    {
+        DataHandle dh1 = this->_dc0->getData("image1");
+        DataHandle dh2 = this->_dc0->getData("image2");
+        const ImageData* image1 = static_cast<const ImageData*>(dh1.getData());
+        const ImageData* image2 = static_cast<const ImageData*>(dh2.getData());
+
+        EXPECT_EQ(nullptr, image1->getRepresentation<ImageRepresentationDisk>(false));
+        ASSERT_NE(nullptr, image2->getRepresentation<ImageRepresentationDisk>(false));
+        EXPECT_EQ(1U, image2->getNumRepresentations());
+
+        // reload from disk
+        const GenericImageRepresentationLocal<float, 1>* rep = image2->getRepresentation< GenericImageRepresentationLocal<float, 1> >();
+        ASSERT_NE(nullptr, rep);
+        for (size_t i = 0; i < rep->getNumElements(); ++i)
+            ASSERT_EQ(1000.f + static_cast<float>(i), rep->getElement(i));
+    }
+
+    // image3 is still referenced by dh3 and must not be touched
+    this->_dc0->setMemoryBudget(1);
+    EXPECT_EQ(nullptr, static_cast<const ImageData*>(dh3.getData())->getRepresentation<ImageRepresentationDisk>(false));
+    EXPECT_NE(nullptr, static_cast<const ImageData*>(this->_dc0->getData("image1").getData())->getRepresentation<ImageRepresentationDisk>(false));
+}
@@ -0,0 +1,156 @@
+// ================================================================================================
+// 
+// This file is part of the CAMPVis Software Framework.
+// 
+// If not explicitly stated otherwise: Copyright (C) 2012-2015, all rights reserved,
+//      Christian Schulte zu Berge <christian.szb@in.tum.de>
+//      Chair for Computer Aided Medical Procedures
+//      Technische Universitaet Muenchen
+//      Boltzmannstr. 3, 85748 Garching b. Muenchen, Germany
+// 
+// For a full list of authors and contributors, please refer to the file "AUTHORS.txt".
+// 
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file 
+// except in compliance with the License. You may obtain a copy of the License at
+// 
+// http://www.apache.org/licenses/LICENSE-2.0
+// 
+// Unless required by applicable law or agreed to in writing, software distributed under the 
+// License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, 
+// either express or implied. See the License for the specific language governing permissions 
+// and limitations under the License.
+// 
+// ================================================================================================
+
+#include "gtest/gtest.h"
+
+#include "core/datastructures/flatmeshgeometry.h"
+#include "core/datastructures/geometrydatafactory.h"
+#include "core/datastructures/meshgeometry.h"
+
+using namespace campvis;
+
+/**
+ * Test class for FlatMeshGeometry. Uses a textured cube with picking information and 
+ * compares the results of FlatMeshGeometry to the ones of the equivalent MeshGeometry.
+ */
+class FlatMeshGeometryTest : public testing::Test {
+protected:
+    FlatMeshGeometryTest() {
+        std::unique_ptr<MeshGeometry> cube = GeometryDataFactory::createCube(cgt::Bounds(cgt::vec3(-1.f, 0.f, 2.f), cgt::vec3(3.f, 2.f, 5.f)), cgt::Bounds(cgt::vec3(0.f), cgt::vec3(1.f)));
+
+        std::vector<FaceGeometry> faces;
+        for (size_t i = 0; i < cube->size(); ++i) {
+            const FaceGeometry& f = cube->getFaces()[i];
+            faces.push_back(FaceGeometry(f.getVertices(), f.getTextureCoordinates(), f.getColors(), f.getNormals()));
+
+            std::vector<cgt::col4> picking;
+            for (size_t j = 0; j < f.size(); ++j)
+                picking.push_back(cgt::col4(static_cast<uint8_t>(i), static_cast<uint8_t>(j), 0, 255));
+            faces.back().setPickingInformation(picking);
+        }
+
+        _mesh.reset(new MeshGeometry(faces));
+        _flat.reset(new FlatMeshGeometry(*_mesh));
+    }
+
+    /**
+     * Expects \a flat to contain the same faces as \a mesh.
+     */
+    void expectEqual(const MeshGeometry& mesh, const FlatMeshGeometry& flat) {
+        std::unique_ptr<MeshGeometry> converted = flat.toMeshGeometry();
+        ASSERT_EQ(mesh.size(), converted->size());
+
+        for (size_t i = 0; i < mesh.size(); ++i) {
+            const FaceGeometry& expected = mesh.getFaces()[i];
+            const FaceGeometry& actual = converted->getFaces()[i];
+            ASSERT_EQ(expected.size(), actual.size());
+
+            for (size_t j = 0; j < expected.size(); ++j) {
+                EXPECT_NEAR(0.f, cgt::distance(expected.getVertices()[j], actual.getVertices()[j]), 1e-5f);
+                EXPECT_NEAR(0.f, cgt::distance(expected.getTextureCoordinates()[j], actual.getTextureCoordinates()[j]), 1e-5f);
+                EXPECT_EQ(expected.getPickingInformation()[j], actual.getPickingInformation()[j]);
+            }
+        }
+    }
+
+protected:
+    std::unique_ptr<MeshGeometry> _mesh;
+    std::unique_ptr<FlatMeshGeometry> _flat;
+};
+
+/**
+ * Tests the conversion from and to MeshGeometry.
+ */
+TEST_F(FlatMeshGeometryTest, conversionTest) {
+    EXPECT_EQ(6U, _flat->size());
+    EXPECT_EQ(24U, _flat->getNumVertices());
+    EXPECT_EQ(7U, _flat->getFaceOffsets().size());
+    EXPECT_TRUE(_flat->hasTextureCoordinates());
+    EXPECT_TRUE(_flat->hasPickingInformation());
+    EXPECT_EQ(24U, _flat->getNormals().size());
+    EXPECT_TRUE(_flat->getColors().empty());
+
+    expectEqual(*_mesh, *_flat);
+}
+
+/**
+ * Tests that createFlatCube() creates the same geometry as createCube().
+ */
+TEST_F(FlatMeshGeometryTest, flatCubeTest) {
+    cgt::Bounds bounds(cgt::vec3(-1.f, 0.f, 2.f), cgt::vec3(3.f, 2.f, 5.f));
+    cgt::Bounds texBounds(cgt::vec3(.1f, .2f, .3f), cgt::vec3(.7f, .8f, .9f));
+    FlatMeshGeometry expected(*GeometryDataFactory::createCube(bounds, texBounds));
+    std::unique_ptr<FlatMeshGeometry> actual = GeometryDataFactory::createFlatCube(bounds, texBounds);
+
+    ASSERT_EQ(expected.getNumVertices(), actual->getNumVertices());
+    EXPECT_EQ(expected.getFaceOffsets(), actual->getFaceOffsets());
+    for (size_t i = 0; i < expected.getNumVertices(); ++i) {
+        EXPECT_EQ(expected.getVertices()[i], actual->getVertices()[i]);
+        EXPECT_EQ(expected.getTextureCoordinates()[i], actual->getTextureCoordinates()[i]);
+        EXPECT_EQ(expected.getNormals()[i], actual->getNormals()[i]);
+    }
+}
+
+/**
+ * Tests clipAgainstPlane() against MeshGeometry::clipAgainstPlane() for several planes.
+ */
+TEST_F(FlatMeshGeometryTest, clipTest) {
+    const cgt::vec3 normals[] = { cgt::vec3(1.f, 0.f, 0.f), cgt::normalize(cgt::vec3(1.f, .3f, .2f)), cgt::normalize(cgt::vec3(-.4f, 1.f, -.7f)) };
+    const float distances[] = { 0.f, 1.5f, -2.f };
+
+    FlatMeshGeometry clipped;
+    for (size_t i = 0; i < 3; ++i) {
+        for (size_t j = 0; j < 3; ++j) {
+            MeshGeometry expected = _mesh->clipAgainstPlane(distances[j], normals[i], true, 1e-4f);
+            _flat->clipAgainstPlane(distances[j], normals[i], clipped, true, 1e-4f);
+            expectEqual(expected, clipped);
+
+            if (expected.size() > 0) {
+                cgt::Bounds eb = expected.getWorldBounds();
+                cgt::Bounds ab = clipped.getWorldBounds();
+                EXPECT_NEAR(0.f, cgt::distance(eb.getLLF(), ab.getLLF()), 1e-5f);
+                EXPECT_NEAR(0.f, cgt::distance(eb.getURB(), ab.getURB()), 1e-5f);
+            }
+        }
+    }
+
+    // clipping everything away yields an empty mesh
+    _flat->clipAgainstPlane(-100.f, cgt::vec3(1.f, 0.f, 0.f), clipped);
+    EXPECT_EQ(0U, clipped.size());
+    EXPECT_EQ(0U, clipped.getNumVertices());
+}
+
+/**
+ * Tests applyTransformationToVertices() and getWorldBounds().
+ */
+TEST_F(FlatMeshGeometryTest, transformationTest) {
+    cgt::mat4 t = cgt::mat4::createTranslation(cgt::vec3(1.f, 2.f, 3.f)) * cgt::mat4::createScale(cgt::vec3(2.f));
+    _mesh->applyTransformationToVertices(t);
+    _flat->applyTransformationToVertices(t);
+    expectEqual(*_mesh, *_flat);
+
+    cgt::Bounds bounds = _flat->getWorldBounds();
+    EXPECT_EQ(cgt::vec3(-1.f, 2.f, 7.f), bounds.getLLF());
+    EXPECT_EQ(cgt::vec3(7.f, 6.f, 13.f), bounds.getURB());
+}
@@ -32,6 +32,10 @@
 #include "core/datastructures/imagedata.h"
 
 #include "core/datastructures/imagedata.h"
+#include "core/datastructures/genericimagerepresentationlocal.h"
+#include "core/tools/concurrenthistogram.h"
+
+#include <tbb/tbb.h>
 
 /**
  * Test class for ImageData class.
@@ -118,3 +122,97 @@ TEST_F(ImageDataTest, cloneTest) {
     EXPECT_EQ(_imgData0->getVideoMemoryFootprint(), _imgData1->getVideoMemoryFootprint());
 }
 
+
+/**
+ * Tests that the native intensity histogram has one bucket per value of an 8 bit image,
+ * is computed only once and shared with clones.
+ */
+TEST_F(ImageDataTest, nativeIntensityHistogramTest) {
+    campvis::ImageData* image = new campvis::ImageData(3, cgt::svec3(16, 16, 4), 1);
+    campvis::GenericImageRepresentationLocal<uint8_t, 1>* rep = campvis::GenericImageRepresentationLocal<uint8_t, 1>::create(image, 0);
+    for (size_t i = 0; i < rep->getNumElements(); ++i)
+        rep->setElement(i, static_cast<uint8_t>(i % 256));
+
+    EXPECT_EQ(nullptr, image->getNativeIntensityHistogram(false));
+
+    std::shared_ptr<const campvis::ImageData::IntensityHistogramType> histogram = image->getNativeIntensityHistogram();
+    ASSERT_TRUE(nullptr != histogram);
+    EXPECT_EQ(256U, histogram->getNumBuckets(0));
+    EXPECT_EQ(image->getNumElements(), histogram->getNumSamples());
+    for (size_t i = 0; i < histogram->getNumBuckets(0); ++i)
+        EXPECT_EQ(4U, histogram->getNumElements(i));
+
+    EXPECT_EQ(histogram, image->getNativeIntensityHistogram(false));
+
+    campvis::ImageData* clone = image->clone();
+    EXPECT_EQ(histogram, clone->getNativeIntensityHistogram(false));
+
+    delete clone;
+    delete image;
+}
+
+/**
+ * Tests that sharing the buffer of a local representation via getDataOwner() does not copy it,
+ * and that ensureUnique() copies the buffer only while it is shared.
+ */
+TEST_F(ImageDataTest, sharedLocalDataCopyOnWriteTest) {
+    campvis::ImageData* image = new campvis::ImageData(3, cgt::svec3(4, 4, 2), 1);
+    campvis::GenericImageRepresentationLocal<uint8_t, 1>* rep = campvis::GenericImageRepresentationLocal<uint8_t, 1>::create(image, 0);
+    for (size_t i = 0; i < rep->getNumElements(); ++i)
+        rep->setElement(i, static_cast<uint8_t>(i));
+    const campvis::GenericImageRepresentationLocal<uint8_t, 1>& constRep = *rep;
+
+    // unsharing an unshared buffer must not copy
+    const uint8_t* originalData = constRep.getImageData();
+    rep->ensureUnique();
+    rep->setElement(0, 42);
+    EXPECT_EQ(originalData, constRep.getImageData());
+
+    // accessing a shared buffer must not copy either
+    std::shared_ptr<void> owner = rep->getDataOwner();
+    EXPECT_EQ(originalData, rep->getImageData());
+    EXPECT_EQ(originalData, &rep->getElement(0));
+
+    // unshare the buffer and write to it: the shared buffer must stay untouched
+    rep->ensureUnique();
+    rep->setElement(1, 23);
+    EXPECT_NE(originalData, constRep.getImageData());
+    EXPECT_EQ(1, originalData[1]);
+    EXPECT_EQ(42, originalData[0]);
+    EXPECT_EQ(23, rep->getElement(1));
+    EXPECT_EQ(42, rep->getElement(0));
+    EXPECT_NE(owner, rep->getDataOwner());
+
+    delete image;
+}
+
+/**
+ * Tests concurrent writes to a representation whose buffer is shared: All workers unshare the
+ * buffer before writing, which must copy it exactly once without losing any write.
+ */
+TEST_F(ImageDataTest, sharedLocalDataConcurrentWriteTest) {
+    campvis::ImageData* image = new campvis::ImageData(3, cgt::svec3(64, 64, 16), 1);
+    campvis::GenericImageRepresentationLocal<uint16_t, 1>* rep = campvis::GenericImageRepresentationLocal<uint16_t, 1>::create(image, 0);
+    const size_t numElements = rep->getNumElements();
+    for (size_t i = 0; i < numElements; ++i)
+        rep->setElement(i, static_cast<uint16_t>(i));
+
+    std::shared_ptr<void> owner = rep->getDataOwner();
+    const uint16_t* sharedData = static_cast<const uint16_t*>(owner.get());
+
+    tbb::parallel_for(tbb::blocked_range<size_t>(0, numElements, 256), [&] (const tbb::blocked_range<size_t>& range) {
+        rep->ensureUnique();
+        for (size_t i = range.begin(); i != range.end(); ++i)
+            rep->setElement(i, static_cast<uint16_t>(i + 1));
+    });
+
+    const campvis::GenericImageRepresentationLocal<uint16_t, 1>& constRep = *rep;
+    EXPECT_NE(sharedData, constRep.getImageData());
+    EXPECT_EQ(2, rep->getDataOwner().use_count());   // the representation and the returned pointer
+    for (size_t i = 0; i < numElements; ++i) {
+        ASSERT_EQ(static_cast<uint16_t>(i), sharedData[i]);
+        ASSERT_EQ(static_cast<uint16_t>(i + 1), constRep.getElement(i));
+    }
+
+    delete image;
+}
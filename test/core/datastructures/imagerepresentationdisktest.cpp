@@ -0,0 +1,133 @@
+// ================================================================================================
+// 
+// This file is part of the CAMPVis Software Framework.
+// 
+// If not explicitly stated otherwise: Copyright (C) 2012-2015, all rights reserved,
+//      Christian Schulte zu Berge <christian.szb@in.tum.de>
+//      Chair for Computer Aided Medical Procedures
+//      Technische Universitaet Muenchen
+//      Boltzmannstr. 3, 85748 Garching b. Muenchen, Germany
+// 
+// For a full list of authors and contributors, please refer to the file "AUTHORS.txt".
+// 
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file 
+// except in compliance with the License. You may obtain a copy of the License at
+// 
+// http://www.apache.org/licenses/LICENSE-2.0
+// 
+// Unless required by applicable law or agreed to in writing, software distributed under the 
+// License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, 
+// either express or implied. See the License for the specific language governing permissions 
+// and limitations under the License.
+// 
+// ================================================================================================
+
+#include "gtest/gtest.h"
+
+#include "cgt/filesystem.h"
+
+#include "core/datastructures/imagedata.h"
+#include "core/datastructures/imagerepresentationdisk.h"
+#include "core/tools/endianhelper.h"
+
+#include <fstream>
+#include <vector>
+
+using namespace campvis;
+
+/**
+ * Test and benchmark class for reading strided and endian-swapped image data through 
+ * ImageRepresentationDisk.
+ * Writes a synthetic uint16 volume with the given layout to disk, reads it back and compares
+ * every voxel. The read time of each layout is printed, so that the test doubles as benchmark.
+ */
+class ImageRepresentationDiskTest : public testing::TestWithParam< std::tr1::tuple<EndianHelper::Endianness, int> > {
+protected:
+    ImageRepresentationDiskTest() 
+        : _size(256, 256, 64)
+        , _offset(352)
+        , _fileName("imagerepresentationdisktest.raw")
+    {
+    }
+
+    ~ImageRepresentationDiskTest() {
+        cgt::FileSystem::deleteFile(_fileName);
+    }
+
+    /// Returns the expected value of the voxel at (x, y, z).
+    static uint16_t expectedValue(size_t x, size_t y, size_t z) {
+        return static_cast<uint16_t>(x + 3*y + 7*z);
+    }
+
+    /// Returns the stride for the given stride mode.
+    cgt::svec3 getStride(int strideMode) const {
+        switch (strideMode) {
+            case 1: // padded rows
+                return cgt::svec3(0, _size.x + 16, (_size.x + 16) * _size.y);
+            case 2: // padded slices
+                return cgt::svec3(0, _size.x, _size.x * _size.y + 1024);
+            case 3: // every other element
+                return cgt::svec3(2, 2 * _size.x, 2 * _size.x * _size.y);
+            default: // tightly packed
+                return cgt::svec3::zero;
+        }
+    }
+
+    /// Writes the synthetic volume to _fileName using the given layout.
+    void writeFile(EndianHelper::Endianness endianness, const cgt::svec3& stride) {
+        cgt::svec3 s(stride.x == 0 ? 1 : stride.x, stride.y == 0 ? _size.x : stride.y, stride.z == 0 ? _size.x * _size.y : stride.z);
+        size_t numBytes = _offset + ((_size.z - 1) * s.z + (_size.y - 1) * s.y + (_size.x - 1) * s.x + 1) * sizeof(uint16_t);
+        std::vector<char> buffer(numBytes, 0);
+
+        for (size_t z = 0; z < _size.z; ++z) {
+            for (size_t y = 0; y < _size.y; ++y) {
+                for (size_t x = 0; x < _size.x; ++x) {
+                    uint16_t value = expectedValue(x, y, z);
+                    char* ptr = &buffer[_offset + (z * s.z + y * s.y + x * s.x) * sizeof(uint16_t)];
+                    memcpy(ptr, &value, sizeof(uint16_t));
+                    if (endianness != EndianHelper::getLocalEndianness())
+                        EndianHelper::swapEndian<2>(ptr);
+                }
+            }
+        }
+
+        std::ofstream file(_fileName.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+        file.write(&buffer.front(), buffer.size());
+    }
+
+protected:
+    cgt::svec3 _size;
+    size_t _offset;
+    std::string _fileName;
+};
+
+/**
+ * Reads the volume in the given layout and compares each voxel.
+ */
+TEST_P(ImageRepresentationDiskTest, strided_endianness_read_test) {
+    EndianHelper::Endianness endianness = std::tr1::get<0>(GetParam());
+    cgt::svec3 stride = getStride(std::tr1::get<1>(GetParam()));
+    writeFile(endianness, stride);
+
+    ImageData image(3, _size, 1);
+    const ImageRepresentationDisk* rep = ImageRepresentationDisk::create(&image, _fileName, WeaklyTypedPointer::UINT16, _offset, endianness, stride);
+
+    WeaklyTypedPointer wtp = rep->getWeaklyTypedPointer();
+    ASSERT_TRUE(wtp._pointer != nullptr);
+
+    const uint16_t* voxels = static_cast<const uint16_t*>(wtp._pointer);
+    size_t numMismatches = 0;
+    for (size_t z = 0; z < _size.z; ++z)
+        for (size_t y = 0; y < _size.y; ++y)
+            for (size_t x = 0; x < _size.x; ++x)
+                if (voxels[(z * _size.y + y) * _size.x + x] != expectedValue(x, y, z))
+                    ++numMismatches;
+
+    EXPECT_EQ(0U, numMismatches);
+    delete [] static_cast<char*>(wtp._pointer);
+}
+
+INSTANTIATE_TEST_CASE_P(
+    ImageRepresentationDiskLayouts, 
+    ImageRepresentationDiskTest, 
+    testing::Combine(testing::Values(EndianHelper::IS_LITTLE_ENDIAN, EndianHelper::IS_BIG_ENDIAN), testing::Values(0, 1, 2, 3)));
@@ -29,6 +29,7 @@
 #include "core/datastructures/imagerepresentationlocal.h"
 #include "core/datastructures/imagerepresentationgl.h"
 #include "core/datastructures/genericimagerepresentationlocal.h"
+#include "core/tools/mappedfile.h"
 #include "core/tools/simplejobprocessor.h"
 
 using namespace campvis;
@@ -151,6 +152,30 @@ TEST_F(ImageRepresentationTest, basetype_conversion_test) {
     performBasetypeConversionTest();
 }
 
+/**
+ * Tests that the zero-copy conversion from the memory-mapped file yields the same data as 
+ * explicitly reading the file into local memory.
+ */
+TEST_F(ImageRepresentationTest, mapped_disk_local_test) {
+    const ImageRepresentationDisk* diskRep = _image->getRepresentation<ImageRepresentationDisk>(false);
+    ASSERT_TRUE(diskRep != nullptr);
+    EXPECT_TRUE(diskRep->isDirectlyMappable());
+
+    std::shared_ptr<MappedFile> mapping;
+    WeaklyTypedPointer mappedWtp = diskRep->getMappedWeaklyTypedPointer(mapping);
+    WeaklyTypedPointer copiedWtp = diskRep->getWeaklyTypedPointer();
+    ASSERT_TRUE(mappedWtp._pointer != nullptr);
+    ASSERT_TRUE(copiedWtp._pointer != nullptr);
+    EXPECT_TRUE(mapping != nullptr);
+
+    const uint16_t* mappedVoxels = static_cast<const uint16_t*>(mappedWtp._pointer);
+    const uint16_t* copiedVoxels = static_cast<const uint16_t*>(copiedWtp._pointer);
+    for (size_t i = 0; i < _image->getNumElements(); ++i)
+        EXPECT_EQ(mappedVoxels[i], copiedVoxels[i]);
+
+    delete [] static_cast<char*>(copiedWtp._pointer);
+}
+
 /**
  * Tests multiple concurrent conversions.
  * Tests that no redundant representations are created.
@@ -0,0 +1,178 @@
+// ================================================================================================
+// 
+// This file is part of the CAMPVis Software Framework.
+// 
+// If not explicitly stated otherwise: Copyright (C) 2012-2015, all rights reserved,
+//      Christian Schulte zu Berge <christian.szb@in.tum.de>
+//      Chair for Computer Aided Medical Procedures
+//      Technische Universitaet Muenchen
+//      Boltzmannstr. 3, 85748 Garching b. Muenchen, Germany
+// 
+// For a full list of authors and contributors, please refer to the file "AUTHORS.txt".
+// 
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file 
+// except in compliance with the License. You may obtain a copy of the License at
+// 
+// http://www.apache.org/licenses/LICENSE-2.0
+// 
+// Unless required by applicable law or agreed to in writing, software distributed under the 
+// License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, 
+// either express or implied. See the License for the specific language governing permissions 
+// and limitations under the License.
+// 
+// ================================================================================================
+
+#include "gtest/gtest.h"
+
+#include "core/pipeline/abstractprocessor.h"
+#include "core/pipeline/autoevaluationpipeline.h"
+#include "core/properties/datanameproperty.h"
+#include "core/datastructures/datacontainer.h"
+#include "core/datastructures/imagedata.h"
+
+#include <tbb/atomic.h>
+#include <tbb/task_scheduler_init.h>
+
+#include <chrono>
+#include <thread>
+
+using namespace campvis;
+
+namespace {
+    tbb::atomic<int> s_numRunning;      ///< number of DummyWorkProcessors currently executing
+    tbb::atomic<int> s_maxNumRunning;   ///< maximum number of concurrently executing DummyWorkProcessors
+}
+
+/**
+ * Dummy processor reading one data item and writing another one. Sleeps during execution
+ * and tracks how many of its kind are executed concurrently.
+ */
+class DummyWorkProcessor : public AbstractProcessor {
+public:
+    DummyWorkProcessor(const std::string& input, const std::string& output, bool concurrent)
+        : p_inputId("InputId", "Input ID", input, DataNameProperty::READ)
+        , p_outputId("OutputId", "Output ID", output, DataNameProperty::WRITE)
+        , _concurrent(concurrent)
+        , _inputFound(false)
+    {
+        addProperty(p_inputId);
+        addProperty(p_outputId);
+    }
+
+    ~DummyWorkProcessor() {}
+
+    virtual const std::string getName() const override { return "DummyWorkProcessor"; };
+    virtual const std::string getDescription() const override { return "A dummy processor for the testing purposes only."; };
+    virtual const std::string getAuthor() const override { return "CAMPVis Developers"; };
+    virtual ProcessorState getProcessorState() const override { return AbstractProcessor::TESTING; };
+    virtual bool supportsConcurrentExecution() const override { return _concurrent; };
+
+    virtual void updateResult(DataContainer& dataContainer) override {
+        int numRunning = ++s_numRunning;
+        int oldMax = s_maxNumRunning;
+        while (numRunning > oldMax && s_maxNumRunning.compare_and_swap(numRunning, oldMax) != oldMax)
+            oldMax = s_maxNumRunning;
+
+        _inputFound = p_inputId.getValue().empty() || dataContainer.hasData(p_inputId.getValue());
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        dataContainer.addData(p_outputId.getValue(), new ImageData(2, cgt::svec3(1, 2, 1), 1));
+
+        --s_numRunning;
+    }
+
+    DataNameProperty p_inputId;
+    DataNameProperty p_outputId;
+    bool _concurrent;
+    bool _inputFound;
+};
+
+/**
+ * Test class for the parallel processor execution of AutoEvaluationPipeline.
+ */
+class AutoEvaluationPipelineTest : public ::testing::Test {
+protected:
+    AutoEvaluationPipelineTest() 
+        : _dataContainer("testContainer")
+        , _pipeline(_dataContainer, "testPipeline")
+    {
+        s_numRunning = 0;
+        s_maxNumRunning = 0;
+    }
+
+    ~AutoEvaluationPipelineTest() {
+    }
+
+    void addProcessor(AbstractProcessor* processor) {
+        _pipeline.addProcessor(processor);
+        processor->invalidate(AbstractProcessor::INVALID_RESULT);
+    }
+
+    void runPipeline() {
+        _pipeline.executePipeline();
+        EXPECT_EQ(0, s_numRunning);
+    }
+
+protected:
+    DataContainer _dataContainer;
+    AutoEvaluationPipeline _pipeline;
+};
+
+/** 
+ * Processors depending on each other's data must be executed one after another.
+ */ 
+TEST_F(AutoEvaluationPipelineTest, dependencyTest) {
+    DummyWorkProcessor first("", "a", true);
+    DummyWorkProcessor second("a", "b", true);
+    DummyWorkProcessor third("b", "c", true);
+    addProcessor(&first);
+    addProcessor(&second);
+    addProcessor(&third);
+
+    runPipeline();
+
+    EXPECT_TRUE(second._inputFound);
+    EXPECT_TRUE(third._inputFound);
+    EXPECT_TRUE(_dataContainer.hasData("c"));
+    EXPECT_EQ(1, s_maxNumRunning);
+}
+
+/** 
+ * Independent processors supporting concurrent execution may run in parallel, the others
+ * are executed on the calling thread.
+ */ 
+TEST_F(AutoEvaluationPipelineTest, concurrencyTest) {
+    DummyWorkProcessor first("", "a", true);
+    DummyWorkProcessor second("", "b", true);
+    DummyWorkProcessor serial("", "c", false);
+    DummyWorkProcessor join("a", "d", false);
+    addProcessor(&first);
+    addProcessor(&second);
+    addProcessor(&serial);
+    addProcessor(&join);
+
+    runPipeline();
+
+    EXPECT_TRUE(join._inputFound);
+    EXPECT_TRUE(first.isValid());
+    EXPECT_TRUE(second.isValid());
+    EXPECT_TRUE(serial.isValid());
+    EXPECT_TRUE(join.isValid());
+    if (tbb::task_scheduler_init::default_num_threads() > 1)
+        EXPECT_LE(2, s_maxNumRunning);
+}
+
+/** 
+ * Disabling parallel execution restores the serial behavior.
+ */ 
+TEST_F(AutoEvaluationPipelineTest, serialTest) {
+    DummyWorkProcessor first("", "a", true);
+    DummyWorkProcessor second("", "b", true);
+    addProcessor(&first);
+    addProcessor(&second);
+    _pipeline.setParallelExecution(false);
+
+    runPipeline();
+
+    EXPECT_TRUE(_dataContainer.hasData("b"));
+    EXPECT_EQ(1, s_maxNumRunning);
+}
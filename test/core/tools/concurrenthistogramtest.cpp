@@ -307,3 +307,73 @@ TEST_F(ConcurrentHistogram2DTestSpecific, concurrentAddSampleTest) {
     }
 }
 
+
+/** 
+ * Batched insertion into thread-local buckets must yield the same histogram as addSample().
+ */
+TEST_F(ConcurrentHistogram2DTest, concurrentAddSamplesTest) {
+    std::vector<int> flatSamples;
+    for (size_t i = 0; i < samples.size(); ++i)
+        flatSamples.insert(flatSamples.end(), samples[i].begin(), samples[i].end());
+
+    tbb::parallel_for(tbb::blocked_range<size_t>(0, samples.size(), 64), [&] (const tbb::blocked_range<size_t>& range) {
+        _cgh->addSamples(&flatSamples[range.begin() * 2], range.size());
+    });
+    _cgh->mergeLocalBuckets();
+
+    EXPECT_EQ(samples.size(), _cgh->getNumSamples());
+    EXPECT_EQ(static_cast<size_t>(1), _cgh->getMaxFilling());
+    for (size_t j = 0; j < numBuckets[0] * numBuckets[1]; ++j) {
+        EXPECT_EQ(static_cast<size_t>(1), _cgh->getNumElements(j));
+    }
+
+    // merging again must not change anything
+    _cgh->mergeLocalBuckets();
+    EXPECT_EQ(static_cast<size_t>(1), _cgh->getNumElements(static_cast<size_t>(0)));
+}
+
+/** 
+ * _maxFilling is computed once after merging the thread-local buckets.
+ */
+TEST_F(ConcurrentHistogram1DTestSpecific, concurrentAddSamplesTest) {
+    std::vector<int> flatSamples;
+    for (size_t i = 0; i < samples.size(); ++i)
+        flatSamples.push_back(samples[i].front());
+
+    tbb::parallel_for(tbb::blocked_range<size_t>(0, samples.size()), [&] (const tbb::blocked_range<size_t>& range) {
+        _cgh->addSamples(&flatSamples[range.begin()], range.size());
+    });
+
+    EXPECT_EQ(static_cast<size_t>(0), _cgh->getMaxFilling());
+    _cgh->mergeLocalBuckets();
+
+    for (size_t j = 0; j < numBuckets[0]; j ++) {
+        EXPECT_EQ(static_cast<size_t>(histogram[j]), _cgh->getNumElements(j));
+    }
+    EXPECT_EQ(static_cast<size_t>(histogram[0]), _cgh->getMaxFilling());
+}
+
+/** 
+ * Weighted samples must count as often as their weight, e.g. when rebinning another histogram.
+ */
+TEST_F(ConcurrentHistogram1DTest, weightedAddSamplesTest) {
+    std::vector<int> flatSamples;
+    std::vector<size_t> weights;
+    for (size_t i = 0; i < samples.size(); ++i) {
+        flatSamples.push_back(samples[i].front());
+        weights.push_back(i % 3);
+    }
+
+    _cgh->addSamples(flatSamples.data(), weights.data(), flatSamples.size());
+    _cgh->mergeLocalBuckets();
+
+    size_t total = 0;
+    for (size_t j = 0; j < numBuckets[0]; ++j) {
+        EXPECT_EQ(weights[j], _cgh->getNumElements(j));
+        total += weights[j];
+    }
+    EXPECT_EQ(total, _cgh->getNumSamples());
+    EXPECT_EQ(static_cast<size_t>(2), _cgh->getMaxFilling());
+    EXPECT_EQ(0, _cgh->getMin(0));
+    EXPECT_EQ(100, _cgh->getMax(0));
+}
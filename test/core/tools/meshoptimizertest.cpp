@@ -0,0 +1,160 @@
+// ================================================================================================
+// 
+// This file is part of the CAMPVis Software Framework.
+// 
+// If not explicitly stated otherwise: Copyright (C) 2012-2015, all rights reserved,
+//      Christian Schulte zu Berge <christian.szb@in.tum.de>
+//      Chair for Computer Aided Medical Procedures
+//      Technische Universitaet Muenchen
+//      Boltzmannstr. 3, 85748 Garching b. Muenchen, Germany
+// 
+// For a full list of authors and contributors, please refer to the file "AUTHORS.txt".
+// 
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file 
+// except in compliance with the License. You may obtain a copy of the License at
+// 
+// http://www.apache.org/licenses/LICENSE-2.0
+// 
+// Unless required by applicable law or agreed to in writing, software distributed under the 
+// License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, 
+// either express or implied. See the License for the specific language governing permissions 
+// and limitations under the License.
+// 
+// ================================================================================================
+
+#include "gtest/gtest.h"
+
+#include "core/datastructures/indexedmeshgeometry.h"
+#include "core/datastructures/multiindexedgeometry.h"
+#include "core/tools/meshoptimizer.h"
+
+#include <algorithm>
+#include <array>
+
+using namespace campvis;
+
+/**
+ * Test class for MeshOptimizer. Creates a regular grid of triangles stored as triangle soup, 
+ * i.e. with each vertex duplicated for each of its triangles.
+ */
+class MeshOptimizerTest : public testing::Test {
+protected:
+    MeshOptimizerTest()
+        : _gridSize(40)
+    {
+        for (int y = 0; y < _gridSize; ++y) {
+            for (int x = 0; x < _gridSize; ++x) {
+                cgt::vec3 a(x, y, 0.f), b(x + 1, y, 0.f), c(x, y + 1, 0.f), d(x + 1, y + 1, 0.f);
+                const cgt::vec3 triangles[6] = { a, b, c, b, d, c };
+                for (size_t i = 0; i < 6; ++i) {
+                    _indices.push_back(static_cast<uint32_t>(_vertices.size()));
+                    _vertices.push_back(triangles[i]);
+                    _normals.push_back(cgt::vec3(0.f, 0.f, 1.f));
+                }
+            }
+        }
+    }
+
+    /// Returns the triangles of \a indices as sorted list of vertex position triples.
+    std::vector< std::array<float, 9> > getTriangles(const std::vector<uint32_t>& indices, const std::vector<cgt::vec3>& vertices) {
+        std::vector< std::array<float, 9> > toReturn;
+        for (size_t i = 0; i < indices.size(); i += 3) {
+            std::array<float, 9> t;
+            for (size_t j = 0; j < 3; ++j)
+                for (size_t k = 0; k < 3; ++k)
+                    t[3*j + k] = vertices[indices[i + j]][k];
+            toReturn.push_back(t);
+        }
+        std::sort(toReturn.begin(), toReturn.end());
+        return toReturn;
+    }
+
+    int _gridSize;
+    std::vector<uint32_t> _indices;
+    std::vector<cgt::vec3> _vertices;
+    std::vector<cgt::vec3> _normals;
+};
+
+/**
+ * Tests that deduplicateVertices() merges all duplicates and keeps the triangles.
+ */
+TEST_F(MeshOptimizerTest, deduplicateVerticesTest) {
+    std::vector<uint32_t> indices = _indices;
+    std::vector<cgt::vec3> vertices = _vertices;
+    std::vector<cgt::vec3> texCoords;
+    std::vector<cgt::vec4> colors;
+    std::vector<cgt::vec3> normals = _normals;
+
+    size_t numVertices = MeshOptimizer::deduplicateVertices(indices, vertices, texCoords, colors, normals);
+    EXPECT_EQ(static_cast<size_t>((_gridSize + 1) * (_gridSize + 1)), numVertices);
+    EXPECT_EQ(numVertices, vertices.size());
+    EXPECT_EQ(numVertices, normals.size());
+    EXPECT_EQ(_indices.size(), indices.size());
+    EXPECT_EQ(getTriangles(_indices, _vertices), getTriangles(indices, vertices));
+
+    // vertices are sorted by first use
+    uint32_t maxIndex = 0;
+    for (size_t i = 0; i < indices.size(); ++i) {
+        EXPECT_LE(indices[i], maxIndex + 1);
+        maxIndex = std::max(maxIndex, indices[i]);
+    }
+
+    // differing normals prevent merging
+    normals = _normals;
+    normals[1] = cgt::vec3(1.f, 0.f, 0.f);
+    indices = _indices;
+    vertices = _vertices;
+    EXPECT_EQ(numVertices + 1, MeshOptimizer::deduplicateVertices(indices, vertices, texCoords, colors, normals));
+}
+
+/**
+ * Tests that optimizeVertexCache() keeps the triangles and improves the cache miss ratio.
+ */
+TEST_F(MeshOptimizerTest, optimizeVertexCacheTest) {
+    std::vector<cgt::vec3> texCoords;
+    std::vector<cgt::vec4> colors;
+    size_t numVertices = MeshOptimizer::deduplicateVertices(_indices, _vertices, texCoords, colors, _normals);
+
+    // scramble the triangle order
+    std::vector<uint32_t> scrambled;
+    const size_t numTriangles = _indices.size() / 3;
+    for (size_t i = 0; i < numTriangles; ++i) {
+        size_t t = (i * 7919) % numTriangles;
+        scrambled.insert(scrambled.end(), _indices.begin() + 3*t, _indices.begin() + 3*t + 3);
+    }
+
+    std::vector<uint32_t> optimized = MeshOptimizer::optimizeVertexCache(scrambled, numVertices);
+    ASSERT_EQ(scrambled.size(), optimized.size());
+    EXPECT_EQ(getTriangles(scrambled, _vertices), getTriangles(optimized, _vertices));
+
+    float before = MeshOptimizer::computeAverageCacheMissRatio(scrambled, numVertices);
+    float after = MeshOptimizer::computeAverageCacheMissRatio(optimized, numVertices);
+    EXPECT_LT(after, 0.8f);
+    EXPECT_LT(after, before);
+}
+
+/**
+ * Tests the selection of the index width in IndexedMeshGeometry and MultiIndexedGeometry.
+ */
+TEST_F(MeshOptimizerTest, indexWidthTest) {
+    std::vector<uint32_t> smallIndices(3);
+    smallIndices[0] = 0; smallIndices[1] = 1; smallIndices[2] = 65535;
+    std::vector<cgt::vec3> vertices(70000);
+    EXPECT_FALSE(IndexedMeshGeometry(smallIndices, vertices).hasWideIndices());
+
+    std::vector<uint32_t> largeIndices(smallIndices);
+    largeIndices[2] = 65536;
+    IndexedMeshGeometry wide(largeIndices, vertices);
+    EXPECT_TRUE(wide.hasWideIndices());
+    EXPECT_EQ(3U, wide.getNumIndices());
+
+    // MultiIndexedGeometry reserves 65535 for primitive restart
+    MultiIndexedGeometry multi(vertices);
+    multi.addPrimitive(std::vector<uint16_t>(4, 1));
+    EXPECT_FALSE(multi.hasWideIndices());
+    EXPECT_EQ(4U, multi.getNumIndices());
+
+    multi.addPrimitive(smallIndices);
+    EXPECT_TRUE(multi.hasWideIndices());
+    EXPECT_EQ(8U, multi.getNumIndices());
+}
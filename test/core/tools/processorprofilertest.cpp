@@ -0,0 +1,142 @@
+// ================================================================================================
+// 
+// This file is part of the CAMPVis Software Framework.
+// 
+// If not explicitly stated otherwise: Copyright (C) 2012-2015, all rights reserved,
+//      Christian Schulte zu Berge <christian.szb@in.tum.de>
+//      Chair for Computer Aided Medical Procedures
+//      Technische Universitaet Muenchen
+//      Boltzmannstr. 3, 85748 Garching b. Muenchen, Germany
+// 
+// For a full list of authors and contributors, please refer to the file "AUTHORS.txt".
+// 
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file 
+// except in compliance with the License. You may obtain a copy of the License at
+// 
+// http://www.apache.org/licenses/LICENSE-2.0
+// 
+// Unless required by applicable law or agreed to in writing, software distributed under the 
+// License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, 
+// either express or implied. See the License for the specific language governing permissions 
+// and limitations under the License.
+// 
+// ================================================================================================
+
+#include "gtest/gtest.h"
+
+#include "core/pipeline/abstractprocessor.h"
+#include "core/tools/processorprofiler.h"
+
+#include <tbb/atomic.h>
+
+#include <thread>
+
+using namespace campvis;
+
+/**
+ * Test class for ProcessorProfiler. Starts a small capture for each test and stops it afterwards.
+ */
+class ProcessorProfilerTest : public testing::Test {
+protected:
+    ProcessorProfilerTest() {
+        ProcProfiler.startCapture(8);
+    }
+
+    ~ProcessorProfilerTest() {
+        ProcProfiler.stopCapture();
+    }
+};
+
+/**
+ * Checks that records are stored in order and only while capturing.
+ */
+TEST_F(ProcessorProfilerTest, recordTest) {
+    EXPECT_TRUE(ProcessorProfiler::isCapturing());
+
+    long long t = ProcessorProfiler::getTimestamp();
+    ProcProfiler.record("dc", "Processor1", AbstractProcessor::INVALID_RESULT, t + 10, t + 30, t);
+    ProcProfiler.record("dc", "Processor2", AbstractProcessor::INVALID_SHADER, t + 40, t + 45, 0);
+
+    ProcProfiler.stopCapture();
+    EXPECT_FALSE(ProcessorProfiler::isCapturing());
+    ProcProfiler.record("dc", "Processor3", AbstractProcessor::INVALID_RESULT, t + 50, t + 60, t);
+
+    std::vector<ProcessorProfiler::Record> records = ProcProfiler.getRecords();
+    ASSERT_EQ(2U, records.size());
+
+    EXPECT_STREQ("dc", records[0]._contextName);
+    EXPECT_STREQ("Processor1", records[0]._processorName);
+    EXPECT_EQ(AbstractProcessor::INVALID_RESULT, records[0]._invalidationLevel);
+    EXPECT_EQ(20, records[0]._duration);
+    EXPECT_EQ(10, records[0]._queueWaitTime);
+
+    EXPECT_STREQ("Processor2", records[1]._processorName);
+    EXPECT_EQ(5, records[1]._duration);
+    EXPECT_EQ(0, records[1]._queueWaitTime);
+    EXPECT_EQ(records[0]._threadId, records[1]._threadId);
+}
+
+/**
+ * Checks that the ring buffer keeps the most recent records once it is full and truncates long names.
+ */
+TEST_F(ProcessorProfilerTest, ringBufferTest) {
+    long long t = ProcessorProfiler::getTimestamp();
+    for (int i = 0; i < 20; ++i)
+        ProcProfiler.record("dc", std::string(100, 'a') + "Processor", AbstractProcessor::INVALID_RESULT, t + i, t + i + 1, 0);
+
+    std::vector<ProcessorProfiler::Record> records = ProcProfiler.getRecords();
+    ASSERT_EQ(8U, records.size());
+    for (size_t i = 1; i < records.size(); ++i)
+        EXPECT_EQ(records[i - 1]._startTime + 1, records[i]._startTime);
+
+    EXPECT_EQ(ProcessorProfiler::MAX_NAME_LENGTH - 1, strlen(records[0]._processorName));
+}
+
+/**
+ * Checks the Chrome trace export for the expected events and escaped names.
+ */
+TEST_F(ProcessorProfilerTest, chromeTraceTest) {
+    long long t = ProcessorProfiler::getTimestamp();
+    ProcProfiler.record("first \"dc\"", "Processor1", AbstractProcessor::INVALID_RESULT, t, t + 10, 0);
+    ProcProfiler.record("second dc", "Processor2", AbstractProcessor::INVALID_PROPERTIES, t, t + 10, 0);
+
+    std::string trace = ProcProfiler.getChromeTrace();
+    EXPECT_NE(std::string::npos, trace.find("\"traceEvents\""));
+    EXPECT_NE(std::string::npos, trace.find("first \\\"dc\\\""));
+    EXPECT_NE(std::string::npos, trace.find("\"name\":\"Processor1::updateResult\""));
+    EXPECT_NE(std::string::npos, trace.find("\"name\":\"Processor2::updateProperties\""));
+    EXPECT_NE(std::string::npos, trace.find("\"pid\":2"));
+    EXPECT_NE(std::string::npos, trace.find("\"dur\":10"));
+}
+
+/**
+ * Restarts the capture with different capacities while other threads are recording, each
+ * returned record must be complete.
+ */
+TEST_F(ProcessorProfilerTest, concurrentRestartTest) {
+    tbb::atomic<bool> done;
+    done = false;
+    long long t = ProcessorProfiler::getTimestamp();
+
+    // use plain threads, so that the writers run concurrently even with a single TBB worker
+    std::vector<std::thread> writers;
+    for (int i = 0; i < 4; ++i) {
+        writers.push_back(std::thread([&] () {
+            while (! done)
+                ProcProfiler.record("dc", "Processor", AbstractProcessor::INVALID_RESULT, t, t + 5, 0);
+        }));
+    }
+
+    for (int i = 0; i < 200; ++i) {
+        ProcProfiler.startCapture((i % 2 == 0) ? 16 : 64);
+        std::vector<ProcessorProfiler::Record> records = ProcProfiler.getRecords();
+        for (size_t j = 0; j < records.size(); ++j) {
+            EXPECT_STREQ("Processor", records[j]._processorName);
+            EXPECT_EQ(5, records[j]._duration);
+        }
+    }
+
+    done = true;
+    for (size_t i = 0; i < writers.size(); ++i)
+        writers[i].join();
+}
@@ -0,0 +1,149 @@
+// ================================================================================================
+// 
+// This file is part of the CAMPVis Software Framework.
+// 
+// If not explicitly stated otherwise: Copyright (C) 2012-2015, all rights reserved,
+//      Christian Schulte zu Berge <christian.szb@in.tum.de>
+//      Chair for Computer Aided Medical Procedures
+//      Technische Universitaet Muenchen
+//      Boltzmannstr. 3, 85748 Garching b. Muenchen, Germany
+// 
+// For a full list of authors and contributors, please refer to the file "AUTHORS.txt".
+// 
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file 
+// except in compliance with the License. You may obtain a copy of the License at
+// 
+// http://www.apache.org/licenses/LICENSE-2.0
+// 
+// Unless required by applicable law or agreed to in writing, software distributed under the 
+// License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, 
+// either express or implied. See the License for the specific language governing permissions 
+// and limitations under the License.
+// 
+// ================================================================================================
+
+#include "gtest/gtest.h"
+
+#include "core/datastructures/imagedata.h"
+#include "core/datastructures/genericimagerepresentationlocal.h"
+#include "core/tools/voxelview.h"
+
+using namespace campvis;
+
+/**
+ * Test class for VoxelView. Creates a small 3-channel int16 volume filled with a 
+ * deterministic pattern and compares the VoxelView accessors to the ones of the
+ * underlying ImageRepresentationLocal.
+ */
+class VoxelViewTest : public testing::Test {
+protected:
+    VoxelViewTest()
+        : _size(7, 5, 4)
+    {
+        _image = new ImageData(3, _size, 3);
+        _rep = GenericImageRepresentationLocal<int16_t, 3>::create(_image, 0);
+        for (size_t i = 0; i < _rep->getNumElements(); ++i)
+            _rep->setElement(i, cgt::Vector3<int16_t>(static_cast<int16_t>(i * 37 % 1001 - 500), static_cast<int16_t>(i * 13), static_cast<int16_t>(-static_cast<int>(i))));
+    }
+
+    ~VoxelViewTest() {
+        delete _image;
+    }
+
+    cgt::svec3 _size;
+    ImageData* _image;
+    GenericImageRepresentationLocal<int16_t, 3>* _rep;
+};
+
+/**
+ * Visits a VoxelView and stores its base type size to check the dispatch.
+ */
+struct BaseTypeSizeVisitor {
+    BaseTypeSizeVisitor() : _baseTypeSize(0) {}
+
+    template<typename BASETYPE, size_t NUMCHANNELS>
+    void operator() (const VoxelView<BASETYPE, NUMCHANNELS>& view) {
+        _baseTypeSize = sizeof(BASETYPE);
+        EXPECT_EQ(cgt::svec3(7, 5, 4), view.getSize());
+    }
+
+    size_t _baseTypeSize;
+};
+
+/**
+ * Tests that index/position conversion matches ImageData.
+ */
+TEST_F(VoxelViewTest, indexTest) {
+    VoxelView<int16_t, 3> view(_rep);
+    for (size_t i = 0; i < view.getNumElements(); ++i) {
+        EXPECT_EQ(_image->indexToPosition(i), view.indexToPosition(i));
+        EXPECT_EQ(i, view.positionToIndex(view.indexToPosition(i)));
+    }
+}
+
+/**
+ * Tests that nearest and trilinear normalized access matches ImageRepresentationLocal.
+ */
+TEST_F(VoxelViewTest, normalizedAccessTest) {
+    VoxelView<int16_t, 3> view(_rep);
+    const ImageRepresentationLocal* rep = _rep;
+
+    for (size_t i = 0; i < view.getNumElements(); ++i) {
+        cgt::vec3 all = view.getNormalized(i);
+        for (size_t c = 0; c < 3; ++c) {
+            EXPECT_EQ(rep->getElementNormalized(i, c), view.getNormalized(i, c));
+            EXPECT_EQ(rep->getElementNormalized(i, c), all[c]);
+        }
+    }
+
+    for (float z = -.5f; z < 4.5f; z += .3f) {
+        for (float y = 0.f; y < 5.5f; y += .7f) {
+            for (float x = 0.f; x < 7.5f; x += .45f) {
+                cgt::vec3 pos(x, y, z);
+                cgt::vec3 all = view.getNormalizedLinear(pos);
+                for (size_t c = 0; c < 3; ++c) {
+                    EXPECT_NEAR(rep->getElementNormalizedLinear(pos, c), view.getNormalizedLinear(pos, c), 1e-6f);
+                    EXPECT_NEAR(rep->getElementNormalizedLinear(pos, c), all[c], 1e-6f);
+                }
+            }
+        }
+    }
+}
+
+/**
+ * Tests central differences including the border handling.
+ */
+TEST_F(VoxelViewTest, gradientTest) {
+    VoxelView<int16_t, 3> view(_rep);
+    const ImageRepresentationLocal* rep = _rep;
+
+    for (size_t i = 0; i < view.getNumElements(); ++i) {
+        cgt::svec3 pos = view.indexToPosition(i);
+        cgt::vec3 expected(0.f);
+        for (size_t d = 0; d < 3; ++d) {
+            cgt::svec3 offset = cgt::svec3::zero;
+            offset[d] = 1;
+            float forward = (pos[d] != _size[d] - 1) ? rep->getElementNormalized(pos + offset, 1) : 0.f;
+            float backward = (pos[d] != 0) ? rep->getElementNormalized(pos - offset, 1) : 0.f;
+            expected[d] = (forward - backward) * .5f;
+        }
+
+        cgt::vec3 gradient = view.getGradient(pos, 1);
+        for (size_t d = 0; d < 3; ++d)
+            EXPECT_FLOAT_EQ(expected[d], gradient[d]);
+    }
+}
+
+/**
+ * Tests dispatching on the base type.
+ */
+TEST_F(VoxelViewTest, dispatchTest) {
+    BaseTypeSizeVisitor visitor;
+    EXPECT_TRUE(dispatchVoxelView<3>(_rep, visitor));
+    EXPECT_EQ(sizeof(int16_t), visitor._baseTypeSize);
+
+    BaseTypeSizeVisitor wrongChannels;
+    EXPECT_FALSE(dispatchVoxelView<1>(_rep, wrongChannels));
+    EXPECT_EQ(static_cast<size_t>(0), wrongChannels._baseTypeSize);
+    EXPECT_FALSE(dispatchVoxelView<3>(static_cast<const ImageRepresentationLocal*>(0), visitor));
+}
@@ -0,0 +1,182 @@
+// ================================================================================================
+// 
+// This file is part of the CAMPVis Software Framework.
+// 
+// If not explicitly stated otherwise: Copyright (C) 2012-2015, all rights reserved,
+//      Christian Schulte zu Berge <christian.szb@in.tum.de>
+//      Chair for Computer Aided Medical Procedures
+//      Technische Universitaet Muenchen
+//      Boltzmannstr. 3, 85748 Garching b. Muenchen, Germany
+// 
+// For a full list of authors and contributors, please refer to the file "AUTHORS.txt".
+// 
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file 
+// except in compliance with the License. You may obtain a copy of the License at
+// 
+// http://www.apache.org/licenses/LICENSE-2.0
+// 
+// Unless required by applicable law or agreed to in writing, software distributed under the 
+// License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, 
+// either express or implied. See the License for the specific language governing permissions 
+// and limitations under the License.
+// 
+// ================================================================================================
+
+
+#include "gtest/gtest.h"
+
+#ifdef CAMPVIS_HAS_MODULE_VIS
+
+#include "cgt/camera.h"
+
+#include "core/classification/geometry1dtransferfunction.h"
+#include "core/classification/tfgeometry1d.h"
+#include "core/datastructures/cameradata.h"
+#include "core/datastructures/datacontainer.h"
+#include "core/datastructures/genericimagerepresentationlocal.h"
+#include "core/datastructures/imagedata.h"
+#include "core/datastructures/renderdata.h"
+
+#include "modules/vis/processors/cpuraycaster.h"
+
+#include <cmath>
+#include <cstring>
+
+using namespace campvis;
+
+/**
+ * Test class for CpuRaycaster. Renders small synthetic volumes without any OpenGL involved.
+ */
+class CpuRaycasterTest : public ::testing::Test {
+protected:
+    CpuRaycasterTest()
+        : _dataContainer("Test Container")
+    {
+        _raycaster.p_sourceImageID.setValue("volume");
+        _raycaster.p_camera.setValue("camera");
+        _raycaster.p_targetImageID.setValue("result");
+    }
+
+    /// Adds a uint8 volume of \a size voxels to the DataContainer, \a func maps voxel positions to values.
+    template<typename FUNC>
+    void createVolume(const cgt::svec3& size, FUNC func) {
+        ImageData* image = new ImageData(3, size, 1);
+        GenericImageRepresentationLocal<uint8_t, 1>* rep = GenericImageRepresentationLocal<uint8_t, 1>::create(image, 0);
+        for (size_t z = 0; z < size.z; ++z)
+            for (size_t y = 0; y < size.y; ++y)
+                for (size_t x = 0; x < size.x; ++x)
+                    rep->getElement(cgt::svec3(x, y, z)) = func(cgt::svec3(x, y, z));
+        _dataContainer.addData("volume", image);
+    }
+
+    /// Replaces the transfer function by a single quad over \a interval with the constant color \a color.
+    void setTransferFunction(const cgt::vec2& interval, const cgt::col4& leftColor, const cgt::col4& rightColor) {
+        Geometry1DTransferFunction* tf = new Geometry1DTransferFunction(256);
+        tf->addGeometry(TFGeometry1D::createQuad(interval, leftColor, rightColor));
+        _raycaster.p_transferFunction.replaceTF(tf);
+    }
+
+    /// Renders the volume and copies the color and depth buffers into \a colors and \a depths.
+    void render(std::vector<cgt::col4>& colors, std::vector<float>& depths) {
+        _raycaster.invalidate(AbstractProcessor::INVALID_RESULT);
+        _raycaster.process(_dataContainer);
+
+        ScopedTypedData<RenderData> rd(_dataContainer, "result");
+        ASSERT_TRUE(rd != 0);
+        const GenericImageRepresentationLocal<uint8_t, 4>* colorRep = rd->getColorTexture()->getRepresentation< GenericImageRepresentationLocal<uint8_t, 4> >(false);
+        const GenericImageRepresentationLocal<float, 1>* depthRep = rd->getDepthTexture()->getRepresentation< GenericImageRepresentationLocal<float, 1> >(false);
+        ASSERT_NE(nullptr, colorRep);
+        ASSERT_NE(nullptr, depthRep);
+        colors.assign(colorRep->getImageData(), colorRep->getImageData() + colorRep->getNumElements());
+        depths.assign(depthRep->getImageData(), depthRep->getImageData() + depthRep->getNumElements());
+    }
+
+protected:
+    DataContainer _dataContainer;
+    CpuRaycaster _raycaster;
+};
+
+/**
+ * Renders a 16^3 volume whose back half is filled with a semi-transparent material along the
+ * z axis and compares the composited color and the depth of the center pixel to the analytic values.
+ */
+TEST_F(CpuRaycasterTest, analyticTest) {
+    const size_t N = 16;
+    createVolume(cgt::svec3(N), [] (const cgt::svec3& p) { return static_cast<uint8_t>(p.z >= N/2 ? 255 : 0); });
+
+    // the volume covers [0, 16]^3 in world coordinates, the center ray hits it at texture coordinates (.5, .5, 0)
+    cgt::Camera camera(cgt::vec3(8.f, 8.f, -40.f), cgt::vec3(8.f, 8.f, 8.f), cgt::vec3(0.f, 1.f, 0.f), 30.f, 1.f, 1.f, 100.f);
+    _dataContainer.addData("camera", new CameraData(camera));
+
+    // use a low opacity so that early ray termination does not kick in
+    setTransferFunction(cgt::vec2(.5f, 1.f), cgt::col4(255, 0, 0, 1), cgt::col4(255, 0, 0, 1));
+    _raycaster.p_outputSize.setValue(cgt::ivec2(9, 9));
+    _raycaster.p_samplingRate.setValue(1.9f);
+
+    std::vector<cgt::col4> colors;
+    std::vector<float> depths;
+    render(colors, depths);
+    ASSERT_EQ(81U, colors.size());
+
+    // sample k is located at voxel z coordinate k * N * step - .5, which yields an interpolated
+    // intensity of at least .92 for k >= 16 and at most .4 for k <= 15, the last sample is 30
+    const double step = 1.0 / (1.9 * N);
+    const size_t firstSample = 16;
+    const size_t numSamples = 15;
+    const double opacity = 1.0 / 255.0;
+    const double alpha = 1.0 - std::pow(1.0 - opacity, numSamples * step * 200.0);
+
+    const cgt::col4& center = colors[4 * 9 + 4];
+    EXPECT_NEAR(alpha * 255.0, center.r, 1.0);
+    EXPECT_EQ(0, center.g);
+    EXPECT_EQ(0, center.b);
+    EXPECT_NEAR(alpha * 255.0, center.a, 1.0);
+
+    // the depth is taken at the first sample with non-zero opacity
+    const cgt::vec4 hit(8.f, 8.f, static_cast<float>(firstSample * step * N), 1.f);
+    const cgt::vec4 clip = camera.getProjectionMatrix() * camera.getViewMatrix() * hit;
+    EXPECT_NEAR(clip.z / clip.w * .5f + .5f, depths[4 * 9 + 4], 1e-5f);
+
+    // the corner pixels miss the volume
+    EXPECT_EQ(cgt::col4(0, 0, 0, 0), colors[0]);
+    EXPECT_EQ(1.f, depths[0]);
+}
+
+/**
+ * Renders a sphere with and without empty space skipping, skipping transparent bricks must not
+ * change the image at all.
+ */
+TEST_F(CpuRaycasterTest, emptySpaceSkippingTest) {
+    const cgt::svec3 size(37, 41, 29);
+    createVolume(size, [&] (const cgt::svec3& p) -> uint8_t {
+        const float r = cgt::length((cgt::vec3(p) - cgt::vec3(size) * .5f) / (cgt::vec3(size) * .5f));
+        return static_cast<uint8_t>(std::max(0.f, 1.f - r) * 255.f);
+    });
+
+    cgt::Camera camera(cgt::vec3(60.f, -20.f, 80.f), cgt::vec3(18.f, 20.f, 14.f), cgt::vec3(0.f, 1.f, 0.f), 40.f, 1.f, 1.f, 500.f);
+    _dataContainer.addData("camera", new CameraData(camera));
+
+    setTransferFunction(cgt::vec2(.3f, .7f), cgt::col4(255, 0, 0, 10), cgt::col4(0, 0, 255, 80));
+    _raycaster.p_outputSize.setValue(cgt::ivec2(48, 40));
+
+    std::vector<cgt::col4> colors[2];
+    std::vector<float> depths[2];
+    for (int i = 0; i < 2; ++i) {
+        _raycaster.p_enableEmptySpaceSkipping.setValue(i == 1);
+        render(colors[i], depths[i]);
+        ASSERT_EQ(48U * 40U, colors[i].size());
+    }
+
+    size_t numHits = 0;
+    for (size_t i = 0; i < colors[0].size(); ++i) {
+        if (colors[0][i].a > 0)
+            ++numHits;
+    }
+    EXPECT_LT(0U, numHits);
+    EXPECT_GT(colors[0].size(), numHits);
+
+    EXPECT_EQ(0, memcmp(&colors[0].front(), &colors[1].front(), colors[0].size() * sizeof(cgt::col4)));
+    EXPECT_EQ(0, memcmp(&depths[0].front(), &depths[1].front(), depths[0].size() * sizeof(float)));
+}
+
+#endif
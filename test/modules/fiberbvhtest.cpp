@@ -0,0 +1,274 @@
+// ================================================================================================
+// 
+// This file is part of the CAMPVis Software Framework.
+// 
+// If not explicitly stated otherwise: Copyright (C) 2012-2015, all rights reserved,
+//      Christian Schulte zu Berge <christian.szb@in.tum.de>
+//      Chair for Computer Aided Medical Procedures
+//      Technische Universitaet Muenchen
+//      Boltzmannstr. 3, 85748 Garching b. Muenchen, Germany
+// 
+// For a full list of authors and contributors, please refer to the file "AUTHORS.txt".
+// 
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file 
+// except in compliance with the License. You may obtain a copy of the License at
+// 
+// http://www.apache.org/licenses/LICENSE-2.0
+// 
+// Unless required by applicable law or agreed to in writing, software distributed under the 
+// License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, 
+// either express or implied. See the License for the specific language governing permissions 
+// and limitations under the License.
+// 
+// ================================================================================================
+
+
+#include "gtest/gtest.h"
+
+#ifdef CAMPVIS_HAS_MODULE_DTI
+
+#include "cgt/camera.h"
+
+#include "modules/dti/datastructures/fiberbvh.h"
+#include "modules/dti/datastructures/fiberdata.h"
+
+#include <algorithm>
+#include <functional>
+#include <random>
+
+using namespace campvis;
+using namespace campvis::dti;
+
+/**
+ * Test class for FiberBvh. Builds the BVH over random walk fibers and compares all queries 
+ * against a brute-force scan over all segments.
+ */
+class FiberBvhTest : public ::testing::Test {
+protected:
+    /// Predicate whether a segment given by its two end points hits the query volume.
+    typedef std::function<bool (const cgt::vec3&, const cgt::vec3&)> SegmentPredicate;
+
+    FiberBvhTest()
+        : _random(42)
+    {
+        // enough fibers for a BVH with several levels above the parallel traversal cut, 
+        // including empty fibers and fibers with only a single vertex
+        std::uniform_real_distribution<float> position(0.f, 100.f);
+        std::uniform_real_distribution<float> step(-3.f, 3.f);
+        std::uniform_int_distribution<int> length(0, 40);
+        for (size_t f = 0; f < 400; ++f) {
+            std::vector<cgt::vec3> vertices;
+            const int numVertices = length(_random);
+            cgt::vec3 p(position(_random), position(_random), position(_random));
+            for (int i = 0; i < numVertices; ++i) {
+                vertices.push_back(p);
+                p += cgt::vec3(step(_random), step(_random), step(_random));
+            }
+            _fibers.addFiber(vertices);
+        }
+        _bvh = _fibers.getBvh();
+
+        std::uniform_int_distribution<int> bit(0, 1);
+        for (size_t f = 0; f < _fibers.numFibers(); ++f)
+            _initialMask.push_back(static_cast<uint8_t>(bit(_random)));
+    }
+
+    /// Computes the mask of all fibers with at least one segment satisfying \a predicate.
+    std::vector<uint8_t> bruteForce(const SegmentPredicate& predicate) const {
+        const std::vector<cgt::vec3>& vertices = _fibers.getVertices();
+        const std::vector<size_t>& offsets = _fibers.getFiberOffsets();
+        std::vector<uint8_t> toReturn(_fibers.numFibers(), 0);
+
+        for (size_t f = 0; f < _fibers.numFibers(); ++f) {
+            if (offsets[f+1] - offsets[f] == 1)
+                toReturn[f] = predicate(vertices[offsets[f]], vertices[offsets[f]]);
+            for (size_t v = offsets[f]; v + 1 < offsets[f+1] && ! toReturn[f]; ++v)
+                toReturn[f] = predicate(vertices[v], vertices[v + 1]);
+        }
+        return toReturn;
+    }
+
+    /**
+     * Runs \a query with all mask operations and compares the results to the brute-force scan.
+     * \param   query       Functor running the BVH query with the given mask and operation.
+     * \param   predicate   Segment predicate of the query for the brute-force scan.
+     * \return  The number of hit fibers.
+     */
+    template<typename QUERY>
+    size_t compare(const QUERY& query, const SegmentPredicate& predicate) {
+        const std::vector<uint8_t> expected = bruteForce(predicate);
+        size_t numHits = std::count(expected.begin(), expected.end(), 1);
+
+        std::vector<uint8_t> mask;
+        query(mask, FiberBvh::SET);
+        EXPECT_EQ(expected, mask);
+
+        std::vector<uint8_t> intersected(_initialMask), subtracted(_initialMask), united(_initialMask);
+        query(intersected, FiberBvh::INTERSECT);
+        query(subtracted, FiberBvh::SUBTRACT);
+        query(united, FiberBvh::UNITE);
+        for (size_t f = 0; f < expected.size(); ++f) {
+            EXPECT_EQ(_initialMask[f] && expected[f], intersected[f] != 0) << "Fiber " << f;
+            EXPECT_EQ(_initialMask[f] && ! expected[f], subtracted[f] != 0) << "Fiber " << f;
+            EXPECT_EQ(_initialMask[f] || expected[f], united[f] != 0) << "Fiber " << f;
+        }
+
+        return numHits;
+    }
+
+    /// Returns a random point in the volume covered by the fibers, with some margin.
+    cgt::vec3 randomPoint() {
+        std::uniform_real_distribution<float> position(-20.f, 120.f);
+        return cgt::vec3(position(_random), position(_random), position(_random));
+    }
+
+    std::mt19937 _random;
+    FiberData _fibers;
+    std::shared_ptr<const FiberBvh> _bvh;
+    std::vector<uint8_t> _initialMask;
+};
+
+/**
+ * Checks the structure of the BVH.
+ */
+TEST_F(FiberBvhTest, constructionTest) {
+    // single vertices are represented by a degenerate segment
+    const std::vector<size_t>& offsets = _fibers.getFiberOffsets();
+    size_t numSegments = 0;
+    for (size_t f = 0; f < _fibers.numFibers(); ++f) {
+        const size_t numVertices = offsets[f+1] - offsets[f];
+        numSegments += (numVertices > 1) ? numVertices - 1 : numVertices;
+    }
+
+    EXPECT_EQ(_fibers.numFibers(), _bvh->getNumFibers());
+    EXPECT_EQ(numSegments, _bvh->getNumSegments());
+    EXPECT_LT(64 * FiberBvh::LEAF_SIZE, _bvh->getNumSegments());
+
+    cgt::Bounds bounds = _bvh->getBounds();
+    ASSERT_TRUE(bounds.isDefined());
+    const std::vector<cgt::vec3>& vertices = _fibers.getVertices();
+    for (size_t i = 0; i < vertices.size(); ++i)
+        EXPECT_TRUE(bounds.containsPoint(vertices[i]));
+
+    // the BVH is shared until the fibers change
+    EXPECT_EQ(_bvh, _fibers.getBvh());
+    _fibers.addFiber(std::vector<cgt::vec3>(2, cgt::vec3(50.f)));
+    std::shared_ptr<const FiberBvh> rebuilt = _fibers.getBvh();
+    EXPECT_NE(_bvh, rebuilt);
+    EXPECT_EQ(_fibers.numFibers(), rebuilt->getNumFibers());
+}
+
+/**
+ * Compares queryBox() to the brute-force scan.
+ */
+TEST_F(FiberBvhTest, queryBoxTest) {
+    std::uniform_real_distribution<float> extent(.5f, 40.f);
+    size_t numHits = 0;
+
+    for (int i = 0; i < 60; ++i) {
+        const cgt::vec3 llf = randomPoint();
+        // the last box contains everything to exercise nodes completely inside
+        const cgt::vec3 urb = (i == 59) ? cgt::vec3(1000.f) : llf + cgt::vec3(extent(_random), extent(_random), extent(_random));
+        const cgt::Bounds box(llf, urb);
+
+        numHits += compare(
+            [&] (std::vector<uint8_t>& mask, FiberBvh::MaskOperation op) { _bvh->queryBox(box, mask, op); },
+            [&] (const cgt::vec3& a, const cgt::vec3& b) -> bool {
+                // clip the segment against the slabs of the box
+                double tMin = 0.0, tMax = 1.0;
+                for (size_t j = 0; j < 3; ++j) {
+                    const double d = static_cast<double>(b[j]) - a[j];
+                    if (d == 0.0) {
+                        if (a[j] < llf[j] || a[j] > urb[j])
+                            return false;
+                        continue;
+                    }
+                    const double t1 = (llf[j] - a[j]) / d;
+                    const double t2 = (urb[j] - a[j]) / d;
+                    tMin = std::max(tMin, std::min(t1, t2));
+                    tMax = std::min(tMax, std::max(t1, t2));
+                }
+                return tMin <= tMax;
+            });
+    }
+    EXPECT_LT(0U, numHits);
+
+    // an undefined box hits nothing
+    std::vector<uint8_t> mask;
+    _bvh->queryBox(cgt::Bounds(), mask);
+    EXPECT_EQ(std::vector<uint8_t>(_fibers.numFibers(), 0), mask);
+}
+
+/**
+ * Compares querySphere() to the brute-force scan.
+ */
+TEST_F(FiberBvhTest, querySphereTest) {
+    std::uniform_real_distribution<float> radii(.5f, 30.f);
+    size_t numHits = 0;
+
+    for (int i = 0; i < 60; ++i) {
+        const cgt::vec3 center = randomPoint();
+        const float radius = (i == 59) ? 1000.f : radii(_random);
+
+        numHits += compare(
+            [&] (std::vector<uint8_t>& mask, FiberBvh::MaskOperation op) { _bvh->querySphere(center, radius, mask, op); },
+            [&] (const cgt::vec3& a, const cgt::vec3& b) -> bool {
+                // distance of the closest point on the segment
+                const cgt::dvec3 d = cgt::dvec3(b) - cgt::dvec3(a);
+                const double length2 = cgt::dot(d, d);
+                const double t = (length2 > 0.0) ? std::min(std::max(cgt::dot(cgt::dvec3(center) - cgt::dvec3(a), d) / length2, 0.0), 1.0) : 0.0;
+                const cgt::dvec3 difference = cgt::dvec3(a) + t * d - cgt::dvec3(center);
+                return cgt::dot(difference, difference) <= static_cast<double>(radius) * radius;
+            });
+    }
+    EXPECT_LT(0U, numHits);
+}
+
+/**
+ * Compares queryPlane() to the brute-force scan.
+ */
+TEST_F(FiberBvhTest, queryPlaneTest) {
+    std::uniform_real_distribution<float> component(-1.f, 1.f);
+    size_t numHits = 0;
+
+    for (int i = 0; i < 60; ++i) {
+        // include axis-aligned planes
+        cgt::vec3 normal = (i < 3) ? cgt::vec3(i == 0, i == 1, i == 2) : cgt::normalize(cgt::vec3(component(_random), component(_random), component(_random)) + cgt::vec3(1e-3f));
+        const float distance = cgt::dot(normal, randomPoint());
+
+        numHits += compare(
+            [&] (std::vector<uint8_t>& mask, FiberBvh::MaskOperation op) { _bvh->queryPlane(normal, distance, mask, op); },
+            [&] (const cgt::vec3& a, const cgt::vec3& b) -> bool {
+                const float da = cgt::dot(normal, a) - distance;
+                const float db = cgt::dot(normal, b) - distance;
+                return (da <= 0.f && db >= 0.f) || (da >= 0.f && db <= 0.f);
+            });
+    }
+    EXPECT_LT(0U, numHits);
+}
+
+/**
+ * Compares queryFrustum() to culling the bounding box of each segment with cgt::Frustum.
+ */
+TEST_F(FiberBvhTest, queryFrustumTest) {
+    std::uniform_real_distribution<float> fovy(10.f, 90.f);
+    size_t numHits = 0;
+
+    for (int i = 0; i < 40; ++i) {
+        const cgt::vec3 position = randomPoint() * 2.f - cgt::vec3(50.f);
+        const cgt::vec3 focus = randomPoint();
+        const cgt::vec3 up = cgt::normalize(cgt::cross(focus - position, cgt::vec3(.3f, 1.f, .2f)));
+        cgt::Camera camera(position, focus, up, fovy(_random), 1.25f, 1.f, (i % 2 == 0) ? 60.f : 1000.f);
+        camera.updateFrustum();
+        const cgt::Frustum& frustum = camera.getFrustum();
+
+        numHits += compare(
+            [&] (std::vector<uint8_t>& mask, FiberBvh::MaskOperation op) { _bvh->queryFrustum(frustum, mask, op); },
+            [&] (const cgt::vec3& a, const cgt::vec3& b) -> bool {
+                return ! frustum.isCulled(cgt::Bounds(cgt::min(a, b), cgt::max(a, b)));
+            });
+    }
+    EXPECT_LT(0U, numHits);
+}
+
+#endif
@@ -0,0 +1,117 @@
+// ================================================================================================
+// 
+// This file is part of the CAMPVis Software Framework.
+// 
+// If not explicitly stated otherwise: Copyright (C) 2012-2015, all rights reserved,
+//      Christian Schulte zu Berge <christian.szb@in.tum.de>
+//      Chair for Computer Aided Medical Procedures
+//      Technische Universitaet Muenchen
+//      Boltzmannstr. 3, 85748 Garching b. Muenchen, Germany
+// 
+// For a full list of authors and contributors, please refer to the file "AUTHORS.txt".
+// 
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file 
+// except in compliance with the License. You may obtain a copy of the License at
+// 
+// http://www.apache.org/licenses/LICENSE-2.0
+// 
+// Unless required by applicable law or agreed to in writing, software distributed under the 
+// License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, 
+// either express or implied. See the License for the specific language governing permissions 
+// and limitations under the License.
+// 
+// ================================================================================================
+
+
+#include "gtest/gtest.h"
+
+#ifdef CAMPVIS_HAS_MODULE_PREPROCESSING
+
+#include "core/datastructures/genericimagerepresentationlocal.h"
+#include "core/datastructures/imagedata.h"
+
+#include "modules/preprocessing/tools/abstractimagefilter.h"
+
+#include <cstring>
+#include <limits>
+#include <memory>
+
+using namespace campvis;
+
+/**
+ * Test class comparing ImageFilterMedianTyped against the generic ImageFilterMedian.
+ * Both filters are applied to the same pseudo-random image, the results must be bit-identical.
+ */
+template<typename T>
+class ImageFilterMedianTest : public ::testing::Test {
+protected:
+    typedef GenericImageRepresentationLocal<T, 1> ImageType;
+
+    ImageFilterMedianTest()
+        : _size(17, 13, 9)
+        , _input(createImage())
+        , _expected(createImage())
+        , _result(createImage())
+    {
+        // simple LCG, so that the input is the same on all platforms
+        T* data = getRepresentation(_input.get())->getImageData();
+        uint32_t state = 42;
+        for (size_t i = 0; i < _input->getNumElements(); ++i) {
+            state = state * 1664525u + 1013904223u;
+            data[i] = randomValue(state, std::is_floating_point<T>());
+        }
+    }
+
+    /// Creates a new zero-initialized image of size _size.
+    ImageData* createImage() const {
+        ImageData* toReturn = new ImageData(3, _size, 1);
+        ImageType::create(toReturn, new T[cgt::hmul(_size)]());
+        return toReturn;
+    }
+
+    static ImageType* getRepresentation(const ImageData* image) {
+        return const_cast<ImageType*>(image->getRepresentation<ImageType>(false));
+    }
+
+    /// Maps the random state to 64 distinct values spanning the full range of T, so that there are ties and extremal values.
+    static T randomValue(uint32_t state, std::false_type) {
+        double range = static_cast<double>(std::numeric_limits<T>::max()) - static_cast<double>(std::numeric_limits<T>::min());
+        return static_cast<T>(static_cast<double>(std::numeric_limits<T>::min()) + static_cast<double>((state >> 8) % 64) / 63.0 * range);
+    }
+    static T randomValue(uint32_t state, std::true_type) {
+        return static_cast<T>((state >> 8) % 1000) / T(10) - T(50);
+    }
+
+    /// Applies both filters with the given kernel size and compares their results.
+    void compareFilters(size_t kernelSize) {
+        const ImageType* input = getRepresentation(_input.get());
+        ImageType* expected = getRepresentation(_expected.get());
+        ImageType* result = getRepresentation(_result.get());
+
+        tbb::parallel_for(tbb::blocked_range<size_t>(0, input->getNumElements()), ImageFilterMedian(input, expected, kernelSize));
+        tbb::parallel_for(tbb::blocked_range2d<size_t>(0, _size.z, 0, _size.y), ImageFilterMedianTyped<T>(input, result, kernelSize));
+
+        for (size_t i = 0; i < input->getNumElements(); ++i)
+            ASSERT_EQ(0, memcmp(expected->getImageData() + i, result->getImageData() + i, sizeof(T))) << "Results differ at index " << i << " for kernel size " << kernelSize;
+    }
+
+    cgt::svec3 _size;
+    std::unique_ptr<ImageData> _input;
+    std::unique_ptr<ImageData> _expected;
+    std::unique_ptr<ImageData> _result;
+};
+
+typedef ::testing::Types<uint8_t, int8_t, uint16_t, int16_t, uint32_t, int32_t, float> MedianFilterTypes;
+TYPED_TEST_CASE(ImageFilterMedianTest, MedianFilterTypes);
+
+/**
+ * The typed median filter must yield the same result as the generic one for all base types,
+ * using the sliding histogram for 8/16 bit images and the scratch buffer for all others.
+ */
+TYPED_TEST(ImageFilterMedianTest, bitIdenticalToGenericFilter) {
+    this->compareFilters(3);
+    this->compareFilters(5);
+    this->compareFilters(1);
+}
+
+#endif
@@ -0,0 +1,180 @@
+// ================================================================================================
+// 
+// This file is part of the CAMPVis Software Framework.
+// 
+// If not explicitly stated otherwise: Copyright (C) 2012-2015, all rights reserved,
+//      Christian Schulte zu Berge <christian.szb@in.tum.de>
+//      Chair for Computer Aided Medical Procedures
+//      Technische Universitaet Muenchen
+//      Boltzmannstr. 3, 85748 Garching b. Muenchen, Germany
+// 
+// For a full list of authors and contributors, please refer to the file "AUTHORS.txt".
+// 
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file 
+// except in compliance with the License. You may obtain a copy of the License at
+// 
+// http://www.apache.org/licenses/LICENSE-2.0
+// 
+// Unless required by applicable law or agreed to in writing, software distributed under the 
+// License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, 
+// either express or implied. See the License for the specific language governing permissions 
+// and limitations under the License.
+// 
+// ================================================================================================
+
+
+#include "gtest/gtest.h"
+
+#ifdef CAMPVIS_HAS_MODULE_VIS
+
+#include "core/datastructures/datacontainer.h"
+#include "core/datastructures/genericimagerepresentationlocal.h"
+#include "core/datastructures/imagedata.h"
+#include "core/datastructures/indexedmeshgeometry.h"
+
+#include "modules/vis/processors/isosurfaceextractor.h"
+
+#include <map>
+#include <utility>
+
+using namespace campvis;
+
+namespace {
+    /// IsosurfaceExtractor granting access to its block index.
+    class TestIsosurfaceExtractor : public IsosurfaceExtractor {
+    public:
+        /// Updates the block index for the image \a name and returns whether it had to be rebuilt.
+        bool updateBlockIndex(DataContainer& dataContainer, const std::string& name) {
+            ImageRepresentationLocal::ScopedRepresentation input(dataContainer, name);
+            return _blockIndex.update(input, input.getDataHandle());
+        }
+    };
+}
+
+/**
+ * Test class for IsosurfaceExtractor. Extracts spheres from a synthetic cone-shaped intensity 
+ * field, whose intensity decreases linearly with the distance from _center.
+ */
+class IsosurfaceExtractorTest : public ::testing::Test {
+protected:
+    IsosurfaceExtractorTest()
+        : _dataContainer("Test Container")
+        , _size(30, 33, 31)
+        , _center(14.6f, 16.3f, 15.2f)
+        , _radius(14.f)
+    {
+        ImageData* image = new ImageData(3, _size, 1);
+        GenericImageRepresentationLocal<float, 1>* rep = GenericImageRepresentationLocal<float, 1>::create(image, 0);
+        for (size_t z = 0; z < _size.z; ++z)
+            for (size_t y = 0; y < _size.y; ++y)
+                for (size_t x = 0; x < _size.x; ++x)
+                    rep->getElement(cgt::svec3(x, y, z)) = std::max(0.f, 1.f - cgt::distance(cgt::vec3(cgt::svec3(x, y, z)), _center) / _radius);
+        _dataContainer.addData("volume", image);
+    }
+
+    /// Runs \a extractor with the given iso value and returns the resulting mesh.
+    const IndexedMeshGeometry* extract(IsosurfaceExtractor& extractor, float isoValue) {
+        extractor.p_sourceImageID.setValue("volume");
+        extractor.p_geometryID.setValue("isosurface");
+        extractor.p_isoValue.setValue(isoValue);
+        extractor.invalidate(AbstractProcessor::INVALID_RESULT);
+        extractor.process(_dataContainer);
+
+        // the DataContainer keeps the geometry alive
+        return dynamic_cast<const IndexedMeshGeometry*>(_dataContainer.getData("isosurface").getData());
+    }
+
+protected:
+    DataContainer _dataContainer;
+    cgt::svec3 _size;
+    cgt::vec3 _center;
+    float _radius;
+};
+
+/**
+ * Checks that the extracted sphere is a closed, consistently oriented manifold: every edge is 
+ * shared by exactly two triangles, which traverse it in opposite directions.
+ */
+TEST_F(IsosurfaceExtractorTest, watertightTest) {
+    IsosurfaceExtractor extractor;
+    const IndexedMeshGeometry* mesh = extract(extractor, .3f);
+    ASSERT_NE(nullptr, mesh);
+    ASSERT_LT(0U, mesh->getNumIndices());
+    ASSERT_EQ(0U, mesh->getNumIndices() % 3);
+
+    std::map<std::pair<uint32_t, uint32_t>, int> undirectedEdges;
+    std::map<std::pair<uint32_t, uint32_t>, int> directedEdges;
+    for (size_t i = 0; i < mesh->getNumIndices(); i += 3) {
+        for (size_t j = 0; j < 3; ++j) {
+            const uint32_t a = mesh->getIndex(i + j);
+            const uint32_t b = mesh->getIndex(i + (j + 1) % 3);
+            ASSERT_NE(a, b);
+            ++undirectedEdges[std::make_pair(std::min(a, b), std::max(a, b))];
+            ++directedEdges[std::make_pair(a, b)];
+        }
+    }
+
+    for (std::map<std::pair<uint32_t, uint32_t>, int>::const_iterator it = undirectedEdges.begin(); it != undirectedEdges.end(); ++it)
+        EXPECT_EQ(2, it->second) << "Edge " << it->first.first << "-" << it->first.second;
+    for (std::map<std::pair<uint32_t, uint32_t>, int>::const_iterator it = directedEdges.begin(); it != directedEdges.end(); ++it)
+        EXPECT_EQ(1, it->second) << "Directed edge " << it->first.first << "-" << it->first.second;
+}
+
+/**
+ * Checks that the triangles are oriented counter-clockwise when seen from the outside and that 
+ * the vertex normals point against the image gradient, i.e. away from the center of the sphere.
+ */
+TEST_F(IsosurfaceExtractorTest, orientationTest) {
+    IsosurfaceExtractor extractor;
+    const IndexedMeshGeometry* mesh = extract(extractor, .3f);
+    ASSERT_NE(nullptr, mesh);
+    const std::vector<cgt::vec3>& vertices = mesh->getVertices();
+    const std::vector<cgt::vec3>& normals = mesh->getNormals();
+    ASSERT_EQ(vertices.size(), normals.size());
+
+    // the image uses the identity mapping, hence world coordinates are voxel coordinates
+    for (size_t i = 0; i < mesh->getNumIndices(); i += 3) {
+        const cgt::vec3& v0 = vertices[mesh->getIndex(i)];
+        const cgt::vec3& v1 = vertices[mesh->getIndex(i + 1)];
+        const cgt::vec3& v2 = vertices[mesh->getIndex(i + 2)];
+        const cgt::vec3 faceNormal = cgt::cross(v1 - v0, v2 - v0);
+        if (cgt::length(faceNormal) < 1e-4f)
+            continue;
+
+        const cgt::vec3 outward = (v0 + v1 + v2) / 3.f - _center;
+        EXPECT_LT(0.f, cgt::dot(faceNormal, outward)) << "Triangle " << i / 3;
+    }
+
+    for (size_t i = 0; i < vertices.size(); ++i) {
+        const cgt::vec3 outward = cgt::normalize(vertices[i] - _center);
+        EXPECT_LT(.9f, cgt::dot(normals[i], outward)) << "Vertex " << i;
+    }
+}
+
+/**
+ * Changes only the iso value and checks that the cached block index yields the same mesh as a 
+ * freshly constructed extractor.
+ */
+TEST_F(IsosurfaceExtractorTest, isoValueChangeTest) {
+    TestIsosurfaceExtractor extractor;
+    ASSERT_NE(nullptr, extract(extractor, .3f));
+    EXPECT_FALSE(extractor.updateBlockIndex(_dataContainer, "volume"));
+
+    const IndexedMeshGeometry* cached = extract(extractor, .6f);
+    ASSERT_NE(nullptr, cached);
+    DataHandle cachedHandle = _dataContainer.getData("isosurface");
+
+    IsosurfaceExtractor freshExtractor;
+    const IndexedMeshGeometry* fresh = extract(freshExtractor, .6f);
+    ASSERT_NE(nullptr, fresh);
+    ASSERT_NE(cached, fresh);
+
+    ASSERT_LT(0U, fresh->getNumIndices());
+    ASSERT_EQ(fresh->getNumIndices(), cached->getNumIndices());
+    for (size_t i = 0; i < fresh->getNumIndices(); ++i)
+        ASSERT_EQ(fresh->getIndex(i), cached->getIndex(i));
+    EXPECT_EQ(fresh->getVertices(), cached->getVertices());
+    EXPECT_EQ(fresh->getNormals(), cached->getNormals());
+}
+
+#endif
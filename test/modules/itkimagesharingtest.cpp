@@ -0,0 +1,107 @@
+// ================================================================================================
+// 
+// This file is part of the CAMPVis Software Framework.
+// 
+// If not explicitly stated otherwise: Copyright (C) 2012-2015, all rights reserved,
+//      Christian Schulte zu Berge <christian.szb@in.tum.de>
+//      Chair for Computer Aided Medical Procedures
+//      Technische Universitaet Muenchen
+//      Boltzmannstr. 3, 85748 Garching b. Muenchen, Germany
+// 
+// For a full list of authors and contributors, please refer to the file "AUTHORS.txt".
+// 
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file 
+// except in compliance with the License. You may obtain a copy of the License at
+// 
+// http://www.apache.org/licenses/LICENSE-2.0
+// 
+// Unless required by applicable law or agreed to in writing, software distributed under the 
+// License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, 
+// either express or implied. See the License for the specific language governing permissions 
+// and limitations under the License.
+// 
+// ================================================================================================
+
+
+#include "gtest/gtest.h"
+
+#ifdef CAMPVIS_HAS_MODULE_ITK
+
+#include "core/datastructures/genericimagerepresentationlocal.h"
+#include "core/datastructures/imagedata.h"
+
+#include "modules/itk/core/genericimagerepresentationitk.h"
+
+#include <memory>
+
+using namespace campvis;
+
+/**
+ * Test class for sharing pixel buffers between local and ITK image representations.
+ * Converts a small local image to ITK, which aliases the local buffer, and writes to both sides.
+ */
+class ItkImageSharingTest : public ::testing::Test {
+protected:
+    typedef GenericImageRepresentationLocal<float, 1> LocalRepType;
+    typedef GenericImageRepresentationItk<float, 1, 3> ItkRepType;
+
+    ItkImageSharingTest()
+        : _image(new ImageData(3, cgt::svec3(4, 3, 2), 1))
+    {
+        _localRep = LocalRepType::create(_image.get(), 0);
+        for (size_t i = 0; i < _localRep->getNumElements(); ++i)
+            _localRep->setElement(i, static_cast<float>(i));
+
+        _itkRep = _image->getRepresentation<ItkRepType>();
+    }
+
+    /// Returns the ITK pixel at \a position without unsharing the buffer.
+    float getItkPixel(const cgt::svec3& position) const {
+        ItkRepType::ItkImageType::IndexType index;
+        index[0] = position.x;
+        index[1] = position.y;
+        index[2] = position.z;
+        return _itkRep->getItkImage()->GetPixel(index);
+    }
+
+protected:
+    std::unique_ptr<ImageData> _image;
+    LocalRepType* _localRep;
+    const ItkRepType* _itkRep;
+};
+
+/**
+ * Checks that the export aliases the local buffer and that writing to the local representation
+ * after the export does not show up in the ITK image.
+ */
+TEST_F(ItkImageSharingTest, writeLocalAfterExportTest) {
+    ASSERT_NE(nullptr, _itkRep);
+    EXPECT_TRUE(_itkRep->isBufferShared());
+    EXPECT_EQ(static_cast<const LocalRepType*>(_localRep)->getImageData(), _itkRep->getItkImage()->GetBufferPointer());
+
+    _localRep->ensureUnique();
+    _localRep->setElement(cgt::svec3(1, 2, 1), -1.f);
+    _localRep->getImageData()[0] = -2.f;
+
+    EXPECT_EQ(-1.f, _localRep->getElement(cgt::svec3(1, 2, 1)));
+    EXPECT_EQ(-2.f, _localRep->getElement(0));
+    EXPECT_EQ(static_cast<float>(_image->positionToIndex(cgt::svec3(1, 2, 1))), getItkPixel(cgt::svec3(1, 2, 1)));
+    EXPECT_EQ(0.f, getItkPixel(cgt::svec3(0, 0, 0)));
+}
+
+/**
+ * Checks that writing to the ITK image obtained for writing does not show up in the local representation.
+ */
+TEST_F(ItkImageSharingTest, writeItkAfterExportTest) {
+    ASSERT_NE(nullptr, _itkRep);
+
+    ItkRepType::ItkImageType::IndexType index;
+    index.Fill(1);
+    ItkRepType::ItkImageType::Pointer itkImage = const_cast<ItkRepType*>(_itkRep)->getItkImage();
+    itkImage->SetPixel(index, -1.f);
+
+    EXPECT_EQ(-1.f, getItkPixel(cgt::svec3(1, 1, 1)));
+    EXPECT_EQ(static_cast<float>(_image->positionToIndex(cgt::svec3(1, 1, 1))), _localRep->getElement(cgt::svec3(1, 1, 1)));
+}
+
+#endif
@@ -0,0 +1,207 @@
+// ================================================================================================
+// 
+// This file is part of the CAMPVis Software Framework.
+// 
+// If not explicitly stated otherwise: Copyright (C) 2012-2015, all rights reserved,
+//      Christian Schulte zu Berge <christian.szb@in.tum.de>
+//      Chair for Computer Aided Medical Procedures
+//      Technische Universitaet Muenchen
+//      Boltzmannstr. 3, 85748 Garching b. Muenchen, Germany
+// 
+// For a full list of authors and contributors, please refer to the file "AUTHORS.txt".
+// 
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file 
+// except in compliance with the License. You may obtain a copy of the License at
+// 
+// http://www.apache.org/licenses/LICENSE-2.0
+// 
+// Unless required by applicable law or agreed to in writing, software distributed under the 
+// License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, 
+// either express or implied. See the License for the specific language governing permissions 
+// and limitations under the License.
+// 
+// ================================================================================================
+
+
+
+#include "gtest/gtest.h"
+
+#ifdef CAMPVIS_HAS_MODULE_IVUS_TC
+
+#include "cgt/filesystem.h"
+
+#include "core/datastructures/datacontainer.h"
+#include "core/datastructures/genericimagerepresentationlocal.h"
+#include "core/datastructures/imagedata.h"
+
+#include "modules/ivus_tc/processors/ivusbatchreader.h"
+
+#include <fstream>
+#include <vector>
+
+using namespace campvis;
+
+/**
+ * Test class for the native BMP decoding of IvusBatchReader. Writes small uncompressed BMP files
+ * into a directory and checks the stacked volume against the expected luminance values.
+ */
+class IvusBatchReaderTest : public ::testing::Test {
+protected:
+    IvusBatchReaderTest()
+        : _dataContainer("Test Container")
+        , _reader(nullptr)
+        , _directory("ivusbatchreadertest")
+        , _size(3, 2)
+    {
+        cgt::FileSystem::createDirectory(_directory);
+        _reader.p_inputDirectory.setValue(_directory);
+        _reader.p_outputImage.setValue("volume");
+    }
+
+    ~IvusBatchReaderTest() {
+        cgt::FileSystem::deleteDirectoryRecursive(_directory);
+    }
+
+    /// Converts RGB to luminance the same way as IvusBatchReader and DevIL.
+    static uint8_t toLuminance(uint8_t r, uint8_t g, uint8_t b) {
+        return static_cast<uint8_t>(0.212671f * r + 0.715160f * g + 0.072169f * b);
+    }
+
+    /**
+     * Writes an uncompressed BMP file with _size.
+     * \param   fileName        Name of the file within _directory
+     * \param   bitsPerPixel    Either 8 (\a pixels are palette indices) or 24 (\a pixels are RGB triples)
+     * \param   pixels          Pixel data, rows from bottom to top
+     * \param   palette         RGB triples of the palette for 8 bit images
+     * \param   topDown         Flag whether to store the rows top-down (negative height)
+     * \param   truncate        Number of bytes to cut off the end of the file
+     */
+    void writeBmp(const std::string& fileName, int bitsPerPixel, const std::vector<uint8_t>& pixels, const std::vector<uint8_t>& palette, bool topDown, size_t truncate = 0) {
+        const size_t bytesPerPixel = bitsPerPixel / 8;
+        const size_t rowStride = ((_size.x * bitsPerPixel + 31) / 32) * 4;
+        const size_t paletteSize = (bitsPerPixel == 8) ? 4 * 256 : 0;
+        const size_t dataOffset = 54 + paletteSize;
+
+        std::vector<uint8_t> file(dataOffset + rowStride * _size.y, 0);
+        file[0] = 'B';
+        file[1] = 'M';
+        writeLE32(&file[2], static_cast<uint32_t>(file.size()));
+        writeLE32(&file[10], static_cast<uint32_t>(dataOffset));
+        writeLE32(&file[14], 40);
+        writeLE32(&file[18], static_cast<uint32_t>(_size.x));
+        writeLE32(&file[22], static_cast<uint32_t>(topDown ? -_size.y : _size.y));
+        file[26] = 1;
+        file[28] = static_cast<uint8_t>(bitsPerPixel);
+
+        for (size_t i = 0; i < palette.size() / 3; ++i) {
+            // palette entries are stored as BGR0
+            file[54 + 4*i + 0] = palette[3*i + 2];
+            file[54 + 4*i + 1] = palette[3*i + 1];
+            file[54 + 4*i + 2] = palette[3*i + 0];
+        }
+
+        for (int y = 0; y < _size.y; ++y) {
+            uint8_t* row = &file[dataOffset + rowStride * (topDown ? (_size.y - 1 - y) : y)];
+            for (int x = 0; x < _size.x; ++x) {
+                const uint8_t* src = &pixels[bytesPerPixel * (y * _size.x + x)];
+                if (bitsPerPixel == 8) {
+                    row[x] = src[0];
+                }
+                else {
+                    // pixels are stored as BGR
+                    row[3*x + 0] = src[2];
+                    row[3*x + 1] = src[1];
+                    row[3*x + 2] = src[0];
+                }
+            }
+        }
+
+        std::ofstream out((_directory + "/" + fileName).c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+        out.write(reinterpret_cast<const char*>(&file.front()), file.size() - truncate);
+    }
+
+    /// Runs the reader and returns the resulting volume, 0 if there is none.
+    const GenericImageRepresentationLocal<uint8_t, 1>* read() {
+        _dataContainer.clear();
+        _reader.invalidate(AbstractProcessor::INVALID_RESULT);
+        _reader.process(_dataContainer);
+
+        // the DataContainer keeps the image alive
+        const ImageData* image = dynamic_cast<const ImageData*>(_dataContainer.getData("volume").getData());
+        return (image != 0) ? image->getRepresentation< GenericImageRepresentationLocal<uint8_t, 1> >(false) : 0;
+    }
+
+    static void writeLE32(uint8_t* p, uint32_t value) {
+        for (size_t i = 0; i < 4; ++i)
+            p[i] = static_cast<uint8_t>(value >> (8 * i));
+    }
+
+protected:
+    DataContainer _dataContainer;
+    IvusBatchReader _reader;
+    std::string _directory;
+    cgt::ivec2 _size;
+};
+
+/**
+ * Reads 8 bit palette images, whose indices must be mapped through the luminance of the palette.
+ */
+TEST_F(IvusBatchReaderTest, palette8Test) {
+    std::vector<uint8_t> palette(3 * 256);
+    for (size_t i = 0; i < 256; ++i) {
+        palette[3*i + 0] = static_cast<uint8_t>(255 - i);
+        palette[3*i + 1] = static_cast<uint8_t>(i / 2);
+        palette[3*i + 2] = static_cast<uint8_t>(i);
+    }
+    const uint8_t indices[] = { 0, 1, 2, 100, 200, 255 };
+    writeBmp("0.bmp", 8, std::vector<uint8_t>(indices, indices + 6), palette, false);
+
+    const GenericImageRepresentationLocal<uint8_t, 1>* volume = read();
+    ASSERT_NE(nullptr, volume);
+    EXPECT_EQ(cgt::svec3(3, 2, 1), volume->getSize());
+    for (size_t i = 0; i < 6; ++i)
+        EXPECT_EQ(toLuminance(palette[3*indices[i]], palette[3*indices[i] + 1], palette[3*indices[i] + 2]), volume->getElement(i));
+}
+
+/**
+ * Reads 24 bit images with padded rows stored bottom-up and top-down, which must yield the same
+ * slices stacked in the order of the file names.
+ */
+TEST_F(IvusBatchReaderTest, rgb24Test) {
+    const uint8_t rgb[] = { 255, 0, 0,   0, 255, 0,   0, 0, 255,
+                            10, 20, 30,  128, 128, 128,  255, 255, 255 };
+    std::vector<uint8_t> pixels(rgb, rgb + 18);
+    writeBmp("0.bmp", 24, pixels, std::vector<uint8_t>(), false);
+    writeBmp("1.bmp", 24, pixels, std::vector<uint8_t>(), true);
+
+    const GenericImageRepresentationLocal<uint8_t, 1>* volume = read();
+    ASSERT_NE(nullptr, volume);
+    EXPECT_EQ(cgt::svec3(3, 2, 2), volume->getSize());
+    for (size_t z = 0; z < 2; ++z) {
+        for (size_t i = 0; i < 6; ++i)
+            EXPECT_EQ(toLuminance(rgb[3*i], rgb[3*i + 1], rgb[3*i + 2]), volume->getElement(cgt::svec3(i % 3, i / 3, z)));
+    }
+}
+
+/**
+ * Checks that truncated files and files of a different size are rejected without falling back 
+ * to DevIL.
+ */
+TEST_F(IvusBatchReaderTest, truncatedTest) {
+    const uint8_t rgb[18] = { 0 };
+    std::vector<uint8_t> pixels(rgb, rgb + 18);
+    writeBmp("0.bmp", 24, pixels, std::vector<uint8_t>(), false);
+    writeBmp("1.bmp", 24, pixels, std::vector<uint8_t>(), false, 5);
+    EXPECT_EQ(nullptr, read());
+
+    // size mismatch
+    _size = cgt::ivec2(2, 2);
+    writeBmp("1.bmp", 24, std::vector<uint8_t>(rgb, rgb + 12), std::vector<uint8_t>(), false);
+    EXPECT_EQ(nullptr, read());
+
+    // the valid file alone is fine
+    cgt::FileSystem::deleteFile(_directory + "/1.bmp");
+    EXPECT_NE(nullptr, read());
+}
+
+#endif
@@ -0,0 +1,158 @@
+// ================================================================================================
+// 
+// This file is part of the CAMPVis Software Framework.
+// 
+// If not explicitly stated otherwise: Copyright (C) 2012-2015, all rights reserved,
+//      Christian Schulte zu Berge <christian.szb@in.tum.de>
+//      Chair for Computer Aided Medical Procedures
+//      Technische Universitaet Muenchen
+//      Boltzmannstr. 3, 85748 Garching b. Muenchen, Germany
+// 
+// For a full list of authors and contributors, please refer to the file "AUTHORS.txt".
+// 
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file 
+// except in compliance with the License. You may obtain a copy of the License at
+// 
+// http://www.apache.org/licenses/LICENSE-2.0
+// 
+// Unless required by applicable law or agreed to in writing, software distributed under the 
+// License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, 
+// either express or implied. See the License for the specific language governing permissions 
+// and limitations under the License.
+// 
+// ================================================================================================
+
+
+#include "gtest/gtest.h"
+
+#ifdef CAMPVIS_HAS_MODULE_DTI
+
+#include "cgt/filesystem.h"
+
+#include "core/datastructures/datacontainer.h"
+#include "core/datastructures/scopedtypeddata.h"
+
+#include "modules/dti/datastructures/fiberdata.h"
+#include "modules/dti/processors/fiberreader.h"
+#include "modules/dti/processors/fiberwriter.h"
+
+#include <fstream>
+#include <iterator>
+
+using namespace campvis;
+using namespace campvis::dti;
+
+/**
+ * Test class for FiberWriter and FiberReader. Writes fibers with point and fiber attributes into 
+ * a TrackVis file and reads them back.
+ */
+class TrkFileTest : public ::testing::Test {
+protected:
+    TrkFileTest()
+        : _dataContainer("Test Container")
+        , _fileName("trkfiletest.trk")
+    {
+        const size_t numPoints[] = { 4, 2, 7 };
+        std::vector<float> fa, curvature, meanFa, seed;
+        for (size_t f = 0; f < 3; ++f) {
+            std::vector<cgt::vec3> vertices;
+            for (size_t i = 0; i < numPoints[f]; ++i) {
+                vertices.push_back(cgt::vec3(1.5f * i, -2.25f * f + .125f * i, 10.f + f * i));
+                fa.push_back(.1f * i + .01f * f);
+                curvature.push_back(-1.f * i * f);
+            }
+            _fibers.addFiber(vertices);
+            meanFa.push_back(.5f + f);
+            seed.push_back(-3.f * f);
+        }
+        _fibers.addPointAttribute("FA", fa);
+        _fibers.addPointAttribute("curvature", curvature);
+        _fibers.addFiberAttribute("mean FA", meanFa);
+        _fibers.addFiberAttribute("seed", seed);
+
+        _reader.p_url.setValue(_fileName);
+        _reader.p_outputId.setValue("fibers");
+    }
+
+    ~TrkFileTest() {
+        cgt::FileSystem::deleteFile(_fileName);
+    }
+
+    /// Reads _fileName with _reader into _dataContainer.
+    void read() {
+        _dataContainer.clear();
+        _reader.invalidate(AbstractProcessor::INVALID_RESULT);
+        _reader.process(_dataContainer);
+    }
+
+    /// Reads the contents of _fileName.
+    std::string readFile() {
+        std::ifstream file(_fileName.c_str(), std::ios::in | std::ios::binary);
+        return std::string(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    }
+
+    /// Overwrites _fileName with \a contents.
+    void writeFile(const std::string& contents) {
+        std::ofstream file(_fileName.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+        file.write(contents.data(), contents.size());
+    }
+
+protected:
+    DataContainer _dataContainer;
+    FiberData _fibers;
+    FiberReader _reader;
+    std::string _fileName;
+};
+
+/**
+ * Writes the fibers and reads them back with the default scaling and offset, all data must be 
+ * reproduced exactly.
+ */
+TEST_F(TrkFileTest, roundTripTest) {
+    ASSERT_TRUE(FiberWriter::writeTrkFile(_fibers, _fileName));
+    read();
+
+    ScopedTypedData<FiberData> fibers(_dataContainer, "fibers");
+    ASSERT_TRUE(fibers != nullptr);
+    EXPECT_EQ(_fibers.getFiberOffsets(), fibers->getFiberOffsets());
+    EXPECT_EQ(_fibers.getVertices(), fibers->getVertices());
+
+    ASSERT_EQ(2U, fibers->getNumPointAttributes());
+    for (size_t i = 0; i < 2; ++i) {
+        EXPECT_EQ(_fibers.getPointAttributeName(i), fibers->getPointAttributeName(i));
+        EXPECT_EQ(_fibers.getPointAttribute(i), fibers->getPointAttribute(i));
+    }
+
+    ASSERT_EQ(2U, fibers->getNumFiberAttributes());
+    for (size_t i = 0; i < 2; ++i) {
+        EXPECT_EQ(_fibers.getFiberAttributeName(i), fibers->getFiberAttributeName(i));
+        EXPECT_EQ(_fibers.getFiberAttribute(i), fibers->getFiberAttribute(i));
+    }
+}
+
+/**
+ * Checks that truncated files are rejected instead of yielding partial fiber data.
+ */
+TEST_F(TrkFileTest, truncatedFileTest) {
+    ASSERT_TRUE(FiberWriter::writeTrkFile(_fibers, _fileName));
+    const std::string contents = readFile();
+
+    // size of the last record: number of points, 7 points with 3 coordinates and 2 scalars, 2 properties
+    const size_t lastRecordSize = sizeof(int32_t) + 7 * 5 * sizeof(float) + 2 * sizeof(float);
+    ASSERT_LT(1000 + lastRecordSize, contents.size());
+
+    // cut within the last record, within its point count, at the record boundary and within the header
+    const size_t lengths[] = { contents.size() - 6, contents.size() - lastRecordSize + 2, contents.size() - lastRecordSize, 999 };
+    for (size_t i = 0; i < sizeof(lengths) / sizeof(size_t); ++i) {
+        writeFile(contents.substr(0, lengths[i]));
+        read();
+        EXPECT_FALSE(_dataContainer.hasData("fibers")) << "File truncated to " << lengths[i] << " bytes";
+    }
+
+    // the untruncated file is still fine
+    writeFile(contents);
+    read();
+    EXPECT_TRUE(_dataContainer.hasData("fibers"));
+}
+
+#endif
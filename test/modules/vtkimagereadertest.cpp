@@ -0,0 +1,352 @@
+// ================================================================================================
+// 
+// This file is part of the CAMPVis Software Framework.
+// 
+// If not explicitly stated otherwise: Copyright (C) 2012-2015, all rights reserved,
+//      Christian Schulte zu Berge <christian.szb@in.tum.de>
+//      Chair for Computer Aided Medical Procedures
+//      Technische Universitaet Muenchen
+//      Boltzmannstr. 3, 85748 Garching b. Muenchen, Germany
+// 
+// For a full list of authors and contributors, please refer to the file "AUTHORS.txt".
+// 
+// Licensed under the Apache License, Version 2.0 (the "License"); you may not use this file 
+// except in compliance with the License. You may obtain a copy of the License at
+// 
+// http://www.apache.org/licenses/LICENSE-2.0
+// 
+// Unless required by applicable law or agreed to in writing, software distributed under the 
+// License is distributed on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, 
+// either express or implied. See the License for the specific language governing permissions 
+// and limitations under the License.
+// 
+// ================================================================================================
+
+
+#include "gtest/gtest.h"
+
+#ifdef CAMPVIS_HAS_MODULE_IO
+
+#include "cgt/filesystem.h"
+
+#include "core/datastructures/datacontainer.h"
+#include "core/datastructures/genericimagerepresentationlocal.h"
+#include "core/datastructures/imagedata.h"
+#include "core/datastructures/indexedmeshgeometry.h"
+#include "core/tools/stringutils.h"
+
+#include "modules/io/processors/vtkimagereader.h"
+
+#include <cstring>
+#include <fstream>
+#include <sstream>
+
+using namespace campvis;
+
+/**
+ * Test class for VtkImageReader. Writes small legacy VTK files and reads them back.
+ */
+class VtkImageReaderTest : public ::testing::Test {
+protected:
+    VtkImageReaderTest()
+        : _dataContainer("Test Container")
+        , _fileName("vtkimagereadertest.vtk")
+    {
+        _reader.p_url.setValue(_fileName);
+        _reader.p_targetImageID.setValue("image");
+    }
+
+    ~VtkImageReaderTest() {
+        cgt::FileSystem::deleteFile(_fileName);
+    }
+
+    /// Returns the header of a STRUCTURED_POINTS file in \a format with the given dimensions up to the FIELD line.
+    static std::string structuredPointsHeader(const std::string& format, size_t x, size_t y, size_t z, size_t numArrays) {
+        std::stringstream ss;
+        ss << "# vtk DataFile Version 3.0\n"
+           << "VtkImageReaderTest\n"
+           << format << "\n"
+           << "DATASET STRUCTURED_POINTS\n"
+           << "DIMENSIONS " << x << " " << y << " " << z << "\n"
+           << "SPACING 1 1 1\n"
+           << "ORIGIN 0 0 0\n"
+           << "POINT_DATA " << (x * y * z) << "\n"
+           << "FIELD FieldData " << numArrays << "\n";
+        return ss.str();
+    }
+
+    /// Appends \a value to \a bytes in big endian byte order, as legacy VTK files store binary data.
+    template<typename T>
+    static void appendBigEndian(std::string& bytes, T value) {
+        unsigned char raw[sizeof(T)];
+        memcpy(raw, &value, sizeof(T));
+
+        const uint16_t probe = 1;
+        if (*reinterpret_cast<const unsigned char*>(&probe) == 1) {
+            for (size_t i = 0; i < sizeof(T) / 2; ++i)
+                std::swap(raw[i], raw[sizeof(T) - 1 - i]);
+        }
+        bytes.append(reinterpret_cast<const char*>(raw), sizeof(T));
+    }
+
+    /// Writes \a contents to the test file and reads it.
+    void writeAndRead(const std::string& contents) {
+        std::ofstream file(_fileName.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+        file << contents;
+        file.close();
+
+        _dataContainer.clear();
+        _reader.invalidate(AbstractProcessor::INVALID_RESULT);
+        _reader.process(_dataContainer);
+    }
+
+    /// Writes a 4x2x1 STRUCTURED_POINTS file with a single field of type \a dataType containing \a values and reads it.
+    void writeAndRead(const std::string& dataType, const std::string& values) {
+        writeAndRead(structuredPointsHeader("ASCII", 4, 2, 1, 1) + "values 1 8 " + dataType + "\n" + values + "\n");
+    }
+
+    /// Writes a POLYDATA file with the given POINTS and POLYGONS sections and reads it without optimizing the mesh.
+    void writeAndReadPolydata(const std::string& points, const std::string& polygons) {
+        _reader.p_optimizeMesh.setValue(false);
+        writeAndRead("# vtk DataFile Version 3.0\n"
+                     "VtkImageReaderTest\n"
+                     "ASCII\n"
+                     "DATASET POLYDATA\n"
+                     + points + "\n"
+                     + polygons + "\n");
+    }
+
+    /// Returns the local representation of the read image \a name, 0 if there is none or it has a different type.
+    template<typename T>
+    const GenericImageRepresentationLocal<T, 1>* getResult(const std::string& name = "image") {
+        // the DataContainer keeps the image alive
+        const ImageData* image = dynamic_cast<const ImageData*>(_dataContainer.getData(name).getData());
+        return (image != 0) ? image->getRepresentation< GenericImageRepresentationLocal<T, 1> >(false) : 0;
+    }
+
+protected:
+    DataContainer _dataContainer;
+    VtkImageReader _reader;
+    std::string _fileName;
+};
+
+/**
+ * Reads signed and unsigned integers including the limits of their types.
+ */
+TEST_F(VtkImageReaderTest, asciiIntegerTest) {
+    writeAndRead("short", "0 1 -1 +42\n32767 -32768\t 7 -0");
+    const GenericImageRepresentationLocal<int16_t, 1>* shorts = getResult<int16_t>();
+    ASSERT_NE(nullptr, shorts);
+    const int16_t expectedShorts[] = { 0, 1, -1, 42, 32767, -32768, 7, 0 };
+    for (size_t i = 0; i < 8; ++i)
+        EXPECT_EQ(expectedShorts[i], shorts->getElement(i));
+
+    writeAndRead("unsigned_char", "0 1 2 3 252 253 254 255");
+    const GenericImageRepresentationLocal<uint8_t, 1>* bytes = getResult<uint8_t>();
+    ASSERT_NE(nullptr, bytes);
+    for (size_t i = 0; i < 8; ++i)
+        EXPECT_EQ((i < 4) ? i : 248 + i, bytes->getElement(i));
+
+    writeAndRead("int", "2147483647 -2147483648 0 1 2 3 4 5");
+    const GenericImageRepresentationLocal<int32_t, 1>* ints = getResult<int32_t>();
+    ASSERT_NE(nullptr, ints);
+    EXPECT_EQ(std::numeric_limits<int32_t>::max(), ints->getElement(0));
+    EXPECT_EQ(std::numeric_limits<int32_t>::min(), ints->getElement(1));
+}
+
+/**
+ * Reads floating point numbers in different notations.
+ */
+TEST_F(VtkImageReaderTest, asciiFloatTest) {
+    writeAndRead("float", "0 1.5 -2.25 1e3 -1.5E-2 .5 3. 42");
+    const GenericImageRepresentationLocal<float, 1>* floats = getResult<float>();
+    ASSERT_NE(nullptr, floats);
+    const float expected[] = { 0.f, 1.5f, -2.25f, 1000.f, -0.015f, 0.5f, 3.f, 42.f };
+    for (size_t i = 0; i < 8; ++i)
+        EXPECT_FLOAT_EQ(expected[i], floats->getElement(i));
+}
+
+/**
+ * Checks that values outside the range of the field's data type and malformed tokens are rejected.
+ */
+TEST_F(VtkImageReaderTest, asciiOutOfRangeTest) {
+    writeAndRead("unsigned_char", "0 1 2 3 4 5 6 300");
+    EXPECT_FALSE(_dataContainer.hasData("image"));
+
+    writeAndRead("unsigned_char", "0 1 2 3 4 5 6 -1");
+    EXPECT_FALSE(_dataContainer.hasData("image"));
+
+    writeAndRead("char", "0 1 2 3 4 5 6 -129");
+    EXPECT_FALSE(_dataContainer.hasData("image"));
+
+    writeAndRead("int", "0 1 2 3 4 5 6 2147483648");
+    EXPECT_FALSE(_dataContainer.hasData("image"));
+
+    writeAndRead("unsigned_int", "0 1 2 3 4 5 6 99999999999999999999999");
+    EXPECT_FALSE(_dataContainer.hasData("image"));
+
+    writeAndRead("float", "0 1 2 3 4 5 6 1e39");
+    EXPECT_FALSE(_dataContainer.hasData("image"));
+
+    writeAndRead("short", "0 1 2 3 4 5 6 7x");
+    EXPECT_FALSE(_dataContainer.hasData("image"));
+
+    // the limits themselves are fine
+    writeAndRead("char", "0 1 2 3 4 5 127 -128");
+    EXPECT_TRUE(_dataContainer.hasData("image"));
+}
+
+/**
+ * Reads BINARY fields and compares them value by value with the same fields stored as ASCII,
+ * which checks the conversion from the big endian file layout.
+ */
+TEST_F(VtkImageReaderTest, binaryTest) {
+    const int16_t shorts[] = { 0, 1, -1, 258, 32767, -32768, 4660, -292 };
+    const float floats[] = { 0.f, 1.5f, -2.25f, 1000.f, -0.015625f, 0.5f, 3.f, 42.f };
+
+    std::string binaryShorts, binaryFloats;
+    std::stringstream asciiShorts, asciiFloats;
+    for (size_t i = 0; i < 8; ++i) {
+        appendBigEndian(binaryShorts, shorts[i]);
+        appendBigEndian(binaryFloats, floats[i]);
+        asciiShorts << shorts[i] << " ";
+        asciiFloats << floats[i] << " ";
+    }
+
+    writeAndRead(structuredPointsHeader("BINARY", 4, 2, 1, 2) + "values 1 8 short\n" + binaryShorts + "\nfloats 1 8 float\n" + binaryFloats + "\n");
+    const GenericImageRepresentationLocal<int16_t, 1>* binaryShortRep = getResult<int16_t>();
+    const GenericImageRepresentationLocal<float, 1>* binaryFloatRep = getResult<float>("image.floats");
+    ASSERT_NE(nullptr, binaryShortRep);
+    ASSERT_NE(nullptr, binaryFloatRep);
+
+    DataContainer binaryData("Binary Container");
+    binaryData.addDataHandle("shorts", _dataContainer.getData("image"));
+    binaryData.addDataHandle("floats", _dataContainer.getData("image.floats"));
+
+    writeAndRead(structuredPointsHeader("ASCII", 4, 2, 1, 2) + "values 1 8 short\n" + asciiShorts.str() + "\nfloats 1 8 float\n" + asciiFloats.str() + "\n");
+    const GenericImageRepresentationLocal<int16_t, 1>* asciiShortRep = getResult<int16_t>();
+    const GenericImageRepresentationLocal<float, 1>* asciiFloatRep = getResult<float>("image.floats");
+    ASSERT_NE(nullptr, asciiShortRep);
+    ASSERT_NE(nullptr, asciiFloatRep);
+
+    for (size_t i = 0; i < 8; ++i) {
+        EXPECT_EQ(shorts[i], binaryShortRep->getElement(i));
+        EXPECT_EQ(asciiShortRep->getElement(i), binaryShortRep->getElement(i));
+        EXPECT_EQ(floats[i], binaryFloatRep->getElement(i));
+        EXPECT_EQ(asciiFloatRep->getElement(i), binaryFloatRep->getElement(i));
+    }
+
+    // truncated binary data is rejected
+    writeAndRead(structuredPointsHeader("BINARY", 4, 2, 1, 1) + "values 1 8 short\n" + binaryShorts.substr(0, 10));
+    EXPECT_FALSE(_dataContainer.hasData("image"));
+}
+
+/**
+ * Reads a FIELD with several arrays of different types and number of components.
+ */
+TEST_F(VtkImageReaderTest, fieldArraysTest) {
+    writeAndRead(structuredPointsHeader("ASCII", 4, 2, 1, 3)
+        + "values 1 8 float\n0 1 2 3 4 5 6 7\n"
+        + "mask 1 8 unsigned_char\n1 0 1 0 1 0 1 0\n"
+        + "vectors 3 8 double\n" + "1 2 3 1 2 3 1 2 3 1 2 3 1 2 3 1 2 3 1 2 3 1 2 3\n");
+
+    const GenericImageRepresentationLocal<float, 1>* values = getResult<float>();
+    const GenericImageRepresentationLocal<uint8_t, 1>* mask = getResult<uint8_t>("image.mask");
+    ASSERT_NE(nullptr, values);
+    ASSERT_NE(nullptr, mask);
+    for (size_t i = 0; i < 8; ++i) {
+        EXPECT_EQ(static_cast<float>(i), values->getElement(i));
+        EXPECT_EQ((i % 2 == 0) ? 1 : 0, mask->getElement(i));
+    }
+
+    const ImageData* vectors = dynamic_cast<const ImageData*>(_dataContainer.getData("image.vectors").getData());
+    ASSERT_NE(nullptr, vectors);
+    EXPECT_EQ(3U, vectors->getNumChannels());
+    const GenericImageRepresentationLocal<float, 3>* vectorRep = vectors->getRepresentation< GenericImageRepresentationLocal<float, 3> >(false);
+    ASSERT_NE(nullptr, vectorRep);
+    for (size_t i = 0; i < 8; ++i)
+        EXPECT_EQ(cgt::vec3(1.f, 2.f, 3.f), vectorRep->getElement(i));
+}
+
+/**
+ * Reads ASCII data that spans several read chunks and parallel parsing ranges, with tokens of
+ * varying length, so that tokens straddle the chunk and range boundaries. A second array follows
+ * to check that the stream is positioned right after the first one.
+ */
+TEST_F(VtkImageReaderTest, asciiChunkBoundaryTest) {
+    // about 40 MB of ASCII data, i.e. more than two 16 MB chunks
+    const size_t x = 1024, y = 1024, z = 5;
+    const size_t numValues = x * y * z;
+
+    std::string contents = structuredPointsHeader("ASCII", x, y, z, 2) + "values 1 " + StringUtils::toString(numValues) + " int\n";
+    contents.reserve(contents.size() + 10 * numValues);
+    for (size_t i = 0; i < numValues; ++i) {
+        contents += StringUtils::toString(static_cast<int32_t>((i * 7919) % 2000003) - 1000000);
+        contents += (i % 13 == 0) ? "\n" : " ";
+    }
+    contents += "\nsecond 1 " + StringUtils::toString(numValues) + " unsigned_char\n";
+    for (size_t i = 0; i < numValues; ++i)
+        contents += (i % 2 == 0) ? "7 " : "42 ";
+    contents += "\n";
+
+    writeAndRead(contents);
+    const GenericImageRepresentationLocal<int32_t, 1>* values = getResult<int32_t>();
+    const GenericImageRepresentationLocal<uint8_t, 1>* second = getResult<uint8_t>("image.second");
+    ASSERT_NE(nullptr, values);
+    ASSERT_NE(nullptr, second);
+
+    size_t numWrong = 0;
+    for (size_t i = 0; i < numValues; ++i) {
+        if (values->getElement(i) != static_cast<int32_t>((i * 7919) % 2000003) - 1000000)
+            ++numWrong;
+        if (second->getElement(i) != ((i % 2 == 0) ? 7 : 42))
+            ++numWrong;
+    }
+    EXPECT_EQ(0U, numWrong);
+}
+
+/**
+ * Reads a POLYDATA file with a quad and a pentagon, which are triangulated as fans.
+ */
+TEST_F(VtkImageReaderTest, polydataFanTest) {
+    writeAndReadPolydata("POINTS 9 float\n0 0 0 1 0 0 1 1 0 0 1 0\n2 0 0 3 0 0 4 1 0 3 2 0 2 1 0",
+                         "POLYGONS 2 11\n4 0 1 2 3\n5 4 5 6 7 8");
+
+    const IndexedMeshGeometry* mesh = dynamic_cast<const IndexedMeshGeometry*>(_dataContainer.getData("image").getData());
+    ASSERT_NE(nullptr, mesh);
+    EXPECT_EQ(9U, mesh->getVertices().size());
+
+    const uint32_t expected[] = { 0, 1, 2,  0, 2, 3,  4, 5, 6,  4, 6, 7,  4, 7, 8 };
+    ASSERT_EQ(15U, mesh->getNumIndices());
+    for (size_t i = 0; i < 15; ++i)
+        EXPECT_EQ(expected[i], mesh->getIndex(i));
+}
+
+/**
+ * Checks that polygons with corrupt point counts or point indices are rejected.
+ */
+TEST_F(VtkImageReaderTest, polydataCorruptCellTest) {
+    const std::string points = "POINTS 4 float\n0 0 0 1 0 0 1 1 0 0 1 0";
+
+    // point count exceeds the number of indices
+    writeAndReadPolydata(points, "POLYGONS 1 4\n5 0 1 2");
+    EXPECT_FALSE(_dataContainer.hasData("image"));
+
+    // negative point count
+    writeAndReadPolydata(points, "POLYGONS 1 4\n-3 0 1 2");
+    EXPECT_FALSE(_dataContainer.hasData("image"));
+
+    // negative point index
+    writeAndReadPolydata(points, "POLYGONS 1 4\n3 0 -1 2");
+    EXPECT_FALSE(_dataContainer.hasData("image"));
+
+    // point index out of range
+    writeAndReadPolydata(points, "POLYGONS 1 4\n3 0 1 4");
+    EXPECT_FALSE(_dataContainer.hasData("image"));
+
+    // the same polygon with valid indices is fine
+    writeAndReadPolydata(points, "POLYGONS 1 4\n3 0 1 3");
+    EXPECT_TRUE(_dataContainer.hasData("image"));
+}
+
+#endif